@@ -50,6 +50,14 @@
 #define ESP32_UART_IRQn          USART1_IRQn
 #define ESP32_UART_IRQ_HANDLER   USART1_IRQHandler
 #define ESP32_UART_RCC_ENABLE()  __HAL_RCC_USART1_CLK_ENABLE()
+// USART1_RX/TX are fixed to DMA1 channels 5/4 on STM32F1.
+#define ESP32_UART_RX_DMA_CHANNEL       DMA1_Channel5
+#define ESP32_UART_RX_DMA_IRQn          DMA1_Channel5_IRQn
+#define ESP32_UART_RX_DMA_IRQ_HANDLER   DMA1_Channel5_IRQHandler
+#define ESP32_UART_RX_DMA_RCC_ENABLE()  __HAL_RCC_DMA1_CLK_ENABLE()
+#define ESP32_UART_TX_DMA_CHANNEL       DMA1_Channel4
+#define ESP32_UART_TX_DMA_IRQn          DMA1_Channel4_IRQn
+#define ESP32_UART_TX_DMA_IRQ_HANDLER   DMA1_Channel4_IRQHandler
 #define PIN_ESP32_TX_GPIO        GPIOA
 #define PIN_ESP32_TX_PIN         GPIO_PIN_9  // STM32 TX  -> ESP32 RX(GPIO16)
 #define PIN_ESP32_RX_GPIO        GPIOA
@@ -17,17 +17,6 @@
 #define AQUA_SENSOR_FAULT_TURBIDITY (1u << 3)
 #define AQUA_SENSOR_FAULT_WATER_LEVEL (1u << 4)
 
-#define AQUA_TEMP_PHYS_MIN (-55.0f)
-#define AQUA_TEMP_PHYS_MAX (125.0f)
-#define AQUA_PH_PHYS_MIN (0.0f)
-#define AQUA_PH_PHYS_MAX (14.0f)
-#define AQUA_TDS_PHYS_MIN (0.0f)
-#define AQUA_TDS_PHYS_MAX (5000.0f)
-#define AQUA_TURB_PHYS_MIN (0.0f)
-#define AQUA_TURB_PHYS_MAX (3000.0f)
-#define AQUA_LEVEL_PHYS_MIN (0.0f)
-#define AQUA_LEVEL_PHYS_MAX (100.0f)
-
 static bool aqua_is_finitef(float v) { return (v == v) && ((v - v) == 0.0f); }
 
 static float aqua_clampf(float v, float min_val, float max_val) {
@@ -182,6 +171,7 @@ void aqua_app_init(AquariumApp *app, const char *device_id) {
   /* 默认上报配置 */
   app->report_interval = DEFAULT_REPORT_INTERVAL_SECONDS;
   app->report_timer = DEFAULT_REPORT_INTERVAL_SECONDS;
+  app->keyframe_interval = DEFAULT_KEYFRAME_INTERVAL;
 }
 
 /* ============================================================================
@@ -198,6 +188,68 @@ void aqua_app_set_report_interval(AquariumApp *app, uint32_t interval_seconds) {
   app->report_timer = interval_seconds;
 }
 
+AquaError aqua_app_set_report_frame_mode(AquariumApp *app, bool enable) {
+  if (!app)
+    return AQUA_ERR_NULL_PTR;
+
+  if (enable) {
+    AquaError err = aqua_report_frame_init(&app->report_frame);
+    if (err != AQUA_OK) {
+      app->report_frame_enabled = false;
+      return err;
+    }
+  }
+  app->report_frame_enabled = enable;
+  return AQUA_OK;
+}
+
+void aqua_app_set_delta_report(AquariumApp *app, bool enable,
+                               uint32_t keyframe_interval) {
+  if (!app)
+    return;
+
+  app->delta_report_enabled = enable;
+  app->keyframe_interval =
+      keyframe_interval ? keyframe_interval : DEFAULT_KEYFRAME_INTERVAL;
+  /* 下一次上报从关键帧开始 */
+  app->has_last_report = false;
+  app->reports_since_keyframe = 0;
+}
+
+void aqua_app_request_keyframe(AquariumApp *app) {
+  if (!app)
+    return;
+  app->has_last_report = false;
+}
+
+void aqua_app_set_batch_report(AquariumApp *app,
+                               uint32_t sample_interval_seconds) {
+  if (!app)
+    return;
+
+  app->sample_interval = sample_interval_seconds;
+  app->sample_timer = sample_interval_seconds;
+  app->batch_count = 0;
+}
+
+void aqua_app_set_report_codec(AquariumApp *app, AquaReportCodec codec) {
+  if (!app)
+    return;
+  app->report_codec = (uint8_t)codec;
+}
+
+void aqua_app_set_command_state_response(AquariumApp *app, bool enable) {
+  if (!app)
+    return;
+  app->command_state_response = enable;
+}
+
+void aqua_app_set_utc_time(AquariumApp *app, uint32_t unix_seconds) {
+  if (!app)
+    return;
+  app->utc_time = unix_seconds;
+}
+
 /* ============================================================================
  * 传感器数据更新
  * ============================================================================
@@ -243,8 +295,8 @@ void aqua_app_update_sensors(AquariumApp *app, float temperature, float ph,
       AQUA_SENSOR_FAULT_TDS, tds_ok, tds_cal, safe.tds);
 
   /* 浊度：物理范围校验 */
-  bool turb_ok = aqua_is_finitef(turbidity) && turbidity >= AQUA_TURB_PHYS_MIN &&
-                 turbidity <= AQUA_TURB_PHYS_MAX;
+  bool turb_ok = aqua_is_finitef(turbidity) && turbidity >= AQUA_TURBIDITY_PHYS_MIN &&
+                 turbidity <= AQUA_TURBIDITY_PHYS_MAX;
   aqua_app_update_sensor_with_tolerance(
       state, &state->props.turbidity, &app->sensor_fail_count_turbidity,
       AQUA_SENSOR_FAULT_TURBIDITY, turb_ok, turbidity, safe.turbidity);
@@ -263,16 +315,242 @@ void aqua_app_update_sensors(AquariumApp *app, float temperature, float ph,
  * ============================================================================
  */
 
-AquaError aqua_app_step(AquariumApp *app, uint32_t elapsed_seconds,
-                        ActuatorDesired *out_actuators, bool *out_has_publish,
-                        char *out_topic, size_t topic_size, char *out_payload,
-                        size_t payload_size) {
-  if (!app || !out_actuators || !out_has_publish || !out_topic ||
-      !out_payload) {
-    return AQUA_ERR_NULL_PTR;
+static bool aqua_app_moved(float current, float last, float deadband) {
+  float delta = current - last;
+  if (delta < 0.0f)
+    delta = -delta;
+  return delta > deadband;
+}
+
+/* 越过死区的传感器字段 */
+static uint16_t aqua_app_sensor_changes(const AquariumApp *app) {
+  const AquariumProperties *cur = &app->state.props;
+  const AquariumProperties *last = &app->last_report;
+  const ThresholdConfig *t = &app->state.thresholds;
+  uint16_t mask = 0;
+
+  if (aqua_app_moved(cur->temperature, last->temperature, t->temp_deadband))
+    mask |= AQUA_PROP_TEMPERATURE;
+  if (aqua_app_moved(cur->ph, last->ph, t->ph_deadband))
+    mask |= AQUA_PROP_PH;
+  if (aqua_app_moved(cur->tds, last->tds, t->tds_deadband))
+    mask |= AQUA_PROP_TDS;
+  if (aqua_app_moved(cur->turbidity, last->turbidity, t->turbidity_deadband))
+    mask |= AQUA_PROP_TURBIDITY;
+  if (aqua_app_moved(cur->water_level, last->water_level, t->level_deadband))
+    mask |= AQUA_PROP_WATER_LEVEL;
+  return mask;
+}
+
+/* 选择本周期需要上报的字段；返回 0 表示无需上报 */
+static uint16_t aqua_app_select_report_fields(AquariumApp *app) {
+  if (!app->delta_report_enabled)
+    return AQUA_PROP_ALL;
+
+  if (!app->has_last_report ||
+      app->reports_since_keyframe + 1 >= app->keyframe_interval) {
+    app->reports_since_keyframe = 0;
+    return AQUA_PROP_ALL;
+  }
+  app->reports_since_keyframe++;
+
+  const AquariumProperties *cur = &app->state.props;
+  const AquariumProperties *last = &app->last_report;
+  uint16_t mask = aqua_app_sensor_changes(app);
+
+  if (cur->heater != last->heater)
+    mask |= AQUA_PROP_HEATER;
+  if (cur->pump_in != last->pump_in)
+    mask |= AQUA_PROP_PUMP_IN;
+  if (cur->pump_out != last->pump_out)
+    mask |= AQUA_PROP_PUMP_OUT;
+  if (cur->auto_mode != last->auto_mode)
+    mask |= AQUA_PROP_AUTO_MODE;
+  if (cur->feeding_in_progress != last->feeding_in_progress)
+    mask |= AQUA_PROP_FEEDING_IN_PROGRESS;
+  if (cur->alarm_level != last->alarm_level)
+    mask |= AQUA_PROP_ALARM_LEVEL;
+  if (cur->alarm_muted != last->alarm_muted)
+    mask |= AQUA_PROP_ALARM_MUTED;
+
+  /* 倒计时按时间递减可由云端推算，仅在偏离推算值（重置/改期）时上报 */
+  int64_t predicted =
+      (int64_t)last->feed_countdown - (int64_t)app->countdown_report_age;
+  if (predicted < 0)
+    predicted = 0;
+  int64_t drift = (int64_t)cur->feed_countdown - predicted;
+  if (drift > 1 || drift < -1)
+    mask |= AQUA_PROP_FEED_COUNTDOWN;
+
+  return mask;
+}
+
+/* 记录已上报字段的值，未上报字段保持旧值以免死区内的缓慢漂移被吞掉 */
+static void aqua_app_commit_report(AquariumApp *app, uint16_t mask) {
+  const AquariumProperties *cur = &app->state.props;
+  AquariumProperties *last = &app->last_report;
+
+  if (mask & AQUA_PROP_TEMPERATURE)
+    last->temperature = cur->temperature;
+  if (mask & AQUA_PROP_PH)
+    last->ph = cur->ph;
+  if (mask & AQUA_PROP_TDS)
+    last->tds = cur->tds;
+  if (mask & AQUA_PROP_TURBIDITY)
+    last->turbidity = cur->turbidity;
+  if (mask & AQUA_PROP_WATER_LEVEL)
+    last->water_level = cur->water_level;
+  if (mask & AQUA_PROP_HEATER)
+    last->heater = cur->heater;
+  if (mask & AQUA_PROP_PUMP_IN)
+    last->pump_in = cur->pump_in;
+  if (mask & AQUA_PROP_PUMP_OUT)
+    last->pump_out = cur->pump_out;
+  if (mask & AQUA_PROP_AUTO_MODE)
+    last->auto_mode = cur->auto_mode;
+  if (mask & AQUA_PROP_FEED_COUNTDOWN) {
+    last->feed_countdown = cur->feed_countdown;
+    app->countdown_report_age = 0;
   }
+  if (mask & AQUA_PROP_FEEDING_IN_PROGRESS)
+    last->feeding_in_progress = cur->feeding_in_progress;
+  if (mask & AQUA_PROP_ALARM_LEVEL)
+    last->alarm_level = cur->alarm_level;
+  if (mask & AQUA_PROP_ALARM_MUTED)
+    last->alarm_muted = cur->alarm_muted;
+
+  if (mask == AQUA_PROP_ALL)
+    app->has_last_report = true;
+}
 
-  *out_has_publish = false;
+/* 上报周期之间记录一个中间采样 */
+static void aqua_app_collect_sample(AquariumApp *app,
+                                    uint32_t elapsed_seconds) {
+  if (app->sample_interval == 0)
+    return;
+  if (elapsed_seconds < app->sample_timer) {
+    app->sample_timer -= elapsed_seconds;
+    return;
+  }
+  app->sample_timer = app->sample_interval;
+
+  /* 未校时的采样没有可用的 event_time */
+  if (app->utc_time == 0)
+    return;
+
+  uint16_t mask = AQUA_PROP_SENSORS;
+  if (app->delta_report_enabled) {
+    mask = aqua_app_sensor_changes(app);
+    if (mask == 0)
+      return;
+  }
+
+  if (app->batch_count == AQUA_APP_BATCH_MAX_SAMPLES) {
+    memmove(&app->batch[0], &app->batch[1],
+            sizeof(app->batch[0]) * (AQUA_APP_BATCH_MAX_SAMPLES - 1));
+    app->batch_count--;
+  }
+
+  AquaPropertySample *sample = &app->batch[app->batch_count++];
+  sample->props = app->state.props;
+  sample->field_mask = mask;
+  sample->event_time = app->utc_time;
+  aqua_app_commit_report(app, mask);
+}
+
+static AquaError aqua_app_encode_samples(const AquariumApp *app,
+                                        const AquaPropertySample *samples,
+                                        size_t count, char *out_payload,
+                                        size_t payload_size,
+                                        size_t *out_len) {
+  if (app->report_codec == AQUA_REPORT_CODEC_CBOR) {
+    return aqua_build_properties_cbor(samples, count, (uint8_t *)out_payload,
+                                      payload_size, out_len);
+  }
+  return aqua_build_properties_batch_json(samples, count, out_payload,
+                                          payload_size, out_len);
+}
+
+/*
+ * 缓存的中间采样 + 当前属性合并为一条批量上报。
+ * 当前属性写入缓存末尾的备用格（不计入 batch_count），直接从缓存编码。
+ */
+static AquaError aqua_app_build_batch(AquariumApp *app, uint16_t mask,
+                                      char *out_payload, size_t payload_size,
+                                      size_t *out_len) {
+  AquaPropertySample *samples = app->batch;
+  size_t count = app->batch_count;
+  if (mask != 0) {
+    samples[count].props = app->state.props;
+    samples[count].field_mask = mask;
+    samples[count].event_time = app->utc_time;
+    count++;
+  }
+
+  /* 放不下时丢弃最早的采样，保证当前属性一定能发出 */
+  size_t first = 0;
+  AquaError err;
+  do {
+    err = aqua_app_encode_samples(app, &samples[first], count - first,
+                                  out_payload, payload_size, out_len);
+  } while (err == AQUA_ERR_BUFFER_TOO_SMALL && ++first < count);
+  return err;
+}
+
+static AquaError aqua_app_build_report(AquariumApp *app, uint16_t mask,
+                                       char *out_topic, size_t topic_size,
+                                       char *out_payload, size_t payload_size,
+                                       size_t *out_len) {
+  size_t topic_len;
+
+  if (app->report_codec == AQUA_REPORT_CODEC_CBOR) {
+    AquaError err = aqua_build_message_up_topic(app->device_id, out_topic,
+                                                topic_size, &topic_len);
+    if (err != AQUA_OK) {
+      return err;
+    }
+    return aqua_app_build_batch(app, mask, out_payload, payload_size, out_len);
+  }
+
+  if (mask == AQUA_PROP_ALL && app->batch_count == 0 &&
+      !app->report_frame_enabled) {
+    return aqua_iotda_build_report(app->device_id, &app->state.props,
+                                   out_topic, topic_size, out_payload,
+                                   payload_size, &topic_len, out_len);
+  }
+
+  AquaError err =
+      aqua_build_report_topic(app->device_id, out_topic, topic_size, &topic_len);
+  if (err != AQUA_OK) {
+    return err;
+  }
+
+  if (app->batch_count > 0) {
+    return aqua_app_build_batch(app, mask, out_payload, payload_size, out_len);
+  }
+
+  if (mask != AQUA_PROP_ALL) {
+    return aqua_build_properties_fields_json(&app->state.props, mask,
+                                             out_payload, payload_size,
+                                             out_len);
+  }
+
+  err = aqua_report_frame_update(&app->report_frame, &app->state.props,
+                                 out_len);
+  if (err != AQUA_OK) {
+    return err;
+  }
+  if (*out_len >= payload_size) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
+  memcpy(out_payload, app->report_frame.buf, *out_len + 1);
+  return AQUA_OK;
+}
+
+void aqua_app_tick(AquariumApp *app, uint32_t elapsed_seconds,
+                   ActuatorDesired *out_actuators) {
+  if (!app || !out_actuators)
+    return;
 
   /* 1. 推进投喂倒计时 */
   aqua_logic_tick(&app->state, elapsed_seconds);
@@ -290,22 +568,49 @@ AquaError aqua_app_step(AquariumApp *app, uint32_t elapsed_seconds,
     app->state.props.pump_out = out_actuators->pump_out;
   }
 
-  /* 5. 检查上报周期 */
+  app->countdown_report_age += elapsed_seconds;
+  if (app->utc_time != 0) {
+    app->utc_time += elapsed_seconds;
+  }
+}
+
+AquaError aqua_app_step(AquariumApp *app, uint32_t elapsed_seconds,
+                        ActuatorDesired *out_actuators, bool *out_has_publish,
+                        char *out_topic, size_t topic_size, char *out_payload,
+                        size_t payload_size) {
+  if (!app || !out_actuators || !out_has_publish || !out_topic ||
+      !out_payload) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  *out_has_publish = false;
+
+  /* 1-4. 业务逻辑 */
+  aqua_app_tick(app, elapsed_seconds, out_actuators);
+
+  /* 6. 检查上报周期 */
   if (elapsed_seconds >= app->report_timer) {
-    /* 触发上报 */
-    size_t topic_len, payload_len;
-    AquaError err = aqua_iotda_build_report(
-        app->device_id, &app->state.props, out_topic, topic_size, out_payload,
-        payload_size, &topic_len, &payload_len);
-    if (err != AQUA_OK) {
-      return err;
+    /* 触发上报（增量模式下无变化且无缓存采样则跳过本周期） */
+    uint16_t mask = aqua_app_select_report_fields(app);
+    if (mask != 0 || app->batch_count > 0) {
+      AquaError err =
+          aqua_app_build_report(app, mask, out_topic, topic_size, out_payload,
+                                payload_size, &app->report_len);
+      if (err != AQUA_OK) {
+        return err;
+      }
+      aqua_app_commit_report(app, mask);
+      app->batch_count = 0;
+      *out_has_publish = true;
     }
 
-    *out_has_publish = true;
-    /* 重置上报计时器 */
+    /* 重置上报/采样计时器 */
     app->report_timer = app->report_interval;
+    app->sample_timer = app->sample_interval;
   } else {
     app->report_timer -= elapsed_seconds;
+    /* 5. 批量上报：缓存中间采样 */
+    aqua_app_collect_sample(app, elapsed_seconds);
   }
 
   return AQUA_OK;
@@ -321,14 +626,31 @@ AquaError aqua_app_on_mqtt_command(AquariumApp *app, const char *in_topic,
                                    bool *out_has_response, char *out_topic,
                                    size_t topic_size, char *out_payload,
                                    size_t payload_size) {
-  if (!app || !in_topic || !in_payload || !out_has_response || !out_topic ||
-      !out_payload) {
+  if (!app) {
+    return AQUA_ERR_NULL_PTR;
+  }
+  return aqua_app_on_mqtt_command_as(app, app->device_id, in_topic, in_payload,
+                                     payload_len, out_has_response, out_topic,
+                                     topic_size, out_payload, payload_size);
+}
+
+AquaError aqua_app_on_mqtt_command_as(AquariumApp *app,
+                                      const char *reply_device_id,
+                                      const char *in_topic,
+                                      const char *in_payload,
+                                      size_t payload_len,
+                                      bool *out_has_response, char *out_topic,
+                                      size_t topic_size, char *out_payload,
+                                      size_t payload_size) {
+  if (!app || !reply_device_id || !in_topic || !in_payload ||
+      !out_has_response || !out_topic || !out_payload) {
     return AQUA_ERR_NULL_PTR;
   }
 
   IoTDACommandResult result;
-  AquaError err = aqua_iotda_handle_command(
-      app->device_id, in_topic, in_payload, payload_len, &app->state, &result);
+  AquaError err = aqua_iotda_handle_downlink(
+      reply_device_id, in_topic, in_payload, payload_len, &app->state,
+      app->command_state_response ? IOTDA_CMD_RESPONSE_STATE : 0, &result);
 
   if (err != AQUA_OK && !result.has_response) {
     *out_has_response = false;
@@ -365,3 +687,9 @@ const AquariumState *aqua_app_get_state(const AquariumApp *app) {
     return NULL;
   return &app->state;
 }
+
+size_t aqua_app_get_report_len(const AquariumApp *app) {
+  if (!app)
+    return 0;
+  return app->report_len;
+}
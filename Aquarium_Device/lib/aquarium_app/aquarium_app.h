@@ -12,6 +12,7 @@
 #ifndef AQUARIUM_APP_H
 #define AQUARIUM_APP_H
 
+#include "aquarium_cbor.h"
 #include "aquarium_iotda.h"
 #include <stdbool.h>
 #include <stdint.h>
@@ -27,9 +28,29 @@ extern "C" {
 
 #define DEFAULT_REPORT_INTERVAL_SECONDS 30
 
+/* 增量上报：默认每 10 个上报周期发送一次全量关键帧 */
+#define DEFAULT_KEYFRAME_INTERVAL 10
+
+/*
+ * 批量上报：两次上报之间最多缓存的中间采样数。
+ * 中间采样只含传感器字段（约 160 B），4 个采样加一条全量属性
+ * 可放进 1 KB 的发布缓冲。
+ */
+#define AQUA_APP_BATCH_MAX_SAMPLES 4
+
 /* 连续 N 次采集失败/异常 -> 触发传感器故障告警 */
 #define AQUA_APP_SENSOR_FAIL_THRESHOLD 3
 
+/* ============================================================================
+ * 上报编码
+ * ============================================================================
+ */
+
+typedef enum {
+  AQUA_REPORT_CODEC_JSON = 0, /* sys/properties/report，JSON（默认） */
+  AQUA_REPORT_CODEC_CBOR      /* sys/messages/up，见 aquarium_cbor.h */
+} AquaReportCodec;
+
 /* ============================================================================
  * 设备 ID 最大长度
  * ============================================================================
@@ -59,6 +80,33 @@ typedef struct {
   /* 上报配置 */
   uint32_t report_interval; /* 上报间隔（秒） */
   uint32_t report_timer;    /* 上报倒计时 */
+  uint8_t report_codec;     /* AquaReportCodec */
+  size_t report_len;        /* 最近一次生成的上报 payload 字节数 */
+
+  /* 预格式化上报帧：启用后每次上报只改写数值槽位 */
+  bool report_frame_enabled;
+  AquaReportFrame report_frame;
+
+  /* 增量上报：只发送越过死区/发生翻转的字段，定期补发全量关键帧 */
+  bool delta_report_enabled;
+  uint32_t keyframe_interval;      /* 关键帧间隔（上报周期数） */
+  uint32_t reports_since_keyframe; /* 距上次关键帧的上报周期数 */
+  bool has_last_report;
+  AquariumProperties last_report; /* 各字段最近一次上报的值 */
+  uint32_t countdown_report_age;  /* feed_countdown 上次上报至今的秒数 */
+
+  /* 批量上报：两次上报之间按采样间隔缓存带时间戳的传感器采样 */
+  uint32_t sample_interval; /* 采样间隔（秒），0 表示关闭 */
+  uint32_t sample_timer;    /* 采样倒计时 */
+  uint8_t batch_count;
+  /* 末尾多一格：组包时放入当前属性，整段直接交给编码器 */
+  AquaPropertySample batch[AQUA_APP_BATCH_MAX_SAMPLES + 1];
+
+  /* UTC 时钟（Unix 秒），0 表示尚未校时 */
+  uint32_t utc_time;
+
+  /* 命令响应附带命令生效后的状态快照 */
+  bool command_state_response;
 } AquariumApp;
 
 /* ============================================================================
@@ -87,6 +135,86 @@ void aqua_app_init(AquariumApp *app, const char *device_id);
  */
 void aqua_app_set_report_interval(AquariumApp *app, uint32_t interval_seconds);
 
+/**
+ * @brief 启用/关闭预格式化上报帧
+ *
+ * 启用后上报 payload 取自定宽槽位的预格式化帧（数值右对齐补空格），
+ * 每次上报只改写 13 个槽位；关闭时使用紧凑格式逐次生成。
+ *
+ * @param app    应用上下文指针
+ * @param enable 是否启用
+ * @return AquaError 错误码
+ */
+AquaError aqua_app_set_report_frame_mode(AquariumApp *app, bool enable);
+
+/**
+ * @brief 启用/关闭增量上报
+ *
+ * 启用后每个上报周期只发送相对上次上报值变化超过死区的字段
+ * （死区来自 set_thresholds 的 *_deadband 参数），布尔/告警等级
+ * 任何变化都会发送；feed_countdown 仅在偏离按时间推算的值时发送。
+ * 没有字段变化的周期不发布消息。每 keyframe_interval 个周期
+ * 发送一次全量关键帧。
+ *
+ * @param app               应用上下文指针
+ * @param enable            是否启用
+ * @param keyframe_interval 关键帧间隔（上报周期数），0 表示默认值
+ */
+void aqua_app_set_delta_report(AquariumApp *app, bool enable,
+                               uint32_t keyframe_interval);
+
+/**
+ * @brief 要求下一次上报发送全量关键帧
+ *
+ * 上报生成后未能实际发出（如离线、发布失败）时调用，
+ * 避免云端与 last_report 记录的状态不一致。
+ */
+void aqua_app_request_keyframe(AquariumApp *app);
+
+/**
+ * @brief 设置批量上报的采样间隔
+ *
+ * 启用后，两次上报之间每 sample_interval_seconds 秒记录一次传感器采样
+ * （带 event_time），下一次上报时与当前全量/增量属性合并为一条消息发布。
+ * 缓存满时丢弃最早的采样；尚未校时（utc_time 为 0）时不记录中间采样。
+ *
+ * @param app                     应用上下文指针
+ * @param sample_interval_seconds 采样间隔（秒），0 表示关闭批量上报
+ */
+void aqua_app_set_batch_report(AquariumApp *app,
+                               uint32_t sample_interval_seconds);
+
+/**
+ * @brief 选择属性上报编码
+ *
+ * CBOR 编码下每次上报（含批量缓存的采样）都编码为一条二进制消息，
+ * 发布到 sys/messages/up；预格式化上报帧只用于 JSON 编码。
+ * 二进制 payload 中可能含 0 字节，发布时须使用 aqua_app_get_report_len。
+ *
+ * @param app   应用上下文指针
+ * @param codec AquaReportCodec
+ */
+void aqua_app_set_report_codec(AquariumApp *app, AquaReportCodec codec);
+
+/**
+ * @brief 命令响应是否附带命令生效后的状态快照
+ *
+ * 启用后命令响应的 paras 中带 "state" 对象（见 aqua_iotda_handle_command），
+ * 云端一次往返即可确认命令效果，无需等待下一次属性上报。
+ *
+ * @param app    应用上下文指针
+ * @param enable 是否启用，默认关闭
+ */
+void aqua_app_set_command_state_response(AquariumApp *app, bool enable);
+
+/**
+ * @brief 设置当前 UTC 时间（如 SNTP 校时后调用），之后随 step 推进
+ *
+ * @param app          应用上下文指针
+ * @param unix_seconds 自 1970-01-01 00:00:00 UTC 起的秒数
+ */
+void aqua_app_set_utc_time(AquariumApp *app, uint32_t unix_seconds);
+
 /* ============================================================================
  * 传感器数据更新
  * ============================================================================
@@ -112,6 +240,19 @@ void aqua_app_update_sensors(AquariumApp *app, float temperature, float ph,
  * ============================================================================
  */
 
+/**
+ * @brief 只推进业务逻辑，不处理上报
+ *
+ * 即 aqua_app_step 的第 1~4 步（同时推进 UTC 时钟）。
+ * 网关模式下各子设备用它推进，上报由 aqua_gateway_step 统一生成。
+ *
+ * @param app             应用上下文指针
+ * @param elapsed_seconds 自上次调用以来经过的秒数
+ * @param out_actuators   [输出] 期望执行器状态
+ */
+void aqua_app_tick(AquariumApp *app, uint32_t elapsed_seconds,
+                   ActuatorDesired *out_actuators);
+
 /**
  * @brief 执行一次主循环步进
  *
@@ -120,7 +261,8 @@ void aqua_app_update_sensors(AquariumApp *app, float temperature, float ph,
  * 2. 调用 aqua_logic_eval_alarm 计算告警等级
  * 3. 调用 aqua_logic_compute_actuators 计算期望执行器状态
  * 4. 自动模式下将期望执行器状态回写到 state.props
- * 5. 检查上报周期，到期时生成属性上报
+ * 5. 批量上报模式下按采样间隔缓存传感器采样
+ * 6. 检查上报周期，到期时生成属性上报（含缓存的采样）
  *
  * @param app             应用上下文指针
  * @param elapsed_seconds 自上次调用以来经过的秒数
@@ -131,6 +273,8 @@ void aqua_app_update_sensors(AquariumApp *app, float temperature, float ph,
  * @param out_payload     [输出] 发布 Payload 缓冲区
  * @param payload_size    Payload 缓冲区大小
  * @return AquaError 错误码
+ *
+ * 有上报时 payload 长度由 aqua_app_get_report_len 取得。
  */
 AquaError aqua_app_step(AquariumApp *app, uint32_t elapsed_seconds,
                         ActuatorDesired *out_actuators, bool *out_has_publish,
@@ -145,6 +289,10 @@ AquaError aqua_app_step(AquariumApp *app, uint32_t elapsed_seconds,
 /**
  * @brief 处理收到的 MQTT 命令
  *
+ * 按 Topic 分发（aqua_iotda_handle_downlink）：命令请求、属性设置请求
+ * 应用到设备状态后回包；属性查询请求直接以当前状态回包，
+ * 不等待也不改变上报周期。
+ *
  * @param app              应用上下文指针
  * @param in_topic         输入命令 Topic
  * @param in_payload       输入命令 Payload
@@ -162,6 +310,23 @@ AquaError aqua_app_on_mqtt_command(AquariumApp *app, const char *in_topic,
                                    size_t topic_size, char *out_payload,
                                    size_t payload_size);
 
+/**
+ * @brief 处理收到的 MQTT 命令，响应 Topic 使用指定设备 ID
+ *
+ * 网关模式下子设备的下行请求经由网关收发，响应须发布到网关的 Topic。
+ * 其余参数与 aqua_app_on_mqtt_command 相同。
+ *
+ * @param reply_device_id 响应 Topic 中的设备 ID
+ */
+AquaError aqua_app_on_mqtt_command_as(AquariumApp *app,
+                                      const char *reply_device_id,
+                                      const char *in_topic,
+                                      const char *in_payload,
+                                      size_t payload_len,
+                                      bool *out_has_response, char *out_topic,
+                                      size_t topic_size, char *out_payload,
+                                      size_t payload_size);
+
 /* ============================================================================
  * 状态访问（供外部查询）
  * ============================================================================
@@ -172,6 +337,11 @@ AquaError aqua_app_on_mqtt_command(AquariumApp *app, const char *in_topic,
  */
 const AquariumState *aqua_app_get_state(const AquariumApp *app);
 
+/**
+ * @brief 最近一次 aqua_app_step 生成的上报 payload 字节数
+ */
+size_t aqua_app_get_report_len(const AquariumApp *app);
+
 #ifdef __cplusplus
 }
 #endif
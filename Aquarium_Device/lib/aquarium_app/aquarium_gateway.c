@@ -0,0 +1,200 @@
+/**
+ * @file aquarium_gateway.c
+ * @brief IoTDA 网关模式实现
+ */
+
+#include "aquarium_gateway.h"
+#include <string.h>
+
+/* ============================================================================
+ * 初始化与配置
+ * ============================================================================
+ */
+
+AquaError aqua_gateway_init(AquaGateway *gw, const char *gateway_id,
+                            AquariumApp *devices, size_t count) {
+  if (!gw || !gateway_id || !devices) {
+    return AQUA_ERR_NULL_PTR;
+  }
+  if (count == 0) {
+    return AQUA_ERR_MISSING_FIELD;
+  }
+  if (count > AQUA_GATEWAY_MAX_DEVICES) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
+
+  memset(gw, 0, sizeof(AquaGateway));
+  strncpy(gw->gateway_id, gateway_id, DEVICE_ID_MAX_LEN);
+  gw->gateway_id[DEVICE_ID_MAX_LEN] = '\0';
+
+  gw->devices = devices;
+  gw->count = count;
+  gw->report_interval = DEFAULT_REPORT_INTERVAL_SECONDS;
+  gw->report_timer = DEFAULT_REPORT_INTERVAL_SECONDS;
+  return AQUA_OK;
+}
+
+void aqua_gateway_set_report_interval(AquaGateway *gw,
+                                      uint32_t interval_seconds) {
+  if (!gw || interval_seconds == 0)
+    return;
+
+  gw->report_interval = interval_seconds;
+  gw->report_timer = interval_seconds;
+  gw->report_next = 0;
+}
+
+void aqua_gateway_set_utc_time(AquaGateway *gw, uint32_t unix_seconds) {
+  if (!gw)
+    return;
+
+  for (size_t i = 0; i < gw->count; ++i) {
+    aqua_app_set_utc_time(&gw->devices[i], unix_seconds);
+  }
+}
+
+/* ============================================================================
+ * 主循环步进
+ * ============================================================================
+ */
+
+/*
+ * 从 report_next 起编码尽可能多的子设备：先尝试全部剩余子设备，
+ * 缓冲不足时逐个减少，至少要放下一个子设备。
+ */
+static AquaError gateway_build_report(AquaGateway *gw, char *out_payload,
+                                      size_t payload_size, size_t *out_sent) {
+  AquaSubDeviceSample samples[AQUA_GATEWAY_MAX_DEVICES];
+  size_t pending = gw->count - gw->report_next;
+
+  for (size_t i = 0; i < pending; ++i) {
+    const AquariumApp *app = &gw->devices[gw->report_next + i];
+    samples[i].device_id = app->device_id;
+    samples[i].sample.props = app->state.props;
+    samples[i].sample.field_mask = AQUA_PROP_ALL;
+    samples[i].sample.event_time = app->utc_time;
+  }
+
+  for (size_t n = pending; n > 0; --n) {
+    AquaError err = aqua_build_sub_devices_report_json(
+        samples, n, out_payload, payload_size, &gw->report_len);
+    if (err != AQUA_ERR_BUFFER_TOO_SMALL) {
+      *out_sent = n;
+      return err;
+    }
+  }
+  return AQUA_ERR_BUFFER_TOO_SMALL;
+}
+
+AquaError aqua_gateway_step(AquaGateway *gw, uint32_t elapsed_seconds,
+                            ActuatorDesired *out_actuators,
+                            bool *out_has_publish, char *out_topic,
+                            size_t topic_size, char *out_payload,
+                            size_t payload_size) {
+  if (!gw || !out_actuators || !out_has_publish || !out_topic ||
+      !out_payload) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  *out_has_publish = false;
+
+  /* 1. 各子设备的业务逻辑 */
+  for (size_t i = 0; i < gw->count; ++i) {
+    aqua_app_tick(&gw->devices[i], elapsed_seconds, &out_actuators[i]);
+  }
+
+  /* 2. 上报计时 */
+  if (elapsed_seconds < gw->report_timer) {
+    gw->report_timer -= elapsed_seconds;
+    return AQUA_OK;
+  }
+
+  /* 3. 合并上报 */
+  gw->report_len = 0;
+  size_t topic_len = 0;
+  AquaError err = aqua_build_gateway_report_topic(gw->gateway_id, out_topic,
+                                                  topic_size, &topic_len);
+  size_t sent = 0;
+  if (err == AQUA_OK) {
+    err = gateway_build_report(gw, out_payload, payload_size, &sent);
+  }
+  if (err != AQUA_OK) {
+    /* 本轮放弃，下个周期从头重试 */
+    gw->report_next = 0;
+    gw->report_timer = gw->report_interval;
+    return err;
+  }
+
+  *out_has_publish = true;
+  gw->report_next += sent;
+  if (gw->report_next < gw->count) {
+    gw->report_timer = 0; /* 剩余子设备下次立即补发 */
+  } else {
+    gw->report_next = 0;
+    gw->report_timer = gw->report_interval;
+  }
+  return AQUA_OK;
+}
+
+/* ============================================================================
+ * 下行路由
+ * ============================================================================
+ */
+
+AquariumApp *aqua_gateway_find(AquaGateway *gw, const char *device_id) {
+  if (!gw || !device_id)
+    return NULL;
+
+  for (size_t i = 0; i < gw->count; ++i) {
+    if (strcmp(gw->devices[i].device_id, device_id) == 0) {
+      return &gw->devices[i];
+    }
+  }
+  return NULL;
+}
+
+AquariumApp *aqua_gateway_route(AquaGateway *gw, const char *in_payload,
+                                size_t payload_len) {
+  if (!gw || !in_payload)
+    return NULL;
+
+  char target[DEVICE_ID_MAX_LEN + 1];
+  if (aqua_extract_object_device_id(in_payload, payload_len, target,
+                                    sizeof(target)) != AQUA_OK) {
+    /* 缺省或 payload 损坏：交给网关自身，由其回复解析错误 */
+    return aqua_gateway_find(gw, gw->gateway_id);
+  }
+  return aqua_gateway_find(gw, target);
+}
+
+AquaError aqua_gateway_on_mqtt_command(AquaGateway *gw, const char *in_topic,
+                                       const char *in_payload,
+                                       size_t payload_len,
+                                       bool *out_has_response, char *out_topic,
+                                       size_t topic_size, char *out_payload,
+                                       size_t payload_size) {
+  if (!gw || !in_topic || !in_payload || !out_has_response) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  AquariumApp *target = aqua_gateway_route(gw, in_payload, payload_len);
+  if (!target) {
+    *out_has_response = false;
+    return AQUA_ERR_INVALID_COMMAND;
+  }
+  return aqua_app_on_mqtt_command_as(target, gw->gateway_id, in_topic,
+                                     in_payload, payload_len, out_has_response,
+                                     out_topic, topic_size, out_payload,
+                                     payload_size);
+}
+
+/* ============================================================================
+ * 状态访问
+ * ============================================================================
+ */
+
+size_t aqua_gateway_get_report_len(const AquaGateway *gw) {
+  if (!gw)
+    return 0;
+  return gw->report_len;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file aquarium_gateway.h
+ * @brief IoTDA 网关模式：一套固件托管多个水族箱
+ *
+ * 每个水族箱是一个独立的 AquariumApp（各自的传感器通道、阈值与执行器），
+ * 在 IoTDA 中注册为网关的子设备：
+ * - 上报：所有子设备的属性合并为一条消息，发布到
+ *   $oc/devices/{gateway_id}/sys/gateway/sub_devices/properties/report
+ * - 下行：命令、属性设置/查询都发往网关自身的 Topic，按 payload 中的
+ *   object_device_id 路由到对应子设备，响应仍发布到网关的 Topic
+ *
+ * 网关模式下每次上报都是全量属性；增量、批量采样与 CBOR 编码只用于单设备。
+ */
+
+#ifndef AQUARIUM_GATEWAY_H
+#define AQUARIUM_GATEWAY_H
+
+#include "aquarium_app.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 默认配置
+ * ============================================================================
+ */
+
+/* 子设备上限（每个全量采样约 330 B，受上行发布缓冲大小约束） */
+#define AQUA_GATEWAY_MAX_DEVICES 4
+
+/* ============================================================================
+ * 网关上下文
+ * ============================================================================
+ */
+
+typedef struct {
+  /* 网关设备标识 */
+  char gateway_id[DEVICE_ID_MAX_LEN + 1];
+
+  /* 子设备数组（调用方持有，device_id 即子设备 ID） */
+  AquariumApp *devices;
+  size_t count;
+
+  /* 上报配置 */
+  uint32_t report_interval; /* 上报间隔（秒） */
+  uint32_t report_timer;    /* 上报倒计时 */
+  size_t report_next;       /* 本轮上报中下一个待发送的子设备 */
+  size_t report_len;        /* 最近一次生成的上报 payload 字节数 */
+} AquaGateway;
+
+/* ============================================================================
+ * 初始化与配置
+ * ============================================================================
+ */
+
+/**
+ * @brief 初始化网关上下文
+ *
+ * 子设备需事先用 aqua_app_init 以各自的子设备 ID 初始化。
+ * 子设备 ID 与 gateway_id 相同的 AquariumApp 视为网关自身的水族箱，
+ * 接收不带 object_device_id 的下行请求。
+ *
+ * @param gw         网关上下文指针
+ * @param gateway_id 网关设备 ID
+ * @param devices    子设备数组
+ * @param count      子设备个数（1 ~ AQUA_GATEWAY_MAX_DEVICES）
+ * @return AQUA_OK 成功；
+ *         AQUA_ERR_MISSING_FIELD 没有子设备；
+ *         AQUA_ERR_BUFFER_TOO_SMALL 子设备数超过 AQUA_GATEWAY_MAX_DEVICES
+ */
+AquaError aqua_gateway_init(AquaGateway *gw, const char *gateway_id,
+                            AquariumApp *devices, size_t count);
+
+/**
+ * @brief 设置子设备合并上报的间隔
+ *
+ * @param gw               网关上下文指针
+ * @param interval_seconds 上报间隔（秒），默认 30
+ */
+void aqua_gateway_set_report_interval(AquaGateway *gw,
+                                      uint32_t interval_seconds);
+
+/**
+ * @brief 设置所有子设备的 UTC 时间（SNTP 校时后调用）
+ */
+void aqua_gateway_set_utc_time(AquaGateway *gw, uint32_t unix_seconds);
+
+/* ============================================================================
+ * 主循环步进
+ * ============================================================================
+ */
+
+/**
+ * @brief 推进所有子设备并在上报周期到期时生成合并上报
+ *
+ * 各子设备按 aqua_app_tick 推进业务逻辑。上报到期时所有子设备的全量属性
+ * 编码为一条 sub_devices/properties/report 消息；payload 缓冲放不下全部
+ * 子设备时本次只发送能放下的部分，其余在下一次调用时立即补发。
+ *
+ * @param gw              网关上下文指针
+ * @param elapsed_seconds 自上次调用以来经过的秒数
+ * @param out_actuators   [输出] 各子设备的期望执行器状态（count 个）
+ * @param out_has_publish [输出] 是否需要发布消息
+ * @param out_topic       [输出] 发布 Topic 缓冲区
+ * @param topic_size      Topic 缓冲区大小
+ * @param out_payload     [输出] 发布 Payload 缓冲区
+ * @param payload_size    Payload 缓冲区大小
+ * @return AquaError 错误码
+ *
+ * 有上报时 payload 长度由 aqua_gateway_get_report_len 取得。
+ */
+AquaError aqua_gateway_step(AquaGateway *gw, uint32_t elapsed_seconds,
+                            ActuatorDesired *out_actuators,
+                            bool *out_has_publish, char *out_topic,
+                            size_t topic_size, char *out_payload,
+                            size_t payload_size);
+
+/* ============================================================================
+ * 下行路由
+ * ============================================================================
+ */
+
+/**
+ * @brief 按子设备 ID 查找子设备
+ *
+ * @return 子设备指针，未找到返回 NULL
+ */
+AquariumApp *aqua_gateway_find(AquaGateway *gw, const char *device_id);
+
+/**
+ * @brief 确定下行请求的目标子设备
+ *
+ * 取 payload 顶层的 object_device_id；缺省或无法解析时视为发给网关自身
+ * （即子设备 ID 为 gateway_id 的水族箱）。
+ *
+ * @return 目标子设备指针，未找到返回 NULL
+ */
+AquariumApp *aqua_gateway_route(AquaGateway *gw, const char *in_payload,
+                                size_t payload_len);
+
+/**
+ * @brief 处理收到的 MQTT 下行请求并路由到子设备
+ *
+ * 参数与 aqua_app_on_mqtt_command 相同；响应 Topic 使用 gateway_id。
+ * 目标子设备不存在时不回包并返回 AQUA_ERR_INVALID_COMMAND。
+ */
+AquaError aqua_gateway_on_mqtt_command(AquaGateway *gw, const char *in_topic,
+                                       const char *in_payload,
+                                       size_t payload_len,
+                                       bool *out_has_response, char *out_topic,
+                                       size_t topic_size, char *out_payload,
+                                       size_t payload_size);
+
+/* ============================================================================
+ * 状态访问
+ * ============================================================================
+ */
+
+/**
+ * @brief 最近一次 aqua_gateway_step 生成的上报 payload 字节数
+ */
+size_t aqua_gateway_get_report_len(const AquaGateway *gw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AQUARIUM_GATEWAY_H */
@@ -19,60 +19,309 @@ static bool is_final_error(const char *line) {
          (strncmp(line, "+CMS ERROR:", 11) == 0);
 }
 
-static bool is_priority_urc(const char *line, size_t len) {
-  if (!line || len == 0) {
-    return false;
+/* 行首为字面量前缀 lit */
+#define AT_HAS_PREFIX(line, len, lit)                                         \
+  ((len) >= sizeof(lit) - 1 && memcmp((line), (lit), sizeof(lit) - 1) == 0)
+
+/*
+ * URC 前缀树：按区分各前缀的字符逐层展开为 switch，编译器生成跳转表，
+ * 每行只做一次分支查找和少量前缀比较。每层只在上一层前缀已确认后才读取
+ * 下一个区分字符（line 以 '\0' 结尾）。新增类型时在对应层级加 case。
+ */
+static AtUrcType classify_urc(const char *line, size_t len) {
+  switch (line[0]) {
+  case '+':
+    switch (line[1]) {
+    case 'I':
+      return AT_HAS_PREFIX(line, len, "+IPD,") ? AT_URC_IPD : AT_URC_UNKNOWN;
+    case 'C':
+      return AT_HAS_PREFIX(line, len, "+CIPSNTPTIME:") ? AT_URC_SNTP_TIME
+                                                       : AT_URC_UNKNOWN;
+    case 'M':
+      if (!AT_HAS_PREFIX(line, len, "+MQTT"))
+        return AT_URC_UNKNOWN;
+      switch (line[5]) {
+      case 'S':
+        return AT_HAS_PREFIX(line, len, "+MQTTSUBRECV:") ? AT_URC_MQTT_SUBRECV
+                                                         : AT_URC_UNKNOWN;
+      case 'P':
+        if (!AT_HAS_PREFIX(line, len, "+MQTTPUB:"))
+          return AT_URC_UNKNOWN;
+        switch (line[9]) {
+        case 'O':
+          return AT_HAS_PREFIX(line, len, "+MQTTPUB:OK") ? AT_URC_MQTT_PUB_OK
+                                                         : AT_URC_UNKNOWN;
+        case 'F':
+          return AT_HAS_PREFIX(line, len, "+MQTTPUB:FAIL")
+                     ? AT_URC_MQTT_PUB_FAIL
+                     : AT_URC_UNKNOWN;
+        }
+        return AT_URC_UNKNOWN;
+      }
+      return AT_URC_UNKNOWN;
+    }
+    return AT_URC_UNKNOWN;
+  case 'S':
+    if (!AT_HAS_PREFIX(line, len, "SEND "))
+      return AT_URC_UNKNOWN;
+    switch (line[5]) {
+    case 'O':
+      return AT_HAS_PREFIX(line, len, "SEND OK") ? AT_URC_SEND_OK
+                                                 : AT_URC_UNKNOWN;
+    case 'F':
+      return AT_HAS_PREFIX(line, len, "SEND FAIL") ? AT_URC_SEND_FAIL
+                                                   : AT_URC_UNKNOWN;
+    }
+    return AT_URC_UNKNOWN;
   }
+  return AT_URC_UNKNOWN;
+}
 
-  if (len >= 5 && strncmp(line, "+IPD,", 5) == 0) {
+static bool is_priority_urc(AtUrcType type) {
+  switch (type) {
+  case AT_URC_IPD:
+  case AT_URC_MQTT_SUBRECV:
+  case AT_URC_MQTT_PUB_OK:
+  case AT_URC_MQTT_PUB_FAIL:
+  case AT_URC_SEND_OK:
+  case AT_URC_SEND_FAIL:
     return true;
+  default:
+    return false;
   }
-  if (len >= 12 && strncmp(line, "+MQTTSUBRECV:", 12) == 0) {
-    return true;
+}
+
+static AtUrcSlot *urc_slot_at(AtClient *client, size_t n) {
+  return &client->urc_slots[(client->urc_tail + n) % AT_URC_QUEUE_SIZE];
+}
+
+/*
+ * 第 index 个有效行所在的槽位下标（跳过空洞），
+ * 没有则返回 AT_URC_QUEUE_SIZE
+ */
+static size_t urc_find(const AtClient *client, size_t index) {
+  for (size_t n = 0; n < client->urc_used; ++n) {
+    size_t i = (client->urc_tail + n) % AT_URC_QUEUE_SIZE;
+    if (!client->urc_slots[i].valid)
+      continue;
+    if (index == 0)
+      return i;
+    index--;
   }
-  if (len >= 9 && strncmp(line, "+MQTTPUB:", 9) == 0) {
-    return true;
+  return AT_URC_QUEUE_SIZE;
+}
+
+/* 回收队首的空洞；队列清空时存储区从头开始使用 */
+static void urc_reclaim(AtClient *client) {
+  while (client->urc_used > 0 && !urc_slot_at(client, 0)->valid) {
+    client->urc_tail = (client->urc_tail + 1) % AT_URC_QUEUE_SIZE;
+    client->urc_used--;
   }
-  if (strcmp(line, "SEND OK") == 0 || strcmp(line, "SEND FAIL") == 0) {
+  if (client->urc_used == 0) {
+    client->urc_arena_head = 0;
+  }
+}
+
+static void urc_drop(AtClient *client, AtUrcSlot *slot) {
+  slot->valid = false;
+  client->urc_count--;
+  urc_reclaim(client);
+}
+
+/*
+ * 在存储区中为 need 字节找连续空间：从写入位置到末尾放不下时回到开头，
+ * 空闲区止于最旧一行的起点
+ */
+static bool urc_arena_alloc(AtClient *client, size_t need, size_t *out_off) {
+  size_t head = client->urc_arena_head;
+  if (client->urc_used == 0) {
+    *out_off = 0;
     return true;
   }
 
+  size_t oldest = urc_slot_at(client, 0)->offset;
+  if (head > oldest) {
+    if (need <= AT_URC_ARENA_SIZE - head) {
+      *out_off = head;
+      return true;
+    }
+    if (need <= oldest) {
+      *out_off = 0;
+      return true;
+    }
+  } else if (head < oldest && need <= oldest - head) {
+    *out_off = head;
+    return true;
+  }
   return false;
 }
 
-static void push_urc(AtClient *client, const char *line, size_t len) {
-  if (client->urc_count >= AT_URC_QUEUE_SIZE) {
+static void push_urc(AtClient *client, const char *line, size_t len,
+                     uint16_t raw_id) {
+  size_t copy_len = (len > AT_LINE_MAX_LEN) ? AT_LINE_MAX_LEN : len;
+  AtUrcType type = classify_urc(line, copy_len);
+
+  AtUrcHandler handler = client->urc_handlers[type];
+  if (handler) {
+    AtLineView view = {line, copy_len, raw_id, type};
+    if (handler(&view, client->urc_handler_data[type]))
+      return;
+  }
+
+  bool incoming_priority = is_priority_urc(type);
+  size_t off = 0;
+
+  while (client->urc_used >= AT_URC_QUEUE_SIZE ||
+         !urc_arena_alloc(client, copy_len + 1, &off)) {
     /*
-     * URC 队列满时保护高优先级事件（如 +IPD / SEND OK）：
+     * 槽位或存储区满时保护高优先级事件（如 +IPD / SEND OK）：
      * - 若最旧元素是高优先级且新元素不是，则丢弃新元素，避免 HTTP 请求头把 +IPD 挤掉。
-     * - 其他情况保持原策略，丢弃最旧元素。
+     * - 其他情况保持原策略，丢弃最旧元素，直到放得下。
      */
-    size_t oldest_idx = client->urc_tail;
-    AtLine *oldest = &client->urc_queue[oldest_idx];
-    bool oldest_priority = oldest->valid &&
-                           is_priority_urc(oldest->data, oldest->len);
-    bool incoming_priority = is_priority_urc(line, len);
-
-    if (oldest_priority && !incoming_priority) {
+    AtUrcSlot *oldest = urc_slot_at(client, 0);
+    client->stats.urc_drops++;
+    if (is_priority_urc((AtUrcType)oldest->type) && !incoming_priority) {
       return;
     }
-
-    client->urc_tail = (client->urc_tail + 1) % AT_URC_QUEUE_SIZE;
-    client->urc_count--;
+    urc_drop(client, oldest);
   }
 
-  AtLine *urc = &client->urc_queue[client->urc_head];
-  size_t copy_len = (len > AT_LINE_MAX_LEN) ? AT_LINE_MAX_LEN : len;
-  memcpy(urc->data, line, copy_len);
-  urc->data[copy_len] = '\0';
-  urc->len = copy_len;
-  urc->valid = true;
+  memcpy(client->urc_arena + off, line, copy_len);
+  client->urc_arena[off + copy_len] = '\0';
+  client->urc_arena_head = off + copy_len + 1;
+
+  AtUrcSlot *slot = &client->urc_slots[client->urc_head];
+  slot->offset = (uint16_t)off;
+  slot->len = (uint16_t)copy_len;
+  slot->raw_id = raw_id;
+  slot->type = (uint8_t)type;
+  slot->valid = true;
 
   client->urc_head = (client->urc_head + 1) % AT_URC_QUEUE_SIZE;
+  client->urc_used++;
   client->urc_count++;
 }
 
-static void process_line(AtClient *client, const char *line, size_t len) {
+/* ============================================================================
+ * 自适应超时
+ * ============================================================================
+ */
+
+/*
+ * 按命令前缀归类：入网耗时取决于 AP 扫描与认证；LOCAL 只收录已知立即
+ * 应答的命令，PROMPT 只计到 '>' 为止，未列出的命令归入不做估计的 CONFIG
+ */
+static AtCmdClass classify_cmd(const char *cmd, size_t len) {
+  if (AT_HAS_PREFIX(cmd, len, "AT+CWJAP"))
+    return AT_CMD_CLASS_FIXED;
+  if (AT_HAS_PREFIX(cmd, len, "AT+MQTTCONN") ||
+      AT_HAS_PREFIX(cmd, len, "AT+MQTTSUB"))
+    return AT_CMD_CLASS_MQTT;
+  if (AT_HAS_PREFIX(cmd, len, "AT+MQTTPUBRAW") ||
+      AT_HAS_PREFIX(cmd, len, "AT+CIPSEND"))
+    return AT_CMD_CLASS_PROMPT;
+  if ((len == 2 && memcmp(cmd, "AT", 2) == 0) ||
+      AT_HAS_PREFIX(cmd, len, "ATE") || AT_HAS_PREFIX(cmd, len, "AT+GMR") ||
+      AT_HAS_PREFIX(cmd, len, "AT+CIPSNTPTIME?"))
+    return AT_CMD_CLASS_LOCAL;
+  return AT_CMD_CLASS_CONFIG;
+}
+
+/* 只有延迟稳定的类别做自适应估计 */
+static bool class_is_adaptive(AtCmdClass cls) {
+  return cls == AT_CMD_CLASS_LOCAL || cls == AT_CMD_CLASS_MQTT ||
+         cls == AT_CMD_CLASS_PROMPT;
+}
+
+/*
+ * 按时应答的样本：Jacobson 定点更新（RFC 6298 的 alpha = 1/8、beta = 1/4），
+ * 先用旧的 SRTT 更新 RTTVAR；同时清除退避
+ */
+static void rtt_sample(AtRttStats *rtt, uint32_t sample_ms) {
+  if (rtt->samples == 0) {
+    rtt->srtt_x8 = sample_ms << 3;
+    rtt->rttvar_x4 = sample_ms << 1; /* RTTVAR = R / 2 */
+  } else {
+    uint32_t srtt = rtt->srtt_x8 >> 3;
+    uint32_t err = (sample_ms > srtt) ? sample_ms - srtt : srtt - sample_ms;
+    rtt->rttvar_x4 = rtt->rttvar_x4 - (rtt->rttvar_x4 >> 2) + err;
+    rtt->srtt_x8 = rtt->srtt_x8 - (rtt->srtt_x8 >> 3) + sample_ms;
+  }
+  if (rtt->samples < UINT16_MAX) {
+    rtt->samples++;
+  }
+  rtt->backoff = 0;
+}
+
+uint32_t aqua_at_timeout_for(const AtClient *client, AtCmdClass cls,
+                             uint32_t cap_ms) {
+  if (!client || !class_is_adaptive(cls))
+    return cap_ms;
+
+  const AtRttStats *rtt = &client->rtt[cls];
+  if (rtt->samples == 0)
+    return cap_ms;
+
+  /* SRTT + 4 * RTTVAR，rttvar_x4 恰好是 4 * RTTVAR */
+  uint32_t rto = (rtt->srtt_x8 >> 3) + rtt->rttvar_x4;
+  if (rto < AT_RTO_MIN_MS) {
+    rto = AT_RTO_MIN_MS;
+  }
+  rto <<= rtt->backoff;
+  return (rto < cap_ms) ? rto : cap_ms;
+}
+
+/* 延迟所在的 log2 桶：即延迟的二进制位数，超出的归入最后一桶 */
+static size_t latency_bucket(uint32_t latency_ms) {
+  size_t bucket = 0;
+  while (latency_ms != 0 && bucket < AT_LATENCY_HIST_BUCKETS - 1) {
+    latency_ms >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+/*
+ * 当前命令以 result 结束（终止响应、提示符或超时）：计入所属类别的统计，
+ * 并更新延迟估计
+ */
+static void at_finish(AtClient *client, AtState result) {
+  AtCmdClass cls = (client->cmd_class < AT_CMD_CLASS_COUNT)
+                       ? client->cmd_class
+                       : AT_CMD_CLASS_FIXED;
+  uint32_t latency_ms = client->now_ms_func() - client->cmd_start_ms;
+  AtCmdStats *stats = &client->stats.cmd[cls];
+
+  client->state = result;
+  if (result == AT_STATE_DONE_TIMEOUT) {
+    stats->timeout++;
+  } else {
+    if (result == AT_STATE_DONE_ERROR) {
+      stats->error++;
+    } else {
+      stats->ok++;
+    }
+    stats->latency_hist[latency_bucket(latency_ms)]++;
+  }
+
+  if (!class_is_adaptive(cls))
+    return;
+
+  AtRttStats *rtt = &client->rtt[cls];
+  if (result == AT_STATE_DONE_TIMEOUT) {
+    /* 超时不知道真实延迟，不取样本，只退避（Karn 算法） */
+    if (rtt->backoff < AT_RTO_MAX_BACKOFF) {
+      rtt->backoff++;
+    }
+  } else {
+    rtt_sample(rtt, latency_ms);
+  }
+}
+
+static void at_cmd_complete(AtClient *client);
+
+static void process_line(AtClient *client, const char *line, size_t len,
+                         uint16_t raw_id) {
   /* 跳过空行 */
   if (len == 0)
     return;
@@ -84,13 +333,13 @@ static void process_line(AtClient *client, const char *line, size_t len) {
         /* 正在等待 > 提示符，OK 只是中间响应，继续等待 */
         client->got_ok = true;
       } else {
-        client->state = AT_STATE_DONE_OK;
+        at_finish(client, AT_STATE_DONE_OK);
       }
     } else if (is_final_error(line)) {
-      client->state = AT_STATE_DONE_ERROR;
+      at_finish(client, AT_STATE_DONE_ERROR);
     } else if (len == 1 && line[0] == '>') {
       /* AT+CIPSEND / AT+MQTTPUBRAW 的数据输入提示 */
-      client->state = AT_STATE_GOT_PROMPT;
+      at_finish(client, AT_STATE_GOT_PROMPT);
     } else {
       /* 非终止行，作为命令响应（保留第一个非空响应） */
       if (!client->cmd_response.valid) {
@@ -105,12 +354,15 @@ static void process_line(AtClient *client, const char *line, size_t len) {
        * 同步放入 URC 队列，避免命令执行期间到来的异步事件（如 MQTT
        * 下行）被丢弃。 后续上层可按前缀/格式自行区分 URC 与多行命令响应。
        */
-      push_urc(client, line, len);
+      push_urc(client, line, len, raw_id);
     }
   } else {
     /* 空闲状态，放入 URC 队列 */
-    push_urc(client, line, len);
+    push_urc(client, line, len, raw_id);
   }
+
+  /* 排队命令收到终止响应：立即回调并发出下一条 */
+  at_cmd_complete(client);
 }
 
 /* ============================================================================
@@ -137,70 +389,360 @@ AtError aqua_at_init(AtClient *client, AtWriteFunc write_fn,
  * ============================================================================
  */
 
+/* 按机器字宽一次检查多个字节 */
+typedef size_t AtWord;
+
+#define AT_WORD_ONES ((AtWord)-1 / 0xFF) /* 0x0101...01 */
+#define AT_WORD_HIGHS (AT_WORD_ONES * 0x80)
+
+/* 字中存在 0 字节时非 0（经典 haszero 位技巧） */
+#define AT_WORD_HAS_ZERO(w) (((w) - AT_WORD_ONES) & ~(w) & AT_WORD_HIGHS)
+
+#ifdef UNIT_TEST
+uint32_t aqua_at_scan_steps;
+#define AT_SCAN_STEP() (aqua_at_scan_steps++)
+#else
+#define AT_SCAN_STEP() ((void)0)
+#endif
+
+/*
+ * 返回 data[0, len) 中第一个 CR 或 LF 的下标，没有则返回 len。
+ * 对齐后按字扫描，命中的字再逐字节定位，与字节序无关。
+ */
+static size_t find_line_end(const uint8_t *data, size_t len) {
+  size_t i = 0;
+
+  while (i < len && ((uintptr_t)(data + i) % sizeof(AtWord)) != 0) {
+    AT_SCAN_STEP();
+    if (data[i] == '\r' || data[i] == '\n')
+      return i;
+    i++;
+  }
+
+  for (; i + sizeof(AtWord) <= len; i += sizeof(AtWord)) {
+    AT_SCAN_STEP();
+    AtWord w;
+    memcpy(&w, data + i, sizeof(w));
+    AtWord cr = w ^ (AT_WORD_ONES * '\r');
+    AtWord lf = w ^ (AT_WORD_ONES * '\n');
+    if (AT_WORD_HAS_ZERO(cr) | AT_WORD_HAS_ZERO(lf))
+      break;
+  }
+
+  while (i < len && data[i] != '\r' && data[i] != '\n') {
+    AT_SCAN_STEP();
+    i++;
+  }
+  return i;
+}
+
+static void flush_line(AtClient *client) {
+  client->line_buffer[client->line_pos] = '\0';
+  process_line(client, client->line_buffer, client->line_pos, 0);
+  client->line_pos = 0;
+  client->line_overflowed = false;
+  client->raw_checked = false;
+}
+
+/* ============================================================================
+ * +MQTTSUBRECV 原始捕获
+ * ============================================================================
+ */
+
+#define AT_SUBRECV_PREFIX "+MQTTSUBRECV:"
+#define AT_SUBRECV_PREFIX_LEN 13
+
+/*
+ * 解析行首的 +MQTTSUBRECV:<id>,"<topic>",<len>, 头部
+ * 返回头部长度（含 <len> 后的逗号）；0 表示头部尚不完整；-1 表示格式不符
+ */
+static int parse_subrecv_header(const char *buf, size_t len,
+                                size_t *out_data_len) {
+  size_t i = AT_SUBRECV_PREFIX_LEN;
+  size_t start = i;
+
+  /* <id> */
+  while (i < len && buf[i] >= '0' && buf[i] <= '9') {
+    AT_SCAN_STEP();
+    i++;
+  }
+  if (i == len)
+    return 0;
+  if (i == start || buf[i] != ',')
+    return -1;
+  i++;
+
+  /* "<topic>" */
+  if (i == len)
+    return 0;
+  if (buf[i] != '"')
+    return -1;
+  i++;
+  while (i < len && buf[i] != '"') {
+    AT_SCAN_STEP();
+    i++;
+  }
+  if (i + 1 >= len)
+    return 0;
+  i++;
+  if (buf[i] != ',')
+    return -1;
+  i++;
+
+  /* <len>：超过捕获上限后不再累加，超长数字串不会溢出 */
+  size_t data_len = 0;
+  start = i;
+  while (i < len && buf[i] >= '0' && buf[i] <= '9') {
+    AT_SCAN_STEP();
+    if (data_len <= AT_RAW_PAYLOAD_MAX_LEN) {
+      data_len = data_len * 10 + (size_t)(buf[i] - '0');
+    }
+    i++;
+  }
+  if (i == len)
+    return 0;
+  if (i == start || buf[i] != ',')
+    return -1;
+
+  *out_data_len = data_len;
+  return (int)(i + 1);
+}
+
+/* 上一次捕获的 payload 是否仍被 URC 队列中的行引用 */
+static bool raw_payload_in_use(const AtClient *client) {
+  if (client->raw_id == 0)
+    return false;
+  for (size_t n = 0; n < client->urc_used; ++n) {
+    const AtUrcSlot *slot =
+        &client->urc_slots[(client->urc_tail + n) % AT_URC_QUEUE_SIZE];
+    if (slot->valid && slot->raw_id == client->raw_id)
+      return true;
+  }
+  return false;
+}
+
+/* payload 收齐：头部作为一行 URC 入队，随后回到行模式 */
+static void finish_raw_capture(AtClient *client) {
+  client->raw_payload[client->raw_len] = '\0';
+  client->line_buffer[client->line_pos] = '\0';
+  process_line(client, client->line_buffer, client->line_pos, client->raw_id);
+  client->line_pos = 0;
+  client->raw_checked = false;
+}
+
+/*
+ * 当前行是 +MQTTSUBRECV 头部且已完整时切换到原始捕获：
+ * 行缓冲中头部之后的字节移入 raw_payload，行缓冲只保留头部。
+ * 返回 true 表示已进入（或已完成）捕获。
+ */
+static bool try_start_raw_capture(AtClient *client) {
+  if (client->raw_checked || client->line_pos == 0)
+    return false;
+
+  const char *line = client->line_buffer;
+  size_t pos = client->line_pos;
+  size_t prefix = (pos < AT_SUBRECV_PREFIX_LEN) ? pos : AT_SUBRECV_PREFIX_LEN;
+  if (memcmp(line, AT_SUBRECV_PREFIX, prefix) != 0) {
+    client->raw_checked = true;
+    return false;
+  }
+  if (pos < AT_SUBRECV_PREFIX_LEN)
+    return false;
+
+  size_t data_len = 0;
+  int header_len = parse_subrecv_header(line, pos, &data_len);
+  if (header_len == 0) {
+    return false;
+  }
+  if (header_len < 0 || data_len == 0 || data_len > AT_RAW_PAYLOAD_MAX_LEN ||
+      raw_payload_in_use(client)) {
+    /* 交给普通行处理（payload 受行长限制） */
+    client->raw_checked = true;
+    return false;
+  }
+
+  client->raw_id = (uint16_t)(client->raw_id + 1);
+  if (client->raw_id == 0) {
+    client->raw_id = 1;
+  }
+
+  size_t extra = pos - (size_t)header_len;
+  size_t take = (extra < data_len) ? extra : data_len;
+  memcpy(client->raw_payload, line + header_len, take);
+  client->raw_len = take;
+  client->raw_remaining = data_len - take;
+  client->raw_last_ms = client->now_ms_func();
+  client->line_pos = (size_t)header_len;
+
+  if (client->raw_remaining == 0) {
+    /* payload 已全部在本段中：头部入队，多出的字节作为下一行的开头 */
+    size_t rest = extra - take;
+    finish_raw_capture(client);
+    memmove(client->line_buffer, line + header_len + take, rest);
+    client->line_pos = rest;
+  }
+  return true;
+}
+
 AtError aqua_at_feed_rx(AtClient *client, const uint8_t *data, size_t len) {
   if (!client || !data) {
     return AT_ERR_NULL_PTR;
   }
 
   AtError result = AT_OK;
+  size_t i = 0;
+
+  while (i < len) {
+    AT_SCAN_STEP();
+    /* 原始捕获：按长度整段拷贝，不做行切分 */
+    if (client->raw_remaining > 0) {
+      size_t n = len - i;
+      if (n > client->raw_remaining)
+        n = client->raw_remaining;
+      memcpy(client->raw_payload + client->raw_len, data + i, n);
+      client->raw_len += n;
+      client->raw_remaining -= n;
+      client->raw_last_ms = client->now_ms_func();
+      i += n;
+      if (client->raw_remaining == 0) {
+        finish_raw_capture(client);
+      }
+      continue;
+    }
 
-  for (size_t i = 0; i < len; i++) {
     uint8_t ch = data[i];
 
     /* 处理 CRLF */
     if (ch == '\r') {
       client->last_was_cr = true;
+      i++;
       continue;
     }
 
     if (ch == '\n') {
       if (client->last_was_cr || client->line_pos > 0) {
         /* 行结束，处理行 */
-        client->line_buffer[client->line_pos] = '\0';
-        process_line(client, client->line_buffer, client->line_pos);
-        client->line_pos = 0;
+        flush_line(client);
       }
       client->last_was_cr = false;
+      i++;
       continue;
     }
 
     /* 如果之前有单独的 CR，先处理 */
     if (client->last_was_cr) {
-      client->line_buffer[client->line_pos] = '\0';
-      process_line(client, client->line_buffer, client->line_pos);
-      client->line_pos = 0;
+      flush_line(client);
       client->last_was_cr = false;
     }
 
-    /* 追加字符到行缓冲区 */
-    if (client->line_pos < AT_LINE_MAX_LEN) {
-      client->line_buffer[client->line_pos++] = (char)ch;
+    /*
+     * 支持"裸 >"（不带 CRLF）：
+     * 如果正在等待 > 提示符，且行首字符是 '>'，立即触发处理
+     * 这样即使 ESP-AT 不输出 CRLF 也能正确识别
+     */
+    if (client->expect_prompt && client->line_pos == 0 && ch == '>') {
+      client->line_buffer[0] = '>';
+      client->line_pos = 1;
+      flush_line(client);
+      i++;
+      continue;
+    }
 
-      /*
-       * 支持"裸 >"（不带 CRLF）：
-       * 如果正在等待 > 提示符，且当前只有一个字符 '>'，立即触发处理
-       * 这样即使 ESP-AT 不输出 CRLF 也能正确识别
-       */
-      if (client->expect_prompt && client->line_pos == 1 && ch == '>') {
-        client->line_buffer[1] = '\0';
-        process_line(client, client->line_buffer, 1);
-        client->line_pos = 0;
-      }
-    } else {
+    /* 整段追加到下一个 CR/LF 为止 */
+    size_t run = find_line_end(data + i, len - i);
+    size_t room = AT_LINE_MAX_LEN - client->line_pos;
+    size_t copy = (run > room) ? room : run;
+    memcpy(client->line_buffer + client->line_pos, data + i, copy);
+    client->line_pos += copy;
+    if (try_start_raw_capture(client)) {
+      /* 本段未拷入行缓冲的部分属于 payload，下一轮按捕获模式处理 */
+      i += copy;
+      continue;
+    }
+    if (run > room) {
       /* 行过长，标记但继续接收 */
       result = AT_ERR_LINE_TOO_LONG;
+      if (!client->line_overflowed) {
+        client->line_overflowed = true;
+        client->stats.line_overflows++;
+      }
     }
+    i += run;
   }
 
   return result;
 }
 
+AtError aqua_at_feed_rx_spans(AtClient *client, const uint8_t *first,
+                              size_t first_len, const uint8_t *second,
+                              size_t second_len) {
+  if (!client || (!first && first_len > 0) || (!second && second_len > 0)) {
+    return AT_ERR_NULL_PTR;
+  }
+
+  AtError result = AT_OK;
+  if (first_len > 0) {
+    result = aqua_at_feed_rx(client, first, first_len);
+  }
+  if (second_len > 0) {
+    AtError err = aqua_at_feed_rx(client, second, second_len);
+    if (result == AT_OK) {
+      result = err;
+    }
+  }
+  return result;
+}
+
 /* ============================================================================
  * 命令发送
  * ============================================================================
  */
 
-AtError aqua_at_begin(AtClient *client, const char *cmd, uint32_t timeout_ms) {
+/*
+ * 把待发送数据尽量交给写回调：先原始数据再命令行，
+ * 写回调返回 0 表示发送队列已满，留待下次 step 重试
+ */
+static void at_tx_flush(AtClient *client) {
+  size_t pending = client->tx_data_len + client->tx_len;
+  if (pending == 0)
+    return;
+
+  while (client->tx_data_len > 0) {
+    size_t n = client->write_func(client->tx_data, client->tx_data_len);
+    if (n == 0)
+      return;
+    if (n > client->tx_data_len)
+      n = client->tx_data_len;
+    client->tx_data += n;
+    client->tx_data_len -= n;
+  }
+  if (client->tx_data_len == 0) {
+    client->tx_data = NULL;
+  }
+
+  size_t sent = 0;
+  while (sent < client->tx_len) {
+    size_t n = client->write_func(client->tx_buffer + sent,
+                                  client->tx_len - sent);
+    if (n == 0)
+      break;
+    sent += (n > client->tx_len - sent) ? client->tx_len - sent : n;
+  }
+  if (sent > 0) {
+    memmove(client->tx_buffer, client->tx_buffer + sent,
+            client->tx_len - sent);
+    client->tx_len -= sent;
+  }
+
+  /* 曾被阻塞的数据刚好发完：超时从此刻起算，排队时间不计入 */
+  if (client->tx_data_len + client->tx_len == 0 &&
+      client->state == AT_STATE_WAITING) {
+    client->cmd_start_ms = client->now_ms_func();
+  }
+}
+
+static AtError at_begin(AtClient *client, const char *cmd, uint32_t timeout_ms,
+                        bool expect_prompt) {
   if (!client || !cmd) {
     return AT_ERR_NULL_PTR;
   }
@@ -209,52 +751,181 @@ AtError aqua_at_begin(AtClient *client, const char *cmd, uint32_t timeout_ms) {
     return AT_ERR_BUSY;
   }
 
+  /* 命令行与 \r\n 拼在一起，一次写出；接在未发完的数据之后 */
+  size_t cmd_len = strlen(cmd);
+  if (client->tx_len + cmd_len + 2 > AT_TX_BUFFER_SIZE) {
+    return AT_ERR_BUFFER_FULL;
+  }
+  memcpy(client->tx_buffer + client->tx_len, cmd, cmd_len);
+  memcpy(client->tx_buffer + client->tx_len + cmd_len, "\r\n", 2);
+  client->tx_len += cmd_len + 2;
+
   /* 清空之前的响应和 prompt 状态 */
   memset(&client->cmd_response, 0, sizeof(AtLine));
-  client->expect_prompt = false;
+  client->expect_prompt = expect_prompt;
   client->got_ok = false;
 
-  /* 发送命令 */
-  size_t cmd_len = strlen(cmd);
-  client->write_func((const uint8_t *)cmd, cmd_len);
-  client->write_func((const uint8_t *)"\r\n", 2);
-
   /* 设置状态 */
   client->state = AT_STATE_WAITING;
   client->cmd_start_ms = client->now_ms_func();
-  client->cmd_timeout_ms = timeout_ms;
+  client->cmd_class = classify_cmd(cmd, cmd_len);
+  client->cmd_timeout_ms =
+      aqua_at_timeout_for(client, client->cmd_class, timeout_ms);
+
+  /* 发送命令 */
+  at_tx_flush(client);
 
   return AT_OK;
 }
 
+AtError aqua_at_begin(AtClient *client, const char *cmd, uint32_t timeout_ms) {
+  return at_begin(client, cmd, timeout_ms, false);
+}
+
 AtError aqua_at_begin_with_prompt(AtClient *client, const char *cmd,
                                   uint32_t timeout_ms) {
+  /* 期待 > 提示符 */
+  return at_begin(client, cmd, timeout_ms, true);
+}
+
+/* ============================================================================
+ * 命令队列
+ * ============================================================================
+ */
+
+/* 客户端空闲时发出队首命令；命令行暂存不下时留在队首，由 step 重试 */
+static void at_queue_start_next(AtClient *client) {
+  if (client->state != AT_STATE_IDLE || client->cmd_queue_count == 0)
+    return;
+
+  AtCmdEntry head = client->cmd_queue[0];
+  if (at_begin(client, client->cmd_pool, head.timeout_ms,
+               head.expect_prompt) != AT_OK) {
+    return;
+  }
+  client->cmd_cb = head.cb;
+  client->cmd_cb_data = head.user_data;
+
+  /* 出队：文本与条目整体前移，队首保持在开头 */
+  size_t used = (size_t)head.len + 1;
+  client->cmd_pool_used -= used;
+  memmove(client->cmd_pool, client->cmd_pool + used, client->cmd_pool_used);
+  client->cmd_queue_count--;
+  memmove(client->cmd_queue, client->cmd_queue + 1,
+          client->cmd_queue_count * sizeof(AtCmdEntry));
+}
+
+/*
+ * 带回调的排队命令已结束（或收到 > 提示符）时调用回调；回调没有自行发起
+ * 新命令时复位并发出下一条
+ */
+static void at_cmd_complete(AtClient *client) {
+  AtState result = client->state;
+  if (!client->cmd_cb || result == AT_STATE_IDLE ||
+      result == AT_STATE_WAITING) {
+    return;
+  }
+
+  AtCmdCallback cb = client->cmd_cb;
+  void *user_data = client->cmd_cb_data;
+  client->cmd_cb = NULL;
+  client->cmd_cb_data = NULL;
+  cb(result, aqua_at_get_response(client), user_data);
+
+  if (result != AT_STATE_GOT_PROMPT && client->state == result) {
+    aqua_at_reset(client);
+  }
+}
+
+AtError aqua_at_enqueue(AtClient *client, const char *cmd, uint32_t timeout_ms,
+                        bool expect_prompt, AtCmdCallback cb,
+                        void *user_data) {
   if (!client || !cmd) {
     return AT_ERR_NULL_PTR;
   }
 
-  if (client->state == AT_STATE_WAITING) {
-    return AT_ERR_BUSY;
+  size_t cmd_len = strlen(cmd);
+  if (client->cmd_queue_count >= AT_CMD_QUEUE_SIZE ||
+      client->cmd_pool_used + cmd_len + 1 > AT_CMD_POOL_SIZE) {
+    return AT_ERR_BUFFER_FULL;
   }
 
-  /* 清空之前的响应 */
-  memset(&client->cmd_response, 0, sizeof(AtLine));
-  client->expect_prompt = true; /* 期待 > 提示符 */
-  client->got_ok = false;
+  memcpy(client->cmd_pool + client->cmd_pool_used, cmd, cmd_len + 1);
+  client->cmd_pool_used += cmd_len + 1;
 
-  /* 发送命令 */
-  size_t cmd_len = strlen(cmd);
-  client->write_func((const uint8_t *)cmd, cmd_len);
-  client->write_func((const uint8_t *)"\r\n", 2);
+  AtCmdEntry *entry = &client->cmd_queue[client->cmd_queue_count++];
+  entry->len = (uint16_t)cmd_len;
+  entry->expect_prompt = expect_prompt;
+  entry->timeout_ms = timeout_ms;
+  entry->cb = cb;
+  entry->user_data = user_data;
+
+  at_queue_start_next(client);
+  return AT_OK;
+}
+
+void aqua_at_cancel_queue(AtClient *client) {
+  if (!client)
+    return;
+  client->cmd_queue_count = 0;
+  client->cmd_pool_used = 0;
+  client->cmd_cb = NULL;
+  client->cmd_cb_data = NULL;
+}
+
+size_t aqua_at_queue_pending(const AtClient *client) {
+  if (!client)
+    return 0;
+  return client->cmd_queue_count;
+}
+
+void aqua_at_await_result(AtClient *client, AtCmdClass cls, uint32_t cap_ms) {
+  if (!client)
+    return;
+  if (cls >= AT_CMD_CLASS_COUNT) {
+    cls = AT_CMD_CLASS_FIXED;
+  }
 
-  /* 设置状态 */
   client->state = AT_STATE_WAITING;
+  client->expect_prompt = false;
+  client->got_ok = false;
+  client->cmd_class = cls;
   client->cmd_start_ms = client->now_ms_func();
-  client->cmd_timeout_ms = timeout_ms;
+  client->cmd_timeout_ms = aqua_at_timeout_for(client, cls, cap_ms);
+}
+
+void aqua_at_complete(AtClient *client, AtState result) {
+  if (!client || client->state != AT_STATE_WAITING)
+    return;
+  if (result != AT_STATE_DONE_OK && result != AT_STATE_DONE_ERROR)
+    return;
+
+  at_finish(client, result);
+  at_cmd_complete(client);
+}
+
+AtError aqua_at_send_data(AtClient *client, const uint8_t *data, size_t len) {
+  if (!client || !data) {
+    return AT_ERR_NULL_PTR;
+  }
+
+  if (client->tx_data_len + client->tx_len > 0) {
+    return AT_ERR_BUSY;
+  }
+
+  client->tx_data = data;
+  client->tx_data_len = len;
+  at_tx_flush(client);
 
   return AT_OK;
 }
 
+size_t aqua_at_tx_pending(const AtClient *client) {
+  if (!client)
+    return 0;
+  return client->tx_data_len + client->tx_len;
+}
+
 /* ============================================================================
  * 状态推进
  * ============================================================================
@@ -265,13 +936,26 @@ AtState aqua_at_step(AtClient *client) {
     return AT_STATE_IDLE;
   }
 
+  /* 续发写回调上次未接收的数据，以及上次暂存不下的排队命令 */
+  at_tx_flush(client);
+  at_queue_start_next(client);
+
+  /* 原始捕获断流（如 UART 丢字节）：按已收部分交付，避免吞掉后续行 */
+  if (client->raw_remaining > 0 &&
+      client->now_ms_func() - client->raw_last_ms >=
+          AT_RAW_CAPTURE_TIMEOUT_MS) {
+    client->raw_remaining = 0;
+    finish_raw_capture(client);
+  }
+
   if (client->state == AT_STATE_WAITING) {
     /* 检查超时 */
     uint32_t now = client->now_ms_func();
     uint32_t elapsed = now - client->cmd_start_ms;
 
     if (elapsed >= client->cmd_timeout_ms) {
-      client->state = AT_STATE_DONE_TIMEOUT;
+      at_finish(client, AT_STATE_DONE_TIMEOUT);
+      at_cmd_complete(client);
     }
   }
 
@@ -305,6 +989,7 @@ void aqua_at_reset(AtClient *client) {
   client->expect_prompt = false;
   client->got_ok = false;
   memset(&client->cmd_response, 0, sizeof(AtLine));
+  at_queue_start_next(client);
 }
 
 /* ============================================================================
@@ -318,21 +1003,202 @@ bool aqua_at_has_urc(const AtClient *client) {
   return client->urc_count > 0;
 }
 
-AtError aqua_at_pop_line(AtClient *client, AtLine *out) {
+void aqua_at_set_urc_handler(AtClient *client, AtUrcType type,
+                             AtUrcHandler handler, void *user_data) {
+  if (!client || (unsigned)type >= AT_URC_TYPE_COUNT)
+    return;
+  client->urc_handlers[type] = handler;
+  client->urc_handler_data[type] = user_data;
+}
+
+AtError aqua_at_peek_line(const AtClient *client, size_t index,
+                          AtLineView *out) {
   if (!client || !out) {
     return AT_ERR_NULL_PTR;
   }
 
-  if (client->urc_count == 0) {
+  size_t i = urc_find(client, index);
+  if (i == AT_URC_QUEUE_SIZE) {
     return AT_ERR_NO_LINE;
   }
 
-  AtLine *urc = &client->urc_queue[client->urc_tail];
-  memcpy(out, urc, sizeof(AtLine));
-  urc->valid = false;
+  const AtUrcSlot *slot = &client->urc_slots[i];
+  out->data = client->urc_arena + slot->offset;
+  out->len = slot->len;
+  out->raw_id = slot->raw_id;
+  out->type = (AtUrcType)slot->type;
+  return AT_OK;
+}
 
-  client->urc_tail = (client->urc_tail + 1) % AT_URC_QUEUE_SIZE;
-  client->urc_count--;
+AtError aqua_at_consume_line(AtClient *client, size_t index) {
+  if (!client) {
+    return AT_ERR_NULL_PTR;
+  }
 
+  size_t i = urc_find(client, index);
+  if (i == AT_URC_QUEUE_SIZE) {
+    return AT_ERR_NO_LINE;
+  }
+
+  urc_drop(client, &client->urc_slots[i]);
   return AT_OK;
 }
+
+AtError aqua_at_pop_line(AtClient *client, AtLine *out) {
+  if (!client || !out) {
+    return AT_ERR_NULL_PTR;
+  }
+
+  AtLineView view;
+  if (aqua_at_peek_line(client, 0, &view) != AT_OK) {
+    return AT_ERR_NO_LINE;
+  }
+
+  memcpy(out->data, view.data, view.len + 1);
+  out->len = view.len;
+  out->valid = true;
+  out->raw_id = view.raw_id;
+  out->type = view.type;
+
+  return aqua_at_consume_line(client, 0);
+}
+
+const char *aqua_at_get_raw_payload(const AtClient *client, uint16_t raw_id,
+                                    size_t *out_len) {
+  if (!client || raw_id == 0 || raw_id != client->raw_id ||
+      client->raw_remaining > 0) {
+    return NULL;
+  }
+  if (out_len) {
+    *out_len = client->raw_len;
+  }
+  return client->raw_payload;
+}
+
+/* ============================================================================
+ * 运行统计
+ * ============================================================================
+ */
+
+const AtStats *aqua_at_get_stats(const AtClient *client) {
+  if (!client)
+    return NULL;
+  return &client->stats;
+}
+
+void aqua_at_stats_snapshot(AtClient *client, AtStats *out, bool reset) {
+  if (!client || !out)
+    return;
+  memcpy(out, &client->stats, sizeof(AtStats));
+  if (reset) {
+    memset(&client->stats, 0, sizeof(AtStats));
+  }
+}
+
+uint32_t aqua_at_latency_percentile(const AtCmdStats *stats,
+                                    uint32_t percent) {
+  if (!stats)
+    return 0;
+
+  uint64_t total = 0;
+  for (size_t b = 0; b < AT_LATENCY_HIST_BUCKETS; ++b) {
+    total += stats->latency_hist[b];
+  }
+  if (total == 0)
+    return 0;
+
+  if (percent > 100) {
+    percent = 100;
+  }
+  uint64_t target = (total * percent + 99) / 100;
+  if (target == 0) {
+    target = 1;
+  }
+
+  uint64_t seen = 0;
+  for (size_t b = 0; b < AT_LATENCY_HIST_BUCKETS - 1; ++b) {
+    seen += stats->latency_hist[b];
+    if (seen >= target) {
+      return (b == 0) ? 0 : (((uint32_t)1 << b) - 1);
+    }
+  }
+  return UINT32_MAX;
+}
+
+/* 统计 JSON 的类别名，与 AtCmdClass 一一对应 */
+static const char *const AT_CMD_CLASS_NAMES[AT_CMD_CLASS_COUNT] = {
+    "fixed", "local", "config", "mqtt", "prompt", "publish"};
+
+/* 追加字符串；放不下时把 *len 置为 size 作为溢出标记 */
+static void json_put(char *buf, size_t size, size_t *len, const char *s) {
+  size_t n = strlen(s);
+  if (*len >= size || n >= size - *len) {
+    *len = size;
+    return;
+  }
+  memcpy(buf + *len, s, n);
+  *len += n;
+}
+
+static void json_put_u32(char *buf, size_t size, size_t *len, uint32_t v) {
+  char digits[11];
+  size_t i = sizeof(digits) - 1;
+  digits[i] = '\0';
+  do {
+    digits[--i] = (char)('0' + v % 10);
+    v /= 10;
+  } while (v != 0);
+  json_put(buf, size, len, digits + i);
+}
+
+static void json_put_field(char *buf, size_t size, size_t *len,
+                           const char *key, uint32_t v) {
+  json_put(buf, size, len, "\"");
+  json_put(buf, size, len, key);
+  json_put(buf, size, len, "\":");
+  json_put_u32(buf, size, len, v);
+}
+
+size_t aqua_at_stats_to_json(const AtStats *stats, char *buf, size_t size) {
+  if (!stats || !buf || size == 0)
+    return 0;
+
+  size_t len = 0;
+  json_put(buf, size, &len, "{");
+  json_put_field(buf, size, &len, "rx_overruns", stats->rx_overruns);
+  json_put(buf, size, &len, ",");
+  json_put_field(buf, size, &len, "line_overflows", stats->line_overflows);
+  json_put(buf, size, &len, ",");
+  json_put_field(buf, size, &len, "urc_drops", stats->urc_drops);
+
+  for (size_t c = 0; c < AT_CMD_CLASS_COUNT; ++c) {
+    const AtCmdStats *cmd = &stats->cmd[c];
+    json_put(buf, size, &len, ",\"");
+    json_put(buf, size, &len, AT_CMD_CLASS_NAMES[c]);
+    json_put(buf, size, &len, "\":{");
+    json_put_field(buf, size, &len, "ok", cmd->ok);
+    json_put(buf, size, &len, ",");
+    json_put_field(buf, size, &len, "error", cmd->error);
+    json_put(buf, size, &len, ",");
+    json_put_field(buf, size, &len, "timeout", cmd->timeout);
+    json_put(buf, size, &len, ",\"hist\":[");
+
+    size_t used = AT_LATENCY_HIST_BUCKETS;
+    while (used > 0 && cmd->latency_hist[used - 1] == 0) {
+      used--;
+    }
+    for (size_t b = 0; b < used; ++b) {
+      if (b > 0) {
+        json_put(buf, size, &len, ",");
+      }
+      json_put_u32(buf, size, &len, cmd->latency_hist[b]);
+    }
+    json_put(buf, size, &len, "]}");
+  }
+  json_put(buf, size, &len, "}");
+
+  if (len >= size)
+    return 0;
+  buf[len] = '\0';
+  return len;
+}
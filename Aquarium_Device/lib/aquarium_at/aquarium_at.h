@@ -6,7 +6,13 @@
  * - 非阻塞设计，适合主循环集成
  * - 按 CRLF 切行解析
  * - 支持 OK/ERROR 终止识别与超时
- * - URC（未归属命令的响应行）队列
+ * - URC（未归属命令的响应行）队列：变长存放在共享存储区，按视图读取
+ * - URC 入队时按前缀分类一次，带类型标签；可按类型注册处理回调
+ * - +MQTTSUBRECV 的 payload 按长度原样捕获，不受行切分与行长限制
+ * - 非阻塞发送：写回调可只接收部分字节，剩余部分在 step 中重试
+ * - 命令队列：多条命令连续排队，每条收到终止响应时立即发出下一条
+ * - 自适应超时：按命令类别估计应答延迟，调用方给出的超时作为上限
+ * - 运行统计：各类别的完成计数与 log2 延迟直方图，接收溢出与 URC 丢弃计数
  */
 
 #ifndef AQUARIUM_AT_H
@@ -25,8 +31,8 @@ extern "C" {
  * ============================================================================
  */
 
-#ifndef AT_RX_BUFFER_SIZE
-#define AT_RX_BUFFER_SIZE 512
+#ifndef AT_TX_BUFFER_SIZE
+#define AT_TX_BUFFER_SIZE 512 /* 待发送命令行（含 \r\n）的暂存 */
 #endif
 
 #ifndef AT_LINE_MAX_LEN
@@ -34,7 +40,43 @@ extern "C" {
 #endif
 
 #ifndef AT_URC_QUEUE_SIZE
-#define AT_URC_QUEUE_SIZE 8
+#define AT_URC_QUEUE_SIZE 8 /* URC 队列最多容纳的行数 */
+#endif
+
+#ifndef AT_URC_ARENA_SIZE
+#define AT_URC_ARENA_SIZE 2048 /* URC 行内容共享存储（每行含结尾 '\0'） */
+#endif
+
+#if AT_URC_ARENA_SIZE < AT_LINE_MAX_LEN + 1 || AT_URC_ARENA_SIZE > 65535
+#error "AT_URC_ARENA_SIZE must hold one full line and fit in 16 bits"
+#endif
+
+#ifndef AT_CMD_QUEUE_SIZE
+#define AT_CMD_QUEUE_SIZE 4 /* 排队等待发送的命令数 */
+#endif
+
+#ifndef AT_CMD_POOL_SIZE
+#define AT_CMD_POOL_SIZE 512 /* 排队命令文本的共享存储（每条含结尾 '\0'） */
+#endif
+
+#ifndef AT_RTO_MIN_MS
+#define AT_RTO_MIN_MS 1000 /* 自适应超时下限（RFC 6298 的 1 s） */
+#endif
+
+#ifndef AT_RTO_MAX_BACKOFF
+#define AT_RTO_MAX_BACKOFF 4 /* 连续超时时超时翻倍的最多次数 */
+#endif
+
+#ifndef AT_LATENCY_HIST_BUCKETS
+#define AT_LATENCY_HIST_BUCKETS 16 /* log2 延迟直方图桶数，最后一桶 >= 16.4 s */
+#endif
+
+#ifndef AT_RAW_PAYLOAD_MAX_LEN
+#define AT_RAW_PAYLOAD_MAX_LEN 1024 /* +MQTTSUBRECV 原样捕获的 payload 上限 */
+#endif
+
+#ifndef AT_RAW_CAPTURE_TIMEOUT_MS
+#define AT_RAW_CAPTURE_TIMEOUT_MS 200 /* 捕获中途断流超过此时长按已收部分交付 */
 #endif
 
 /* ============================================================================
@@ -67,6 +109,23 @@ typedef enum {
   AT_STATE_DONE_TIMEOUT /* 命令超时 */
 } AtState;
 
+/* ============================================================================
+ * URC 类型
+ * ============================================================================
+ */
+
+typedef enum {
+  AT_URC_UNKNOWN = 0,   /* 其他行（含多行命令响应） */
+  AT_URC_IPD,           /* +IPD, */
+  AT_URC_MQTT_SUBRECV,  /* +MQTTSUBRECV: */
+  AT_URC_MQTT_PUB_OK,   /* +MQTTPUB:OK */
+  AT_URC_MQTT_PUB_FAIL, /* +MQTTPUB:FAIL */
+  AT_URC_SEND_OK,       /* SEND OK */
+  AT_URC_SEND_FAIL,     /* SEND FAIL */
+  AT_URC_SNTP_TIME,     /* +CIPSNTPTIME: */
+  AT_URC_TYPE_COUNT
+} AtUrcType;
+
 /* ============================================================================
  * 回调函数类型
  * ============================================================================
@@ -74,9 +133,14 @@ typedef enum {
 
 /**
  * @brief 写入数据到 UART 的回调
+ *
+ * 不应阻塞：只需把能放下的字节放入发送队列（由中断/DMA 异步发出），
+ * 返回实际接收的字节数。返回值小于 len 时，AtClient 保留剩余部分，
+ * 在后续 aqua_at_step 中重试。
+ *
  * @param data  数据指针
  * @param len   数据长度
- * @return 实际写入的字节数
+ * @return 实际接收的字节数（0 表示发送队列已满）
  */
 typedef size_t (*AtWriteFunc)(const uint8_t *data, size_t len);
 
@@ -95,8 +159,138 @@ typedef struct {
   char data[AT_LINE_MAX_LEN + 1];
   size_t len;
   bool valid;
+  uint16_t raw_id; /* 非 0：payload 在原始捕获缓冲区中 */
+  AtUrcType type;  /* URC 类型（命令响应行为 AT_URC_UNKNOWN） */
 } AtLine;
 
+/**
+ * @brief URC 行视图（指向 URC 存储区，不复制）
+ *
+ * 在该行被消费或下一次 aqua_at_feed_rx 之前有效。
+ */
+typedef struct {
+  const char *data; /* 以 '\0' 结尾 */
+  size_t len;
+  uint16_t raw_id; /* 非 0：payload 在原始捕获缓冲区中 */
+  AtUrcType type;
+} AtLineView;
+
+/* URC 槽位：只记录行在存储区中的位置 */
+typedef struct {
+  uint16_t offset;
+  uint16_t len;
+  uint16_t raw_id;
+  uint8_t type; /* AtUrcType */
+  bool valid;   /* false：已从队列中间消费，等待回收 */
+} AtUrcSlot;
+
+/**
+ * @brief URC 处理回调
+ *
+ * 在 aqua_at_feed_rx 内、该行入队之前调用，不应阻塞，也不应再喂入数据
+ * 或发送命令。line 只在回调期间有效。
+ *
+ * @param line      已分类的 URC 行
+ * @param user_data 注册时传入的用户数据
+ * @return true 已处理，不再入队；false 照常入队
+ */
+typedef bool (*AtUrcHandler)(const AtLineView *line, void *user_data);
+
+/* ============================================================================
+ * 命令队列
+ * ============================================================================
+ */
+
+/**
+ * @brief 排队命令完成回调
+ *
+ * 收到终止响应时在 aqua_at_feed_rx 内调用，超时时在 aqua_at_step 内调用。
+ * 回调中可以继续 aqua_at_enqueue；返回后客户端自动回到 IDLE 并立即发出
+ * 下一条排队命令。result 为 AT_STATE_GOT_PROMPT 时不自动复位：调用方发送
+ * 数据并 aqua_at_reset 后队列继续。
+ *
+ * @param result    AT_STATE_DONE_OK / DONE_ERROR / DONE_TIMEOUT / GOT_PROMPT
+ * @param response  命令的第一行非空响应，没有时为 NULL
+ * @param user_data 入队时传入的用户数据
+ */
+typedef void (*AtCmdCallback)(AtState result, const AtLine *response,
+                              void *user_data);
+
+typedef struct {
+  uint16_t len; /* 命令文本长度（不含 '\0'） */
+  bool expect_prompt;
+  uint32_t timeout_ms;
+  AtCmdCallback cb; /* NULL：完成状态留给调用方轮询，与 aqua_at_begin 相同 */
+  void *user_data;
+} AtCmdEntry;
+
+/* ============================================================================
+ * 自适应超时
+ * ============================================================================
+ */
+
+/**
+ * @brief 命令延迟类别，同类命令共享一组延迟估计与统计
+ *
+ * 命令行按前缀归类，发布结果的等待由调用方指定类别。只有延迟稳定的
+ * LOCAL、MQTT 与 PROMPT 做自适应估计；其余类别始终使用调用方给出的超时。
+ * PROMPT 的 '>' 由模组本地立即给出，卡死的模组在这一步即可被发现。
+ * LOCAL 只收录已知立即应答的命令，其他命令默认归入 CONFIG，避免少量
+ * 快速样本把慢命令的超时压到下限。
+ */
+typedef enum {
+  AT_CMD_CLASS_FIXED = 0, /* 不估计：耗时取决于外部（如 CWJAP 扫描入网） */
+  AT_CMD_CLASS_LOCAL,     /* 立即应答（AT、ATE0、AT+GMR、SNTP 时间查询） */
+  AT_CMD_CLASS_CONFIG,    /* 不估计：耗时随模组状态变化（CWSAP 等） */
+  AT_CMD_CLASS_MQTT,      /* 需与 broker 往返（MQTTCONN、MQTTSUB） */
+  AT_CMD_CLASS_PROMPT,    /* 等待 > 提示符（MQTTPUBRAW、CIPSEND） */
+  AT_CMD_CLASS_PUBLISH,   /* 不估计：发布数据之后等待 +MQTTPUB 结果 */
+  AT_CMD_CLASS_COUNT
+} AtCmdClass;
+
+/**
+ * @brief 一个类别的应答延迟估计（RFC 6298 的 SRTT/RTTVAR，定点存放）
+ *
+ * 超时 = SRTT + 4 * RTTVAR，限定在 [AT_RTO_MIN_MS, 调用方上限]；
+ * 超时的命令不取样本（无法得知真实延迟），改为把超时翻倍直到下一次
+ * 按时应答。
+ */
+typedef struct {
+  uint32_t srtt_x8;   /* 平滑延迟 ×8（ms） */
+  uint32_t rttvar_x4; /* 平均偏差 ×4（ms） */
+  uint16_t samples;   /* 已取样本数，0 时使用调用方上限 */
+  uint8_t backoff;    /* 连续超时次数 */
+} AtRttStats;
+
+/* ============================================================================
+ * 运行统计
+ * ============================================================================
+ */
+
+/**
+ * @brief 一个命令类别的完成计数与延迟直方图
+ *
+ * 直方图按 log2 分桶：桶 0 为 0 ms，桶 b（b >= 1）为 [2^(b-1), 2^b) ms，
+ * 最后一桶收纳更长的延迟。只有按时应答（OK、ERROR、> 提示符）计入
+ * 直方图，超时只计数。
+ */
+typedef struct {
+  uint32_t ok; /* OK 或 > 提示符 */
+  uint32_t error;
+  uint32_t timeout;
+  uint32_t latency_hist[AT_LATENCY_HIST_BUCKETS];
+} AtCmdStats;
+
+/**
+ * @brief AT 链路运行统计（可整体复制为快照）
+ */
+typedef struct {
+  AtCmdStats cmd[AT_CMD_CLASS_COUNT];
+  uint32_t rx_overruns;    /* 接收环未读数据被覆盖（经 aqua_at_rx_feed 汇总） */
+  uint32_t line_overflows; /* 超过 AT_LINE_MAX_LEN 被截断的行 */
+  uint32_t urc_drops;      /* URC 队列满时丢弃的行 */
+} AtStats;
+
 /* ============================================================================
  * AT 客户端上下文
  * ============================================================================
@@ -107,32 +301,70 @@ typedef struct {
   AtWriteFunc write_func;
   AtNowMsFunc now_ms_func;
 
-  /* RX 缓冲区 */
-  uint8_t rx_buffer[AT_RX_BUFFER_SIZE];
-  size_t rx_head;   /* 写入位置 */
-  size_t rx_tail;   /* 读取位置 */
-  bool rx_overflow; /* 溢出标志 */
+  /* TX 待发送数据：先发原始数据（调用方缓冲区），再发暂存的命令行 */
+  const uint8_t *tx_data; /* 未发完的原始数据 */
+  size_t tx_data_len;
+  uint8_t tx_buffer[AT_TX_BUFFER_SIZE]; /* 未发完的命令行 */
+  size_t tx_len;
 
   /* 行解析状态 */
   char line_buffer[AT_LINE_MAX_LEN + 1];
   size_t line_pos;
-  bool last_was_cr; /* 上一个字符是否为 CR */
+  bool last_was_cr;     /* 上一个字符是否为 CR */
+  bool line_overflowed; /* 当前行已超长（只计一次） */
 
   /* 命令状态 */
   AtState state;
   uint32_t cmd_start_ms;
   uint32_t cmd_timeout_ms;
+  AtCmdClass cmd_class; /* 当前命令的延迟类别 */
   bool expect_prompt; /* 是否期待 > 提示符（用于 CIPSEND/MQTTPUBRAW） */
   bool got_ok;        /* 已收到 OK（等待 > 提示符时使用） */
 
   /* 当前命令的响应行（第一行非空响应） */
   AtLine cmd_response;
 
-  /* URC 队列 */
-  AtLine urc_queue[AT_URC_QUEUE_SIZE];
-  size_t urc_head;
-  size_t urc_tail;
-  size_t urc_count;
+  /* +MQTTSUBRECV payload 原始捕获 */
+  char raw_payload[AT_RAW_PAYLOAD_MAX_LEN + 1];
+  size_t raw_len;       /* 已捕获字节数 */
+  size_t raw_remaining; /* 仍需捕获的字节数，非 0 时处于捕获模式 */
+  uint16_t raw_id;      /* 当前 payload 的编号（0 表示没有） */
+  uint32_t raw_last_ms; /* 最近一次收到 payload 字节的时间 */
+  bool raw_checked;     /* 当前行已判定不是可捕获的头部 */
+
+  /*
+   * URC 队列：行内容按到达顺序变长写入 urc_arena（环形使用，一行不跨越
+   * 末尾），槽位按 FIFO 记录位置。从队列中间消费的行先留作空洞，
+   * 成为最旧一行时随之回收。
+   */
+  char urc_arena[AT_URC_ARENA_SIZE];
+  size_t urc_arena_head; /* 下一行的写入位置 */
+  AtUrcSlot urc_slots[AT_URC_QUEUE_SIZE];
+  size_t urc_head;  /* 下一个空闲槽位 */
+  size_t urc_tail;  /* 最旧的已占用槽位 */
+  size_t urc_used;  /* 已占用槽位数（含空洞） */
+  size_t urc_count; /* 可读的 URC 行数 */
+
+  /*
+   * 命令队列：排队命令的文本按 FIFO 紧凑存放在 cmd_pool 中（队首总在
+   * 开头），客户端回到 IDLE 时发出队首命令
+   */
+  char cmd_pool[AT_CMD_POOL_SIZE];
+  size_t cmd_pool_used;
+  AtCmdEntry cmd_queue[AT_CMD_QUEUE_SIZE];
+  size_t cmd_queue_count;
+  AtCmdCallback cmd_cb; /* 执行中的排队命令的完成回调 */
+  void *cmd_cb_data;
+
+  /* 各类别命令的应答延迟估计 */
+  AtRttStats rtt[AT_CMD_CLASS_COUNT];
+
+  /* 运行统计 */
+  AtStats stats;
+
+  /* 按 URC 类型注册的处理回调 */
+  AtUrcHandler urc_handlers[AT_URC_TYPE_COUNT];
+  void *urc_handler_data[AT_URC_TYPE_COUNT];
 } AtClient;
 
 /* ============================================================================
@@ -163,6 +395,13 @@ AtError aqua_at_init(AtClient *client, AtWriteFunc write_fn,
  * - 命令执行中时：归属到当前命令响应或检测 OK/ERROR
  * - 空闲时：放入 URC 队列
  *
+ * 行首出现完整的 +MQTTSUBRECV:<id>,"<topic>",<len>, 头部后切换到原始捕获：
+ * 随后恰好 <len> 字节（可含 CR/LF）直接拷入原始捕获缓冲区，完成后头部作为
+ * 一行 URC 入队并带上 raw_id。<len> 超过 AT_RAW_PAYLOAD_MAX_LEN，或上一次
+ * 捕获的 payload 对应的行仍在 URC 队列中时，按普通行处理。
+ * 捕获中途断流超过 AT_RAW_CAPTURE_TIMEOUT_MS 时，aqua_at_step 按已收到的
+ * 部分交付（payload 不完整，由上层回错误响应）。
+ *
  * @param client AT 客户端上下文指针
  * @param data   接收到的数据
  * @param len    数据长度
@@ -170,6 +409,35 @@ AtError aqua_at_init(AtClient *client, AtWriteFunc write_fn,
  */
 AtError aqua_at_feed_rx(AtClient *client, const uint8_t *data, size_t len);
 
+#ifdef UNIT_TEST
+/**
+ * @brief 接收行切分累计的扫描步数（仅测试构建）
+ *
+ * 每检查一个字节或一个整字加一，测试据此断言 aqua_at_feed_rx 的
+ * 工作量随输入长度线性增长。
+ */
+extern uint32_t aqua_at_scan_steps;
+#endif
+
+/**
+ * @brief 批量喂入环形缓冲区中的连续数据段
+ *
+ * 环形缓冲区未回绕时只有 first 一段；回绕时 first 为读指针到缓冲区末尾，
+ * second 为缓冲区开头到写指针。两段按顺序送入 aqua_at_feed_rx，
+ * 跨段的 CR/LF 与半行照常拼接。行内数据按字宽查找 CR/LF 后整段拷贝，
+ * 避免逐字节调用。
+ *
+ * @param client     AT 客户端上下文指针
+ * @param first      第一段数据（first_len 为 0 时可为 NULL）
+ * @param first_len  第一段长度
+ * @param second     第二段数据（second_len 为 0 时可为 NULL）
+ * @param second_len 第二段长度
+ * @return AtError 错误码（两段中第一个非 AT_OK 的结果）
+ */
+AtError aqua_at_feed_rx_spans(AtClient *client, const uint8_t *first,
+                              size_t first_len, const uint8_t *second,
+                              size_t second_len);
+
 /* ============================================================================
  * 命令发送
  * ============================================================================
@@ -178,12 +446,15 @@ AtError aqua_at_feed_rx(AtClient *client, const uint8_t *data, size_t len);
 /**
  * @brief 开始发送一条 AT 命令
  *
- * 会自动在命令末尾追加 \r\n
+ * 会自动在命令末尾追加 \r\n，命令与 \r\n 一次写出
  * 单通道串行执行，如已有命令在执行则返回 AT_ERR_BUSY
+ * 写回调未能全部接收时命令行暂存在 AtClient 中，由 aqua_at_step 续发；
+ * 超时从命令行全部发出时重新计时。暂存空间不足时返回 AT_ERR_BUFFER_FULL
+ * 实际超时见 aqua_at_timeout_for：同类命令已有延迟样本时按估计缩短
  *
  * @param client     AT 客户端上下文指针
  * @param cmd        AT 命令字符串（不含 \r\n）
- * @param timeout_ms 超时时间（毫秒）
+ * @param timeout_ms 超时上限（毫秒）
  * @return AtError 错误码
  */
 AtError aqua_at_begin(AtClient *client, const char *cmd, uint32_t timeout_ms);
@@ -197,12 +468,150 @@ AtError aqua_at_begin(AtClient *client, const char *cmd, uint32_t timeout_ms);
  *
  * @param client     AT 客户端上下文指针
  * @param cmd        AT 命令字符串（不含 \r\n）
- * @param timeout_ms 超时时间（毫秒）
+ * @param timeout_ms 超时上限（毫秒）
  * @return AtError 错误码
  */
 AtError aqua_at_begin_with_prompt(AtClient *client, const char *cmd,
                                   uint32_t timeout_ms);
 
+/**
+ * @brief 发送原始数据（收到 > 提示符后的 payload）
+ *
+ * 不复制数据：data 必须保持有效，直到 aqua_at_tx_pending 返回 0。
+ * 写回调未能全部接收的部分由 aqua_at_step 续发。
+ *
+ * @param client AT 客户端上下文指针
+ * @param data   数据指针
+ * @param len    数据长度
+ * @return AT_OK 已排队；AT_ERR_BUSY 上一次发送尚未完成
+ */
+AtError aqua_at_send_data(AtClient *client, const uint8_t *data, size_t len);
+
+/**
+ * @brief 尚未被写回调接收的字节数
+ */
+size_t aqua_at_tx_pending(const AtClient *client);
+
+/**
+ * @brief 把一条命令加入命令队列
+ *
+ * 客户端空闲时立即发出，否则在当前命令结束、客户端回到 IDLE 时按入队顺序
+ * 发出。带回调的命令由客户端在完成时自动复位，因此一组排队命令会在各自
+ * 的 OK 到达时连续发出，不需要等待主循环的下一轮。
+ *
+ * @param client        AT 客户端上下文指针
+ * @param cmd           AT 命令字符串（不含 \r\n）
+ * @param timeout_ms    超时上限（毫秒），同 aqua_at_begin
+ * @param expect_prompt 是否等待 > 提示符
+ * @param cb            完成回调（NULL 时由调用方轮询状态并 aqua_at_reset）
+ * @param user_data     传给回调的用户数据
+ * @return AT_OK 已入队；AT_ERR_BUFFER_FULL 队列或文本存储已满
+ */
+AtError aqua_at_enqueue(AtClient *client, const char *cmd, uint32_t timeout_ms,
+                        bool expect_prompt, AtCmdCallback cb, void *user_data);
+
+/**
+ * @brief 丢弃尚未发出的排队命令，并解除执行中命令的完成回调
+ *
+ * 不改变当前状态；被丢弃的命令不调用回调。
+ */
+void aqua_at_cancel_queue(AtClient *client);
+
+/**
+ * @brief 尚未发出的排队命令数
+ */
+size_t aqua_at_queue_pending(const AtClient *client);
+
+/* ============================================================================
+ * 自适应超时
+ * ============================================================================
+ */
+
+/**
+ * @brief 某类命令当前应使用的超时
+ *
+ * 类别不做估计（LOCAL、MQTT 以外）或尚无样本时返回 cap_ms；否则返回
+ * (SRTT + 4 * RTTVAR) << backoff，限定在 [AT_RTO_MIN_MS, cap_ms]。
+ *
+ * @param client AT 客户端上下文指针
+ * @param cls    命令延迟类别
+ * @param cap_ms 超时上限（毫秒）
+ * @return 超时（毫秒）
+ */
+uint32_t aqua_at_timeout_for(const AtClient *client, AtCmdClass cls,
+                             uint32_t cap_ms);
+
+/**
+ * @brief 发送原始数据后继续等待最终结果（如 +MQTTPUB:OK 或 OK）
+ *
+ * 状态回到 AT_STATE_WAITING，超时按 cls 的估计计算并以 cap_ms 为上限，
+ * 从原始数据全部发出时起算。
+ *
+ * @param client AT 客户端上下文指针
+ * @param cls    等待结果的延迟类别
+ * @param cap_ms 超时上限（毫秒）
+ */
+void aqua_at_await_result(AtClient *client, AtCmdClass cls, uint32_t cap_ms);
+
+/**
+ * @brief 由上层判定当前命令已结束（如收到 +MQTTPUB:OK URC）
+ *
+ * 与收到 OK/ERROR 等价：记录延迟样本，调用排队命令的完成回调。
+ * 不在 AT_STATE_WAITING 时忽略。
+ *
+ * @param client AT 客户端上下文指针
+ * @param result AT_STATE_DONE_OK 或 AT_STATE_DONE_ERROR
+ */
+void aqua_at_complete(AtClient *client, AtState result);
+
+/* ============================================================================
+ * 运行统计
+ * ============================================================================
+ */
+
+/**
+ * @brief 读取累计的运行统计（随客户端更新，不复制）
+ *
+ * @param client AT 客户端上下文指针
+ * @return 统计指针；client 为 NULL 时返回 NULL
+ */
+const AtStats *aqua_at_get_stats(const AtClient *client);
+
+/**
+ * @brief 复制一份运行统计快照，可选择随后清零
+ *
+ * 周期性上报时传 reset = true，每份快照即为上报间隔内的增量。
+ *
+ * @param client AT 客户端上下文指针
+ * @param out    [输出] 快照
+ * @param reset  复制后是否清零
+ */
+void aqua_at_stats_snapshot(AtClient *client, AtStats *out, bool reset);
+
+/**
+ * @brief 由直方图估计延迟百分位
+ *
+ * @param stats   一个类别的统计
+ * @param percent 百分位（1~100）
+ * @return 该百分位所在桶的上沿（毫秒）；没有样本时返回 0，
+ *         落在最后一桶时返回 UINT32_MAX
+ */
+uint32_t aqua_at_latency_percentile(const AtCmdStats *stats, uint32_t percent);
+
+/**
+ * @brief 把统计快照格式化为紧凑 JSON，供固件发布
+ *
+ * 形如 {"rx_overruns":0,"line_overflows":0,"urc_drops":0,
+ * "local":{"ok":9,"error":0,"timeout":1,"hist":[0,0,2,7]},...}；
+ * hist 为 log2 直方图，省略末尾的空桶。
+ *
+ * @param stats 统计快照
+ * @param buf   输出缓冲区
+ * @param size  缓冲区大小
+ * @return JSON 长度（不含 '\0'）；参数为空或缓冲区不足时返回 0
+ */
+size_t aqua_at_stats_to_json(const AtStats *stats, char *buf, size_t size);
+
 /* ============================================================================
  * 状态推进
  * ============================================================================
@@ -211,7 +620,7 @@ AtError aqua_at_begin_with_prompt(AtClient *client, const char *cmd,
 /**
  * @brief 推进 AT 状态机
  *
- * 检查超时，处理接收缓冲区中的行，更新命令状态
+ * 续发未发完的数据，检查超时（含原始捕获断流），更新命令状态
  *
  * @param client AT 客户端上下文指针
  * @return 当前状态
@@ -234,7 +643,7 @@ AtState aqua_at_get_state(const AtClient *client);
 const AtLine *aqua_at_get_response(const AtClient *client);
 
 /**
- * @brief 重置为 IDLE 状态（命令处理完成后调用）
+ * @brief 重置为 IDLE 状态（命令处理完成后调用），并发出下一条排队命令
  */
 void aqua_at_reset(AtClient *client);
 
@@ -249,7 +658,45 @@ void aqua_at_reset(AtClient *client);
 bool aqua_at_has_urc(const AtClient *client);
 
 /**
- * @brief 弹出一个 URC 行
+ * @brief 为一种 URC 类型注册处理回调（handler 为 NULL 时取消）
+ *
+ * 每种类型只保留一个回调，后注册的覆盖先注册的；type 越界时忽略。
+ *
+ * @param client    AT 客户端上下文指针
+ * @param type      URC 类型
+ * @param handler   处理回调
+ * @param user_data 传给回调的用户数据
+ */
+void aqua_at_set_urc_handler(AtClient *client, AtUrcType type,
+                             AtUrcHandler handler, void *user_data);
+
+/**
+ * @brief 查看第 index 个 URC 行（0 为最旧），不出队不复制
+ *
+ * @param client AT 客户端上下文指针
+ * @param index  从最旧一行起的序号
+ * @param out    [输出] 行视图
+ * @return AtError 错误码（AT_ERR_NO_LINE 表示没有该行）
+ */
+AtError aqua_at_peek_line(const AtClient *client, size_t index,
+                          AtLineView *out);
+
+/**
+ * @brief 消费第 index 个 URC 行（0 为最旧）
+ *
+ * 可以消费队列中间的行，其余行保持原有顺序，已取得的其他行视图仍然有效。
+ *
+ * @param client AT 客户端上下文指针
+ * @param index  从最旧一行起的序号
+ * @return AtError 错误码（AT_ERR_NO_LINE 表示没有该行）
+ */
+AtError aqua_at_consume_line(AtClient *client, size_t index);
+
+/**
+ * @brief 弹出一个 URC 行（复制到 out）
+ *
+ * 需要保留行副本时使用；逐行处理优先用 aqua_at_peek_line /
+ * aqua_at_consume_line，避免整行复制。
  *
  * @param client AT 客户端上下文指针
  * @param out    [输出] URC 行缓冲区
@@ -257,6 +704,21 @@ bool aqua_at_has_urc(const AtClient *client);
  */
 AtError aqua_at_pop_line(AtClient *client, AtLine *out);
 
+/**
+ * @brief 取得 URC 行对应的原始捕获 payload
+ *
+ * 对 raw_id 非 0 的 +MQTTSUBRECV 行，返回按长度捕获的完整 payload
+ * （以 '\0' 结尾，但可能含 CR/LF 或 '\0'）。该行仍在队列中时 payload
+ * 不会被覆盖；出队后返回的指针在下一次 aqua_at_feed_rx 之前有效。
+ *
+ * @param client  AT 客户端上下文指针
+ * @param raw_id  URC 行的 raw_id（AtLineView / AtLine 中的同名字段）
+ * @param out_len [输出] payload 长度
+ * @return payload 指针；该行没有原始 payload 或已被后续捕获覆盖时返回 NULL
+ */
+const char *aqua_at_get_raw_payload(const AtClient *client, uint16_t raw_id,
+                                    size_t *out_len);
+
 #ifdef __cplusplus
 }
 #endif
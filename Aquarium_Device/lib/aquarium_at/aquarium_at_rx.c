@@ -0,0 +1,111 @@
+/**
+ * @file aquarium_at_rx.c
+ * @brief UART DMA 循环接收环实现
+ */
+
+#include "aquarium_at_rx.h"
+#include <string.h>
+
+/* ============================================================================
+ * 初始化
+ * ============================================================================
+ */
+
+AtError aqua_at_rx_init(AtRxRing *ring, uint8_t *buf, uint32_t size) {
+  if (!ring || !buf) {
+    return AT_ERR_NULL_PTR;
+  }
+  if (size == 0 || (size & (size - 1)) != 0) {
+    return AT_ERR_BUFFER_FULL;
+  }
+
+  memset(ring, 0, sizeof(AtRxRing));
+  ring->buf = buf;
+  ring->size = size;
+  return AT_OK;
+}
+
+/* ============================================================================
+ * 写端（DMA 事件 ISR）
+ * ============================================================================
+ */
+
+void aqua_at_rx_on_dma(AtRxRing *ring, uint32_t dma_pos) {
+  if (!ring || ring->size == 0 || dma_pos > ring->size)
+    return;
+
+  /* 全满事件报告的是 size，与下一圈的 0 是同一位置 */
+  if (dma_pos == ring->size) {
+    dma_pos = 0;
+  }
+
+  /*
+   * 半满/全满中断保证两次事件之间最多写入半圈，位置差即新写入字节数；
+   * 位置未变（如 IDLE 紧跟全满）视为没有新数据。
+   */
+  uint32_t delta = (dma_pos - ring->dma_pos) & (ring->size - 1);
+  ring->dma_pos = dma_pos;
+  ring->written += delta;
+}
+
+/* ============================================================================
+ * 读端（主循环）
+ * ============================================================================
+ */
+
+size_t aqua_at_rx_peek(AtRxRing *ring, AtRxSpans *out) {
+  if (!ring || !out)
+    return 0;
+
+  memset(out, 0, sizeof(AtRxSpans));
+  if (ring->size == 0)
+    return 0;
+
+  uint32_t written = ring->written; /* 快照：之后写入的数据留到下一轮 */
+  uint32_t avail = written - ring->consumed;
+  if (avail > ring->size) {
+    /* DMA 已覆盖未读数据，其中的行已不完整：整体丢弃 */
+    ring->consumed = written;
+    ring->overruns++;
+    return 0;
+  }
+  if (avail == 0)
+    return 0;
+
+  uint32_t start = ring->consumed & (ring->size - 1);
+  uint32_t to_end = ring->size - start;
+  out->first = ring->buf + start;
+  if (avail <= to_end) {
+    out->first_len = avail;
+  } else {
+    out->first_len = to_end;
+    out->second = ring->buf;
+    out->second_len = avail - to_end;
+  }
+  return avail;
+}
+
+void aqua_at_rx_consume(AtRxRing *ring, size_t len) {
+  if (!ring)
+    return;
+  ring->consumed += (uint32_t)len;
+}
+
+AtError aqua_at_rx_feed(AtRxRing *ring, AtClient *client) {
+  if (!ring || !client) {
+    return AT_ERR_NULL_PTR;
+  }
+
+  AtRxSpans spans;
+  uint32_t overruns = ring->overruns;
+  size_t avail = aqua_at_rx_peek(ring, &spans);
+  client->stats.rx_overruns += ring->overruns - overruns;
+  if (avail == 0) {
+    return AT_OK;
+  }
+
+  AtError err = aqua_at_feed_rx_spans(client, spans.first, spans.first_len,
+                                      spans.second, spans.second_len);
+  aqua_at_rx_consume(ring, avail);
+  return err;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file aquarium_at_rx.h
+ * @brief UART DMA 循环接收环（与硬件无关）
+ *
+ * DMA 以循环模式把 UART 数据写入 buf，硬件只需在 DMA 半满/全满与 USART
+ * IDLE（线路空闲）中断中报告当前写位置；主循环取出新数据段喂给 AT 引擎。
+ * - 写端（ISR）只更新 written，读端（主循环）只更新 consumed，无需关中断
+ * - 两者都是单调递增的 32 位字节计数，环大小为 2 的幂时取模即得下标，
+ *   计数回绕不影响结果
+ * - 未读数据超过一圈说明 DMA 已覆盖未读字节：丢弃并重新同步，记一次溢出
+ *
+ * 环大小需保证主循环在 DMA 写满一圈前取走数据
+ * （2048 B @115200 约 178 ms）。
+ */
+
+#ifndef AQUARIUM_AT_RX_H
+#define AQUARIUM_AT_RX_H
+
+#include "aquarium_at.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 接收环上下文
+ * ============================================================================
+ */
+
+typedef struct {
+  uint8_t *buf; /* DMA 目标缓冲区（调用方持有） */
+  uint32_t size;
+
+  volatile uint32_t written; /* DMA 累计写入字节数（ISR 更新） */
+  uint32_t dma_pos;          /* 上次报告的 DMA 写位置（ISR 使用） */
+  uint32_t consumed;         /* 主循环累计取走字节数 */
+  uint32_t overruns;         /* 未读数据被 DMA 覆盖的次数 */
+} AtRxRing;
+
+/**
+ * @brief 环中一次可读的数据（回绕时分两段）
+ */
+typedef struct {
+  const uint8_t *first;
+  size_t first_len;
+  const uint8_t *second;
+  size_t second_len;
+} AtRxSpans;
+
+/* ============================================================================
+ * 初始化
+ * ============================================================================
+ */
+
+/**
+ * @brief 初始化接收环，在启动 DMA 之前（或 DMA 停止后重启前）调用
+ *
+ * @param ring 接收环上下文
+ * @param buf  DMA 目标缓冲区
+ * @param size 缓冲区大小，必须为 2 的幂
+ * @return AT_OK 成功；AT_ERR_NULL_PTR 空指针；
+ *         AT_ERR_BUFFER_FULL size 不是 2 的幂
+ */
+AtError aqua_at_rx_init(AtRxRing *ring, uint8_t *buf, uint32_t size);
+
+/* ============================================================================
+ * 写端（DMA 事件 ISR）
+ * ============================================================================
+ */
+
+/**
+ * @brief 报告 DMA 当前写位置
+ *
+ * 在 DMA 半满、全满与 USART IDLE 事件中调用。dma_pos 为缓冲区内已写入的
+ * 末尾位置（size - NDTR，全满时可以等于 size）。
+ */
+void aqua_at_rx_on_dma(AtRxRing *ring, uint32_t dma_pos);
+
+/* ============================================================================
+ * 读端（主循环）
+ * ============================================================================
+ */
+
+/**
+ * @brief 取得当前全部未读数据段（不消费）
+ *
+ * 若未读数据已超过一圈，丢弃全部并累加 overruns。
+ *
+ * @return 未读字节总数
+ */
+size_t aqua_at_rx_peek(AtRxRing *ring, AtRxSpans *out);
+
+/**
+ * @brief 标记 len 字节已读
+ */
+void aqua_at_rx_consume(AtRxRing *ring, size_t len);
+
+/**
+ * @brief 把全部未读数据批量喂给 AT 引擎并消费
+ *
+ * 取数时发现的溢出同时计入 client->stats.rx_overruns。
+ *
+ * @return aqua_at_feed_rx_spans 的结果；没有新数据时返回 AT_OK
+ */
+AtError aqua_at_rx_feed(AtRxRing *ring, AtClient *client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AQUARIUM_AT_RX_H */
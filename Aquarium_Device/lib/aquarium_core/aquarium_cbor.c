@@ -0,0 +1,330 @@
+/**
+ * @file aquarium_cbor.c
+ * @brief 属性上报的紧凑二进制编码实现
+ */
+
+#include "aquarium_cbor.h"
+#include <string.h>
+
+/* ============================================================================
+ * 字段表
+ * ============================================================================
+ */
+
+typedef enum { CBOR_FIELD_FLOAT, CBOR_FIELD_INT, CBOR_FIELD_BOOL } CborFieldType;
+
+typedef struct {
+  uint8_t type;    /* CborFieldType */
+  uint16_t offset; /* 在 AquariumProperties 中的偏移 */
+} CborFieldDesc;
+
+/* 下标即 AQUA_PROP_* 位号，也就是 CBOR 中的键 */
+static const CborFieldDesc CBOR_FIELDS[AQUA_REPORT_FIELD_COUNT] = {
+#define AQUA_PROPERTY(name, NAME, type)                                        \
+  {CBOR_FIELD_##type, (uint16_t)offsetof(AquariumProperties, name)},
+#include "aquarium_schema.def"
+};
+
+/* ============================================================================
+ * CBOR 写入
+ * ============================================================================
+ */
+
+#define CBOR_MAJOR_UINT 0u
+#define CBOR_MAJOR_NINT 1u
+#define CBOR_MAJOR_ARRAY 4u
+#define CBOR_MAJOR_MAP 5u
+#define CBOR_MAJOR_SIMPLE 7u
+
+#define CBOR_SIMPLE_FALSE 20u
+#define CBOR_SIMPLE_TRUE 21u
+
+typedef struct {
+  uint8_t *buf;
+  size_t size;
+  size_t len;
+  bool overflow;
+} CborWriter;
+
+/* 写出类型头：参数 < 24 时嵌在首字节，否则按 1/2/4 字节大端跟随 */
+static void cbor_head(CborWriter *w, uint8_t major, uint32_t arg) {
+  uint8_t tmp[5];
+  size_t n;
+
+  major = (uint8_t)(major << 5);
+  if (arg < 24u) {
+    tmp[0] = (uint8_t)(major | arg);
+    n = 1;
+  } else if (arg <= 0xFFu) {
+    tmp[0] = (uint8_t)(major | 24u);
+    tmp[1] = (uint8_t)arg;
+    n = 2;
+  } else if (arg <= 0xFFFFu) {
+    tmp[0] = (uint8_t)(major | 25u);
+    tmp[1] = (uint8_t)(arg >> 8);
+    tmp[2] = (uint8_t)arg;
+    n = 3;
+  } else {
+    tmp[0] = (uint8_t)(major | 26u);
+    tmp[1] = (uint8_t)(arg >> 24);
+    tmp[2] = (uint8_t)(arg >> 16);
+    tmp[3] = (uint8_t)(arg >> 8);
+    tmp[4] = (uint8_t)arg;
+    n = 5;
+  }
+
+  if (w->overflow || w->size - w->len < n) {
+    w->overflow = true;
+    return;
+  }
+  memcpy(&w->buf[w->len], tmp, n);
+  w->len += n;
+}
+
+static void cbor_i32(CborWriter *w, int32_t v) {
+  if (v < 0) {
+    /* 负整数编码为 -1 - n */
+    cbor_head(w, CBOR_MAJOR_NINT, (uint32_t)(-(v + 1)));
+  } else {
+    cbor_head(w, CBOR_MAJOR_UINT, (uint32_t)v);
+  }
+}
+
+/* 浮点放大为整数：四舍五入，NaN/Inf 写为 0，超出 int32 时饱和 */
+static int32_t cbor_scale_float(float v) {
+  if (!((v == v) && ((v - v) == 0.0f))) {
+    return 0;
+  }
+  float s = v * (float)AQUA_CBOR_FLOAT_SCALE;
+  if (s >= 2147483520.0f) { /* 小于 2^31 的最大 float */
+    return INT32_MAX;
+  }
+  if (s <= -2147483648.0f) {
+    return INT32_MIN;
+  }
+  return (int32_t)(s < 0.0f ? s - 0.5f : s + 0.5f);
+}
+
+static size_t cbor_popcount(uint16_t mask) {
+  size_t n = 0;
+  for (; mask; mask &= (uint16_t)(mask - 1u)) {
+    n++;
+  }
+  return n;
+}
+
+static void cbor_write_sample(CborWriter *w, const AquaPropertySample *s) {
+  uint16_t mask = (uint16_t)(s->field_mask & AQUA_PROP_ALL);
+  size_t pairs = cbor_popcount(mask) + (s->event_time != 0 ? 1 : 0);
+
+  cbor_head(w, CBOR_MAJOR_MAP, (uint32_t)pairs);
+  for (uint8_t i = 0; i < AQUA_REPORT_FIELD_COUNT; ++i) {
+    if (!(mask & (1u << i))) {
+      continue;
+    }
+    const uint8_t *base = (const uint8_t *)&s->props + CBOR_FIELDS[i].offset;
+    cbor_head(w, CBOR_MAJOR_UINT, i);
+    switch (CBOR_FIELDS[i].type) {
+    case CBOR_FIELD_FLOAT:
+      cbor_i32(w, cbor_scale_float(*(const float *)base));
+      break;
+    case CBOR_FIELD_INT:
+      cbor_i32(w, *(const int32_t *)base);
+      break;
+    case CBOR_FIELD_BOOL:
+      cbor_head(w, CBOR_MAJOR_SIMPLE,
+                *(const bool *)base ? CBOR_SIMPLE_TRUE : CBOR_SIMPLE_FALSE);
+      break;
+    }
+  }
+  if (s->event_time != 0) {
+    cbor_head(w, CBOR_MAJOR_UINT, AQUA_CBOR_KEY_EVENT_TIME);
+    cbor_head(w, CBOR_MAJOR_UINT, s->event_time);
+  }
+}
+
+AquaError aqua_build_properties_cbor(const AquaPropertySample *samples,
+                                     size_t count, uint8_t *buffer,
+                                     size_t buf_size, size_t *out_len) {
+  if (!samples || !buffer || !out_len) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  CborWriter w = {buffer, buf_size, 0, false};
+  cbor_head(&w, CBOR_MAJOR_ARRAY, (uint32_t)(count + 1));
+  cbor_head(&w, CBOR_MAJOR_UINT, AQUA_CBOR_VERSION);
+  for (size_t i = 0; i < count && !w.overflow; ++i) {
+    cbor_write_sample(&w, &samples[i]);
+  }
+
+  if (w.overflow) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
+  *out_len = w.len;
+  return AQUA_OK;
+}
+
+/* ============================================================================
+ * CBOR 解析
+ * ============================================================================
+ */
+
+typedef struct {
+  const uint8_t *p;
+  const uint8_t *end;
+} CborReader;
+
+/*
+ * 读取一个类型头；只接受定长参数（最长 4 字节）。
+ * 返回 false 表示数据不足或编码不在本格式范围内。
+ */
+static bool cbor_read_head(CborReader *r, uint8_t *major, uint32_t *arg) {
+  if (r->p >= r->end) {
+    return false;
+  }
+  uint8_t ib = *r->p++;
+  uint8_t info = ib & 0x1Fu;
+  *major = (uint8_t)(ib >> 5);
+
+  if (info < 24u) {
+    *arg = info;
+    return true;
+  }
+  if (info > 26u) {
+    return false;
+  }
+  size_t n = (size_t)1 << (info - 24u);
+  if ((size_t)(r->end - r->p) < n) {
+    return false;
+  }
+  uint32_t v = 0;
+  for (size_t i = 0; i < n; ++i) {
+    v = (v << 8) | *r->p++;
+  }
+  *arg = v;
+  return true;
+}
+
+/* 读取一个整数或布尔值；is_bool 标明是哪一种 */
+static bool cbor_read_scalar(CborReader *r, int64_t *value, bool *is_bool) {
+  uint8_t major;
+  uint32_t arg;
+  if (!cbor_read_head(r, &major, &arg)) {
+    return false;
+  }
+  *is_bool = false;
+  switch (major) {
+  case CBOR_MAJOR_UINT:
+    *value = arg;
+    return true;
+  case CBOR_MAJOR_NINT:
+    *value = -1 - (int64_t)arg;
+    return true;
+  case CBOR_MAJOR_SIMPLE:
+    if (arg != CBOR_SIMPLE_FALSE && arg != CBOR_SIMPLE_TRUE) {
+      return false;
+    }
+    *is_bool = true;
+    *value = (arg == CBOR_SIMPLE_TRUE);
+    return true;
+  default:
+    return false;
+  }
+}
+
+static bool cbor_store_field(AquaPropertySample *s, uint32_t key, int64_t v,
+                             bool is_bool) {
+  if (key == AQUA_CBOR_KEY_EVENT_TIME) {
+    if (is_bool || v < 0 || v > (int64_t)UINT32_MAX) {
+      return false;
+    }
+    s->event_time = (uint32_t)v;
+    return true;
+  }
+  if (key >= AQUA_REPORT_FIELD_COUNT) {
+    return true; /* 未知字段：跳过 */
+  }
+
+  uint8_t *base = (uint8_t *)&s->props + CBOR_FIELDS[key].offset;
+  switch (CBOR_FIELDS[key].type) {
+  case CBOR_FIELD_FLOAT:
+    if (is_bool || v < INT32_MIN || v > INT32_MAX) {
+      return false;
+    }
+    *(float *)base = (float)v / (float)AQUA_CBOR_FLOAT_SCALE;
+    break;
+  case CBOR_FIELD_INT:
+    if (is_bool || v < INT32_MIN || v > INT32_MAX) {
+      return false;
+    }
+    *(int32_t *)base = (int32_t)v;
+    break;
+  case CBOR_FIELD_BOOL:
+    if (!is_bool) {
+      return false;
+    }
+    *(bool *)base = (v != 0);
+    break;
+  }
+  s->field_mask |= (uint16_t)(1u << key);
+  return true;
+}
+
+static bool cbor_read_sample(CborReader *r, AquaPropertySample *s) {
+  uint8_t major;
+  uint32_t pairs;
+  if (!cbor_read_head(r, &major, &pairs) || major != CBOR_MAJOR_MAP) {
+    return false;
+  }
+
+  memset(s, 0, sizeof(*s));
+  for (uint32_t i = 0; i < pairs; ++i) {
+    uint32_t key;
+    int64_t v;
+    bool is_bool;
+    if (!cbor_read_head(r, &major, &key) || major != CBOR_MAJOR_UINT ||
+        !cbor_read_scalar(r, &v, &is_bool) ||
+        !cbor_store_field(s, key, v, is_bool)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+AquaError aqua_parse_properties_cbor(const uint8_t *data, size_t len,
+                                     AquaPropertySample *samples,
+                                     size_t max_samples, size_t *out_count) {
+  if (!data || !out_count || (!samples && max_samples > 0)) {
+    return AQUA_ERR_NULL_PTR;
+  }
+  *out_count = 0;
+
+  CborReader r = {data, data + len};
+  uint8_t major;
+  uint32_t items, version;
+  if (!cbor_read_head(&r, &major, &items) || major != CBOR_MAJOR_ARRAY ||
+      items == 0 || !cbor_read_head(&r, &major, &version) ||
+      major != CBOR_MAJOR_UINT || version != AQUA_CBOR_VERSION) {
+    return AQUA_ERR_JSON_PARSE;
+  }
+
+  AquaError result = AQUA_OK;
+  for (uint32_t i = 1; i < items; ++i) {
+    AquaPropertySample tmp;
+    AquaPropertySample *dst =
+        (*out_count < max_samples) ? &samples[*out_count] : &tmp;
+    if (!cbor_read_sample(&r, dst)) {
+      return AQUA_ERR_JSON_PARSE;
+    }
+    if (dst == &tmp) {
+      result = AQUA_ERR_BUFFER_TOO_SMALL;
+    } else {
+      (*out_count)++;
+    }
+  }
+
+  if (r.p != r.end) {
+    return AQUA_ERR_JSON_PARSE; /* 尾部多余数据 */
+  }
+  return result;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file aquarium_cbor.h
+ * @brief 属性上报的紧凑二进制编码（CBOR，整数键）
+ *
+ * JSON 上报中大部分字节是键名。这里以 RFC 8949 CBOR 为载体，
+ * 用 AQUA_PROP_BIT_* 位号代替键名，全量上报约 45 字节
+ * （同样内容的 JSON 约 300 字节）。
+ *
+ * 报文结构（CBOR 诊断记法）：
+ *   [1, {0: 2550, 1: 720, 5: true, 9: 600, 23: 1760515200}, {...}, ...]
+ *   - 首元素为格式版本 AQUA_CBOR_VERSION
+ *   - 其后每个 map 为一个采样，对应 JSON 批量上报中的一个 services 元素
+ *   - 键 0..AQUA_REPORT_FIELD_COUNT-1 为属性位号，只出现 field_mask 选中的字段
+ *   - FLOAT 字段为放大 AQUA_CBOR_FLOAT_SCALE 倍后四舍五入的整数
+ *     （与 JSON 的 2 位小数同精度），INT 为整数，BOOL 为 true/false
+ *   - 键 AQUA_CBOR_KEY_EVENT_TIME 为采样时刻（Unix 秒），为 0 时省略
+ *
+ * 所有长度均为定长编码，解码端不接受不定长数组/map。
+ * 设备侧按 aqua_app_set_report_codec 选择编码，云端编解码插件或
+ * 主机工具用 aqua_parse_properties_cbor 还原为 AquaPropertySample。
+ */
+
+#ifndef AQUARIUM_CBOR_H
+#define AQUARIUM_CBOR_H
+
+#include "aquarium_protocol.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AQUA_CBOR_VERSION 1
+#define AQUA_CBOR_FLOAT_SCALE 100
+#define AQUA_CBOR_KEY_EVENT_TIME 23 /* 仍是单字节键，且不与属性位号冲突 */
+
+/* 单个采样编码后的最大长度：map 头 + 每字段 1 字节键 + 5 字节值 + 时间戳 */
+#define AQUA_CBOR_SAMPLE_MAX_LEN (1 + AQUA_REPORT_FIELD_COUNT * 6 + 6)
+
+typedef char aqua_cbor_keys_fit[
+    (AQUA_REPORT_FIELD_COUNT <= AQUA_CBOR_KEY_EVENT_TIME) ? 1 : -1];
+
+/**
+ * @brief 生成 CBOR 属性上报（可携带多个采样）
+ *
+ * @param samples  采样数组（按时间先后排列）
+ * @param count    采样个数
+ * @param buffer   输出缓冲区
+ * @param buf_size 缓冲区大小
+ * @param out_len  [输出] 实际生成的字节数
+ * @return AquaError 错误码
+ */
+AquaError aqua_build_properties_cbor(const AquaPropertySample *samples,
+                                     size_t count, uint8_t *buffer,
+                                     size_t buf_size, size_t *out_len);
+
+/**
+ * @brief 解析 CBOR 属性上报（aqua_build_properties_cbor 的逆运算）
+ *
+ * 未知的整数键（值为整数或布尔）跳过，便于向后兼容新增字段。
+ *
+ * @param data        输入数据
+ * @param len         数据长度
+ * @param samples     [输出] 采样数组
+ * @param max_samples 采样数组容量
+ * @param out_count   [输出] 写入的采样数
+ * @return AQUA_ERR_JSON_PARSE 格式错误、版本不符或字段类型不符；
+ *         AQUA_ERR_BUFFER_TOO_SMALL 采样数超过容量（前 max_samples 个已写入）
+ */
+AquaError aqua_parse_properties_cbor(const uint8_t *data, size_t len,
+                                     AquaPropertySample *samples,
+                                     size_t max_samples, size_t *out_count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AQUARIUM_CBOR_H */
@@ -0,0 +1,214 @@
+/**
+ * @file aquarium_format.c
+ * @brief 轻量文本格式化实现（仅整数运算 + 单精度乘法）
+ */
+
+#include "aquarium_format.h"
+#include <string.h>
+
+static const uint32_t POW10[AQUA_FMT_MAX_DECIMALS + 1] = {
+    1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u};
+
+void aqua_fmt_init(AquaFmt *f, char *buf, size_t size) {
+  f->buf = buf;
+  f->size = size;
+  f->len = 0;
+  f->overflow = (buf == NULL || size == 0);
+  f->sink = NULL;
+  f->sink_ctx = NULL;
+  f->flushed = 0;
+  if (!f->overflow) {
+    buf[0] = '\0';
+  }
+}
+
+void aqua_fmt_init_sink(AquaFmt *f, char *buf, size_t size, AquaFmtSink sink,
+                        void *ctx) {
+  f->buf = buf;
+  f->size = buf ? size : 0;
+  f->len = 0;
+  f->overflow = (sink == NULL);
+  f->sink = sink;
+  f->sink_ctx = ctx;
+  f->flushed = 0;
+}
+
+static void fmt_sink_emit(AquaFmt *f, const char *s, size_t len) {
+  if (len == 0 || f->overflow) {
+    return;
+  }
+  if (!f->sink(f->sink_ctx, s, len)) {
+    f->overflow = true;
+    return;
+  }
+  f->flushed += len;
+}
+
+static void fmt_sink_flush(AquaFmt *f) {
+  fmt_sink_emit(f, f->buf, f->len);
+  f->len = 0;
+}
+
+/* 回调模式：凑满暂存区再整块输出，超过暂存区的数据直接输出 */
+static void fmt_sink_mem(AquaFmt *f, const char *s, size_t len) {
+  if (len == 0) {
+    return;
+  }
+  if (len > f->size - f->len) {
+    fmt_sink_flush(f);
+    if (len > f->size) {
+      fmt_sink_emit(f, s, len);
+      return;
+    }
+  }
+  memcpy(f->buf + f->len, s, len);
+  f->len += len;
+}
+
+void aqua_fmt_mem(AquaFmt *f, const char *s, size_t len) {
+  if (f->overflow) {
+    return;
+  }
+  if (f->sink) {
+    fmt_sink_mem(f, s, len);
+    return;
+  }
+  /* 保留 1 字节给 '\0' */
+  if (len >= f->size - f->len) {
+    f->overflow = true;
+    return;
+  }
+  memcpy(f->buf + f->len, s, len);
+  f->len += len;
+  f->buf[f->len] = '\0';
+}
+
+void aqua_fmt_char(AquaFmt *f, char c) {
+  /* 单字符是 JSON 标点的常见路径，缓冲模式下直接写入 */
+  if (!f->sink && !f->overflow && f->len + 1 < f->size) {
+    f->buf[f->len++] = c;
+    f->buf[f->len] = '\0';
+    return;
+  }
+  aqua_fmt_mem(f, &c, 1);
+}
+
+void aqua_fmt_str(AquaFmt *f, const char *s) {
+  aqua_fmt_mem(f, s, s ? strlen(s) : 0);
+}
+
+void aqua_fmt_bool(AquaFmt *f, bool v) {
+  if (v) {
+    aqua_fmt_mem(f, "true", 4);
+  } else {
+    aqua_fmt_mem(f, "false", 5);
+  }
+}
+
+/* 将 v 写成至少 min_digits 位（不足补 0）的十进制 */
+static void fmt_u32_padded(AquaFmt *f, uint32_t v, uint8_t min_digits) {
+  char tmp[10];
+  size_t n = 0;
+
+  do {
+    tmp[sizeof(tmp) - 1 - n] = (char)('0' + (v % 10u));
+    v /= 10u;
+    n++;
+  } while (v != 0);
+
+  while (n < min_digits && n < sizeof(tmp)) {
+    tmp[sizeof(tmp) - 1 - n] = '0';
+    n++;
+  }
+
+  aqua_fmt_mem(f, &tmp[sizeof(tmp) - n], n);
+}
+
+void aqua_fmt_u32(AquaFmt *f, uint32_t v) { fmt_u32_padded(f, v, 1); }
+
+void aqua_fmt_i32(AquaFmt *f, int32_t v) {
+  if (v < 0) {
+    aqua_fmt_char(f, '-');
+    /* INT32_MIN 取反需在无符号域完成 */
+    aqua_fmt_u32(f, 0u - (uint32_t)v);
+  } else {
+    aqua_fmt_u32(f, (uint32_t)v);
+  }
+}
+
+void aqua_fmt_fixed(AquaFmt *f, float v, uint8_t decimals) {
+  if (decimals > AQUA_FMT_MAX_DECIMALS) {
+    decimals = AQUA_FMT_MAX_DECIMALS;
+  }
+
+  /* NaN/Inf 输出为 0，与原 aqua_safe_float 行为一致 */
+  if (!((v == v) && ((v - v) == 0.0f))) {
+    v = 0.0f;
+  }
+
+  bool negative = (v < 0.0f);
+  float a = negative ? -v : v;
+  uint32_t scale = POW10[decimals];
+  uint32_t whole;
+  uint32_t frac;
+
+  if (a >= 4294967295.0f) {
+    whole = 0xFFFFFFFFu;
+    frac = 0;
+  } else {
+    /* 先拆出整数部分，小数部分的缩放误差远小于 1 个末位 */
+    whole = (uint32_t)a;
+    frac = (uint32_t)((a - (float)whole) * (float)scale + 0.5f);
+    if (frac >= scale) {
+      frac -= scale;
+      if (whole != 0xFFFFFFFFu) {
+        whole++;
+      }
+    }
+  }
+
+  /* 舍入后为 0 时不输出 "-0.00" */
+  if (negative && (whole != 0 || frac != 0)) {
+    aqua_fmt_char(f, '-');
+  }
+  aqua_fmt_u32(f, whole);
+  if (decimals > 0) {
+    aqua_fmt_char(f, '.');
+    fmt_u32_padded(f, frac, decimals);
+  }
+}
+
+void aqua_fmt_event_time(AquaFmt *f, uint32_t unix_seconds) {
+  uint32_t days = unix_seconds / 86400u;
+  uint32_t secs = unix_seconds % 86400u;
+
+  /* 公历日期换算（Howard Hinnant civil_from_days，纪元从 0000-03-01 起算） */
+  uint32_t z = days + 719468u;
+  uint32_t era = z / 146097u;
+  uint32_t doe = z - era * 146097u;
+  uint32_t yoe = (doe - doe / 1460u + doe / 36524u - doe / 146096u) / 365u;
+  uint32_t doy = doe - (365u * yoe + yoe / 4u - yoe / 100u);
+  uint32_t mp = (5u * doy + 2u) / 153u;
+  uint32_t day = doy - (153u * mp + 2u) / 5u + 1u;
+  uint32_t month = (mp < 10u) ? mp + 3u : mp - 9u;
+  uint32_t year = yoe + era * 400u + (month <= 2u ? 1u : 0u);
+
+  fmt_u32_padded(f, year, 4);
+  fmt_u32_padded(f, month, 2);
+  fmt_u32_padded(f, day, 2);
+  aqua_fmt_char(f, 'T');
+  fmt_u32_padded(f, secs / 3600u, 2);
+  fmt_u32_padded(f, (secs / 60u) % 60u, 2);
+  fmt_u32_padded(f, secs % 60u, 2);
+  aqua_fmt_char(f, 'Z');
+}
+
+bool aqua_fmt_finish(AquaFmt *f, size_t *out_len) {
+  if (f->sink) {
+    fmt_sink_flush(f);
+  }
+  if (out_len) {
+    *out_len = f->flushed + f->len;
+  }
+  return !f->overflow;
+}
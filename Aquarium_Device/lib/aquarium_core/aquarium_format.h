@@ -0,0 +1,112 @@
+/**
+ * @file aquarium_format.h
+ * @brief 轻量文本格式化（替代 snprintf）
+ *
+ * 协议层只需要拼接字符串、整数和固定小数位的浮点数。
+ * 这里用整数运算完成格式化，固件无需链接带浮点支持的 printf
+ * （newlib-nano 默认不含 %f，开启 -u _printf_float 需额外数 KB Flash）。
+ *
+ * 用法：
+ *   AquaFmt f;
+ *   aqua_fmt_init(&f, buf, sizeof(buf));
+ *   aqua_fmt_str(&f, "{\"t\":");
+ *   aqua_fmt_fixed(&f, 26.5f, 2);
+ *   aqua_fmt_char(&f, '}');
+ *   if (!aqua_fmt_finish(&f, &len)) { ... 缓冲区不足 ... }
+ *
+ * 也可以挂接输出回调（sink）：缓冲区只作暂存，写满即交给回调，
+ * 适合把报文直接写入传输层或只统计长度。
+ */
+
+#ifndef AQUARIUM_FORMAT_H
+#define AQUARIUM_FORMAT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 固定小数位上限（10^AQUA_FMT_MAX_DECIMALS 须在 uint32 范围内） */
+#define AQUA_FMT_MAX_DECIMALS 6
+
+/**
+ * @brief 输出回调
+ *
+ * @param ctx  aqua_fmt_init_sink 传入的上下文
+ * @param data 待输出的数据（不以 '\0' 结尾）
+ * @return false 表示输出失败，之后的写入全部丢弃
+ */
+typedef bool (*AquaFmtSink)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief 追加写入的输出缓冲区
+ *
+ * 缓冲模式：空间不足时停止写入并置 overflow，缓冲区始终保持 '\0' 结尾。
+ * 回调模式：buf 为暂存区（可为 NULL，此时每次写入直接交给回调），
+ * 写满时整块交给回调；回调失败时置 overflow。
+ */
+typedef struct {
+  char *buf;
+  size_t size;
+  size_t len; /* 缓冲区中尚未交给回调的字节数 */
+  bool overflow;
+  AquaFmtSink sink;
+  void *sink_ctx;
+  size_t flushed; /* 已交给回调的字节数 */
+} AquaFmt;
+
+void aqua_fmt_init(AquaFmt *f, char *buf, size_t size);
+
+/**
+ * @brief 以回调模式初始化
+ *
+ * @param buf  暂存区，可为 NULL（size 须为 0）
+ * @param sink 输出回调，不可为 NULL
+ */
+void aqua_fmt_init_sink(AquaFmt *f, char *buf, size_t size, AquaFmtSink sink,
+                        void *ctx);
+
+void aqua_fmt_char(AquaFmt *f, char c);
+
+void aqua_fmt_str(AquaFmt *f, const char *s);
+
+void aqua_fmt_mem(AquaFmt *f, const char *s, size_t len);
+
+void aqua_fmt_bool(AquaFmt *f, bool v);
+
+void aqua_fmt_u32(AquaFmt *f, uint32_t v);
+
+void aqua_fmt_i32(AquaFmt *f, int32_t v);
+
+/**
+ * @brief 以固定小数位输出浮点数（等价于 "%.Nf"，四舍五入远离零）
+ *
+ * NaN/Inf 输出为 0；绝对值超出 uint32 整数部分时饱和到 4294967295。
+ *
+ * @param decimals 小数位数，超过 AQUA_FMT_MAX_DECIMALS 时按上限处理
+ */
+void aqua_fmt_fixed(AquaFmt *f, float v, uint8_t decimals);
+
+/**
+ * @brief 以 IoTDA event_time 格式输出 UTC 时间（yyyyMMdd'T'HHmmss'Z'）
+ *
+ * @param unix_seconds 自 1970-01-01 00:00:00 UTC 起的秒数
+ */
+void aqua_fmt_event_time(AquaFmt *f, uint32_t unix_seconds);
+
+/**
+ * @brief 结束格式化（回调模式下先交出暂存区中剩余的数据）
+ *
+ * @param out_len 输出总长度（不含 '\0'），可为 NULL
+ * @return true 全部内容已写入；false 缓冲区不足或回调失败（内容被截断）
+ */
+bool aqua_fmt_finish(AquaFmt *f, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AQUARIUM_FORMAT_H */
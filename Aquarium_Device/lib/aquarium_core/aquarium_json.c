@@ -0,0 +1,208 @@
+/**
+ * @file aquarium_json.c
+ * @brief 追加式 JSON 写入器实现
+ */
+
+#include "aquarium_json.h"
+#include <string.h>
+
+static void jw_reset(AquaJsonWriter *w) {
+  w->depth = 0;
+  w->has_items = 0;
+  w->after_key = false;
+  w->error = false;
+}
+
+void aqua_jw_init(AquaJsonWriter *w, char *buf, size_t size) {
+  aqua_fmt_init(&w->out, buf, size);
+  jw_reset(w);
+}
+
+void aqua_jw_init_sink(AquaJsonWriter *w, char *buf, size_t size,
+                       AquaFmtSink sink, void *ctx) {
+  aqua_fmt_init_sink(&w->out, buf, size, sink, ctx);
+  jw_reset(w);
+}
+
+/* 值或键之前：同层非首个元素加逗号 */
+static void jw_separator(AquaJsonWriter *w) {
+  if (w->after_key) {
+    w->after_key = false;
+    return;
+  }
+  if (w->depth == 0) {
+    return;
+  }
+  uint8_t bit = (uint8_t)(1u << (w->depth - 1));
+  if (w->has_items & bit) {
+    aqua_fmt_char(&w->out, ',');
+  }
+  w->has_items |= bit;
+}
+
+static void jw_open(AquaJsonWriter *w, char c) {
+  jw_separator(w);
+  if (w->depth >= AQUA_JW_MAX_DEPTH) {
+    w->error = true;
+    return;
+  }
+  aqua_fmt_char(&w->out, c);
+  w->depth++;
+  w->has_items &= (uint8_t)~(1u << (w->depth - 1));
+}
+
+static void jw_close(AquaJsonWriter *w, char c) {
+  if (w->depth == 0 || w->after_key) {
+    w->error = true;
+    return;
+  }
+  aqua_fmt_char(&w->out, c);
+  w->depth--;
+}
+
+void aqua_jw_begin_obj(AquaJsonWriter *w) { jw_open(w, '{'); }
+
+void aqua_jw_end_obj(AquaJsonWriter *w) { jw_close(w, '}'); }
+
+void aqua_jw_begin_arr(AquaJsonWriter *w) { jw_open(w, '['); }
+
+void aqua_jw_end_arr(AquaJsonWriter *w) { jw_close(w, ']'); }
+
+void aqua_jw_key(AquaJsonWriter *w, const char *key) {
+  jw_separator(w);
+  aqua_fmt_char(&w->out, '"');
+  aqua_fmt_str(&w->out, key);
+  aqua_fmt_mem(&w->out, "\":", 2);
+  w->after_key = true;
+}
+
+void aqua_jw_str_begin(AquaJsonWriter *w) {
+  jw_separator(w);
+  aqua_fmt_char(&w->out, '"');
+}
+
+void aqua_jw_str_append(AquaJsonWriter *w, const char *s) {
+  static const char HEX[] = "0123456789abcdef";
+
+  if (!s) {
+    return;
+  }
+
+  /* 连续的普通字符整段写出，只对需转义的字符单独处理 */
+  const char *run = s;
+  for (; *s; ++s) {
+    unsigned char c = (unsigned char)*s;
+    if (c >= 0x20 && c != '"' && c != '\\') {
+      continue;
+    }
+    aqua_fmt_mem(&w->out, run, (size_t)(s - run));
+    run = s + 1;
+
+    char esc[6] = {'\\', (char)c, 0, 0, 0, 0};
+    size_t esc_len = 2;
+    switch (c) {
+    case '"':
+    case '\\':
+      break;
+    case '\n':
+      esc[1] = 'n';
+      break;
+    case '\r':
+      esc[1] = 'r';
+      break;
+    case '\t':
+      esc[1] = 't';
+      break;
+    case '\b':
+      esc[1] = 'b';
+      break;
+    case '\f':
+      esc[1] = 'f';
+      break;
+    default:
+      esc[1] = 'u';
+      esc[2] = '0';
+      esc[3] = '0';
+      esc[4] = HEX[c >> 4];
+      esc[5] = HEX[c & 0x0F];
+      esc_len = 6;
+      break;
+    }
+    aqua_fmt_mem(&w->out, esc, esc_len);
+  }
+  aqua_fmt_mem(&w->out, run, (size_t)(s - run));
+}
+
+void aqua_jw_str_end(AquaJsonWriter *w) { aqua_fmt_char(&w->out, '"'); }
+
+void aqua_jw_str(AquaJsonWriter *w, const char *s) {
+  aqua_jw_str_begin(w);
+  aqua_jw_str_append(w, s);
+  aqua_jw_str_end(w);
+}
+
+void aqua_jw_i32(AquaJsonWriter *w, int32_t v) {
+  jw_separator(w);
+  aqua_fmt_i32(&w->out, v);
+}
+
+void aqua_jw_u32(AquaJsonWriter *w, uint32_t v) {
+  jw_separator(w);
+  aqua_fmt_u32(&w->out, v);
+}
+
+void aqua_jw_f32(AquaJsonWriter *w, float v, uint8_t decimals) {
+  jw_separator(w);
+  aqua_fmt_fixed(&w->out, v, decimals);
+}
+
+void aqua_jw_bool(AquaJsonWriter *w, bool v) {
+  jw_separator(w);
+  aqua_fmt_bool(&w->out, v);
+}
+
+void aqua_jw_raw(AquaJsonWriter *w, const char *s, size_t len) {
+  jw_separator(w);
+  aqua_fmt_mem(&w->out, s, len);
+}
+
+void aqua_jw_key_obj(AquaJsonWriter *w, const char *key) {
+  aqua_jw_key(w, key);
+  aqua_jw_begin_obj(w);
+}
+
+void aqua_jw_key_arr(AquaJsonWriter *w, const char *key) {
+  aqua_jw_key(w, key);
+  aqua_jw_begin_arr(w);
+}
+
+void aqua_jw_key_str(AquaJsonWriter *w, const char *key, const char *s) {
+  aqua_jw_key(w, key);
+  aqua_jw_str(w, s);
+}
+
+void aqua_jw_key_i32(AquaJsonWriter *w, const char *key, int32_t v) {
+  aqua_jw_key(w, key);
+  aqua_jw_i32(w, v);
+}
+
+void aqua_jw_key_u32(AquaJsonWriter *w, const char *key, uint32_t v) {
+  aqua_jw_key(w, key);
+  aqua_jw_u32(w, v);
+}
+
+void aqua_jw_key_f32(AquaJsonWriter *w, const char *key, float v,
+                     uint8_t decimals) {
+  aqua_jw_key(w, key);
+  aqua_jw_f32(w, v, decimals);
+}
+
+void aqua_jw_key_bool(AquaJsonWriter *w, const char *key, bool v) {
+  aqua_jw_key(w, key);
+  aqua_jw_bool(w, v);
+}
+
+bool aqua_jw_finish(AquaJsonWriter *w, size_t *out_len) {
+  bool ok = aqua_fmt_finish(&w->out, out_len);
+  return ok && !w->error && w->depth == 0 && !w->after_key;
+}
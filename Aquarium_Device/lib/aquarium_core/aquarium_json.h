@@ -0,0 +1,100 @@
+/**
+ * @file aquarium_json.h
+ * @brief 追加式 JSON 写入器
+ *
+ * 在 AquaFmt 之上维护对象/数组嵌套与逗号，所有上报、响应报文共用。
+ * 写入过程中不做逐次检查，最后由 aqua_jw_finish 统一判断是否溢出。
+ * 通过 aqua_jw_init_sink 可以把报文直接写进传输层回调，不经过中间缓冲。
+ *
+ * 用法：
+ *   AquaJsonWriter w;
+ *   aqua_jw_init(&w, buf, sizeof(buf));
+ *   aqua_jw_begin_obj(&w);
+ *   aqua_jw_key_f32(&w, "temperature", 26.5f, 2);
+ *   aqua_jw_key_bool(&w, "heater", true);
+ *   aqua_jw_end_obj(&w);
+ *   if (!aqua_jw_finish(&w, &len)) { ... 缓冲区不足 ... }
+ *
+ * 键名按原样输出（调用方保证不含需转义的字符），字符串值会转义。
+ */
+
+#ifndef AQUARIUM_JSON_H
+#define AQUARIUM_JSON_H
+
+#include "aquarium_format.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 最大嵌套层数 */
+#define AQUA_JW_MAX_DEPTH 8
+
+typedef struct {
+  AquaFmt out;
+  uint8_t depth;
+  uint8_t has_items; /* 第 d 位：第 d 层已有元素，下一个元素前需加逗号 */
+  bool after_key;    /* 刚写完键，下一个值不加逗号 */
+  bool error;        /* 嵌套越界或不匹配 */
+} AquaJsonWriter;
+
+void aqua_jw_init(AquaJsonWriter *w, char *buf, size_t size);
+
+/**
+ * @brief 以回调模式初始化，buf 为暂存区（可为 NULL）
+ */
+void aqua_jw_init_sink(AquaJsonWriter *w, char *buf, size_t size,
+                       AquaFmtSink sink, void *ctx);
+
+void aqua_jw_begin_obj(AquaJsonWriter *w);
+void aqua_jw_end_obj(AquaJsonWriter *w);
+void aqua_jw_begin_arr(AquaJsonWriter *w);
+void aqua_jw_end_arr(AquaJsonWriter *w);
+
+/* 写出 "key":，随后必须紧跟一个值 */
+void aqua_jw_key(AquaJsonWriter *w, const char *key);
+
+/* 值（数组元素或紧跟在 aqua_jw_key 之后） */
+void aqua_jw_str(AquaJsonWriter *w, const char *s);
+void aqua_jw_i32(AquaJsonWriter *w, int32_t v);
+void aqua_jw_u32(AquaJsonWriter *w, uint32_t v);
+void aqua_jw_f32(AquaJsonWriter *w, float v, uint8_t decimals);
+void aqua_jw_bool(AquaJsonWriter *w, bool v);
+
+/* 已格式化好的值，按原样输出（如预留的定宽槽位） */
+void aqua_jw_raw(AquaJsonWriter *w, const char *s, size_t len);
+
+/*
+ * 分段写字符串值：begin 写开引号，append 转义追加，end 写闭引号。
+ * 期间也可以直接向 w->out 写入不需转义的内容（如 aqua_fmt_event_time）。
+ */
+void aqua_jw_str_begin(AquaJsonWriter *w);
+void aqua_jw_str_append(AquaJsonWriter *w, const char *s);
+void aqua_jw_str_end(AquaJsonWriter *w);
+
+/* 键 + 值 */
+void aqua_jw_key_obj(AquaJsonWriter *w, const char *key);
+void aqua_jw_key_arr(AquaJsonWriter *w, const char *key);
+void aqua_jw_key_str(AquaJsonWriter *w, const char *key, const char *s);
+void aqua_jw_key_i32(AquaJsonWriter *w, const char *key, int32_t v);
+void aqua_jw_key_u32(AquaJsonWriter *w, const char *key, uint32_t v);
+void aqua_jw_key_f32(AquaJsonWriter *w, const char *key, float v,
+                     uint8_t decimals);
+void aqua_jw_key_bool(AquaJsonWriter *w, const char *key, bool v);
+
+/**
+ * @brief 结束写入
+ *
+ * @param out_len 输出总长度，可为 NULL
+ * @return true 全部写入且对象/数组已闭合；false 缓冲区不足、回调失败或嵌套错误
+ */
+bool aqua_jw_finish(AquaJsonWriter *w, size_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AQUARIUM_JSON_H */
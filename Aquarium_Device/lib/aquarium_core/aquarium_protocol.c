@@ -4,69 +4,307 @@
  */
 
 #include "aquarium_protocol.h"
-#include <stdio.h>
-#include <stdlib.h>
+#include "aquarium_format.h"
+#include "aquarium_json.h"
+#include <stddef.h>
 #include <string.h>
 
+/* 命令 JSON 长度上限（解析直接读取调用方缓冲区，不做整段拷贝） */
 #define AQUA_JSON_MAX_LEN 1024
 
+#ifdef UNIT_TEST
+uint32_t aqua_json_scan_steps;
+#define JSON_SCAN_STEP() (aqua_json_scan_steps++)
+#else
+#define JSON_SCAN_STEP() ((void)0)
+#endif
 
-static bool aqua_is_finitef(float v) { return (v == v) && ((v - v) == 0.0f); }
 
-static float aqua_safe_float(float v) { return aqua_is_finitef(v) ? v : 0.0f; }
-
-/* 简易 JSON 解析辅助函数声明 */
-static const char *find_json_key(const char *json, const char *key);
-static int parse_json_string(const char *start, char *out, size_t out_size);
-static int parse_json_bool(const char *start, bool *out);
-static int parse_json_int(const char *start, int32_t *out);
-static int parse_json_int_or_string(const char *start, int32_t *out);
-static int parse_json_float(const char *start, float *out);
+/*
+ * 简易 JSON 解析辅助函数声明
+ *
+ * 值解析函数直接工作在 (start, len) 区间上，不依赖 '\0' 结尾。
+ */
+static int parse_json_string(const char *start, size_t len, char *out,
+                             size_t out_size);
+static int parse_json_bool(const char *start, size_t len, bool *out);
+static int parse_json_int(const char *start, size_t len, int32_t *out);
+static int parse_json_int_or_string(const char *start, size_t len,
+                                    int32_t *out);
+static int parse_json_float(const char *start, size_t len, float *out);
 
 /* ============================================================================
  * 属性上报 JSON 生成
  * ============================================================================
  */
 
+typedef enum {
+  REPORT_SLOT_FLOAT, /* 2 位小数 */
+  REPORT_SLOT_INT,
+  REPORT_SLOT_BOOL
+} ReportSlotType;
+
+typedef struct {
+  const char *key;
+  ReportSlotType type;
+  uint16_t offset; /* 在 AquariumProperties 中的偏移 */
+} ReportSlotDesc;
+
+#define REPORT_SLOT(name, type, field)                                         \
+  { name, type, (uint16_t)offsetof(AquariumProperties, field) }
+
+/* 属性上报的字段顺序（下标即 AQUA_PROP_* 位号）；各构建方式共用 */
+static const ReportSlotDesc REPORT_SLOTS[AQUA_REPORT_FIELD_COUNT] = {
+#define AQUA_PROPERTY(name, NAME, type)                                        \
+  REPORT_SLOT(#name, REPORT_SLOT_##type, name),
+#include "aquarium_schema.def"
+};
+
+static void report_slot_format(AquaJsonWriter *w, const ReportSlotDesc *slot,
+                               const AquariumProperties *props) {
+  const uint8_t *base = (const uint8_t *)props + slot->offset;
+
+  switch (slot->type) {
+  case REPORT_SLOT_FLOAT:
+    aqua_jw_key_f32(w, slot->key, *(const float *)base, 2);
+    break;
+  case REPORT_SLOT_INT:
+    aqua_jw_key_i32(w, slot->key, *(const int32_t *)base);
+    break;
+  case REPORT_SLOT_BOOL:
+    aqua_jw_key_bool(w, slot->key, *(const bool *)base);
+    break;
+  }
+}
+
 AquaError aqua_build_properties_json(const AquariumProperties *props,
                                      char *buffer, size_t buf_size,
                                      size_t *out_len) {
+  return aqua_build_properties_fields_json(props, AQUA_PROP_ALL, buffer,
+                                           buf_size, out_len);
+}
+
+void aqua_jw_properties(AquaJsonWriter *w, const AquariumProperties *props,
+                        uint16_t field_mask) {
+  if (!w || !props) {
+    return;
+  }
+  for (size_t i = 0; i < AQUA_REPORT_FIELD_COUNT; ++i) {
+    if (field_mask & (1u << i)) {
+      report_slot_format(w, &REPORT_SLOTS[i], props);
+    }
+  }
+}
+
+/* 上报报文外层：{"services":[ ... ]} */
+static void report_begin(AquaJsonWriter *w) {
+  aqua_jw_begin_obj(w);
+  aqua_jw_key_arr(w, "services");
+}
+
+static void report_end(AquaJsonWriter *w) {
+  aqua_jw_end_arr(w);
+  aqua_jw_end_obj(w);
+}
+
+/* services 元素开头：{"service_id":"Aquarium","properties":{ */
+static void report_service_begin(AquaJsonWriter *w) {
+  aqua_jw_begin_obj(w);
+  aqua_jw_key_str(w, "service_id", SERVICE_ID_AQUARIUM);
+  aqua_jw_key_obj(w, "properties");
+}
+
+/* 写出一个 services 元素；event_time 为 0 时不带时间戳 */
+static void report_write_service(AquaJsonWriter *w,
+                                 const AquariumProperties *props,
+                                 uint16_t field_mask, uint32_t event_time) {
+  report_service_begin(w);
+  aqua_jw_properties(w, props, field_mask);
+  aqua_jw_end_obj(w);
+  if (event_time != 0) {
+    aqua_jw_key(w, "event_time");
+    aqua_jw_str_begin(w);
+    aqua_fmt_event_time(&w->out, event_time);
+    aqua_jw_str_end(w);
+  }
+  aqua_jw_end_obj(w);
+}
+
+AquaError aqua_build_properties_fields_json(const AquariumProperties *props,
+                                            uint16_t field_mask, char *buffer,
+                                            size_t buf_size, size_t *out_len) {
   if (!props || !buffer || !out_len) {
     return AQUA_ERR_NULL_PTR;
   }
 
-  int len = snprintf(
-      buffer, buf_size,
-      "{\"services\":[{"
-      "\"service_id\":\"" SERVICE_ID_AQUARIUM "\","
-      "\"properties\":{"
-      "\"temperature\":%.2f,"
-      "\"ph\":%.2f,"
-      "\"tds\":%.2f,"
-      "\"turbidity\":%.2f,"
-      "\"water_level\":%.2f,"
-      "\"heater\":%s,"
-      "\"pump_in\":%s,"
-      "\"pump_out\":%s,"
-      "\"auto_mode\":%s,"
-      "\"feed_countdown\":%d,"
-      "\"feeding_in_progress\":%s,"
-      "\"alarm_level\":%d,"
-      "\"alarm_muted\":%s"
-      "}}]}",
-      aqua_safe_float(props->temperature), aqua_safe_float(props->ph),
-      aqua_safe_float(props->tds), aqua_safe_float(props->turbidity),
-      aqua_safe_float(props->water_level), props->heater ? "true" : "false",
-      props->pump_in ? "true" : "false", props->pump_out ? "true" : "false",
-      props->auto_mode ? "true" : "false", (int)props->feed_countdown,
-      props->feeding_in_progress ? "true" : "false", (int)props->alarm_level,
-      props->alarm_muted ? "true" : "false");
-
-  if (len < 0 || (size_t)len >= buf_size) {
+  AquaJsonWriter w;
+  aqua_jw_init(&w, buffer, buf_size);
+  report_begin(&w);
+  report_write_service(&w, props, field_mask, 0);
+  report_end(&w);
+
+  if (!aqua_jw_finish(&w, out_len)) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
+  return AQUA_OK;
+}
+
+AquaError aqua_build_properties_batch_json(const AquaPropertySample *samples,
+                                           size_t count, char *buffer,
+                                           size_t buf_size, size_t *out_len) {
+  if (!samples || !buffer || !out_len) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  AquaJsonWriter w;
+  aqua_jw_init(&w, buffer, buf_size);
+  report_begin(&w);
+  for (size_t i = 0; i < count; ++i) {
+    report_write_service(&w, &samples[i].props, samples[i].field_mask,
+                         samples[i].event_time);
+  }
+  report_end(&w);
+
+  if (!aqua_jw_finish(&w, out_len)) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
+  return AQUA_OK;
+}
+
+AquaError aqua_build_sub_devices_report_json(const AquaSubDeviceSample *devices,
+                                             size_t count, char *buffer,
+                                             size_t buf_size, size_t *out_len) {
+  if (!devices || !buffer || !out_len) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  AquaJsonWriter w;
+  aqua_jw_init(&w, buffer, buf_size);
+  aqua_jw_begin_obj(&w);
+  aqua_jw_key_arr(&w, "devices");
+  for (size_t i = 0; i < count; ++i) {
+    const AquaPropertySample *s = &devices[i].sample;
+    if (!devices[i].device_id) {
+      return AQUA_ERR_NULL_PTR;
+    }
+    aqua_jw_begin_obj(&w);
+    aqua_jw_key_str(&w, "device_id", devices[i].device_id);
+    aqua_jw_key_arr(&w, "services");
+    report_write_service(&w, &s->props, s->field_mask, s->event_time);
+    aqua_jw_end_arr(&w);
+    aqua_jw_end_obj(&w);
+  }
+  aqua_jw_end_arr(&w);
+  aqua_jw_end_obj(&w);
+
+  if (!aqua_jw_finish(&w, out_len)) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
+  return AQUA_OK;
+}
+
+/* ============================================================================
+ * 预格式化属性上报帧
+ * ============================================================================
+ */
+
+static size_t report_slot_width(ReportSlotType type) {
+  switch (type) {
+  case REPORT_SLOT_FLOAT:
+    return AQUA_REPORT_SLOT_FLOAT_WIDTH;
+  case REPORT_SLOT_INT:
+    return AQUA_REPORT_SLOT_INT_WIDTH;
+  default:
+    return AQUA_REPORT_SLOT_BOOL_WIDTH;
+  }
+}
+
+/* 将单个字段右对齐写入槽位 */
+static void report_frame_patch(AquaReportFrame *frame, size_t index,
+                               const AquariumProperties *props) {
+  const ReportSlotDesc *slot = &REPORT_SLOTS[index];
+  char *dst = &frame->buf[frame->slot_pos[index]];
+  size_t width = report_slot_width(slot->type);
+
+  if (slot->type == REPORT_SLOT_BOOL) {
+    const bool *v = (const bool *)((const uint8_t *)props + slot->offset);
+    memcpy(dst, *v ? "true " : "false", AQUA_REPORT_SLOT_BOOL_WIDTH);
+    return;
+  }
+
+  char tmp[16];
+  AquaFmt f;
+  aqua_fmt_init(&f, tmp, sizeof(tmp));
+
+  if (slot->type == REPORT_SLOT_FLOAT) {
+    /* 饱和到槽位可表示的范围，保证不越界覆盖骨架 */
+    float v = *(const float *)((const uint8_t *)props + slot->offset);
+    if (v > 99999.99f) {
+      v = 99999.99f;
+    } else if (v < -99999.99f) {
+      v = -99999.99f;
+    }
+    aqua_fmt_fixed(&f, v, 2);
+  } else {
+    aqua_fmt_i32(&f,
+                 *(const int32_t *)((const uint8_t *)props + slot->offset));
+  }
+
+  size_t n = f.len;
+  memset(dst, ' ', width - n);
+  memcpy(dst + (width - n), tmp, n);
+}
+
+AquaError aqua_report_frame_init(AquaReportFrame *frame) {
+  if (!frame) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  static const AquariumProperties zero_props = {0};
+  static const char blanks[AQUA_REPORT_SLOT_INT_WIDTH] = {
+      ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
+  AquaJsonWriter w;
+  aqua_jw_init(&w, frame->buf, sizeof(frame->buf));
+
+  report_begin(&w);
+  report_service_begin(&w);
+  for (size_t i = 0; i < AQUA_REPORT_FIELD_COUNT; ++i) {
+    aqua_jw_key(&w, REPORT_SLOTS[i].key);
+    frame->slot_pos[i] = (uint16_t)w.out.len;
+    aqua_jw_raw(&w, blanks, report_slot_width(REPORT_SLOTS[i].type));
+  }
+  aqua_jw_end_obj(&w);
+  aqua_jw_end_obj(&w);
+  report_end(&w);
+
+  size_t len = 0;
+  if (!aqua_jw_finish(&w, &len)) {
+    frame->len = 0;
     return AQUA_ERR_BUFFER_TOO_SMALL;
   }
+  frame->len = (uint16_t)len;
 
-  *out_len = (size_t)len;
+  for (size_t i = 0; i < AQUA_REPORT_FIELD_COUNT; ++i) {
+    report_frame_patch(frame, i, &zero_props);
+  }
+  return AQUA_OK;
+}
+
+AquaError aqua_report_frame_update(AquaReportFrame *frame,
+                                   const AquariumProperties *props,
+                                   size_t *out_len) {
+  if (!frame || !props || !out_len) {
+    return AQUA_ERR_NULL_PTR;
+  }
+  if (frame->len == 0) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
+
+  for (size_t i = 0; i < AQUA_REPORT_FIELD_COUNT; ++i) {
+    report_frame_patch(frame, i, props);
+  }
+
+  *out_len = frame->len;
   return AQUA_OK;
 }
 
@@ -75,33 +313,74 @@ AquaError aqua_build_properties_json(const AquariumProperties *props,
  * ============================================================================
  */
 
+/* {"result_code":N,"response_name":"<name><suffix>","paras":{...}} */
+static void response_write(AquaJsonWriter *w, int32_t result_code,
+                           const char *name, const char *name_suffix,
+                           const char *result, const char *error,
+                           AquaResponseParasWriter paras_writer,
+                           const void *ctx) {
+  aqua_jw_begin_obj(w);
+  aqua_jw_key_i32(w, "result_code", result_code);
+  aqua_jw_key(w, "response_name");
+  aqua_jw_str_begin(w);
+  aqua_jw_str_append(w, name);
+  aqua_jw_str_append(w, name_suffix);
+  aqua_jw_str_end(w);
+  aqua_jw_key_obj(w, "paras");
+  aqua_jw_key_str(w, "result", result);
+  if (error) {
+    aqua_jw_key_str(w, "error", error);
+  }
+  if (paras_writer) {
+    paras_writer(w, ctx);
+  }
+  aqua_jw_end_obj(w);
+  aqua_jw_end_obj(w);
+}
+
 AquaError aqua_build_response_json(const CommandResponse *resp, char *buffer,
                                    size_t buf_size, size_t *out_len) {
   if (!resp || !buffer || !out_len) {
     return AQUA_ERR_NULL_PTR;
   }
 
-  int len;
-  if (resp->has_error) {
-    len = snprintf(buffer, buf_size,
-                   "{\"result_code\":%d,"
-                   "\"response_name\":\"%s\","
-                   "\"paras\":{\"result\":\"%s\",\"error\":\"%s\"}}",
-                   (int)resp->result_code, resp->response_name, resp->result,
-                   resp->error);
-  } else {
-    len = snprintf(buffer, buf_size,
-                   "{\"result_code\":%d,"
-                   "\"response_name\":\"%s\","
-                   "\"paras\":{\"result\":\"%s\"}}",
-                   (int)resp->result_code, resp->response_name, resp->result);
-  }
+  AquaJsonWriter w;
+  aqua_jw_init(&w, buffer, buf_size);
+  response_write(&w, resp->result_code, resp->response_name, NULL,
+                 resp->result, resp->has_error ? resp->error : NULL, NULL,
+                 NULL);
 
-  if (len < 0 || (size_t)len >= buf_size) {
+  if (!aqua_jw_finish(&w, out_len)) {
     return AQUA_ERR_BUFFER_TOO_SMALL;
   }
+  return AQUA_OK;
+}
+
+AquaError aqua_build_command_response_json(int32_t result_code,
+                                           const char *command_name,
+                                           const char *error, char *buffer,
+                                           size_t buf_size, size_t *out_len) {
+  return aqua_build_command_response_paras_json(
+      result_code, command_name, error, NULL, NULL, buffer, buf_size, out_len);
+}
+
+AquaError aqua_build_command_response_paras_json(
+    int32_t result_code, const char *command_name, const char *error,
+    AquaResponseParasWriter paras_writer, const void *ctx, char *buffer,
+    size_t buf_size, size_t *out_len) {
+  if (!command_name || !buffer || !out_len) {
+    return AQUA_ERR_NULL_PTR;
+  }
 
-  *out_len = (size_t)len;
+  AquaJsonWriter w;
+  aqua_jw_init(&w, buffer, buf_size);
+  response_write(&w, result_code, command_name, "_response",
+                 (result_code == 0) ? "success" : "failed", error,
+                 paras_writer, ctx);
+
+  if (!aqua_jw_finish(&w, out_len)) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
   return AQUA_OK;
 }
 
@@ -136,39 +415,122 @@ AquaError aqua_extract_request_id(const char *topic, char *request_id,
   return AQUA_OK;
 }
 
-AquaError aqua_build_response_topic(const char *device_id,
-                                    const char *request_id, char *buffer,
-                                    size_t buf_size, size_t *out_len) {
+/* 下标为 AquaDownlinkType，即 sys/ 之后、request_id= 之前的部分 */
+static const char *const DOWNLINK_KINDS[] = {
+    NULL,
+    "commands/",
+    "properties/set/",
+    "properties/get/",
+};
+
+AquaDownlinkType aqua_parse_downlink_topic(const char *topic) {
+  if (!topic) {
+    return AQUA_DOWNLINK_UNKNOWN;
+  }
+
+  const char *sys = strstr(topic, "/sys/");
+  if (!sys) {
+    return AQUA_DOWNLINK_UNKNOWN;
+  }
+  sys += 5;
+
+  for (size_t t = AQUA_DOWNLINK_COMMAND; t <= AQUA_DOWNLINK_PROPERTIES_GET;
+       ++t) {
+    size_t len = strlen(DOWNLINK_KINDS[t]);
+    if (strncmp(sys, DOWNLINK_KINDS[t], len) == 0 &&
+        strncmp(sys + len, "request_id=", 11) == 0) {
+      return (AquaDownlinkType)t;
+    }
+  }
+  return AQUA_DOWNLINK_UNKNOWN;
+}
+
+AquaError aqua_build_downlink_response_topic(const char *device_id,
+                                             AquaDownlinkType type,
+                                             const char *request_id,
+                                             char *buffer, size_t buf_size,
+                                             size_t *out_len) {
   if (!device_id || !request_id || !buffer || !out_len) {
     return AQUA_ERR_NULL_PTR;
   }
+  if (type < AQUA_DOWNLINK_COMMAND || type > AQUA_DOWNLINK_PROPERTIES_GET) {
+    return AQUA_ERR_TOPIC_PARSE;
+  }
 
-  int len = snprintf(buffer, buf_size,
-                     "$oc/devices/%s/sys/commands/response/request_id=%s",
-                     device_id, request_id);
+  AquaFmt f;
+  aqua_fmt_init(&f, buffer, buf_size);
+  aqua_fmt_str(&f, "$oc/devices/");
+  aqua_fmt_str(&f, device_id);
+  aqua_fmt_str(&f, "/sys/");
+  aqua_fmt_str(&f, DOWNLINK_KINDS[type]);
+  aqua_fmt_str(&f, "response/request_id=");
+  aqua_fmt_str(&f, request_id);
 
-  if (len < 0 || (size_t)len >= buf_size) {
+  if (!aqua_fmt_finish(&f, out_len)) {
     return AQUA_ERR_BUFFER_TOO_SMALL;
   }
-
-  *out_len = (size_t)len;
   return AQUA_OK;
 }
 
+AquaError aqua_build_response_topic(const char *device_id,
+                                    const char *request_id, char *buffer,
+                                    size_t buf_size, size_t *out_len) {
+  return aqua_build_downlink_response_topic(device_id, AQUA_DOWNLINK_COMMAND,
+                                            request_id, buffer, buf_size,
+                                            out_len);
+}
+
 AquaError aqua_build_report_topic(const char *device_id, char *buffer,
                                   size_t buf_size, size_t *out_len) {
   if (!device_id || !buffer || !out_len) {
     return AQUA_ERR_NULL_PTR;
   }
 
-  int len = snprintf(buffer, buf_size, "$oc/devices/%s/sys/properties/report",
-                     device_id);
+  AquaFmt f;
+  aqua_fmt_init(&f, buffer, buf_size);
+  aqua_fmt_str(&f, "$oc/devices/");
+  aqua_fmt_str(&f, device_id);
+  aqua_fmt_str(&f, "/sys/properties/report");
 
-  if (len < 0 || (size_t)len >= buf_size) {
+  if (!aqua_fmt_finish(&f, out_len)) {
     return AQUA_ERR_BUFFER_TOO_SMALL;
   }
+  return AQUA_OK;
+}
 
-  *out_len = (size_t)len;
+AquaError aqua_build_gateway_report_topic(const char *gateway_id, char *buffer,
+                                          size_t buf_size, size_t *out_len) {
+  if (!gateway_id || !buffer || !out_len) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  AquaFmt f;
+  aqua_fmt_init(&f, buffer, buf_size);
+  aqua_fmt_str(&f, "$oc/devices/");
+  aqua_fmt_str(&f, gateway_id);
+  aqua_fmt_str(&f, "/sys/gateway/sub_devices/properties/report");
+
+  if (!aqua_fmt_finish(&f, out_len)) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
+  return AQUA_OK;
+}
+
+AquaError aqua_build_message_up_topic(const char *device_id, char *buffer,
+                                      size_t buf_size, size_t *out_len) {
+  if (!device_id || !buffer || !out_len) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  AquaFmt f;
+  aqua_fmt_init(&f, buffer, buf_size);
+  aqua_fmt_str(&f, "$oc/devices/");
+  aqua_fmt_str(&f, device_id);
+  aqua_fmt_str(&f, "/sys/messages/up");
+
+  if (!aqua_fmt_finish(&f, out_len)) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
   return AQUA_OK;
 }
 
@@ -177,24 +539,12 @@ AquaError aqua_build_report_topic(const char *device_id, char *buffer,
  * ============================================================================
  */
 
-static const char *find_json_key(const char *json, const char *key) {
-  char pattern[64];
-  snprintf(pattern, sizeof(pattern), "\"%s\"", key);
-  const char *pos = strstr(json, pattern);
-  if (!pos)
-    return NULL;
-
-  pos += strlen(pattern);
-  while (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')
-    pos++;
-  if (*pos != ':')
-    return NULL;
-  pos++;
-  while (*pos == ' ' || *pos == '\t' || *pos == '\n' || *pos == '\r')
-    pos++;
-  return pos;
+static bool is_json_ws(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
 }
 
+static bool is_json_digit(char c) { return c >= '0' && c <= '9'; }
+
 static int parse_hex_nibble(char c) {
   if (c >= '0' && c <= '9')
     return (int)(c - '0');
@@ -205,15 +555,18 @@ static int parse_hex_nibble(char c) {
   return -1;
 }
 
-static int parse_json_string(const char *start, char *out, size_t out_size) {
-  if (!start || !out || out_size == 0 || *start != '"')
+static int parse_json_string(const char *start, size_t len, char *out,
+                             size_t out_size) {
+  if (!start || !out || out_size == 0 || len == 0 || *start != '"')
     return -1;
 
-  start++;
+  const char *p = start + 1;
+  const char *end = start + len;
   size_t i = 0;
 
-  while (*start) {
-    char ch = *start;
+  while (p < end) {
+    JSON_SCAN_STEP();
+    char ch = *p;
     if (ch == '"') {
       out[i] = '\0';
       return 0;
@@ -224,289 +577,1460 @@ static int parse_json_string(const char *start, char *out, size_t out_size) {
     }
 
     if (ch == '\\') {
-      start++;
-      ch = *start;
-      if (ch == '\0') {
+      if (++p >= end) {
         return -1;
       }
+      ch = *p;
 
       switch (ch) {
       case '"':
       case '\\':
       case '/':
         out[i++] = ch;
-        start++;
         break;
       case 'b':
         out[i++] = '\b';
-        start++;
         break;
       case 'f':
         out[i++] = '\f';
-        start++;
         break;
       case 'n':
         out[i++] = '\n';
-        start++;
         break;
       case 'r':
         out[i++] = '\r';
-        start++;
         break;
       case 't':
         out[i++] = '\t';
-        start++;
         break;
       case 'u': {
+        if (end - p < 5) {
+          return -1;
+        }
         int code = 0;
-        for (int k = 0; k < 4; ++k) {
-          start++;
-          int nibble = parse_hex_nibble(*start);
+        for (int k = 1; k <= 4; ++k) {
+          int nibble = parse_hex_nibble(p[k]);
           if (nibble < 0) {
             return -1;
           }
           code = (code << 4) | nibble;
         }
 
-        if (code < 0x00 || code > 0x7F) {
+        if (code > 0x7F) {
           return -1;
         }
         out[i++] = (char)code;
-        start++;
+        p += 4;
         break;
       }
       default:
         return -1;
       }
 
+      p++;
       continue;
     }
 
     out[i++] = ch;
-    start++;
+    p++;
   }
 
   return -1;
 }
 
-static int parse_json_bool(const char *start, bool *out) {
-  if (strncmp(start, "true", 4) == 0) {
+static int parse_json_bool(const char *start, size_t len, bool *out) {
+  if (len >= 4 && memcmp(start, "true", 4) == 0) {
     *out = true;
     return 0;
-  } else if (strncmp(start, "false", 5) == 0) {
+  } else if (len >= 5 && memcmp(start, "false", 5) == 0) {
     *out = false;
     return 0;
   }
   return -1;
 }
 
-static int parse_json_int(const char *start, int32_t *out) {
-  char *end;
-  long val = strtol(start, &end, 10);
-  if (end == start)
-    return -1;
+/* 解析十进制整数前缀，返回消耗的字符数（0 表示失败或超出 int32 范围） */
+static size_t parse_int_prefix(const char *start, size_t len, int32_t *out) {
+  size_t i = 0;
+  bool negative = false;
+
+  if (i < len && start[i] == '-') {
+    negative = true;
+    i++;
+  }
+
+  size_t digits_start = i;
+  int64_t val = 0;
+  while (i < len && is_json_digit(start[i])) {
+    JSON_SCAN_STEP();
+    val = val * 10 + (start[i] - '0');
+    if (val > (int64_t)INT32_MAX + 1) {
+      return 0;
+    }
+    i++;
+  }
+  if (i == digits_start) {
+    return 0;
+  }
+
+  if (negative) {
+    val = -val;
+  } else if (val > INT32_MAX) {
+    return 0;
+  }
+
   *out = (int32_t)val;
-  return 0;
+  return i;
 }
 
-static int parse_json_int_or_string(const char *start, int32_t *out) {
+static int parse_json_int(const char *start, size_t len, int32_t *out) {
+  return (parse_int_prefix(start, len, out) > 0) ? 0 : -1;
+}
+
+static int parse_json_int_or_string(const char *start, size_t len,
+                                    int32_t *out) {
   if (!start || !out) {
     return -1;
   }
 
-  if (parse_json_int(start, out) == 0) {
+  if (parse_json_int(start, len, out) == 0) {
     return 0;
   }
 
   char text[16];
-  if (parse_json_string(start, text, sizeof(text)) != 0) {
+  if (parse_json_string(start, len, text, sizeof(text)) != 0) {
     return -1;
   }
 
-  char *end = NULL;
-  long val = strtol(text, &end, 10);
-  if (end == text || *end != '\0') {
+  size_t text_len = strlen(text);
+  if (text_len == 0 || parse_int_prefix(text, text_len, out) != text_len) {
     return -1;
   }
-  *out = (int32_t)val;
   return 0;
 }
 
-static int parse_json_float(const char *start, float *out) {
-  char *end;
-  double val = strtod(start, &end);
-  if (end == start)
+/*
+ * 解析 JSON 数字为 float，不依赖 strtod：
+ * 最多保留 9 位有效数字，按十进制指数一次缩放。
+ */
+static int parse_json_float(const char *start, size_t len, float *out) {
+  const char *p = start;
+  const char *end = start + len;
+  bool negative = false;
+  uint32_t mantissa = 0;
+  int mantissa_digits = 0;
+  int exp10 = 0;
+  bool any_digit = false;
+
+  if (p < end && *p == '-') {
+    negative = true;
+    p++;
+  }
+
+  while (p < end && is_json_digit(*p)) {
+    JSON_SCAN_STEP();
+    any_digit = true;
+    if (mantissa_digits < 9) {
+      mantissa = mantissa * 10u + (uint32_t)(*p - '0');
+      if (mantissa != 0)
+        mantissa_digits++;
+    } else {
+      exp10++;
+    }
+    p++;
+  }
+
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && is_json_digit(*p)) {
+      JSON_SCAN_STEP();
+      any_digit = true;
+      if (mantissa_digits < 9) {
+        mantissa = mantissa * 10u + (uint32_t)(*p - '0');
+        if (mantissa != 0)
+          mantissa_digits++;
+        exp10--;
+      }
+      p++;
+    }
+  }
+
+  if (!any_digit) {
     return -1;
-  *out = (float)val;
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    p++;
+    bool exp_negative = false;
+    int exp_val = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+      exp_negative = (*p == '-');
+      p++;
+    }
+    const char *exp_digits = p;
+    while (p < end && is_json_digit(*p)) {
+      JSON_SCAN_STEP();
+      if (exp_val < 1000)
+        exp_val = exp_val * 10 + (*p - '0');
+      p++;
+    }
+    if (p == exp_digits) {
+      return -1;
+    }
+    exp10 += exp_negative ? -exp_val : exp_val;
+  }
+
+  /* float 范围之外直接饱和，交由上层范围校验拒绝 */
+  double scale = 1.0;
+  int abs_exp = (exp10 < 0) ? -exp10 : exp10;
+  if (abs_exp > 60)
+    abs_exp = 60;
+  for (int k = 0; k < abs_exp; ++k)
+    scale *= 10.0;
+
+  double val = (exp10 < 0) ? (double)mantissa / scale
+                           : (double)mantissa * scale;
+  *out = (float)(negative ? -val : val);
   return 0;
 }
 
 /* ============================================================================
- * 命令下发 JSON 解析
+ * 属性上报 JSON 解析
  * ============================================================================
  */
 
-AquaError aqua_parse_command_json(const char *json, size_t json_len,
-                                  ParsedCommand *cmd) {
-  if (!json || !cmd) {
-    return AQUA_ERR_NULL_PTR;
+/* 在 [p, p + n) 上前进的游标；出错后 ok 置 false，后续操作全部失败 */
+typedef struct {
+  const char *p;
+  size_t n;
+  size_t i;
+  bool ok;
+} JsonCursor;
+
+static void jc_ws(JsonCursor *c) {
+  while (c->i < c->n && is_json_ws(c->p[c->i])) {
+    JSON_SCAN_STEP();
+    c->i++;
   }
+}
 
-  if (json_len == 0 || json_len >= AQUA_JSON_MAX_LEN) {
-    return AQUA_ERR_BUFFER_TOO_SMALL;
+/* 跳过空白后若下一个字符为 ch 则消耗它 */
+static bool jc_accept(JsonCursor *c, char ch) {
+  jc_ws(c);
+  if (c->ok && c->i < c->n && c->p[c->i] == ch) {
+    c->i++;
+    return true;
   }
+  return false;
+}
 
-  char json_buf[AQUA_JSON_MAX_LEN];
-  memcpy(json_buf, json, json_len);
-  json_buf[json_len] = '\0';
-  json = json_buf;
+static void jc_expect(JsonCursor *c, char ch) {
+  if (!jc_accept(c, ch)) {
+    c->ok = false;
+  }
+}
 
-  memset(cmd, 0, sizeof(ParsedCommand));
-  cmd->type = COMMAND_TYPE_UNKNOWN;
+/*
+ * 取下一个值的原始文本：字符串含两侧引号，标量到分隔符为止，
+ * 对象/数组整体跳过（按括号计数，不递归）
+ */
+static void jc_value(JsonCursor *c, const char **start, size_t *len) {
+  jc_ws(c);
+  size_t begin = c->i;
+  size_t depth = 0;
+  bool in_string = false;
+
+  while (c->ok && c->i < c->n) {
+    JSON_SCAN_STEP();
+    char ch = c->p[c->i];
+    if (in_string) {
+      if (ch == '\\') {
+        c->i++;
+      } else if (ch == '"') {
+        in_string = false;
+        if (depth == 0) {
+          c->i++;
+          break;
+        }
+      }
+    } else if (ch == '"') {
+      if (depth == 0 && c->i != begin) {
+        break;
+      }
+      in_string = true;
+    } else if (ch == '{' || ch == '[') {
+      depth++;
+    } else if (ch == '}' || ch == ']') {
+      if (depth == 0) {
+        break;
+      }
+      if (--depth == 0) {
+        c->i++;
+        break;
+      }
+    } else if (depth == 0 && (ch == ',' || is_json_ws(ch))) {
+      break;
+    }
+    c->i++;
+  }
 
-  /* 解析 service_id */
-  const char *pos = find_json_key(json, "service_id");
-  if (!pos ||
-      parse_json_string(pos, cmd->service_id, sizeof(cmd->service_id)) != 0) {
-    return AQUA_ERR_MISSING_FIELD;
+  if (in_string || depth != 0 || c->i > c->n || c->i == begin) {
+    c->ok = false;
   }
+  *start = c->p + begin;
+  *len = c->ok ? c->i - begin : 0;
+}
 
-  /* 解析 command_name */
-  pos = find_json_key(json, "command_name");
-  if (!pos || parse_json_string(pos, cmd->command_name,
-                                sizeof(cmd->command_name)) != 0) {
-    return AQUA_ERR_MISSING_FIELD;
+/* 读取对象键（不处理转义，与上报 JSON 的键名一致即可） */
+static void jc_key(JsonCursor *c, const char **key, size_t *key_len) {
+  const char *raw = NULL;
+  size_t len = 0;
+  jc_value(c, &raw, &len);
+  if (!c->ok || len < 2 || raw[0] != '"') {
+    c->ok = false;
+    *key = NULL;
+    *key_len = 0;
+    return;
+  }
+  *key = raw + 1;
+  *key_len = len - 2;
+  jc_expect(c, ':');
+}
+
+/* 对象成员之间：返回 true 表示还有下一个成员 */
+static bool jc_next_member(JsonCursor *c, bool first) {
+  if (!c->ok) {
+    return false;
+  }
+  if (jc_accept(c, '}')) {
+    return false;
+  }
+  if (!first) {
+    jc_expect(c, ',');
+  }
+  return c->ok;
+}
+
+static bool jc_key_is(const char *key, size_t key_len, const char *name) {
+  JSON_SCAN_STEP();
+  size_t name_len = strlen(name);
+  return key_len == name_len && memcmp(key, name, name_len) == 0;
+}
+
+/* aqua_fmt_event_time 的逆运算："yyyyMMdd'T'HHmmss'Z'" → Unix 秒 */
+static int parse_event_time(const char *start, size_t len, uint32_t *out) {
+  uint32_t f[6];
+  static const uint8_t WIDTH[6] = {4, 2, 2, 2, 2, 2};
+
+  if (len != 18 || start[0] != '"' || start[9] != 'T' || start[16] != 'Z' ||
+      start[17] != '"') {
+    return -1;
+  }
+
+  const char *p = start + 1;
+  for (size_t k = 0; k < 6; ++k) {
+    if (k == 3) {
+      p++; /* 'T' */
+    }
+    f[k] = 0;
+    for (uint8_t d = 0; d < WIDTH[k]; ++d, ++p) {
+      if (!is_json_digit(*p)) {
+        return -1;
+      }
+      f[k] = f[k] * 10u + (uint32_t)(*p - '0');
+    }
+  }
+
+  uint32_t year = f[0], month = f[1], day = f[2];
+  if (year < 1970u || month < 1u || month > 12u || day < 1u || day > 31u ||
+      f[3] > 23u || f[4] > 59u || f[5] > 59u) {
+    return -1;
+  }
+
+  /* Howard Hinnant days_from_civil */
+  year -= (month <= 2u) ? 1u : 0u;
+  uint32_t era = year / 400u;
+  uint32_t yoe = year - era * 400u;
+  uint32_t mp = (month > 2u) ? month - 3u : month + 9u;
+  uint32_t doy = (153u * mp + 2u) / 5u + day - 1u;
+  uint32_t doe = yoe * 365u + yoe / 4u - yoe / 100u + doy;
+  uint32_t days = era * 146097u + doe - 719468u;
+
+  uint64_t seconds =
+      (uint64_t)days * 86400u + f[3] * 3600u + f[4] * 60u + f[5];
+  if (seconds > UINT32_MAX) {
+    return -1;
+  }
+  *out = (uint32_t)seconds;
+  return 0;
+}
+
+static int parse_report_field(const ReportSlotDesc *slot, const char *value,
+                              size_t len, AquariumProperties *props) {
+  uint8_t *base = (uint8_t *)props + slot->offset;
+
+  switch (slot->type) {
+  case REPORT_SLOT_FLOAT:
+    return parse_json_float(value, len, (float *)base);
+  case REPORT_SLOT_INT:
+    return parse_json_int(value, len, (int32_t *)base);
+  default:
+    return parse_json_bool(value, len, (bool *)base);
+  }
+}
+
+/* 解析 properties 对象，未知键忽略 */
+static void parse_report_properties(JsonCursor *c, AquaPropertySample *sample) {
+  jc_expect(c, '{');
+  for (bool first = true; jc_next_member(c, first); first = false) {
+    const char *key;
+    size_t key_len;
+    const char *value;
+    size_t value_len;
+    jc_key(c, &key, &key_len);
+    jc_value(c, &value, &value_len);
+    if (!c->ok) {
+      return;
+    }
+
+    for (size_t i = 0; i < AQUA_REPORT_FIELD_COUNT; ++i) {
+      if (jc_key_is(key, key_len, REPORT_SLOTS[i].key)) {
+        if (parse_report_field(&REPORT_SLOTS[i], value, value_len,
+                               &sample->props) != 0) {
+          c->ok = false;
+          return;
+        }
+        sample->field_mask |= (uint16_t)(1u << i);
+        break;
+      }
+    }
+  }
+}
+
+/*
+ * 解析 services 的一个元素；返回 true 表示属于 Aquarium 服务。
+ * service_id 可能在 properties 之后出现，因此先记下 properties 的范围，
+ * 确认服务后再解析，其他服务的同名字段不会被误读。
+ */
+static bool parse_report_service(JsonCursor *c, AquaPropertySample *sample) {
+  bool is_aquarium = false;
+  const char *props = NULL;
+  size_t props_len = 0;
+
+  memset(sample, 0, sizeof(*sample));
+  jc_expect(c, '{');
+  for (bool first = true; jc_next_member(c, first); first = false) {
+    const char *key;
+    size_t key_len;
+    const char *value;
+    size_t value_len;
+    jc_key(c, &key, &key_len);
+    jc_value(c, &value, &value_len);
+    if (!c->ok) {
+      break;
+    }
+
+    if (jc_key_is(key, key_len, "properties")) {
+      props = value;
+      props_len = value_len;
+    } else if (jc_key_is(key, key_len, "service_id")) {
+      is_aquarium = (value_len == sizeof(SERVICE_ID_AQUARIUM) + 1 &&
+                     memcmp(value + 1, SERVICE_ID_AQUARIUM,
+                            sizeof(SERVICE_ID_AQUARIUM) - 1) == 0);
+    } else if (jc_key_is(key, key_len, "event_time")) {
+      if (parse_event_time(value, value_len, &sample->event_time) != 0) {
+        c->ok = false;
+      }
+    }
   }
 
-  /* 定位 paras 对象 */
-  const char *paras = find_json_key(json, "paras");
-  if (!paras) {
+  if (!c->ok || !is_aquarium) {
+    return false;
+  }
+  if (props) {
+    JsonCursor sub = {props, props_len, 0, true};
+    parse_report_properties(&sub, sample);
+    c->ok = sub.ok;
+  }
+  return c->ok;
+}
+
+AquaError aqua_parse_properties_json(const char *json, size_t json_len,
+                                     AquaPropertySample *samples,
+                                     size_t max_samples, size_t *out_count) {
+  if (!json || !out_count || (!samples && max_samples > 0)) {
+    return AQUA_ERR_NULL_PTR;
+  }
+  *out_count = 0;
+
+  JsonCursor c = {json, json_len, 0, true};
+  AquaPropertySample scratch;
+  size_t count = 0;
+  bool has_services = false;
+
+  jc_expect(&c, '{');
+  for (bool first = true; jc_next_member(&c, first); first = false) {
+    const char *key;
+    size_t key_len;
+    jc_key(&c, &key, &key_len);
+    if (!c.ok) {
+      break;
+    }
+
+    if (!jc_key_is(key, key_len, "services")) {
+      const char *value;
+      size_t value_len;
+      jc_value(&c, &value, &value_len);
+      continue;
+    }
+
+    has_services = true;
+    jc_expect(&c, '[');
+    if (jc_accept(&c, ']')) {
+      continue;
+    }
+    do {
+      AquaPropertySample *dst =
+          (count < max_samples) ? &samples[count] : &scratch;
+      if (parse_report_service(&c, dst)) {
+        count++;
+      }
+    } while (c.ok && jc_accept(&c, ','));
+    jc_expect(&c, ']');
+  }
+
+  /* 顶层对象之后只允许空白 */
+  jc_ws(&c);
+  if (!c.ok || c.i != c.n) {
+    return AQUA_ERR_JSON_PARSE;
+  }
+  if (!has_services) {
     return AQUA_ERR_MISSING_FIELD;
   }
 
-  /* 根据 service_id 和 command_name 分流解析 */
-  if (strcmp(cmd->service_id, SERVICE_ID_AQUARIUM_CONTROL) == 0 &&
-      strcmp(cmd->command_name, COMMAND_NAME_CONTROL) == 0) {
-    cmd->type = COMMAND_TYPE_CONTROL;
-    ControlCommandParams *p = &cmd->params.control;
+  *out_count = (count < max_samples) ? count : max_samples;
+  return (count > max_samples) ? AQUA_ERR_BUFFER_TOO_SMALL : AQUA_OK;
+}
 
-    pos = find_json_key(paras, "heater");
-    if (pos && parse_json_bool(pos, &p->heater) == 0)
-      p->has_heater = true;
+/* ============================================================================
+ * 下行请求目标设备
+ * ============================================================================
+ */
 
-    pos = find_json_key(paras, "pump_in");
-    if (pos && parse_json_bool(pos, &p->pump_in) == 0)
-      p->has_pump_in = true;
+AquaError aqua_extract_object_device_id(const char *json, size_t json_len,
+                                        char *out, size_t out_size) {
+  if (!json || !out || out_size == 0) {
+    return AQUA_ERR_NULL_PTR;
+  }
+  out[0] = '\0';
+
+  JsonCursor c = {json, json_len, 0, true};
+  jc_expect(&c, '{');
+  for (bool first = true; jc_next_member(&c, first); first = false) {
+    const char *key;
+    size_t key_len;
+    const char *value;
+    size_t value_len;
+    jc_key(&c, &key, &key_len);
+    jc_value(&c, &value, &value_len);
+    if (!c.ok) {
+      break;
+    }
+    if (jc_key_is(key, key_len, "object_device_id")) {
+      return (parse_json_string(value, value_len, out, out_size) == 0)
+                 ? AQUA_OK
+                 : AQUA_ERR_JSON_PARSE;
+    }
+  }
+  return c.ok ? AQUA_ERR_MISSING_FIELD : AQUA_ERR_JSON_PARSE;
+}
 
-    pos = find_json_key(paras, "pump_out");
-    if (pos && parse_json_bool(pos, &p->pump_out) == 0)
-      p->has_pump_out = true;
+/* ============================================================================
+ * 命令参数字段表
+ * ============================================================================
+ */
 
-    pos = find_json_key(paras, "mute");
-    if (pos && parse_json_bool(pos, &p->mute) == 0)
-      p->has_mute = true;
+typedef struct {
+  const char *key;
+  uint8_t key_len;
+  uint8_t type;          /* AquaFieldType */
+  uint16_t value_offset; /* 值字段在参数结构体中的偏移 */
+  uint16_t has_offset;   /* has_* 标志在参数结构体中的偏移 */
+  uint16_t value_size;   /* 值字段大小（字符串字段为缓冲区大小） */
+} CmdFieldDesc;
+
+#define CMD_FIELD(type_name, field, field_type)                                \
+  {#field, (uint8_t)(sizeof(#field) - 1), (uint8_t)(field_type),               \
+   (uint16_t)offsetof(type_name, field),                                       \
+   (uint16_t)offsetof(type_name, has_##field),                                 \
+   (uint16_t)sizeof(((type_name *)0)->field)}
+
+/* 以下三张表由 aquarium_schema.def 展开 */
+static const CmdFieldDesc CONTROL_FIELDS[] = {
+#define AQUA_CONTROL_PARAM(name, type, min, max)                               \
+  CMD_FIELD(ControlCommandParams, name, AQUA_FIELD_##type),
+#include "aquarium_schema.def"
+};
+
+static const CmdFieldDesc THRESHOLD_FIELDS[] = {
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  CMD_FIELD(ThresholdCommandParams, name, AQUA_FIELD_##type),
+#define AQUA_THRESHOLD_RUNTIME(name, type, min, max)                           \
+  CMD_FIELD(ThresholdCommandParams, name, AQUA_FIELD_##type),
+#include "aquarium_schema.def"
+};
+
+static const CmdFieldDesc CONFIG_FIELDS[] = {
+#define AQUA_CONFIG_PARAM(name, type, min, max, def)                           \
+  CMD_FIELD(ConfigCommandParams, name, AQUA_FIELD_##type),
+#include "aquarium_schema.def"
+};
+
+#define CMD_FIELD_COUNT(table) (sizeof(table) / sizeof((table)[0]))
+
+/* 各字段在上面三张表中的下标，供命令键哈希表引用 */
+enum {
+#define AQUA_CONTROL_PARAM(name, type, min, max) CMD_CONTROL_IDX_##name,
+#include "aquarium_schema.def"
+};
+
+enum {
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  CMD_THRESHOLD_IDX_##name,
+#define AQUA_THRESHOLD_RUNTIME(name, type, min, max) CMD_THRESHOLD_IDX_##name,
+#include "aquarium_schema.def"
+};
+
+enum {
+#define AQUA_CONFIG_PARAM(name, type, min, max, def) CMD_CONFIG_IDX_##name,
+#include "aquarium_schema.def"
+};
+
+static int parse_cmd_field(const CmdFieldDesc *field, const char *value,
+                           size_t len, uint8_t *params) {
+  void *dst = params + field->value_offset;
+
+  switch (field->type) {
+  case AQUA_FIELD_BOOL:
+    return parse_json_bool(value, len, (bool *)dst);
+  case AQUA_FIELD_INT:
+    return parse_json_int(value, len, (int32_t *)dst);
+  case AQUA_FIELD_INT_OR_STRING:
+    return parse_json_int_or_string(value, len, (int32_t *)dst);
+  case AQUA_FIELD_FLOAT:
+    return parse_json_float(value, len, (float *)dst);
+  case AQUA_FIELD_STRING:
+    return parse_json_string(value, len, (char *)dst, field->value_size);
+  default:
+    return -1;
+  }
+}
 
-    pos = find_json_key(paras, "auto_mode");
-    if (pos && parse_json_bool(pos, &p->auto_mode) == 0)
-      p->has_auto_mode = true;
+/* ============================================================================
+ * 命令下发增量解析
+ * ============================================================================
+ */
 
-    pos = find_json_key(paras, "feed");
-    if (pos && parse_json_bool(pos, &p->feed) == 0)
-      p->has_feed = true;
+enum {
+  CMD_PARSER_ST_VALUE = 0,    /* 期待一个值 */
+  CMD_PARSER_ST_KEY_OR_END,   /* '{' 之后：期待键或 '}' */
+  CMD_PARSER_ST_KEY,          /* ',' 之后：期待键 */
+  CMD_PARSER_ST_KEY_STRING,   /* 键字符串内部 */
+  CMD_PARSER_ST_COLON,        /* 期待 ':' */
+  CMD_PARSER_ST_VALUE_OR_END, /* '[' 之后：期待值或 ']' */
+  CMD_PARSER_ST_STRING,       /* 字符串值内部 */
+  CMD_PARSER_ST_SCALAR,       /* 数字 / true / false / null */
+  CMD_PARSER_ST_AFTER_VALUE,  /* 期待 ',' 或闭合括号 */
+  CMD_PARSER_ST_DONE,
+  CMD_PARSER_ST_ERROR
+};
+
+enum {
+  CMD_CAPTURE_NONE = 0,
+  CMD_CAPTURE_SERVICE_ID,
+  CMD_CAPTURE_COMMAND_NAME,
+  CMD_CAPTURE_PARAS,
+  CMD_CAPTURE_PARAM
+};
+
+typedef struct {
+  const CmdFieldDesc *fields;
+  size_t count;
+} CmdFieldTable;
+
+/* 字符串参数解码后须能完整放入解析器的值缓冲区 */
+#define CMD_TOKEN_FITS_BOOL(name, max)
+#define CMD_TOKEN_FITS_INT(name, max)
+#define CMD_TOKEN_FITS_INT_OR_STRING(name, max)
+#define CMD_TOKEN_FITS_FLOAT(name, max)
+#define CMD_TOKEN_FITS_STRING(name, max)                                       \
+  typedef char cmd_token_fits_##name[                                          \
+      ((max) <= AQUA_CMD_PARSER_TOKEN_MAX) ? 1 : -1];
+#define AQUA_CONTROL_PARAM(name, type, min, max)                               \
+  CMD_TOKEN_FITS_##type(name, max)
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  CMD_TOKEN_FITS_##type(name, max)
+#define AQUA_THRESHOLD_RUNTIME(name, type, min, max)                           \
+  CMD_TOKEN_FITS_##type(name, max)
+#define AQUA_CONFIG_PARAM(name, type, min, max, def)                           \
+  CMD_TOKEN_FITS_##type(name, max)
+#include "aquarium_schema.def"
+
+/* 下标与 AquaCmdParser.field_idx 一一对应 */
+static const CmdFieldTable CMD_PARAM_TABLES[3] = {
+    {CONTROL_FIELDS, CMD_FIELD_COUNT(CONTROL_FIELDS)},
+    {THRESHOLD_FIELDS, CMD_FIELD_COUNT(THRESHOLD_FIELDS)},
+    {CONFIG_FIELDS, CMD_FIELD_COUNT(CONFIG_FIELDS)},
+};
+
+static uint8_t *cmd_parser_params(AquaCmdParser *ctx, size_t table) {
+  switch (table) {
+  case 0:
+    return (uint8_t *)&ctx->control;
+  case 1:
+    return (uint8_t *)&ctx->threshold;
+  default:
+    return (uint8_t *)&ctx->config;
+  }
+}
 
-    pos = find_json_key(paras, "feed_once_delay");
-    if (pos && parse_json_int(pos, &p->feed_once_delay) == 0)
-      p->has_feed_once_delay = true;
+/* ============================================================================
+ * 命令键完美哈希
+ *
+ * 顶层键、service_id / command_name 取值与全部参数键共用一张最小完美哈希表，
+ * 由 scripts/gen_cmd_keys.py 生成。第一级 FNV-1a 在读键时逐字节累积，
+ * 键读完后一次查表加一次比较即可得到其全部含义。
+ * ============================================================================
+ */
 
-    pos = find_json_key(paras, "target_temp");
-    if (pos && parse_json_float(pos, &p->target_temp) == 0)
-      p->has_target_temp = true;
+typedef struct {
+  const char *key;
+  uint8_t key_len;
+  uint8_t capture;     /* 顶层键对应的 CMD_CAPTURE_*，否则 NONE */
+  uint8_t service;     /* 作为 service_id 取值时对应的 CommandType */
+  uint8_t command;     /* 作为 command_name 取值时对应的 CommandType */
+  int8_t field_idx[3]; /* 在 control/threshold/config 字段表中的下标 */
+} CmdKeyEntry;
 
-  } else if (strcmp(cmd->service_id, SERVICE_ID_AQUARIUM_THRESHOLD) == 0 &&
-             strcmp(cmd->command_name, COMMAND_NAME_SET_THRESHOLDS) == 0) {
-    cmd->type = COMMAND_TYPE_SET_THRESHOLDS;
-    ThresholdCommandParams *p = &cmd->params.threshold;
+#include "aquarium_cmd_keys.inc"
 
-    pos = find_json_key(paras, "temp_min");
-    if (pos && parse_json_float(pos, &p->temp_min) == 0)
-      p->has_temp_min = true;
+/* 超过解析器键缓冲区的键被视为未知，缓冲区须容纳全部已知键 */
+typedef char cmd_key_fits_parser[
+    (CMD_KEY_MAX_LEN <= AQUA_CMD_PARSER_KEY_MAX) ? 1 : -1];
 
-    pos = find_json_key(paras, "temp_max");
-    if (pos && parse_json_float(pos, &p->temp_max) == 0)
-      p->has_temp_max = true;
+static inline uint32_t cmd_key_hash_step(uint32_t hash, char c) {
+  return (hash ^ (uint8_t)c) * CMD_KEY_HASH_PRIME;
+}
 
-    pos = find_json_key(paras, "ph_min");
-    if (pos && parse_json_float(pos, &p->ph_min) == 0)
-      p->has_ph_min = true;
+/* 按完整哈希值定位唯一候选，再比较原文排除未知键 */
+static const CmdKeyEntry *cmd_key_lookup(uint32_t hash, const char *key,
+                                         size_t key_len) {
+  uint32_t d = CMD_KEY_DISP[hash % CMD_KEY_BUCKETS];
+  uint32_t x = (hash ^ (d * CMD_KEY_MIX_A)) * CMD_KEY_MIX_B;
+  const CmdKeyEntry *entry = &CMD_KEYS[(x >> 16) % CMD_KEY_COUNT];
 
-    pos = find_json_key(paras, "ph_max");
-    if (pos && parse_json_float(pos, &p->ph_max) == 0)
-      p->has_ph_max = true;
+  if (entry->key_len != key_len || memcmp(entry->key, key, key_len) != 0) {
+    return NULL;
+  }
+  return entry;
+}
 
-    pos = find_json_key(paras, "tds_warn");
-    if (pos && parse_json_int(pos, &p->tds_warn) == 0)
-      p->has_tds_warn = true;
+static const CmdKeyEntry *cmd_key_find(const char *key, size_t key_len) {
+  uint32_t hash = CMD_KEY_HASH_BASIS;
+  for (size_t i = 0; i < key_len; ++i) {
+    JSON_SCAN_STEP();
+    hash = cmd_key_hash_step(hash, key[i]);
+  }
+  return cmd_key_lookup(hash, key, key_len);
+}
 
-    pos = find_json_key(paras, "tds_critical");
-    if (pos && parse_json_int(pos, &p->tds_critical) == 0)
-      p->has_tds_critical = true;
+static void cmd_parser_token_push(AquaCmdParser *ctx, char c) {
+  if (ctx->capture == CMD_CAPTURE_NONE || ctx->capture == CMD_CAPTURE_PARAS) {
+    return;
+  }
+  if (ctx->token_len < AQUA_CMD_PARSER_TOKEN_MAX) {
+    ctx->token[ctx->token_len++] = c;
+  } else {
+    ctx->token_overflow = true;
+  }
+}
 
-    pos = find_json_key(paras, "turbidity_warn");
-    if (pos && parse_json_int(pos, &p->turbidity_warn) == 0)
-      p->has_turbidity_warn = true;
+static void cmd_parser_key_push(AquaCmdParser *ctx, char c) {
+  if (ctx->key_len < AQUA_CMD_PARSER_KEY_MAX) {
+    ctx->key[ctx->key_len++] = c;
+    ctx->key_hash = cmd_key_hash_step(ctx->key_hash, c);
+  } else {
+    ctx->key_overflow = true;
+  }
+}
 
-    pos = find_json_key(paras, "turbidity_critical");
-    if (pos && parse_json_int(pos, &p->turbidity_critical) == 0)
-      p->has_turbidity_critical = true;
+static void cmd_parser_end_value(AquaCmdParser *ctx);
 
-    pos = find_json_key(paras, "level_min");
-    if (pos && parse_json_int(pos, &p->level_min) == 0)
-      p->has_level_min = true;
+/*
+ * 字符串值内部的一个字符：边接收边解码转义，只缓存解码后的内容。
+ * 与 parse_json_string 一致，\u 转义只接受 ASCII。
+ */
+static void cmd_parser_string_char(AquaCmdParser *ctx, char c) {
+  if (ctx->hex_left > 0) {
+    int nibble = parse_hex_nibble(c);
+    if (nibble >= 0) {
+      ctx->hex_code = (uint16_t)((ctx->hex_code << 4) | (uint16_t)nibble);
+      if (--ctx->hex_left == 0) {
+        if (ctx->hex_code > 0x7F) {
+          ctx->token_invalid = true;
+        } else {
+          cmd_parser_token_push(ctx, (char)ctx->hex_code);
+        }
+      }
+      return;
+    }
+    /* 非法的 \u 转义：当前字符仍按普通字符处理，以便找到字符串结尾 */
+    ctx->hex_left = 0;
+    ctx->token_invalid = true;
+  }
 
-    pos = find_json_key(paras, "level_max");
-    if (pos && parse_json_int(pos, &p->level_max) == 0)
-      p->has_level_max = true;
+  if (ctx->escape) {
+    ctx->escape = false;
+    switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      cmd_parser_token_push(ctx, c);
+      break;
+    case 'b':
+      cmd_parser_token_push(ctx, '\b');
+      break;
+    case 'f':
+      cmd_parser_token_push(ctx, '\f');
+      break;
+    case 'n':
+      cmd_parser_token_push(ctx, '\n');
+      break;
+    case 'r':
+      cmd_parser_token_push(ctx, '\r');
+      break;
+    case 't':
+      cmd_parser_token_push(ctx, '\t');
+      break;
+    case 'u':
+      ctx->hex_left = 4;
+      ctx->hex_code = 0;
+      break;
+    default:
+      ctx->token_invalid = true;
+      break;
+    }
+    return;
+  }
 
-    pos = find_json_key(paras, "feed_interval");
-    if (pos && parse_json_int(pos, &p->feed_interval) == 0)
-      p->has_feed_interval = true;
+  if (c == '\\') {
+    ctx->escape = true;
+  } else if (c == '"') {
+    cmd_parser_end_value(ctx);
+    ctx->state = CMD_PARSER_ST_AFTER_VALUE;
+  } else {
+    cmd_parser_token_push(ctx, c);
+  }
+}
 
-    pos = find_json_key(paras, "feed_amount");
-    if (pos && parse_json_int_or_string(pos, &p->feed_amount) == 0)
-      p->has_feed_amount = true;
+/* 键读取完毕：根据所在层级决定随后的值是否需要缓存 */
+static void cmd_parser_classify_key(AquaCmdParser *ctx) {
+  ctx->capture = CMD_CAPTURE_NONE;
+  if (ctx->key_overflow || (ctx->depth != 1 && !ctx->in_paras)) {
+    return;
+  }
 
-    pos = find_json_key(paras, "target_temp");
-    if (pos && parse_json_float(pos, &p->target_temp) == 0)
-      p->has_target_temp = true;
+  const CmdKeyEntry *entry =
+      cmd_key_lookup(ctx->key_hash, ctx->key, ctx->key_len);
+  if (!entry) {
+    return;
+  }
 
-  } else if (strcmp(cmd->service_id, SERVICE_ID_AQUARIUM_CONFIG) == 0 &&
-             strcmp(cmd->command_name, COMMAND_NAME_SET_CONFIG) == 0) {
-    cmd->type = COMMAND_TYPE_SET_CONFIG;
-    ConfigCommandParams *p = &cmd->params.config;
+  if (ctx->depth == 1) {
+    if ((entry->capture == CMD_CAPTURE_SERVICE_ID && !ctx->has_service_id) ||
+        (entry->capture == CMD_CAPTURE_COMMAND_NAME &&
+         !ctx->has_command_name) ||
+        (entry->capture == CMD_CAPTURE_PARAS && !ctx->has_paras)) {
+      ctx->capture = entry->capture;
+    }
+    return;
+  }
 
-    pos = find_json_key(paras, "wifi_ssid");
-    if (pos &&
-        parse_json_string(pos, p->wifi_ssid, sizeof(p->wifi_ssid)) == 0) {
-      p->has_wifi_ssid = true;
+  if (ctx->depth == 2) {
+    memcpy(ctx->field_idx, entry->field_idx, sizeof(ctx->field_idx));
+    if (entry->field_idx[0] >= 0 || entry->field_idx[1] >= 0 ||
+        entry->field_idx[2] >= 0) {
+      ctx->capture = CMD_CAPTURE_PARAM;
     }
+  }
+}
+
+/* 已解码的字符串值复制为 C 字符串；非字符串、转义无效或放不下时失败 */
+static bool cmd_parser_copy_string(const AquaCmdParser *ctx, char *out,
+                                   size_t out_size) {
+  if (!ctx->token_is_string || ctx->token_invalid || ctx->token_overflow ||
+      ctx->token_len >= out_size) {
+    return false;
+  }
+  memcpy(out, ctx->token, ctx->token_len);
+  out[ctx->token_len] = '\0';
+  return true;
+}
+
+static int cmd_parser_parse_field(const AquaCmdParser *ctx,
+                                  const CmdFieldDesc *field, uint8_t *base) {
+  if (!ctx->token_is_string) {
+    return parse_cmd_field(field, ctx->token, ctx->token_len, base);
+  }
+  if (ctx->token_invalid) {
+    return -1;
+  }
 
-    pos = find_json_key(paras, "wifi_password");
-    if (pos && parse_json_string(pos, p->wifi_password,
-                                 sizeof(p->wifi_password)) == 0) {
-      p->has_wifi_password = true;
+  switch (field->type) {
+  case AQUA_FIELD_STRING:
+    return cmd_parser_copy_string(ctx, (char *)(base + field->value_offset),
+                                  field->value_size)
+               ? 0
+               : -1;
+  case AQUA_FIELD_INT_OR_STRING:
+    return (ctx->token_len > 0 &&
+            parse_int_prefix(ctx->token, ctx->token_len,
+                             (int32_t *)(base + field->value_offset)) ==
+                ctx->token_len)
+               ? 0
+               : -1;
+  default:
+    return -1;
+  }
+}
+
+/* 标量或字符串值结束：把缓存的值交给值解析函数 */
+static void cmd_parser_end_value(AquaCmdParser *ctx) {
+  uint8_t capture = ctx->capture;
+  ctx->capture = CMD_CAPTURE_NONE;
+
+  if (capture == CMD_CAPTURE_NONE) {
+    return;
+  }
+
+  ParsedCommand *cmd = ctx->cmd;
+  if (capture == CMD_CAPTURE_SERVICE_ID) {
+    ctx->has_service_id = cmd_parser_copy_string(ctx, cmd->service_id,
+                                                 sizeof(cmd->service_id));
+    if (ctx->has_service_id) {
+      const CmdKeyEntry *entry =
+          cmd_key_find(cmd->service_id, strlen(cmd->service_id));
+      ctx->service_type = entry ? entry->service : COMMAND_TYPE_UNKNOWN;
+    }
+  } else if (capture == CMD_CAPTURE_COMMAND_NAME) {
+    ctx->has_command_name = cmd_parser_copy_string(
+        ctx, cmd->command_name, sizeof(cmd->command_name));
+    if (ctx->has_command_name) {
+      const CmdKeyEntry *entry =
+          cmd_key_find(cmd->command_name, strlen(cmd->command_name));
+      ctx->command_type = entry ? entry->command : COMMAND_TYPE_UNKNOWN;
     }
+  } else if (capture == CMD_CAPTURE_PARAM) {
+    /* 同名键以首次出现为准 */
+    for (size_t t = 0; t < 3; ++t) {
+      if (ctx->field_idx[t] < 0) {
+        continue;
+      }
+      const CmdFieldDesc *field =
+          &CMD_PARAM_TABLES[t].fields[ctx->field_idx[t]];
+      uint8_t *base = cmd_parser_params(ctx, t);
+      bool *has = (bool *)(base + field->has_offset);
+      if (*has) {
+        continue;
+      }
+      /* 值放不下不能当作缺失：否则命令回报成功而参数并未生效 */
+      if (ctx->token_overflow ||
+          (field->type == AQUA_FIELD_STRING && ctx->token_is_string &&
+           ctx->token_len >= field->value_size)) {
+        ctx->overflow_mask |= (uint8_t)(1u << t);
+        continue;
+      }
+      if (cmd_parser_parse_field(ctx, field, base) == 0) {
+        *has = true;
+      }
+    }
+  }
+}
 
-    pos = find_json_key(paras, "ph_offset");
-    if (pos && parse_json_float(pos, &p->ph_offset) == 0)
-      p->has_ph_offset = true;
+/* 顶层对象闭合：校验必要字段并按 service_id / command_name 分流 */
+static AquaError cmd_parser_finish(AquaCmdParser *ctx) {
+  ParsedCommand *cmd = ctx->cmd;
 
-    pos = find_json_key(paras, "tds_factor");
-    if (pos && parse_json_float(pos, &p->tds_factor) == 0)
-      p->has_tds_factor = true;
+  if (!ctx->has_service_id || !ctx->has_command_name || !ctx->has_paras) {
+    return AQUA_ERR_MISSING_FIELD;
+  }
+
+  /* service_id 与 command_name 必须指向同一类命令 */
+  if (ctx->service_type != ctx->command_type) {
+    return AQUA_ERR_INVALID_COMMAND;
+  }
+
+  size_t table;
+  switch (ctx->service_type) {
+  case COMMAND_TYPE_CONTROL:
+    cmd->params.control = ctx->control;
+    table = 0;
+    break;
+  case COMMAND_TYPE_SET_THRESHOLDS:
+    cmd->params.threshold = ctx->threshold;
+    table = 1;
+    break;
+  case COMMAND_TYPE_SET_CONFIG:
+    cmd->params.config = ctx->config;
+    table = 2;
+    break;
+  default:
+    return AQUA_ERR_INVALID_COMMAND;
+  }
+
+  if (ctx->overflow_mask & (1u << table)) {
+    return AQUA_ERR_INVALID_VALUE;
+  }
+  cmd->type = (CommandType)ctx->service_type;
+  return AQUA_OK;
+}
+
+static bool cmd_parser_open(AquaCmdParser *ctx, char c) {
+  if (ctx->depth >= AQUA_CMD_PARSER_MAX_DEPTH) {
+    return false;
+  }
+
+  if (ctx->capture == CMD_CAPTURE_PARAS && c == '{') {
+    ctx->in_paras = true;
+    ctx->has_paras = true;
+  }
+  ctx->capture = CMD_CAPTURE_NONE;
 
+  if (c == '[') {
+    ctx->array_mask |= (1UL << ctx->depth);
+    ctx->state = CMD_PARSER_ST_VALUE_OR_END;
   } else {
+    ctx->array_mask &= ~(1UL << ctx->depth);
+    ctx->state = CMD_PARSER_ST_KEY_OR_END;
+  }
+  ctx->depth++;
+  return true;
+}
+
+static void cmd_parser_close(AquaCmdParser *ctx) {
+  ctx->depth--;
+  if (ctx->depth == 0) {
+    ctx->result = cmd_parser_finish(ctx);
+    ctx->state = CMD_PARSER_ST_DONE;
+    return;
+  }
+  if (ctx->depth == 1) {
+    ctx->in_paras = false;
+  }
+  ctx->state = CMD_PARSER_ST_AFTER_VALUE;
+}
+
+static bool cmd_parser_top_is_array(const AquaCmdParser *ctx) {
+  return (ctx->array_mask & (1UL << (ctx->depth - 1))) != 0;
+}
+
+void aqua_cmd_parser_init(AquaCmdParser *ctx, ParsedCommand *cmd) {
+  if (!ctx) {
+    return;
+  }
+  memset(ctx, 0, sizeof(AquaCmdParser));
+  ctx->cmd = cmd;
+  ctx->state = CMD_PARSER_ST_VALUE;
+  ctx->result = AQUA_ERR_INCOMPLETE;
+
+  if (cmd) {
+    memset(cmd, 0, sizeof(ParsedCommand));
+    cmd->type = COMMAND_TYPE_UNKNOWN;
+  }
+}
+
+AquaError aqua_cmd_parser_feed(AquaCmdParser *ctx, const char *data,
+                               size_t len, size_t *consumed) {
+  if (consumed) {
+    *consumed = 0;
+  }
+  if (!ctx || !ctx->cmd || (!data && len > 0)) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  size_t i = 0;
+  while (i < len && ctx->state != CMD_PARSER_ST_DONE &&
+         ctx->state != CMD_PARSER_ST_ERROR) {
+    JSON_SCAN_STEP();
+    char c = data[i];
+
+    /* 字符串与标量内部：逐字节推进，不跳过空白 */
+    if (ctx->state == CMD_PARSER_ST_STRING) {
+      cmd_parser_string_char(ctx, c);
+      i++;
+      continue;
+    }
+
+    if (ctx->state == CMD_PARSER_ST_KEY_STRING) {
+      if (ctx->escape) {
+        ctx->escape = false;
+        cmd_parser_key_push(ctx, c);
+      } else if (c == '"') {
+        ctx->state = CMD_PARSER_ST_COLON;
+      } else {
+        ctx->escape = (c == '\\');
+        cmd_parser_key_push(ctx, c);
+      }
+      i++;
+      continue;
+    }
+
+    if (ctx->state == CMD_PARSER_ST_SCALAR) {
+      if (c == ',' || c == '}' || c == ']' || is_json_ws(c)) {
+        /* 终止符留给 AFTER_VALUE 处理 */
+        cmd_parser_end_value(ctx);
+        ctx->state = CMD_PARSER_ST_AFTER_VALUE;
+        continue;
+      }
+      cmd_parser_token_push(ctx, c);
+      i++;
+      continue;
+    }
+
+    i++;
+    if (is_json_ws(c)) {
+      continue;
+    }
+
+    switch (ctx->state) {
+    case CMD_PARSER_ST_VALUE_OR_END:
+      if (c == ']') {
+        cmd_parser_close(ctx);
+        break;
+      }
+      /* fall through */
+    case CMD_PARSER_ST_VALUE:
+      if (c == '{' || c == '[') {
+        if ((ctx->depth == 0 && c != '{') || !cmd_parser_open(ctx, c)) {
+          ctx->state = CMD_PARSER_ST_ERROR;
+        }
+      } else if (ctx->depth == 0 ||
+                 (c != '"' && c != '-' && !is_json_digit(c) &&
+                  (c < 'a' || c > 'z'))) {
+        ctx->state = CMD_PARSER_ST_ERROR;
+      } else {
+        ctx->token_len = 0;
+        ctx->token_overflow = false;
+        ctx->token_is_string = (c == '"');
+        ctx->token_invalid = false;
+        ctx->escape = false;
+        ctx->hex_left = 0;
+        if (ctx->token_is_string) {
+          ctx->state = CMD_PARSER_ST_STRING;
+        } else {
+          cmd_parser_token_push(ctx, c);
+          ctx->state = CMD_PARSER_ST_SCALAR;
+        }
+      }
+      break;
+
+    case CMD_PARSER_ST_KEY_OR_END:
+      if (c == '}') {
+        cmd_parser_close(ctx);
+        break;
+      }
+      /* fall through */
+    case CMD_PARSER_ST_KEY:
+      if (c == '"') {
+        ctx->key_len = 0;
+        ctx->key_hash = CMD_KEY_HASH_BASIS;
+        ctx->key_overflow = false;
+        ctx->escape = false;
+        ctx->state = CMD_PARSER_ST_KEY_STRING;
+      } else {
+        ctx->state = CMD_PARSER_ST_ERROR;
+      }
+      break;
+
+    case CMD_PARSER_ST_COLON:
+      if (c == ':') {
+        cmd_parser_classify_key(ctx);
+        ctx->state = CMD_PARSER_ST_VALUE;
+      } else {
+        ctx->state = CMD_PARSER_ST_ERROR;
+      }
+      break;
+
+    case CMD_PARSER_ST_AFTER_VALUE:
+      if (c == ',') {
+        ctx->state = cmd_parser_top_is_array(ctx) ? CMD_PARSER_ST_VALUE
+                                                  : CMD_PARSER_ST_KEY;
+      } else if ((c == '}' && !cmd_parser_top_is_array(ctx)) ||
+                 (c == ']' && cmd_parser_top_is_array(ctx))) {
+        cmd_parser_close(ctx);
+      } else {
+        ctx->state = CMD_PARSER_ST_ERROR;
+      }
+      break;
+
+    default:
+      ctx->state = CMD_PARSER_ST_ERROR;
+      break;
+    }
+  }
+
+  if (consumed) {
+    *consumed = i;
+  }
+
+  if (ctx->state == CMD_PARSER_ST_ERROR) {
+    return AQUA_ERR_JSON_PARSE;
+  }
+  return ctx->result;
+}
+
+/* ============================================================================
+ * 命令下发 JSON 解析
+ * ============================================================================
+ */
+
+AquaError aqua_parse_command_json(const char *json, size_t json_len,
+                                  ParsedCommand *cmd) {
+  if (!json || !cmd) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  if (json_len == 0 || json_len >= AQUA_JSON_MAX_LEN) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
+
+  /* 整段输入即一次喂入；顶层对象未闭合视为格式错误 */
+  AquaCmdParser parser;
+  aqua_cmd_parser_init(&parser, cmd);
+  AquaError err = aqua_cmd_parser_feed(&parser, json, json_len, NULL);
+  return (err == AQUA_ERR_INCOMPLETE) ? AQUA_ERR_JSON_PARSE : err;
+}
+
+/* ============================================================================
+ * 属性设置下发解析
+ * ============================================================================
+ */
+
+/* Aquarium 服务中可写的属性，映射为 control 命令参数 */
+typedef struct {
+  const char *key;
+  uint8_t control_idx; /* 在 CONTROL_FIELDS 中的下标 */
+} PropertySetDesc;
+
+static const PropertySetDesc PROPERTY_SET_FIELDS[] = {
+    {"heater", CMD_CONTROL_IDX_heater},
+    {"pump_in", CMD_CONTROL_IDX_pump_in},
+    {"pump_out", CMD_CONTROL_IDX_pump_out},
+    {"auto_mode", CMD_CONTROL_IDX_auto_mode},
+    {"alarm_muted", CMD_CONTROL_IDX_mute},
+};
+
+/*
+ * 查找 properties 中的键对应的命令参数。
+ * 返回 NULL 表示忽略该键；*read_only 置位表示该键是只读属性。
+ */
+static const CmdFieldDesc *prop_set_field(bool is_aquarium, CommandType type,
+                                          const char *key, size_t key_len,
+                                          bool *read_only) {
+  *read_only = false;
+  if (is_aquarium) {
+    for (size_t i = 0; i < CMD_FIELD_COUNT(PROPERTY_SET_FIELDS); ++i) {
+      if (jc_key_is(key, key_len, PROPERTY_SET_FIELDS[i].key)) {
+        return &CONTROL_FIELDS[PROPERTY_SET_FIELDS[i].control_idx];
+      }
+    }
+    for (size_t i = 0; i < AQUA_REPORT_FIELD_COUNT; ++i) {
+      if (jc_key_is(key, key_len, REPORT_SLOTS[i].key)) {
+        *read_only = true;
+        break;
+      }
+    }
+    return NULL;
+  }
+
+  const CmdFieldTable *table = &CMD_PARAM_TABLES[type - COMMAND_TYPE_CONTROL];
+  for (size_t i = 0; i < table->count; ++i) {
+    JSON_SCAN_STEP();
+    if (key_len == table->fields[i].key_len &&
+        memcmp(key, table->fields[i].key, key_len) == 0) {
+      return &table->fields[i];
+    }
+  }
+  return NULL;
+}
+
+static AquaError parse_prop_set_properties(JsonCursor *c, bool is_aquarium,
+                                           ParsedCommand *cmd,
+                                           bool *has_field) {
+  uint8_t *params = (uint8_t *)&cmd->params;
+
+  jc_expect(c, '{');
+  for (bool first = true; jc_next_member(c, first); first = false) {
+    const char *key;
+    size_t key_len;
+    const char *value;
+    size_t value_len;
+    jc_key(c, &key, &key_len);
+    jc_value(c, &value, &value_len);
+    if (!c->ok) {
+      break;
+    }
+
+    bool read_only;
+    const CmdFieldDesc *field =
+        prop_set_field(is_aquarium, cmd->type, key, key_len, &read_only);
+    if (read_only) {
+      return AQUA_ERR_INVALID_COMMAND;
+    }
+    if (!field) {
+      continue;
+    }
+    if (parse_cmd_field(field, value, value_len, params) != 0) {
+      return AQUA_ERR_JSON_PARSE;
+    }
+    *(bool *)(params + field->has_offset) = true;
+    *has_field = true;
+  }
+  return c->ok ? AQUA_OK : AQUA_ERR_JSON_PARSE;
+}
+
+/* 解析 services 的一个元素；service_id 可能在 properties 之后出现 */
+static AquaError parse_prop_set_service(JsonCursor *c, ParsedCommand *cmd,
+                                        bool *has_field) {
+  char service_id[sizeof(cmd->service_id)];
+  bool has_service_id = false;
+  const char *props = NULL;
+  size_t props_len = 0;
+
+  jc_expect(c, '{');
+  for (bool first = true; jc_next_member(c, first); first = false) {
+    const char *key;
+    size_t key_len;
+    const char *value;
+    size_t value_len;
+    jc_key(c, &key, &key_len);
+    jc_value(c, &value, &value_len);
+    if (!c->ok) {
+      break;
+    }
+
+    if (jc_key_is(key, key_len, "properties")) {
+      props = value;
+      props_len = value_len;
+    } else if (jc_key_is(key, key_len, "service_id")) {
+      has_service_id = (parse_json_string(value, value_len, service_id,
+                                          sizeof(service_id)) == 0);
+    }
+  }
+  if (!c->ok) {
+    return AQUA_ERR_JSON_PARSE;
+  }
+  if (!has_service_id || !props) {
+    return AQUA_ERR_MISSING_FIELD;
+  }
+
+  bool is_aquarium = (strcmp(service_id, SERVICE_ID_AQUARIUM) == 0);
+  CommandType type = COMMAND_TYPE_CONTROL;
+  if (!is_aquarium) {
+    const CmdKeyEntry *entry = cmd_key_find(service_id, strlen(service_id));
+    type = entry ? (CommandType)entry->service : COMMAND_TYPE_UNKNOWN;
+    if (type == COMMAND_TYPE_UNKNOWN) {
+      return AQUA_ERR_INVALID_SERVICE;
+    }
+  }
+
+  /* 参数共用一个 union，多个 services 只能落在同一类命令上 */
+  if (cmd->type != COMMAND_TYPE_UNKNOWN && cmd->type != type) {
     return AQUA_ERR_INVALID_COMMAND;
   }
+  cmd->type = type;
+  memcpy(cmd->service_id, service_id, sizeof(cmd->service_id));
+
+  JsonCursor sub = {props, props_len, 0, true};
+  return parse_prop_set_properties(&sub, is_aquarium, cmd, has_field);
+}
+
+AquaError aqua_parse_properties_set_json(const char *json, size_t json_len,
+                                         ParsedCommand *cmd) {
+  if (!json || !cmd) {
+    return AQUA_ERR_NULL_PTR;
+  }
+  memset(cmd, 0, sizeof(*cmd));
+
+  JsonCursor c = {json, json_len, 0, true};
+  AquaError err = AQUA_OK;
+  bool has_services = false;
+  bool has_field = false;
+
+  jc_expect(&c, '{');
+  for (bool first = true; err == AQUA_OK && jc_next_member(&c, first);
+       first = false) {
+    const char *key;
+    size_t key_len;
+    jc_key(&c, &key, &key_len);
+    if (!c.ok) {
+      break;
+    }
+
+    if (!jc_key_is(key, key_len, "services")) {
+      const char *value;
+      size_t value_len;
+      jc_value(&c, &value, &value_len);
+      continue;
+    }
+
+    has_services = true;
+    jc_expect(&c, '[');
+    if (jc_accept(&c, ']')) {
+      continue;
+    }
+    do {
+      err = parse_prop_set_service(&c, cmd, &has_field);
+    } while (err == AQUA_OK && c.ok && jc_accept(&c, ','));
+    if (err == AQUA_OK) {
+      jc_expect(&c, ']');
+    }
+  }
+  if (err != AQUA_OK) {
+    return err;
+  }
+
+  jc_ws(&c);
+  if (!c.ok || c.i != c.n) {
+    return AQUA_ERR_JSON_PARSE;
+  }
+  if (!has_services || !has_field) {
+    return AQUA_ERR_MISSING_FIELD;
+  }
+  return AQUA_OK;
+}
 
+AquaError aqua_build_properties_set_response_json(int32_t result_code,
+                                                  const char *result_desc,
+                                                  char *buffer,
+                                                  size_t buf_size,
+                                                  size_t *out_len) {
+  if (!buffer || !out_len) {
+    return AQUA_ERR_NULL_PTR;
+  }
+  if (!result_desc) {
+    result_desc = (result_code == 0) ? "success" : "failed";
+  }
+
+  AquaJsonWriter w;
+  aqua_jw_init(&w, buffer, buf_size);
+  aqua_jw_begin_obj(&w);
+  aqua_jw_key_i32(&w, "result_code", result_code);
+  aqua_jw_key_str(&w, "result_desc", result_desc);
+  aqua_jw_end_obj(&w);
+
+  if (!aqua_jw_finish(&w, out_len)) {
+    return AQUA_ERR_BUFFER_TOO_SMALL;
+  }
   return AQUA_OK;
 }
@@ -8,14 +8,18 @@
  * - 生成命令响应 JSON
  * - 解析/组装 MQTT Topic
  *
+ * 所有 JSON 输出经由 aquarium_json.h 的写入器生成。
+ *
  * 参考文档：docs/Interface.MD, docs/HuaweiCloud.MD
  */
 
 #ifndef AQUARIUM_PROTOCOL_H
 #define AQUARIUM_PROTOCOL_H
 
+#include "aquarium_json.h"
 #include "aquarium_types.h"
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,7 +38,9 @@ typedef enum {
   AQUA_ERR_INVALID_COMMAND,  /* 无效的命令 */
   AQUA_ERR_INVALID_SERVICE,  /* 无效的服务 ID */
   AQUA_ERR_MISSING_FIELD,    /* 缺少必要字段 */
-  AQUA_ERR_TOPIC_PARSE       /* Topic 解析错误 */
+  AQUA_ERR_TOPIC_PARSE,      /* Topic 解析错误 */
+  AQUA_ERR_INCOMPLETE,       /* 数据尚不完整，需要继续输入 */
+  AQUA_ERR_INVALID_VALUE     /* 参数值超出字段容量 */
 } AquaError;
 
 /* ============================================================================
@@ -70,6 +76,185 @@ AquaError aqua_build_properties_json(const AquariumProperties *props,
                                      char *buffer, size_t buf_size,
                                      size_t *out_len);
 
+/* 属性字段位号（顺序与上报 JSON 中的字段顺序一致，见 aquarium_schema.def） */
+enum {
+#define AQUA_PROPERTY(name, NAME, type) AQUA_PROP_BIT_##NAME,
+#include "aquarium_schema.def"
+  AQUA_REPORT_FIELD_COUNT
+};
+
+/* 属性字段位：AQUA_PROP_TEMPERATURE、AQUA_PROP_PH ... */
+enum {
+#define AQUA_PROPERTY(name, NAME, type)                                        \
+  AQUA_PROP_##NAME = 1 << AQUA_PROP_BIT_##NAME,
+#include "aquarium_schema.def"
+};
+
+#define AQUA_PROP_ALL ((1u << AQUA_REPORT_FIELD_COUNT) - 1u)
+
+/* 字段位须能放进 uint16_t 掩码 */
+typedef char aqua_prop_mask_fits_u16[(AQUA_REPORT_FIELD_COUNT <= 16) ? 1 : -1];
+
+/**
+ * @brief 生成只包含部分属性的上报 JSON（增量上报）
+ *
+ * 格式与 aqua_build_properties_json 相同，properties 中只输出
+ * field_mask 选中的字段；field_mask 为 AQUA_PROP_ALL 时两者等价。
+ *
+ * @param props      属性结构体指针
+ * @param field_mask AQUA_PROP_* 位组合
+ * @param buffer     输出缓冲区
+ * @param buf_size   缓冲区大小
+ * @param out_len    [输出] 实际生成的 JSON 长度（不含 '\0'）
+ * @return AquaError 错误码
+ */
+AquaError aqua_build_properties_fields_json(const AquariumProperties *props,
+                                            uint16_t field_mask, char *buffer,
+                                            size_t buf_size, size_t *out_len);
+
+/**
+ * @brief 以上报格式在当前 JSON 对象中写出 field_mask 选中的属性
+ *
+ * 键名、顺序与数值格式和属性上报一致，供其他报文（如命令响应）复用。
+ */
+void aqua_jw_properties(AquaJsonWriter *w, const AquariumProperties *props,
+                        uint16_t field_mask);
+
+/**
+ * @brief 带时间戳的属性采样
+ */
+typedef struct {
+  AquariumProperties props;
+  uint16_t field_mask; /* 本采样上报的字段（AQUA_PROP_* 位组合） */
+  uint32_t event_time; /* 采样时刻，UTC Unix 秒；0 表示由平台打时间戳 */
+} AquaPropertySample;
+
+/* 传感器读数字段 */
+#define AQUA_PROP_SENSORS                                                      \
+  (AQUA_PROP_TEMPERATURE | AQUA_PROP_PH | AQUA_PROP_TDS |                      \
+   AQUA_PROP_TURBIDITY | AQUA_PROP_WATER_LEVEL)
+
+/**
+ * @brief 生成批量属性上报 JSON（一条消息携带多个采样）
+ *
+ * 每个采样输出为 services 中的一个元素，带各自的 event_time
+ * （格式 yyyyMMdd'T'HHmmss'Z'）：
+ * {"services":[{"service_id":"Aquarium","properties":{...},
+ *               "event_time":"20261015T080000Z"}, ...]}
+ *
+ * @param samples  采样数组（按时间先后排列）
+ * @param count    采样个数
+ * @param buffer   输出缓冲区
+ * @param buf_size 缓冲区大小
+ * @param out_len  [输出] 实际生成的 JSON 长度（不含 '\0'）
+ * @return AquaError 错误码
+ */
+AquaError aqua_build_properties_batch_json(const AquaPropertySample *samples,
+                                           size_t count, char *buffer,
+                                           size_t buf_size, size_t *out_len);
+
+/**
+ * @brief 网关子设备的一个属性采样
+ */
+typedef struct {
+  const char *device_id; /* 子设备 ID */
+  AquaPropertySample sample;
+} AquaSubDeviceSample;
+
+/**
+ * @brief 生成网关子设备批量属性上报 JSON（一条消息携带多个子设备）
+ *
+ * 用于发布到 Topic: $oc/devices/{gateway_id}/sys/gateway/sub_devices/
+ * properties/report，每个子设备的 services 与单设备上报格式相同：
+ * {"devices":[{"device_id":"tank_1","services":[{"service_id":"Aquarium",
+ *   "properties":{...},"event_time":"20261015T080000Z"}]}, ...]}
+ *
+ * @param devices  子设备采样数组
+ * @param count    子设备个数
+ * @param buffer   输出缓冲区
+ * @param buf_size 缓冲区大小
+ * @param out_len  [输出] 实际生成的 JSON 长度（不含 '\0'）
+ * @return AquaError 错误码
+ */
+AquaError aqua_build_sub_devices_report_json(const AquaSubDeviceSample *devices,
+                                             size_t count, char *buffer,
+                                             size_t buf_size, size_t *out_len);
+
+/* ============================================================================
+ * 预格式化属性上报帧（原位改写数值槽位）
+ * ============================================================================
+ */
+
+
+/* 槽位宽度：数值右对齐、左侧补空格；布尔写作 "true " / "false" */
+#define AQUA_REPORT_SLOT_FLOAT_WIDTH 9 /* 2 位小数，范围 ±99999.99 */
+#define AQUA_REPORT_SLOT_INT_WIDTH 11  /* 覆盖 int32 全范围 */
+#define AQUA_REPORT_SLOT_BOOL_WIDTH 5
+
+#define AQUA_REPORT_FRAME_MAX_LEN 384
+
+/**
+ * @brief 属性上报帧
+ *
+ * 初始化时一次性生成 JSON 骨架并为 13 个字段预留定宽槽位，
+ * 之后每次上报只改写槽位内容，buf 始终是一份完整的 JSON。
+ * 槽位内的前导/尾随空格属于合法 JSON 空白。
+ */
+typedef struct {
+  char buf[AQUA_REPORT_FRAME_MAX_LEN];
+  uint16_t len;
+  uint16_t slot_pos[AQUA_REPORT_FIELD_COUNT];
+} AquaReportFrame;
+
+/**
+ * @brief 生成上报帧骨架（所有槽位初始为 0 / false）
+ *
+ * @return AQUA_OK 或 AQUA_ERR_BUFFER_TOO_SMALL
+ */
+AquaError aqua_report_frame_init(AquaReportFrame *frame);
+
+/**
+ * @brief 将属性写入上报帧的槽位
+ *
+ * 仅改写 13 个槽位，耗时与字段数成正比；浮点值超出槽位范围时饱和，
+ * NaN/Inf 写为 0。
+ *
+ * @param frame   已初始化的上报帧
+ * @param props   属性结构体指针
+ * @param out_len [输出] 帧长度（即 frame->buf 中 JSON 的长度）
+ * @return AquaError 错误码
+ */
+AquaError aqua_report_frame_update(AquaReportFrame *frame,
+                                   const AquariumProperties *props,
+                                   size_t *out_len);
+
+/* ============================================================================
+ * 属性上报 JSON 解析
+ * ============================================================================
+ */
+
+/**
+ * @brief 解析属性上报 JSON（上报构建函数的逆运算）
+ *
+ * 接受 aqua_build_properties_json / aqua_build_properties_fields_json /
+ * aqua_build_properties_batch_json 以及预格式化上报帧的输出。
+ * services 中每个 service_id 为 Aquarium 的元素解析为一个采样：
+ * properties 中出现的字段写入 props 并置位 field_mask，
+ * event_time 换算为 Unix 秒（缺省为 0）。其他服务与未知键忽略。
+ *
+ * @param json        输入 JSON（不要求 '\0' 结尾）
+ * @param json_len    JSON 长度
+ * @param samples     [输出] 采样数组
+ * @param max_samples 采样数组容量
+ * @param out_count   [输出] 写入的采样数
+ * @return AQUA_ERR_JSON_PARSE 格式错误或字段类型不符；
+ *         AQUA_ERR_MISSING_FIELD 缺少 services；
+ *         AQUA_ERR_BUFFER_TOO_SMALL 采样数超过容量（前 max_samples 个已写入）
+ */
+AquaError aqua_parse_properties_json(const char *json, size_t json_len,
+                                     AquaPropertySample *samples,
+                                     size_t max_samples, size_t *out_count);
+
 /* ============================================================================
  * 命令下发 JSON 解析
  * ============================================================================
@@ -86,6 +271,9 @@ AquaError aqua_build_properties_json(const AquariumProperties *props,
  * @param cmd       [输出] 解析后的命令结构
  * @return AquaError 错误码
  *
+ * 内部以 aqua_cmd_parser_feed 一次喂入整段 payload，解析器上下文位于本函数
+ * 栈帧（约 sizeof(AquaCmdParser)），可重入。
+ *
  * 支持的命令：
  * - service_id=aquarium_control, command_name=control
  * - service_id=aquarium_threshold, command_name=set_thresholds
@@ -94,6 +282,95 @@ AquaError aqua_build_properties_json(const AquariumProperties *props,
 AquaError aqua_parse_command_json(const char *json, size_t json_len,
                                   ParsedCommand *cmd);
 
+/* ============================================================================
+ * 命令下发增量解析（按任意分片喂入）
+ * ============================================================================
+ */
+
+/* 可识别的键最大长度：不小于最长命令键（18 字节），更长的键必然未知 */
+#define AQUA_CMD_PARSER_KEY_MAX 20
+/* 单个参数值最大长度：字符串按解码后的内容缓存，不小于最长字符串参数 */
+#define AQUA_CMD_PARSER_TOKEN_MAX WIFI_PASSWORD_MAX_LEN
+#define AQUA_CMD_PARSER_MAX_DEPTH 32  /* 最大嵌套深度 */
+
+/**
+ * @brief 增量命令解析器上下文
+ *
+ * 字段仅供内部使用。占用固定内存，与 payload 总长度无关：
+ * 只缓存当前键和当前参数值。字符串值边接收边解码转义，缓存的是解码后
+ * 的内容；参数值超出 AQUA_CMD_PARSER_TOKEN_MAX 或字段容量时，
+ * 命令以 AQUA_ERR_INVALID_VALUE 结束，而不是当作缺失。
+ */
+typedef struct {
+  ParsedCommand *cmd; /* 输出目标 */
+
+  /* 词法状态 */
+  uint8_t state;
+  uint8_t depth;       /* 当前已打开的容器层数 */
+  uint32_t array_mask; /* 每层容器类型：bit=1 为数组 */
+  bool escape;         /* 字符串内上一个字符为反斜杠 */
+
+  /* 当前键 */
+  char key[AQUA_CMD_PARSER_KEY_MAX];
+  uint8_t key_len;
+  uint32_t key_hash; /* 读键时逐字节累积的哈希，用于查命令键表 */
+  bool key_overflow;
+
+  /* 当前值的用途及原始文本 */
+  uint8_t capture;
+  int8_t field_idx[3]; /* 当前键在 control/threshold/config 字段表中的下标 */
+  char token[AQUA_CMD_PARSER_TOKEN_MAX]; /* 字符串为解码后内容，不含引号 */
+  uint16_t token_len;
+  bool token_overflow;
+  bool token_is_string;
+  bool token_invalid; /* 字符串含不支持的转义 */
+  uint8_t hex_left;   /* \uXXXX 尚未读取的十六进制位数 */
+  uint16_t hex_code;
+  uint8_t overflow_mask; /* 参数值超出容量的字段表（bit 同 field_idx 下标） */
+
+  /* 文档级进度 */
+  bool in_paras;
+  bool has_service_id;
+  bool has_command_name;
+  bool has_paras;
+  uint8_t service_type; /* service_id 对应的 CommandType */
+  uint8_t command_type; /* command_name 对应的 CommandType */
+
+  /* paras 可能先于 service_id 出现，三类参数分别暂存 */
+  ControlCommandParams control;
+  ThresholdCommandParams threshold;
+  ConfigCommandParams config;
+
+  AquaError result; /* 顶层对象闭合后的最终结果 */
+} AquaCmdParser;
+
+/**
+ * @brief 初始化增量命令解析器
+ *
+ * @param ctx 解析器上下文
+ * @param cmd [输出] 解析结果；service_id / command_name 一经解析即写入，
+ *            参数在顶层对象闭合时一次性写入
+ */
+void aqua_cmd_parser_init(AquaCmdParser *ctx, ParsedCommand *cmd);
+
+/**
+ * @brief 喂入一段命令 JSON
+ *
+ * 可按任意边界切分多次调用，解析工作与数据接收交错进行。
+ *
+ * @param ctx      解析器上下文
+ * @param data     本次数据
+ * @param len      本次数据长度
+ * @param consumed [输出，可为 NULL] 本次消耗的字节数；
+ *                 顶层对象闭合后其余字节不再消耗
+ * @return AQUA_ERR_INCOMPLETE 需要更多数据；
+ *         AQUA_OK 命令完整且有效；
+ *         其他错误码为终态（JSON_PARSE / MISSING_FIELD / INVALID_COMMAND /
+ *         INVALID_VALUE）
+ */
+AquaError aqua_cmd_parser_feed(AquaCmdParser *ctx, const char *data,
+                               size_t len, size_t *consumed);
+
 /* ============================================================================
  * 命令响应 JSON 生成
  * ============================================================================
@@ -128,15 +405,146 @@ AquaError aqua_parse_command_json(const char *json, size_t json_len,
 AquaError aqua_build_response_json(const CommandResponse *resp, char *buffer,
                                    size_t buf_size, size_t *out_len);
 
+/**
+ * @brief 直接由命令名生成命令响应 JSON（无需先填充 CommandResponse）
+ *
+ * response_name 为 "{command_name}_response"，result 由 result_code 决定
+ * （0 为 "success"，其余为 "failed"）；字符串按 JSON 规则转义。
+ *
+ * @param result_code  结果码（0=成功, 1=执行失败, 2=参数错误, ...）
+ * @param command_name 命令名称
+ * @param error        错误描述，NULL 表示不带 error 字段
+ */
+AquaError aqua_build_command_response_json(int32_t result_code,
+                                           const char *command_name,
+                                           const char *error, char *buffer,
+                                           size_t buf_size, size_t *out_len);
+
+/**
+ * @brief 在 paras 的 result/error 之后追加字段的回调
+ *
+ * 在 paras 对象内写出零个或多个键值对。
+ */
+typedef void (*AquaResponseParasWriter)(AquaJsonWriter *w, const void *ctx);
+
+/**
+ * @brief 生成带附加 paras 字段的命令响应 JSON
+ *
+ * 与 aqua_build_command_response_json 相同，paras 中 result/error
+ * 之后由 paras_writer 追加字段（如命令生效后的状态快照）：
+ * {"result_code":0,"response_name":"control_response",
+ *  "paras":{"result":"success","state":{"heater":true,...}}}
+ *
+ * @param paras_writer 追加字段的回调，NULL 时与不带附加字段等价
+ * @param ctx          传给 paras_writer 的上下文
+ */
+AquaError aqua_build_command_response_paras_json(
+    int32_t result_code, const char *command_name, const char *error,
+    AquaResponseParasWriter paras_writer, const void *ctx, char *buffer,
+    size_t buf_size, size_t *out_len);
+
+/* ============================================================================
+ * 属性设置/查询下发
+ * ============================================================================
+ */
+
+/**
+ * @brief 解析属性设置请求 JSON，映射为等价的命令
+ *
+ * Topic: $oc/devices/{device_id}/sys/properties/set/request_id={request_id}
+ * {"object_device_id":"...","services":[{"service_id":"...",
+ *  "properties":{...}}]}
+ *
+ * service_id 与 properties 的映射：
+ * - Aquarium：可写属性 heater/pump_in/pump_out/auto_mode/alarm_muted
+ *   映射为 control 命令（alarm_muted 对应 mute）；只读属性（传感器、
+ *   feed_countdown 等）视为无效请求
+ * - aquarium_control / aquarium_threshold / aquariumConfig：properties
+ *   按对应命令的 paras 解析
+ * 未知键忽略；同一请求中的多个 services 必须映射为同一类命令。
+ * 映射结果交给 aqua_logic_apply_command，与命令下发共用同一套校验。
+ *
+ * @param json      输入 JSON 字符串
+ * @param json_len  JSON 字符串长度
+ * @param cmd       [输出] 映射后的命令（command_name 为空）
+ * @return AQUA_ERR_JSON_PARSE 格式错误或字段类型不符；
+ *         AQUA_ERR_MISSING_FIELD 缺少 services 或没有可设置的字段；
+ *         AQUA_ERR_INVALID_SERVICE 未知 service_id；
+ *         AQUA_ERR_INVALID_COMMAND 设置只读属性或混合多类命令
+ */
+AquaError aqua_parse_properties_set_json(const char *json, size_t json_len,
+                                         ParsedCommand *cmd);
+
+/**
+ * @brief 生成属性设置响应 JSON
+ *
+ * Topic:
+ * $oc/devices/{device_id}/sys/properties/set/response/request_id={request_id}
+ * {"result_code":0,"result_desc":"success"}
+ *
+ * @param result_code 结果码（0=成功，其余为失败）
+ * @param result_desc 结果描述，NULL 时按 result_code 取 "success"/"failed"
+ */
+AquaError aqua_build_properties_set_response_json(int32_t result_code,
+                                                  const char *result_desc,
+                                                  char *buffer,
+                                                  size_t buf_size,
+                                                  size_t *out_len);
+
 /* ============================================================================
  * MQTT Topic 解析/组装
  * ============================================================================
  */
 
+/**
+ * @brief 从下行请求 JSON 中提取顶层 object_device_id
+ *
+ * 网关收到的命令、属性设置/查询请求都发往网关自身的 Topic，
+ * 目标子设备由 payload 中的 object_device_id 指明。
+ *
+ * @param json       输入 JSON（不要求 '\0' 结尾）
+ * @param json_len   JSON 长度
+ * @param out        [输出] 设备 ID 缓冲区
+ * @param out_size   缓冲区大小
+ * @return AQUA_ERR_MISSING_FIELD 不含 object_device_id；
+ *         AQUA_ERR_JSON_PARSE 格式错误或取值不是字符串/超长
+ */
+AquaError aqua_extract_object_device_id(const char *json, size_t json_len,
+                                        char *out, size_t out_size);
+
+#ifdef UNIT_TEST
+/**
+ * @brief 下行 JSON 解析累计检查的字符数（仅测试构建）
+ *
+ * 游标、值解析与流式命令解析器每检查一个字符加一，测试据此断言
+ * 解析步数随输入长度线性增长。
+ */
+extern uint32_t aqua_json_scan_steps;
+#endif
+
+/**
+ * @brief 下行请求类型（由 Topic 区分）
+ */
+typedef enum {
+  AQUA_DOWNLINK_UNKNOWN = 0,
+  AQUA_DOWNLINK_COMMAND,        /* sys/commands/request_id={id} */
+  AQUA_DOWNLINK_PROPERTIES_SET, /* sys/properties/set/request_id={id} */
+  AQUA_DOWNLINK_PROPERTIES_GET  /* sys/properties/get/request_id={id} */
+} AquaDownlinkType;
+
+/**
+ * @brief 按 Topic 判断下行请求类型
+ *
+ * @param topic 输入 Topic 字符串（$oc/devices/{device_id}/sys/...）
+ * @return AquaDownlinkType，不认识的 Topic 为 AQUA_DOWNLINK_UNKNOWN
+ */
+AquaDownlinkType aqua_parse_downlink_topic(const char *topic);
+
 /**
  * @brief 从命令请求 Topic 中提取 request_id
  *
  * 输入 Topic 格式：$oc/devices/{device_id}/sys/commands/request_id={request_id}
+ * （属性设置/查询请求 Topic 同样适用）
  *
  * @param topic        输入 Topic 字符串
  * @param request_id   [输出] request_id 缓冲区
@@ -163,6 +571,26 @@ AquaError aqua_build_response_topic(const char *device_id,
                                     const char *request_id, char *buffer,
                                     size_t buf_size, size_t *out_len);
 
+/**
+ * @brief 构建下行请求的响应 Topic
+ *
+ * 输出 Topic 格式：$oc/devices/{device_id}/sys/{kind}/response/request_id={id}
+ * 其中 kind 为 commands、properties/set 或 properties/get。
+ *
+ * @param device_id    设备 ID
+ * @param type         请求类型，不能为 AQUA_DOWNLINK_UNKNOWN
+ * @param request_id   请求 ID（从请求 Topic 中提取）
+ * @param buffer       输出 Topic 缓冲区
+ * @param buf_size     缓冲区大小
+ * @param out_len      [输出] 实际生成的 Topic 长度（不含 '\0'）
+ * @return AquaError 错误码
+ */
+AquaError aqua_build_downlink_response_topic(const char *device_id,
+                                             AquaDownlinkType type,
+                                             const char *request_id,
+                                             char *buffer, size_t buf_size,
+                                             size_t *out_len);
+
 /**
  * @brief 构建属性上报 Topic
  *
@@ -177,6 +605,36 @@ AquaError aqua_build_response_topic(const char *device_id,
 AquaError aqua_build_report_topic(const char *device_id, char *buffer,
                                   size_t buf_size, size_t *out_len);
 
+/**
+ * @brief 构建网关子设备属性上报 Topic
+ *
+ * 输出 Topic 格式：$oc/devices/{gateway_id}/sys/gateway/sub_devices/
+ * properties/report
+ *
+ * @param gateway_id   网关设备 ID
+ * @param buffer       输出 Topic 缓冲区
+ * @param buf_size     缓冲区大小
+ * @param out_len      [输出] 实际生成的 Topic 长度（不含 '\0'）
+ * @return AquaError 错误码
+ */
+AquaError aqua_build_gateway_report_topic(const char *gateway_id, char *buffer,
+                                          size_t buf_size, size_t *out_len);
+
+/**
+ * @brief 构建设备消息上报 Topic
+ *
+ * 输出 Topic 格式：$oc/devices/{device_id}/sys/messages/up
+ * 二进制（CBOR）属性上报走此 Topic，由云端编解码插件转换为属性。
+ *
+ * @param device_id    设备 ID
+ * @param buffer       输出 Topic 缓冲区
+ * @param buf_size     缓冲区大小
+ * @param out_len      [输出] 实际生成的 Topic 长度（不含 '\0'）
+ * @return AquaError 错误码
+ */
+AquaError aqua_build_message_up_topic(const char *device_id, char *buffer,
+                                      size_t buf_size, size_t *out_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,6 +8,8 @@
  * - aquarium_threshold 命令参数
  * - aquariumConfig 命令参数
  *
+ * 字段清单定义在 aquarium_schema.def，结构体由其展开生成。
+ *
  * 参考文档：docs/HuaweiCloud.MD
  */
 
@@ -40,6 +42,47 @@ extern "C" {
 #define COMMAND_NAME_SET_THRESHOLDS "set_thresholds"
 #define COMMAND_NAME_SET_CONFIG "set_config"
 
+/* ============================================================================
+ * 物理量程（固件侧边界校验，见 aquarium_schema.def）
+ * ============================================================================
+ */
+
+#define AQUA_TEMP_PHYS_MIN (-55.0f)
+#define AQUA_TEMP_PHYS_MAX (125.0f)
+#define AQUA_PH_PHYS_MIN (0.0f)
+#define AQUA_PH_PHYS_MAX (14.0f)
+#define AQUA_TDS_PHYS_MIN (0)
+#define AQUA_TDS_PHYS_MAX (5000)
+#define AQUA_TURBIDITY_PHYS_MIN (0)
+#define AQUA_TURBIDITY_PHYS_MAX (3000)
+#define AQUA_LEVEL_PHYS_MIN (0)
+#define AQUA_LEVEL_PHYS_MAX (100)
+#define AQUA_TARGET_TEMP_MIN (0.0f)
+#define AQUA_TARGET_TEMP_MAX (40.0f)
+
+#define WIFI_SSID_MAX_LEN 32
+#define WIFI_PASSWORD_MAX_LEN 64
+
+/* ============================================================================
+ * 字段类型（与 aquarium_schema.def 中的 type 列对应）
+ * ============================================================================
+ */
+
+typedef enum {
+  AQUA_FIELD_BOOL = 0,
+  AQUA_FIELD_INT,
+  AQUA_FIELD_INT_OR_STRING, /* 整数或数字字符串，如 2 / "2" */
+  AQUA_FIELD_FLOAT,
+  AQUA_FIELD_STRING
+} AquaFieldType;
+
+/* 由 type 列生成结构体成员；STRING 按最大长度 + 1 分配 */
+#define AQUA_SCHEMA_MEMBER_BOOL(name, max) bool name;
+#define AQUA_SCHEMA_MEMBER_INT(name, max) int32_t name;
+#define AQUA_SCHEMA_MEMBER_INT_OR_STRING(name, max) int32_t name;
+#define AQUA_SCHEMA_MEMBER_FLOAT(name, max) float name;
+#define AQUA_SCHEMA_MEMBER_STRING(name, max) char name[(max) + 1];
+
 /* ============================================================================
  * Aquarium 属性服务（13 个字段）
  * 用于周期性上报设备状态
@@ -47,28 +90,8 @@ extern "C" {
  */
 
 typedef struct {
-  /* 传感器数据 */
-  float temperature; /* 水温 ℃ */
-  float ph;          /* pH 值 */
-  float tds;         /* TDS 值 ppm */
-  float turbidity;   /* 浊度 NTU */
-  float water_level; /* 水位 % */
-
-  /* 执行器状态 */
-  bool heater;   /* 加热棒状态 */
-  bool pump_in;  /* 进水泵状态 */
-  bool pump_out; /* 出水泵状态 */
-
-  /* 运行模式 */
-  bool auto_mode; /* 自动模式 */
-
-  /* 投喂相关 */
-  int32_t feed_countdown;   /* 距离下一次投喂的倒计时（秒） */
-  bool feeding_in_progress; /* 设备是否正在执行投喂 */
-
-  /* 告警相关 */
-  int32_t alarm_level; /* 当前告警级别（0=正常, 1=警告, 2=严重） */
-  bool alarm_muted;    /* 告警是否被静音 */
+#define AQUA_PROPERTY(name, NAME, type) AQUA_SCHEMA_MEMBER_##type(name, 0)
+#include "aquarium_schema.def"
 } AquariumProperties;
 
 /* ============================================================================
@@ -78,24 +101,13 @@ typedef struct {
  */
 
 typedef struct {
-  bool heater;       /* 开启/关闭加热棒 */
-  bool pump_in;      /* 开启/关闭进水泵 */
-  bool pump_out;     /* 开启/关闭排水泵 */
-  bool mute;         /* 静音告警 */
-  bool auto_mode;    /* 切换自动/手动模式 */
-  bool feed;         /* 立即投喂一次 */
-  int32_t feed_once_delay; /* 一次性投喂倒计时（秒） */
-  float target_temp; /* 目标温度 ℃ */
+#define AQUA_CONTROL_PARAM(name, type, min, max)                               \
+  AQUA_SCHEMA_MEMBER_##type(name, max)
+#include "aquarium_schema.def"
 
   /* 字段存在标志（用于部分更新） */
-  bool has_heater;
-  bool has_pump_in;
-  bool has_pump_out;
-  bool has_mute;
-  bool has_auto_mode;
-  bool has_feed;
-  bool has_feed_once_delay;
-  bool has_target_temp;
+#define AQUA_CONTROL_PARAM(name, type, min, max) bool has_##name;
+#include "aquarium_schema.def"
 } ControlCommandParams;
 
 /* ============================================================================
@@ -105,34 +117,16 @@ typedef struct {
  */
 
 typedef struct {
-  float temp_min;             /* 温度下限 ℃ */
-  float temp_max;             /* 温度上限 ℃ */
-  float ph_min;               /* pH 下限 */
-  float ph_max;               /* pH 上限 */
-  int32_t tds_warn;           /* TDS 警告阈值 ppm */
-  int32_t tds_critical;       /* TDS 严重阈值 ppm */
-  int32_t turbidity_warn;     /* 浊度警告阈值 NTU */
-  int32_t turbidity_critical; /* 浊度严重阈值 NTU */
-  int32_t level_min;          /* 水位下限 % */
-  int32_t level_max;          /* 水位上限 % */
-  int32_t feed_interval;      /* 自动投喂间隔（小时） */
-  int32_t feed_amount;        /* 投喂量（档位） */
-  float target_temp;          /* 目标温度 ℃（兼容旧云模型） */
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  AQUA_SCHEMA_MEMBER_##type(name, max)
+#define AQUA_THRESHOLD_RUNTIME(name, type, min, max)                           \
+  AQUA_SCHEMA_MEMBER_##type(name, max)
+#include "aquarium_schema.def"
 
   /* 字段存在标志（用于部分更新） */
-  bool has_temp_min;
-  bool has_temp_max;
-  bool has_ph_min;
-  bool has_ph_max;
-  bool has_tds_warn;
-  bool has_tds_critical;
-  bool has_turbidity_warn;
-  bool has_turbidity_critical;
-  bool has_level_min;
-  bool has_level_max;
-  bool has_feed_interval;
-  bool has_feed_amount;
-  bool has_target_temp;
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def) bool has_##name;
+#define AQUA_THRESHOLD_RUNTIME(name, type, min, max) bool has_##name;
+#include "aquarium_schema.def"
 } ThresholdCommandParams;
 
 /* ============================================================================
@@ -141,20 +135,14 @@ typedef struct {
  * ============================================================================
  */
 
-#define WIFI_SSID_MAX_LEN 32
-#define WIFI_PASSWORD_MAX_LEN 64
-
 typedef struct {
-  char wifi_ssid[WIFI_SSID_MAX_LEN + 1];         /* Wi-Fi 名称 */
-  char wifi_password[WIFI_PASSWORD_MAX_LEN + 1]; /* Wi-Fi 密码 */
-  float ph_offset;                               /* pH 校准偏移量 */
-  float tds_factor;                              /* TDS 校准系数 */
+#define AQUA_CONFIG_PARAM(name, type, min, max, def)                           \
+  AQUA_SCHEMA_MEMBER_##type(name, max)
+#include "aquarium_schema.def"
 
   /* 字段存在标志（用于部分更新） */
-  bool has_wifi_ssid;
-  bool has_wifi_password;
-  bool has_ph_offset;
-  bool has_tds_factor;
+#define AQUA_CONFIG_PARAM(name, type, min, max, def) bool has_##name;
+#include "aquarium_schema.def"
 } ConfigCommandParams;
 
 /* ============================================================================
@@ -58,7 +58,26 @@ static void at_escape_string(const char *src, char *dst, size_t dst_size) {
   dst[j] = '\0';
 }
 
-static void aqua_mqtt_begin_cwjap(MqttClient *mqtt, char *cmd_buf,
+static void aqua_mqtt_on_connect_cmd(AtState result, const AtLine *response,
+                                     void *user_data);
+
+/*
+ * 连接流程的命令都经 AT 命令队列发出，完成时由 aqua_mqtt_on_connect_cmd
+ * 按当前状态推进；收到 OK 的同时就发出下一条，不等主循环下一轮
+ */
+static bool aqua_mqtt_queue_cmd(MqttClient *mqtt, const char *cmd,
+                                uint32_t timeout_ms) {
+  return aqua_at_enqueue(mqtt->at, cmd, timeout_ms, false,
+                         aqua_mqtt_on_connect_cmd, mqtt) == AT_OK;
+}
+
+/* 连接流程失败：丢弃剩余排队命令，进入 ERROR 等待重连 */
+static void aqua_mqtt_fail(MqttClient *mqtt) {
+  aqua_at_cancel_queue(mqtt->at);
+  mqtt->state = MQTT_STATE_ERROR;
+}
+
+static bool aqua_mqtt_queue_cwjap(MqttClient *mqtt, char *cmd_buf,
                                   size_t cmd_buf_size) {
   char esc_ssid[33 * 2 + 1];
   char esc_password[65 * 2 + 1];
@@ -69,7 +88,41 @@ static void aqua_mqtt_begin_cwjap(MqttClient *mqtt, char *cmd_buf,
 
   snprintf(cmd_buf, cmd_buf_size, "AT+CWJAP=\"%s\",\"%s\"", esc_ssid,
            esc_password);
-  aqua_at_begin(mqtt->at, cmd_buf, AT_TIMEOUT_WIFI);
+  return aqua_mqtt_queue_cmd(mqtt, cmd_buf, AT_TIMEOUT_WIFI);
+}
+
+/* 上线前依次订阅的下行 Topic（$oc/devices/{device_id}/sys/ 之后的部分） */
+static const char *const MQTT_SUB_TOPICS[] = {
+    "commands/#",
+    "properties/set/#",
+    "properties/get/#",
+};
+
+#define MQTT_SUB_TOPIC_COUNT                                                   \
+  (sizeof(MQTT_SUB_TOPICS) / sizeof(MQTT_SUB_TOPICS[0]))
+
+/* 订阅 MQTT_SUB_TOPICS[sub_index] 并进入 MQTTSUB 状态 */
+static bool aqua_mqtt_queue_sub(MqttClient *mqtt, char *cmd_buf,
+                                size_t cmd_buf_size) {
+  snprintf(cmd_buf, cmd_buf_size, "AT+MQTTSUB=0,\"$oc/devices/%s/sys/%s\",1",
+           mqtt->config.device_id, MQTT_SUB_TOPICS[mqtt->sub_index]);
+  mqtt->state = MQTT_STATE_MQTTSUB;
+  return aqua_mqtt_queue_cmd(mqtt, cmd_buf, AT_TIMEOUT_MQTT);
+}
+
+/*
+ * 初始化序列（first_cmd、ATE0、CWMODE=1）一次性排队，
+ * 各条在前一条的 OK 到达时立即发出
+ */
+static void aqua_mqtt_queue_init(MqttClient *mqtt, const char *first_cmd) {
+  aqua_at_cancel_queue(mqtt->at);
+  aqua_at_reset(mqtt->at);
+  mqtt->state = MQTT_STATE_AT_TEST;
+  if (!aqua_mqtt_queue_cmd(mqtt, first_cmd, AT_TIMEOUT_SHORT) ||
+      !aqua_mqtt_queue_cmd(mqtt, "ATE0", AT_TIMEOUT_SHORT) ||
+      !aqua_mqtt_queue_cmd(mqtt, "AT+CWMODE=1", AT_TIMEOUT_SHORT)) {
+    aqua_mqtt_fail(mqtt);
+  }
 }
 
 static bool is_placeholder_wifi_ssid(const char *ssid) {
@@ -97,44 +150,27 @@ static bool aqua_mqtt_should_enter_ap_bootstrap(const MqttClient *mqtt) {
          is_placeholder_wifi_password(mqtt->config.wifi_password);
 }
 
-/* Preserve non-publish URCs observed during PUB_DATA so command URCs are not
- * lost while waiting for +MQTTPUB completion. */
-static void aqua_mqtt_requeue_urcs(AtClient *at, const AtLine *lines,
-                                   size_t count) {
-  if (!at || !lines || count == 0) {
-    return;
-  }
-
-  for (size_t i = 0; i < count; ++i) {
-    const AtLine *src = &lines[i];
-    if (!src->valid) {
-      continue;
-    }
-    if (at->urc_count >= AT_URC_QUEUE_SIZE) {
-      break;
-    }
-
-    AtLine *dst = &at->urc_queue[at->urc_head];
-    size_t copy_len = src->len;
-    if (copy_len > AT_LINE_MAX_LEN) {
-      copy_len = AT_LINE_MAX_LEN;
-    }
-
-    memcpy(dst->data, src->data, copy_len);
-    dst->data[copy_len] = '\0';
-    dst->len = copy_len;
-    dst->valid = true;
-
-    at->urc_head = (at->urc_head + 1) % AT_URC_QUEUE_SIZE;
-    at->urc_count++;
-  }
-}
-
 /* ============================================================================
  * 
  * ============================================================================
  */
 
+/*
+ * +MQTTPUB:OK / +MQTTPUB:FAIL 在接收时直接记录结果，不进入 URC 队列，
+ * 不会被其他 URC 挤掉；不在 PUB_DATA 时照常入队（由 poll_commands 丢弃）
+ */
+static bool aqua_mqtt_on_pub_result(const AtLineView *line, void *user_data) {
+  MqttClient *mqtt = (MqttClient *)user_data;
+  if (mqtt->state != MQTT_STATE_PUB_DATA)
+    return false;
+  mqtt->pub_result = line->type;
+  /* 结果 URC 即本次发布的应答：计入发布类别的延迟估计 */
+  aqua_at_complete(mqtt->at, line->type == AT_URC_MQTT_PUB_OK
+                                 ? AT_STATE_DONE_OK
+                                 : AT_STATE_DONE_ERROR);
+  return true;
+}
+
 void aqua_mqtt_init(MqttClient *mqtt, AtClient *at, AquariumApp *app) {
   if (!mqtt)
     return;
@@ -142,6 +178,11 @@ void aqua_mqtt_init(MqttClient *mqtt, AtClient *at, AquariumApp *app) {
   mqtt->at = at;
   mqtt->app = app;
   mqtt->state = MQTT_STATE_IDLE;
+
+  aqua_at_set_urc_handler(at, AT_URC_MQTT_PUB_OK, aqua_mqtt_on_pub_result,
+                          mqtt);
+  aqua_at_set_urc_handler(at, AT_URC_MQTT_PUB_FAIL, aqua_mqtt_on_pub_result,
+                          mqtt);
 }
 
 void aqua_mqtt_set_config(MqttClient *mqtt, const MqttConfig *cfg) {
@@ -157,6 +198,12 @@ void aqua_mqtt_set_timestamp(MqttClient *mqtt, const char *ts) {
   mqtt->timestamp[sizeof(mqtt->timestamp) - 1] = '\0';
 }
 
+void aqua_mqtt_set_gateway(MqttClient *mqtt, AquaGateway *gw) {
+  if (!mqtt)
+    return;
+  mqtt->gateway = gw;
+}
+
 void aqua_mqtt_set_ap_credentials(MqttClient *mqtt, const char *ssid,
                                   const char *password) {
   if (!mqtt)
@@ -180,9 +227,8 @@ void aqua_mqtt_set_ap_credentials(MqttClient *mqtt, const char *ssid,
 void aqua_mqtt_start(MqttClient *mqtt) {
   if (!mqtt || !mqtt->at)
     return;
-  mqtt->state = MQTT_STATE_AT_TEST;
   mqtt->retry_count = 0;
-  aqua_at_begin(mqtt->at, "AT", AT_TIMEOUT_SHORT);
+  aqua_mqtt_queue_init(mqtt, "AT");
 }
 
 MqttConnState aqua_mqtt_get_state(const MqttClient *mqtt) {
@@ -202,7 +248,10 @@ bool aqua_mqtt_publish(MqttClient *mqtt, const char *topic, const char *payload,
     return false;
   if (mqtt->state != MQTT_STATE_ONLINE)
     return false;
-  if (len > MQTT_PAYLOAD_MAX_LEN - 1)
+  if (len > MQTT_PUB_PAYLOAD_MAX_LEN - 1)
+    return false;
+  /* 上一次的 payload 仍在发送队列中（引用 pub_payload），稍后重试 */
+  if (aqua_at_tx_pending(mqtt->at) > 0)
     return false;
 
  /* topic null */
@@ -219,221 +268,273 @@ bool aqua_mqtt_publish(MqttClient *mqtt, const char *topic, const char *payload,
   snprintf(cmd, sizeof(cmd), "AT+MQTTPUBRAW=0,\"%s\",%zu,0,0", mqtt->pub_topic,
            mqtt->pub_payload_len);
   aqua_at_begin_with_prompt(mqtt->at, cmd, AT_TIMEOUT_MQTT);
-  mqtt->pub_start_ms = mqtt->at->now_ms_func();
+  mqtt->pub_result = AT_URC_UNKNOWN;
   mqtt->state = MQTT_STATE_PUBLISHING;
   return true;
 }
 
-/* After raw payload is sent, continue waiting for publish completion markers. */
+/*
+ * After raw payload is sent, continue waiting for publish completion markers.
+ * The wait always uses the full PUB_DATA_TIMEOUT_MS (the publish class is not
+ * adaptive): a late +MQTTPUB:FAIL must still be seen, because a timeout here
+ * is treated as success. This AT-level timeout is the only publish deadline.
+ */
 static void aqua_mqtt_arm_publish_result_wait(MqttClient *mqtt) {
   if (!mqtt || !mqtt->at) {
     return;
   }
-  mqtt->at->state = AT_STATE_WAITING;
-  mqtt->at->expect_prompt = false;
-  mqtt->at->got_ok = false;
-  mqtt->at->cmd_start_ms = mqtt->at->now_ms_func();
-  mqtt->at->cmd_timeout_ms = PUB_DATA_TIMEOUT_MS;
+  aqua_at_await_result(mqtt->at, AT_CMD_CLASS_PUBLISH, PUB_DATA_TIMEOUT_MS);
 }
 
-/* ============================================================================
- * 
- * ============================================================================
- */
-
-MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
-  if (!mqtt || !mqtt->at)
-    return MQTT_STATE_ERROR;
+/* 切换到 AP+STA 配网：AP 流程按状态轮询，命令不带回调 */
+static void aqua_mqtt_queue_ap_start(MqttClient *mqtt) {
+  mqtt->state = MQTT_STATE_AP_START;
+  if (aqua_at_enqueue(mqtt->at, "AT+CWMODE=3", AT_TIMEOUT_SHORT, false, NULL,
+                      NULL) != AT_OK) {
+    aqua_mqtt_fail(mqtt);
+  }
+}
 
-  AtState at_state = aqua_at_step(mqtt->at);
+/*
+ * 连接流程中一条命令结束后推进状态：mqtt->state 表示刚结束的命令所处阶段。
+ * 下一条命令或已在队列中，或在这里入队；出错时进入 ERROR。
+ */
+static void aqua_mqtt_on_connect_result(MqttClient *mqtt, AtState result,
+                                        const AtLine *resp) {
+  bool ok = (result == AT_STATE_DONE_OK);
   char cmd[256];
 
- /* AT */
-  if (at_state == AT_STATE_WAITING && mqtt->state != MQTT_STATE_PUB_DATA) {
-    return mqtt->state;
-  }
-
   switch (mqtt->state) {
-  case MQTT_STATE_IDLE:
-    break;
-
   case MQTT_STATE_AT_TEST:
-    if (at_state == AT_STATE_DONE_OK) {
-      aqua_at_reset(mqtt->at);
-      aqua_at_begin(mqtt->at, "ATE0", AT_TIMEOUT_SHORT);
+    if (ok) {
       mqtt->state = MQTT_STATE_ATE0;
-    } else if (at_state == AT_STATE_DONE_ERROR ||
-               at_state == AT_STATE_DONE_TIMEOUT) {
-      mqtt->state = MQTT_STATE_ERROR;
+    } else {
+      aqua_mqtt_fail(mqtt);
     }
     break;
 
   case MQTT_STATE_ATE0:
-    if (at_state == AT_STATE_DONE_OK) {
-      aqua_at_reset(mqtt->at);
-      aqua_at_begin(mqtt->at, "AT+CWMODE=1", AT_TIMEOUT_SHORT);
+    if (ok) {
       mqtt->state = MQTT_STATE_CWMODE;
-    } else if (at_state == AT_STATE_DONE_ERROR ||
-               at_state == AT_STATE_DONE_TIMEOUT) {
-      mqtt->state = MQTT_STATE_ERROR;
+    } else {
+      aqua_mqtt_fail(mqtt);
     }
     break;
 
   case MQTT_STATE_CWMODE:
-    if (at_state == AT_STATE_DONE_OK) {
-      aqua_at_reset(mqtt->at);
-      if (aqua_mqtt_should_enter_ap_bootstrap(mqtt)) {
-        /* Empty/placeholder Wi-Fi defaults should not loop CWJAP failures. */
-        mqtt->cwjap_fail_count = 0;
-        aqua_at_begin(mqtt->at, "AT+CWMODE=3", AT_TIMEOUT_SHORT);
-        mqtt->state = MQTT_STATE_AP_START;
-      } else {
-        aqua_mqtt_begin_cwjap(mqtt, cmd, sizeof(cmd));
-        mqtt->state = MQTT_STATE_CWJAP;
+    if (!ok) {
+      aqua_mqtt_fail(mqtt);
+    } else if (aqua_mqtt_should_enter_ap_bootstrap(mqtt)) {
+      /* Empty/placeholder Wi-Fi defaults should not loop CWJAP failures. */
+      mqtt->cwjap_fail_count = 0;
+      aqua_mqtt_queue_ap_start(mqtt);
+    } else {
+      mqtt->state = MQTT_STATE_CWJAP;
+      if (!aqua_mqtt_queue_cwjap(mqtt, cmd, sizeof(cmd))) {
+        aqua_mqtt_fail(mqtt);
       }
-    } else if (at_state == AT_STATE_DONE_ERROR ||
-               at_state == AT_STATE_DONE_TIMEOUT) {
-      mqtt->state = MQTT_STATE_ERROR;
     }
     break;
 
   case MQTT_STATE_CWJAP:
-    if (at_state == AT_STATE_DONE_OK) {
-      aqua_at_reset(mqtt->at);
+    if (ok) {
  mqtt->cwjap_fail_count = 0; /* */
  /* WiFi SNTP */
  /* IoTDA MQTT UTC(YYYYMMDDHH) */
-      aqua_at_begin(mqtt->at,
-                    "AT+CIPSNTPCFG=1,0,\"ntp.aliyun.com\","
-                    "\"ntp.ntsc.ac.cn\",\"time.cloudflare.com\"",
-                    AT_TIMEOUT_SNTP);
       mqtt->retry_count = 0;
       mqtt->state = MQTT_STATE_SNTPCFG;
-    } else if (at_state == AT_STATE_DONE_ERROR ||
-               at_state == AT_STATE_DONE_TIMEOUT) {
+      if (!aqua_mqtt_queue_cmd(mqtt,
+                               "AT+CIPSNTPCFG=1,0,\"ntp.aliyun.com\","
+                               "\"ntp.ntsc.ac.cn\",\"time.cloudflare.com\"",
+                               AT_TIMEOUT_SNTP) ||
+          !aqua_mqtt_queue_cmd(mqtt, "AT+CIPSNTPTIME?", AT_TIMEOUT_SNTP)) {
+        aqua_mqtt_fail(mqtt);
+      }
+    } else {
       mqtt->cwjap_fail_count++;
-      aqua_at_reset(mqtt->at);
       if (mqtt->cwjap_fail_count >= CWJAP_MAX_FAILS) {
  /* AP */
  /* AP+STA */
-        aqua_at_begin(mqtt->at, "AT+CWMODE=3", AT_TIMEOUT_SHORT);
-        mqtt->state = MQTT_STATE_AP_START;
-      } else {
+        aqua_mqtt_queue_ap_start(mqtt);
+      } else if (!aqua_mqtt_queue_cwjap(mqtt, cmd, sizeof(cmd))) {
  /* */
-        aqua_mqtt_begin_cwjap(mqtt, cmd, sizeof(cmd));
+        aqua_mqtt_fail(mqtt);
       }
     }
     break;
 
   case MQTT_STATE_SNTPCFG:
-    if (at_state == AT_STATE_DONE_OK) {
-      aqua_at_reset(mqtt->at);
+    if (ok) {
  /* SNTP */
-      aqua_at_begin(mqtt->at, "AT+CIPSNTPTIME?", AT_TIMEOUT_SNTP);
       mqtt->state = MQTT_STATE_SNTPTIME;
-    } else if (at_state == AT_STATE_DONE_ERROR ||
-               at_state == AT_STATE_DONE_TIMEOUT) {
-      mqtt->state = MQTT_STATE_ERROR;
+    } else {
+      aqua_mqtt_fail(mqtt);
     }
     break;
 
-  case MQTT_STATE_SNTPTIME:
-    if (at_state == AT_STATE_DONE_OK) {
+  case MQTT_STATE_SNTPTIME: {
+    if (!ok) {
+      aqua_mqtt_fail(mqtt);
+      break;
+    }
  /* */
-      const AtLine *resp = aqua_at_get_response(mqtt->at);
-      char ts[12];
-      bool ts_ok = (resp && aqua_mqtt_parse_sntp_time(resp->data, ts) &&
-                    strlen(ts) == 10);
-
-      if (!ts_ok && aqua_at_has_urc(mqtt->at)) {
-        AtLine urc;
-        while (aqua_at_pop_line(mqtt->at, &urc) == AT_OK) {
-          if (aqua_mqtt_parse_sntp_time(urc.data, ts) && strlen(ts) == 10) {
-            ts_ok = true;
-            break;
+    char ts[12];
+    uint32_t epoch = 0;
+    bool ts_ok = (resp && aqua_mqtt_parse_sntp_time(resp->data, ts) &&
+                  strlen(ts) == 10);
+    if (ts_ok && !aqua_mqtt_parse_sntp_epoch(resp->data, &epoch)) {
+      epoch = 0;
+    }
+
+    if (!ts_ok && aqua_at_has_urc(mqtt->at)) {
+      AtLineView urc;
+      while (aqua_at_peek_line(mqtt->at, 0, &urc) == AT_OK) {
+        if (urc.type == AT_URC_SNTP_TIME &&
+            aqua_mqtt_parse_sntp_time(urc.data, ts) && strlen(ts) == 10) {
+          ts_ok = true;
+          if (!aqua_mqtt_parse_sntp_epoch(urc.data, &epoch)) {
+            epoch = 0;
           }
         }
+        aqua_at_consume_line(mqtt->at, 0);
+        if (ts_ok)
+          break;
       }
+    }
 
-      if (ts_ok) {
-        aqua_mqtt_set_timestamp(mqtt, ts);
-        mqtt->retry_count = 0;
+    if (ts_ok) {
+      aqua_mqtt_set_timestamp(mqtt, ts);
+      /* 同步应用层 UTC 时钟，供批量上报的 event_time 使用 */
+      if (epoch != 0 && mqtt->gateway) {
+        aqua_gateway_set_utc_time(mqtt->gateway, epoch);
+      } else if (epoch != 0 && mqtt->app) {
+        aqua_app_set_utc_time(mqtt->app, epoch);
       }
-      aqua_at_reset(mqtt->at);
+      mqtt->retry_count = 0;
+    }
 
-      if (!ts_ok) {
-        if (mqtt->retry_count < SNTP_QUERY_MAX_RETRY) {
-          mqtt->retry_count++;
-          aqua_at_begin(mqtt->at, "AT+CIPSNTPTIME?", AT_TIMEOUT_SNTP);
-          mqtt->state = MQTT_STATE_SNTPTIME;
-        } else {
-          mqtt->state = MQTT_STATE_ERROR;
-        }
-        break;
+    if (!ts_ok) {
+      if (mqtt->retry_count < SNTP_QUERY_MAX_RETRY &&
+          aqua_mqtt_queue_cmd(mqtt, "AT+CIPSNTPTIME?", AT_TIMEOUT_SNTP)) {
+        mqtt->retry_count++;
+      } else {
+        aqua_mqtt_fail(mqtt);
       }
+      break;
+    }
 
-      if (strlen(mqtt->timestamp) != 10) {
-        mqtt->state = MQTT_STATE_ERROR;
-        break;
-      }
+    if (strlen(mqtt->timestamp) != 10) {
+      aqua_mqtt_fail(mqtt);
+      break;
+    }
  /* */
-      char client_id[128];
-      char password[65];
-      aqua_iotda_build_client_id(mqtt->config.device_id, IOTDA_SIGN_TYPE_CHECK,
-                                 mqtt->timestamp, client_id, sizeof(client_id));
-      aqua_iotda_build_password(mqtt->config.device_secret, mqtt->timestamp,
-                                password);
-      snprintf(cmd, sizeof(cmd),
-               "AT+MQTTUSERCFG=0,1,\"%s\",\"%s\",\"%s\",0,0,\"\"", client_id,
-               mqtt->config.device_id, password);
-      aqua_at_begin(mqtt->at, cmd, AT_TIMEOUT_SHORT);
-      mqtt->state = MQTT_STATE_MQTTUSERCFG;
-    } else if (at_state == AT_STATE_DONE_ERROR ||
-               at_state == AT_STATE_DONE_TIMEOUT) {
-      mqtt->state = MQTT_STATE_ERROR;
+    char client_id[128];
+    char password[65];
+    aqua_iotda_build_client_id(mqtt->config.device_id, IOTDA_SIGN_TYPE_CHECK,
+                               mqtt->timestamp, client_id, sizeof(client_id));
+    aqua_iotda_build_password(mqtt->config.device_secret, mqtt->timestamp,
+                              password);
+    mqtt->state = MQTT_STATE_MQTTUSERCFG;
+    snprintf(cmd, sizeof(cmd),
+             "AT+MQTTUSERCFG=0,1,\"%s\",\"%s\",\"%s\",0,0,\"\"", client_id,
+             mqtt->config.device_id, password);
+    bool queued = aqua_mqtt_queue_cmd(mqtt, cmd, AT_TIMEOUT_SHORT);
+    snprintf(cmd, sizeof(cmd), "AT+MQTTCONN=0,\"%s\",%u,1",
+             mqtt->config.broker_host, mqtt->config.broker_port);
+    if (!queued || !aqua_mqtt_queue_cmd(mqtt, cmd, AT_TIMEOUT_MQTT)) {
+      aqua_mqtt_fail(mqtt);
     }
     break;
+  }
 
   case MQTT_STATE_MQTTUSERCFG:
-    if (at_state == AT_STATE_DONE_OK) {
-      aqua_at_reset(mqtt->at);
-      snprintf(cmd, sizeof(cmd), "AT+MQTTCONN=0,\"%s\",%u,1",
-               mqtt->config.broker_host, mqtt->config.broker_port);
-      aqua_at_begin(mqtt->at, cmd, AT_TIMEOUT_MQTT);
+    if (ok) {
       mqtt->state = MQTT_STATE_MQTTCONN;
-    } else if (at_state == AT_STATE_DONE_ERROR ||
-               at_state == AT_STATE_DONE_TIMEOUT) {
-      mqtt->state = MQTT_STATE_ERROR;
+    } else {
+      aqua_mqtt_fail(mqtt);
     }
     break;
 
   case MQTT_STATE_MQTTCONN:
-    if (at_state == AT_STATE_DONE_OK) {
-      aqua_at_reset(mqtt->at);
-      snprintf(cmd, sizeof(cmd),
-               "AT+MQTTSUB=0,\"$oc/devices/%s/sys/commands/#\",1",
-               mqtt->config.device_id);
-      aqua_at_begin(mqtt->at, cmd, AT_TIMEOUT_MQTT);
-      mqtt->state = MQTT_STATE_MQTTSUB;
-    } else if (at_state == AT_STATE_DONE_ERROR ||
-               at_state == AT_STATE_DONE_TIMEOUT) {
-      mqtt->state = MQTT_STATE_ERROR;
+    if (ok) {
+      mqtt->sub_index = 0;
+      if (!aqua_mqtt_queue_sub(mqtt, cmd, sizeof(cmd))) {
+        aqua_mqtt_fail(mqtt);
+      }
+    } else {
+      aqua_mqtt_fail(mqtt);
     }
     break;
 
   case MQTT_STATE_MQTTSUB:
-    if (at_state == AT_STATE_DONE_OK) {
-      aqua_at_reset(mqtt->at);
-      mqtt->state = MQTT_STATE_ONLINE;
-    } else if (at_state == AT_STATE_DONE_TIMEOUT) {
-      /*
-       * Some ESP-AT releases occasionally miss the trailing OK for MQTTSUB
-       * while subscription is already effective. Do not force reconnect storm.
-       */
-      aqua_at_reset(mqtt->at);
-      mqtt->state = MQTT_STATE_ONLINE;
-    } else if (at_state == AT_STATE_DONE_ERROR) {
-      mqtt->state = MQTT_STATE_ERROR;
+    /*
+     * Some ESP-AT releases occasionally miss the trailing OK for MQTTSUB
+     * while subscription is already effective. Do not force reconnect storm.
+     */
+    if (ok || result == AT_STATE_DONE_TIMEOUT) {
+      if (++mqtt->sub_index < MQTT_SUB_TOPIC_COUNT) {
+        if (!aqua_mqtt_queue_sub(mqtt, cmd, sizeof(cmd))) {
+          aqua_mqtt_fail(mqtt);
+        }
+      } else {
+        mqtt->state = MQTT_STATE_ONLINE;
+      }
+    } else {
+      aqua_mqtt_fail(mqtt);
+    }
+    break;
+
+  default:
+    /* 状态已被外部改变（如 Wi-Fi 重配置），忽略迟到的结果 */
+    break;
+  }
+}
+
+static void aqua_mqtt_on_connect_cmd(AtState result, const AtLine *response,
+                                     void *user_data) {
+  aqua_mqtt_on_connect_result((MqttClient *)user_data, result, response);
+}
+
+/* ============================================================================
+ * 
+ * ============================================================================
+ */
+
+MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
+  if (!mqtt || !mqtt->at)
+    return MQTT_STATE_ERROR;
+
+  AtState at_state = aqua_at_step(mqtt->at);
+  char cmd[256];
+
+ /* AT */
+  if (at_state == AT_STATE_WAITING && mqtt->state != MQTT_STATE_PUB_DATA) {
+    return mqtt->state;
+  }
+
+  switch (mqtt->state) {
+  case MQTT_STATE_IDLE:
+    break;
+
+  case MQTT_STATE_AT_TEST:
+  case MQTT_STATE_ATE0:
+  case MQTT_STATE_CWMODE:
+  case MQTT_STATE_CWJAP:
+  case MQTT_STATE_SNTPCFG:
+  case MQTT_STATE_SNTPTIME:
+  case MQTT_STATE_MQTTUSERCFG:
+  case MQTT_STATE_MQTTCONN:
+  case MQTT_STATE_MQTTSUB:
+    /*
+     * 排队命令在完成回调中推进，这里只处理未经队列（无回调）的完成状态，
+     * 推进后复位，发出新入队的命令
+     */
+    if (at_state != AT_STATE_IDLE) {
+      aqua_mqtt_on_connect_result(mqtt, at_state,
+                                  aqua_at_get_response(mqtt->at));
+      if (aqua_at_get_state(mqtt->at) == at_state) {
+        aqua_at_reset(mqtt->at);
+      }
     }
     break;
 
@@ -446,8 +547,8 @@ MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
      */
     if (at_state == AT_STATE_GOT_PROMPT) {
  /* > payload \r\n */
-      mqtt->at->write_func((const uint8_t *)mqtt->pub_payload,
-                           mqtt->pub_payload_len);
+      aqua_at_send_data(mqtt->at, (const uint8_t *)mqtt->pub_payload,
+                        mqtt->pub_payload_len);
       mqtt->state = MQTT_STATE_PUB_DATA;
       /*
        * Some ESP-AT builds report publish completion via plain final OK
@@ -463,28 +564,14 @@ MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
   case MQTT_STATE_PUB_DATA: {
     /*
  * URC +MQTTPUB:OK +MQTTPUB:FAIL
+     * （由 aqua_mqtt_on_pub_result 在接收时记录）
      */
-    AtLine deferred_urcs[AT_URC_QUEUE_SIZE];
-    size_t deferred_count = 0;
-    if (aqua_at_has_urc(mqtt->at)) {
-      AtLine urc;
-      while (aqua_at_pop_line(mqtt->at, &urc) == AT_OK) {
-        if (strstr(urc.data, "+MQTTPUB:OK") != NULL) {
-          aqua_at_reset(mqtt->at);
-          mqtt->state = MQTT_STATE_ONLINE;
-          break;
-        } else if (strstr(urc.data, "+MQTTPUB:FAIL") != NULL) {
-          aqua_at_reset(mqtt->at);
-          mqtt->state = MQTT_STATE_ERROR;
-          break;
-        } else if (deferred_count < AT_URC_QUEUE_SIZE) {
-          deferred_urcs[deferred_count++] = urc;
-        }
-      }
-
-      if (deferred_count > 0) {
-        aqua_mqtt_requeue_urcs(mqtt->at, deferred_urcs, deferred_count);
-      }
+    if (mqtt->pub_result == AT_URC_MQTT_PUB_OK) {
+      aqua_at_reset(mqtt->at);
+      mqtt->state = MQTT_STATE_ONLINE;
+    } else if (mqtt->pub_result == AT_URC_MQTT_PUB_FAIL) {
+      aqua_at_reset(mqtt->at);
+      mqtt->state = MQTT_STATE_ERROR;
     }
 
     if (mqtt->state == MQTT_STATE_PUB_DATA) {
@@ -512,15 +599,6 @@ MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
         break;
       }
     }
-
- /* */
-    if (mqtt->state == MQTT_STATE_PUB_DATA) {
-      uint32_t now = mqtt->at->now_ms_func();
-      if (now - mqtt->pub_start_ms >= PUB_DATA_TIMEOUT_MS) {
-        aqua_at_reset(mqtt->at);
-        mqtt->state = MQTT_STATE_ONLINE;
-      }
-    }
     break;
   }
 
@@ -606,8 +684,8 @@ MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
     if (at_state == AT_STATE_GOT_PROMPT) {
  /* HTML */
       if (mqtt->ap_send_html) {
-        mqtt->at->write_func((const uint8_t *)mqtt->ap_send_html,
-                             strlen(mqtt->ap_send_html));
+        aqua_at_send_data(mqtt->at, (const uint8_t *)mqtt->ap_send_html,
+                          strlen(mqtt->ap_send_html));
       }
       aqua_at_reset(mqtt->at);
       mqtt->state = MQTT_STATE_AP_SEND_DATA;
@@ -624,10 +702,12 @@ MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
   case MQTT_STATE_AP_SEND_DATA: {
  /* SEND OK SEND FAIL URC */
     if (aqua_at_has_urc(mqtt->at)) {
-      AtLine urc;
-      while (aqua_at_pop_line(mqtt->at, &urc) == AT_OK) {
-        if (strstr(urc.data, "SEND OK") != NULL ||
-            strstr(urc.data, "SEND FAIL") != NULL) {
+      AtLineView urc;
+      while (aqua_at_peek_line(mqtt->at, 0, &urc) == AT_OK) {
+        bool done = (urc.type == AT_URC_SEND_OK ||
+                     urc.type == AT_URC_SEND_FAIL);
+        aqua_at_consume_line(mqtt->at, 0);
+        if (done) {
  /* */
           aqua_at_reset(mqtt->at);
           snprintf(cmd, sizeof(cmd), "AT+CIPCLOSE=%d", mqtt->ap_link_id);
@@ -659,9 +739,11 @@ MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
     if (at_state == AT_STATE_DONE_OK) {
       aqua_at_reset(mqtt->at);
  /* STA WiFi */
-      aqua_at_begin(mqtt->at, "AT+CWMODE=1", AT_TIMEOUT_SHORT);
       mqtt->cwjap_fail_count = 0;
       mqtt->state = MQTT_STATE_CWMODE;
+      if (!aqua_mqtt_queue_cmd(mqtt, "AT+CWMODE=1", AT_TIMEOUT_SHORT)) {
+        aqua_mqtt_fail(mqtt);
+      }
     } else {
  /* */
     }
@@ -673,10 +755,8 @@ MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
       mqtt->wifi_changed = false;
       mqtt->cwjap_fail_count = 0;
       mqtt->reconnect_delay_ms = RECONNECT_DELAY_INIT_MS;
-      aqua_at_reset(mqtt->at);
  /* MQTT */
-      aqua_at_begin(mqtt->at, "AT+MQTTCLEAN=0", AT_TIMEOUT_SHORT);
- mqtt->state = MQTT_STATE_AT_TEST; /* */
+      aqua_mqtt_queue_init(mqtt, "AT+MQTTCLEAN=0");
     }
     break;
 
@@ -702,9 +782,7 @@ MqttConnState aqua_mqtt_step(MqttClient *mqtt) {
  /* */
       mqtt->error_time_ms = 0;
       mqtt->cwjap_fail_count = 0;
-      aqua_at_reset(mqtt->at);
-      aqua_at_begin(mqtt->at, "AT", AT_TIMEOUT_SHORT);
-      mqtt->state = MQTT_STATE_AT_TEST;
+      aqua_mqtt_queue_init(mqtt, "AT");
     }
     break;
   }
@@ -755,20 +833,22 @@ static bool parse_mqttsubrecv(const char *line, char *out_topic,
   if (*p == ',')
     p++;
 
- /* data_len */
-  int data_len = 0;
+ /* data_len：超过一行的上限后不再累加，超长数字串不会溢出 */
+  size_t data_len = 0;
   while (*p >= '0' && *p <= '9') {
-    data_len = data_len * 10 + (*p - '0');
+    if (data_len <= AT_LINE_MAX_LEN) {
+      data_len = data_len * 10 + (size_t)(*p - '0');
+    }
     p++;
   }
   if (*p == ',')
     p++;
 
- /* payload：
-  * 某些场景下 URC 可能被截断（例如 AT 行缓冲不足），这里不直接丢弃，
+ /* payload（仅按普通行接收时使用，通常由 AT 层原样捕获）：
+  * 长度超过捕获上限时 URC 可能被行缓冲截断，这里不直接丢弃，
   * 而是尽量保留可用部分，后续交给命令解析层返回错误响应，避免平台超时。 */
   size_t available_len = strlen(p);
-  size_t copy_len = (size_t)data_len;
+  size_t copy_len = data_len;
   if (copy_len > available_len) {
     copy_len = available_len;
   }
@@ -787,25 +867,40 @@ bool aqua_mqtt_poll_commands(MqttClient *mqtt) {
     return false;
 
   bool handled = false;
-  AtLine urc;
+  AtLineView urc;
 
-  while (aqua_at_pop_line(mqtt->at, &urc) == AT_OK) {
+  /* 每轮处理队首一行，处理完（含 continue）再消费，行内容不复制 */
+  for (; aqua_at_peek_line(mqtt->at, 0, &urc) == AT_OK;
+       aqua_at_consume_line(mqtt->at, 0)) {
  /* +MQTTSUBRECV */
-    if (strstr(urc.data, "+MQTTSUBRECV:") == NULL)
+    if (urc.type != AT_URC_MQTT_SUBRECV)
       continue;
 
     char topic[MQTT_TOPIC_MAX_LEN];
-    char payload[MQTT_PAYLOAD_MAX_LEN];
+    char line_payload[MQTT_PAYLOAD_MAX_LEN];
 
-    if (!parse_mqttsubrecv(urc.data, topic, sizeof(topic), payload,
-                           sizeof(payload))) {
+    if (!parse_mqttsubrecv(urc.data, topic, sizeof(topic), line_payload,
+                           sizeof(line_payload))) {
       continue;
     }
 
+    /* AT 层按长度原样捕获的 payload 优先（可含 CR/LF、超过一行） */
+    size_t payload_len = 0;
+    const char *payload =
+        aqua_at_get_raw_payload(mqtt->at, urc.raw_id, &payload_len);
+    if (!payload) {
+      payload = line_payload;
+      payload_len = strlen(line_payload);
+    }
+
  /* WiFi */
     ParsedCommand cmd;
     bool wifi_change_needed = false;
-    if (aqua_parse_command_json(payload, strlen(payload), &cmd) == AQUA_OK) {
+    AquaError parse_err =
+        (aqua_parse_downlink_topic(topic) == AQUA_DOWNLINK_PROPERTIES_SET)
+            ? aqua_parse_properties_set_json(payload, payload_len, &cmd)
+            : aqua_parse_command_json(payload, payload_len, &cmd);
+    if (parse_err == AQUA_OK) {
       if (cmd.type == COMMAND_TYPE_SET_CONFIG &&
           cmd.params.config.has_wifi_ssid &&
           cmd.params.config.has_wifi_password &&
@@ -823,9 +918,21 @@ bool aqua_mqtt_poll_commands(MqttClient *mqtt) {
     char resp_payload[MQTT_PAYLOAD_MAX_LEN];
     bool has_response = false;
 
-    AquaError err = aqua_app_on_mqtt_command(
-        mqtt->app, topic, payload, strlen(payload), &has_response, resp_topic,
-        sizeof(resp_topic), resp_payload, sizeof(resp_payload));
+    AquaError err;
+    if (mqtt->gateway) {
+      /* 网关模式：Wi-Fi 配置只跟随 mqtt->app 所在的水族箱 */
+      if (aqua_gateway_route(mqtt->gateway, payload, payload_len) !=
+          mqtt->app) {
+        wifi_change_needed = false;
+      }
+      err = aqua_gateway_on_mqtt_command(
+          mqtt->gateway, topic, payload, payload_len, &has_response,
+          resp_topic, sizeof(resp_topic), resp_payload, sizeof(resp_payload));
+    } else {
+      err = aqua_app_on_mqtt_command(
+          mqtt->app, topic, payload, payload_len, &has_response,
+          resp_topic, sizeof(resp_topic), resp_payload, sizeof(resp_payload));
+    }
 
  /* */
     if (err == AQUA_OK && has_response) {
@@ -854,6 +961,7 @@ bool aqua_mqtt_poll_commands(MqttClient *mqtt) {
       }
 
       handled = true;
+      aqua_at_consume_line(mqtt->at, 0);
  /* publish break */
       break;
     }
@@ -897,17 +1005,18 @@ bool aqua_mqtt_poll_ap_config(MqttClient *mqtt) {
   if (mqtt->state != MQTT_STATE_AP_WAIT)
     return false;
 
-  AtLine urc;
-  while (aqua_at_pop_line(mqtt->at, &urc) == AT_OK) {
+  AtLineView urc;
+  for (; aqua_at_peek_line(mqtt->at, 0, &urc) == AT_OK;
+       aqua_at_consume_line(mqtt->at, 0)) {
     /*
  * +IPD 
  * - (CIPDINFO=0): +IPD,<link_id>,<len>:<data>
  * - (CIPDINFO=1):
      * +IPD,<link_id>,<len>,<remote_ip>,<remote_port>:<data>
      */
-    const char *ipd = strstr(urc.data, "+IPD,");
-    if (!ipd)
+    if (urc.type != AT_URC_IPD)
       continue;
+    const char *ipd = urc.data;
 
  /* link_id */
     ipd += 5;
@@ -976,6 +1085,7 @@ bool aqua_mqtt_poll_ap_config(MqttClient *mqtt) {
     }
 
  /* AT+CIPSEND OK -> > begin_with_prompt */
+    aqua_at_consume_line(mqtt->at, 0);
     aqua_at_begin_with_prompt(mqtt->at, cmd, AT_TIMEOUT_SHORT);
     mqtt->state = MQTT_STATE_AP_SENDING;
     return true;
@@ -1088,6 +1198,72 @@ bool aqua_mqtt_parse_sntp_time(const char *sntp_line, char *out_ts) {
   return true;
 }
 
+/* 读取十进制整数，返回读取的位数 */
+static int read_uint(const char **pp, int *out) {
+  const char *p = *pp;
+  int v = 0;
+  int n = 0;
+  while (*p >= '0' && *p <= '9' && n < 9) {
+    v = v * 10 + (*p - '0');
+    p++;
+    n++;
+  }
+  *pp = p;
+  *out = v;
+  return n;
+}
+
+/* 公历日期 -> 1970-01-01 起的天数（Howard Hinnant days_from_civil） */
+static int32_t days_from_civil(int year, int month, int day) {
+  year -= (month <= 2) ? 1 : 0;
+  int era = year / 400;
+  int yoe = year - era * 400;
+  int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return (int32_t)(era * 146097 + doe - 719468);
+}
+
+bool aqua_mqtt_parse_sntp_epoch(const char *sntp_line, uint32_t *out_seconds) {
+  if (!sntp_line || !out_seconds)
+    return false;
+
+  const char *p = strstr(sntp_line, "+CIPSNTPTIME:");
+  if (!p)
+    return false;
+  p += 13;
+
+  /* 跳过星期 */
+  while (*p && *p != ' ')
+    p++;
+  p = skip_spaces(p);
+
+  if (strlen(p) < 3)
+    return false;
+  int month = parse_month(p);
+  if (month == 0)
+    return false;
+  p = skip_spaces(p + 3);
+
+  int day, hour, minute, second, year;
+  if (read_uint(&p, &day) == 0 || day < 1 || day > 31)
+    return false;
+  p = skip_spaces(p);
+  if (read_uint(&p, &hour) == 0 || hour > 23 || *p++ != ':')
+    return false;
+  if (read_uint(&p, &minute) == 0 || minute > 59 || *p++ != ':')
+    return false;
+  if (read_uint(&p, &second) == 0 || second > 60)
+    return false;
+  p = skip_spaces(p);
+  if (read_uint(&p, &year) != 4 || year < 2020 || year > 2100)
+    return false;
+
+  int32_t days = days_from_civil(year, month, day);
+  *out_seconds = (uint32_t)days * 86400u + (uint32_t)hour * 3600u +
+                 (uint32_t)minute * 60u + (uint32_t)second;
+  return true;
+}
+
 /* ============================================================================
  * AP 
  * ============================================================================
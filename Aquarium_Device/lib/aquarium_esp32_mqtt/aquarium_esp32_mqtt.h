@@ -9,6 +9,7 @@
 #define AQUARIUM_ESP32_MQTT_H
 
 #include "aquarium_app.h"
+#include "aquarium_gateway.h"
 #include "aquarium_at.h"
 #include <stdbool.h>
 #include <stdint.h>
@@ -25,6 +26,8 @@ extern "C" {
 #define MQTT_BROKER_MAX_LEN 128
 #define MQTT_TOPIC_MAX_LEN 256
 #define MQTT_PAYLOAD_MAX_LEN 512
+/* 上行发布缓冲：批量属性上报一条消息携带多个采样 */
+#define MQTT_PUB_PAYLOAD_MAX_LEN 1024
 
 /* ============================================================================
  * 
@@ -87,18 +90,20 @@ typedef struct {
   MqttConfig config;
  AtClient *at; /* AT */
  AquariumApp *app; /* */
+  AquaGateway *gateway; /* 网关模式：下行按 object_device_id 路由，NULL 为单设备 */
 
  /* */
   char timestamp[12];
 
  /* */
   char pub_topic[MQTT_TOPIC_MAX_LEN];
-  char pub_payload[MQTT_PAYLOAD_MAX_LEN];
+  char pub_payload[MQTT_PUB_PAYLOAD_MAX_LEN];
   size_t pub_payload_len;
- uint32_t pub_start_ms; /* */
+  AtUrcType pub_result; /* PUB_DATA 期间收到的 +MQTTPUB 结果，未收到为 UNKNOWN */
 
  /* */
   uint8_t retry_count;
+  uint8_t sub_index; /* MQTTSUB 阶段正在订阅的下行 Topic 序号 */
  uint8_t cwjap_fail_count; /* CWJAP */
 
  /* AP */
@@ -136,6 +141,14 @@ void aqua_mqtt_set_config(MqttClient *mqtt, const MqttConfig *cfg);
 /** @brief */
 void aqua_mqtt_set_timestamp(MqttClient *mqtt, const char *ts);
 
+/**
+ * @brief 启用网关模式（gw 为 NULL 时恢复单设备）
+ *
+ * 下行请求经 aqua_gateway_on_mqtt_command 路由到子设备；
+ * Wi-Fi 配置变更只在目标为 mqtt->app 时生效。
+ */
+void aqua_mqtt_set_gateway(MqttClient *mqtt, AquaGateway *gw);
+
 /** @brief AP SSID/ */
 void aqua_mqtt_set_ap_credentials(MqttClient *mqtt, const char *ssid,
                                   const char *password);
@@ -197,6 +210,17 @@ bool aqua_mqtt_poll_ap_config(MqttClient *mqtt);
  */
 bool aqua_mqtt_parse_sntp_time(const char *sntp_line, char *out_ts);
 
+/**
+ * @brief 解析 SNTP 时间为 Unix 秒
+ *
+ * 输入如 "+CIPSNTPTIME:Mon Oct 18 20:12:27 2021"（SNTP 时区配置为 0，即 UTC）
+ *
+ * @param sntp_line   AT+CIPSNTPTIME 响应行
+ * @param out_seconds [输出] 自 1970-01-01 00:00:00 UTC 起的秒数
+ * @return true 解析成功
+ */
+bool aqua_mqtt_parse_sntp_epoch(const char *sntp_line, uint32_t *out_seconds);
+
 /**
  * @brief AP HTTP 
  *
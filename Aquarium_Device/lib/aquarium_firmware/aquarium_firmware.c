@@ -31,11 +31,75 @@ void aqua_fw_set_actuator_callback(AquaFirmware *fw, ActuatorCallback cb,
   fw->actuator_cb_data = user_data;
 }
 
+void aqua_fw_set_gateway(AquaFirmware *fw, AquaGateway *gw,
+                         SubDeviceActuatorCallback cb, void *user_data) {
+  if (!fw)
+    return;
+  fw->gateway = gw;
+  fw->sub_actuator_cb = cb;
+  fw->sub_actuator_cb_data = user_data;
+  aqua_mqtt_set_gateway(fw->mqtt, gw);
+}
+
 /* ============================================================================
  * 主循环
  * ============================================================================
  */
 
+/* 单设备：推进业务逻辑、输出执行器、发布上报 */
+static void fw_step_app(AquaFirmware *fw, uint32_t elapsed_seconds,
+                        MqttConnState mqtt_state) {
+  ActuatorDesired actuators;
+  bool has_publish = false;
+  char topic[MQTT_TOPIC_MAX_LEN];
+  char payload[MQTT_PUB_PAYLOAD_MAX_LEN];
+
+  AquaError err =
+      aqua_app_step(fw->app, elapsed_seconds, &actuators, &has_publish, topic,
+                    sizeof(topic), payload, sizeof(payload));
+
+  /* 5. 输出执行器状态到硬件（通过回调） */
+  if (err == AQUA_OK && fw->actuator_cb) {
+    fw->actuator_cb(&actuators, fw->actuator_cb_data);
+  }
+
+  /* 6. 如果 ONLINE 且有上报数据，调用 mqtt_publish */
+  if (err == AQUA_OK && has_publish) {
+    bool sent = (mqtt_state == MQTT_STATE_ONLINE) &&
+                aqua_mqtt_publish(fw->mqtt, topic, payload,
+                                  aqua_app_get_report_len(fw->app));
+    /* 增量上报未能发出时，下次补发全量关键帧 */
+    if (!sent) {
+      aqua_app_request_keyframe(fw->app);
+    }
+  }
+}
+
+/* 网关模式：推进全部子设备，合并上报一次发布 */
+static void fw_step_gateway(AquaFirmware *fw, uint32_t elapsed_seconds,
+                            MqttConnState mqtt_state) {
+  ActuatorDesired actuators[AQUA_GATEWAY_MAX_DEVICES];
+  bool has_publish = false;
+  char topic[MQTT_TOPIC_MAX_LEN];
+  char payload[MQTT_PUB_PAYLOAD_MAX_LEN];
+
+  AquaError err =
+      aqua_gateway_step(fw->gateway, elapsed_seconds, actuators, &has_publish,
+                        topic, sizeof(topic), payload, sizeof(payload));
+
+  if (err == AQUA_OK && fw->sub_actuator_cb) {
+    for (size_t i = 0; i < fw->gateway->count; ++i) {
+      fw->sub_actuator_cb(i, &actuators[i], fw->sub_actuator_cb_data);
+    }
+  }
+
+  /* 网关上报均为全量，离线时丢弃即可，下个周期会带上最新状态 */
+  if (err == AQUA_OK && has_publish && mqtt_state == MQTT_STATE_ONLINE) {
+    aqua_mqtt_publish(fw->mqtt, topic, payload,
+                      aqua_gateway_get_report_len(fw->gateway));
+  }
+}
+
 void aqua_fw_step(AquaFirmware *fw, uint32_t now_ms) {
   if (!fw || !fw->app || !fw->mqtt)
     return;
@@ -73,23 +137,10 @@ void aqua_fw_step(AquaFirmware *fw, uint32_t now_ms) {
 
   /* 4. 无论网络状态如何，始终推进业务逻辑（投喂倒计时、告警、执行器计算） */
   if (elapsed_seconds > 0) {
-    ActuatorDesired actuators;
-    bool has_publish = false;
-    char topic[MQTT_TOPIC_MAX_LEN];
-    char payload[MQTT_PAYLOAD_MAX_LEN];
-
-    AquaError err =
-        aqua_app_step(fw->app, elapsed_seconds, &actuators, &has_publish, topic,
-                      sizeof(topic), payload, sizeof(payload));
-
-    /* 5. 输出执行器状态到硬件（通过回调） */
-    if (err == AQUA_OK && fw->actuator_cb) {
-      fw->actuator_cb(&actuators, fw->actuator_cb_data);
-    }
-
-    /* 6. 如果 ONLINE 且有上报数据，调用 mqtt_publish */
-    if (err == AQUA_OK && has_publish && mqtt_state == MQTT_STATE_ONLINE) {
-      aqua_mqtt_publish(fw->mqtt, topic, payload, strlen(payload));
+    if (fw->gateway) {
+      fw_step_gateway(fw, elapsed_seconds, mqtt_state);
+    } else {
+      fw_step_app(fw, elapsed_seconds, mqtt_state);
     }
   }
 }
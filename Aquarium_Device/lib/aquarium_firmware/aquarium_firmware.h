@@ -7,6 +7,7 @@
  * - 下行命令处理及响应
  * - 传感器数据更新驱动
  * - 执行器状态输出
+ * - 网关模式：多个水族箱作为子设备合并上报
  */
 
 #ifndef AQUARIUM_FIRMWARE_H
@@ -14,6 +15,7 @@
 
 #include "aquarium_app.h"
 #include "aquarium_esp32_mqtt.h"
+#include "aquarium_gateway.h"
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -36,6 +38,17 @@ extern "C" {
 typedef void (*ActuatorCallback)(const ActuatorDesired *actuators,
                                  void *user_data);
 
+/**
+ * @brief 网关模式下子设备执行器控制回调函数类型
+ *
+ * @param index     子设备在网关 devices 数组中的下标
+ * @param actuators 该子设备期望的执行器状态
+ * @param user_data 用户自定义数据
+ */
+typedef void (*SubDeviceActuatorCallback)(size_t index,
+                                          const ActuatorDesired *actuators,
+                                          void *user_data);
+
 /* ============================================================================
  * 固件上下文
  * ============================================================================
@@ -50,6 +63,11 @@ typedef struct {
   /* 执行器回调 */
   ActuatorCallback actuator_cb;
   void *actuator_cb_data;
+
+  /* 网关模式（NULL 为单设备） */
+  AquaGateway *gateway;
+  SubDeviceActuatorCallback sub_actuator_cb;
+  void *sub_actuator_cb_data;
 } AquaFirmware;
 
 /* ============================================================================
@@ -76,6 +94,23 @@ void aqua_fw_init(AquaFirmware *fw, AquariumApp *app, MqttClient *mqtt);
 void aqua_fw_set_actuator_callback(AquaFirmware *fw, ActuatorCallback cb,
                                    void *user_data);
 
+/**
+ * @brief 启用网关模式
+ *
+ * 启用后 step 推进网关内的全部子设备并合并上报，下行请求按
+ * object_device_id 路由（同时设置到 MQTT 客户端）；执行器输出改为
+ * 按子设备调用 cb。fw->app 仍是持有 Wi-Fi 配置的水族箱，
+ * 通常是网关 devices 中的一项。gw 为 NULL 时恢复单设备。
+ * 子设备的传感器数据直接用 aqua_app_update_sensors 更新。
+ *
+ * @param fw        固件上下文指针
+ * @param gw        已初始化的网关上下文
+ * @param cb        子设备执行器回调
+ * @param user_data 用户自定义数据（传给回调）
+ */
+void aqua_fw_set_gateway(AquaFirmware *fw, AquaGateway *gw,
+                         SubDeviceActuatorCallback cb, void *user_data);
+
 /* ============================================================================
  * 主循环
  * ============================================================================
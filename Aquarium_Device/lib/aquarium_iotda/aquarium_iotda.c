@@ -4,10 +4,8 @@
  */
 
 #include "aquarium_iotda.h"
-#include <stdio.h>
 #include <string.h>
 
-
 /* ============================================================================
  * 属性上报生成
  * ============================================================================
@@ -39,81 +37,93 @@ AquaError aqua_iotda_build_report(const char *device_id,
 }
 
 /* ============================================================================
- * 辅助函数：构建响应名称
+ * 辅助函数：命令生效后的状态快照
  * ============================================================================
  */
 
-static void build_response_name(const char *command_name, char *out,
-                                size_t size) {
-  if (!out || size == 0) {
-    return;
+/* 快照只回显命令涉及的字段：参数中出现的字段及其派生量 */
+typedef struct {
+  const AquariumState *state;
+  const ParsedCommand *cmd;
+} StateSnapshot;
+
+/* control 命令涉及的属性 */
+#define SNAPSHOT_CONTROL_FIELDS                                                \
+  (AQUA_PROP_HEATER | AQUA_PROP_PUMP_IN | AQUA_PROP_PUMP_OUT |                 \
+   AQUA_PROP_AUTO_MODE | AQUA_PROP_FEED_COUNTDOWN |                            \
+   AQUA_PROP_FEEDING_IN_PROGRESS | AQUA_PROP_ALARM_MUTED)
+
+#define SNAPSHOT_FIELD_BOOL(w, name, v) aqua_jw_key_bool(w, #name, v);
+#define SNAPSHOT_FIELD_INT(w, name, v) aqua_jw_key_i32(w, #name, v);
+#define SNAPSHOT_FIELD_INT_OR_STRING(w, name, v) aqua_jw_key_i32(w, #name, v);
+#define SNAPSHOT_FIELD_FLOAT(w, name, v) aqua_jw_key_f32(w, #name, v, 2);
+#define SNAPSHOT_FIELD_STRING(w, name, v) /* Wi-Fi 凭据不回显 */
+
+static void write_state_snapshot(AquaJsonWriter *w, const void *ctx) {
+  const StateSnapshot *snap = (const StateSnapshot *)ctx;
+  const AquariumState *state = snap->state;
+  const ParsedCommand *cmd = snap->cmd;
+
+  aqua_jw_key_obj(w, "state");
+  switch (cmd->type) {
+  case COMMAND_TYPE_CONTROL: {
+    /* 自动模式下执行器由逻辑层接管，回显实际将要输出的状态 */
+    AquariumProperties props = state->props;
+    if (props.auto_mode) {
+      ActuatorDesired desired;
+      aqua_logic_compute_actuators(state, &desired);
+      props.heater = desired.heater;
+      props.pump_in = desired.pump_in;
+      props.pump_out = desired.pump_out;
+    }
+    aqua_jw_properties(w, &props, SNAPSHOT_CONTROL_FIELDS);
+    if (cmd->params.control.has_target_temp) {
+      aqua_jw_key_f32(w, "target_temp", state->target_temp, 2);
+    }
+    break;
   }
-
-  const char *suffix = "_response";
-
-  if (!command_name) {
-    strncpy(out, "response", size - 1);
-    out[size - 1] = '\0';
-    return;
+  case COMMAND_TYPE_SET_THRESHOLDS: {
+    const ThresholdCommandParams *p = &cmd->params.threshold;
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  if (p->has_##name) {                                                         \
+    SNAPSHOT_FIELD_##type(w, name, state->thresholds.name)                     \
   }
-
-  size_t name_len = strlen(command_name);
-  size_t suffix_len = strlen(suffix);
-
-  if (name_len + suffix_len + 1 > size) {
-    strncpy(out, "response", size - 1);
-    out[size - 1] = '\0';
-    return;
+#include "aquarium_schema.def"
+    if (p->has_target_temp) {
+      aqua_jw_key_f32(w, "target_temp", state->target_temp, 2);
+    }
+    /* 投喂间隔变化时倒计时随之重置 */
+    if (p->has_feed_interval) {
+      aqua_jw_properties(w, &state->props, AQUA_PROP_FEED_COUNTDOWN);
+    }
+    break;
   }
-
-  memcpy(out, command_name, name_len);
-  memcpy(out + name_len, suffix, suffix_len + 1);
-}
-
-/* ============================================================================
- * 辅助函数：构建错误响应
- * ============================================================================
- */
-
-static AquaError build_error_response(const char *device_id,
-                                      const char *request_id,
-                                      const char *command_name,
-                                      const char *error_msg,
-                                      IoTDACommandResult *result) {
-  result->has_response = true;
-
-  /* 构建响应 Topic */
-  AquaError err = aqua_build_response_topic(
-      device_id, request_id, result->response_topic,
-      sizeof(result->response_topic), &result->response_topic_len);
-  if (err != AQUA_OK) {
-    return err;
+  case COMMAND_TYPE_SET_CONFIG: {
+    const ConfigCommandParams *p = &cmd->params.config;
+#define AQUA_CONFIG_PARAM(name, type, min, max, def)                           \
+  if (p->has_##name) {                                                         \
+    SNAPSHOT_FIELD_##type(w, name, state->config.name)                         \
   }
-
-  /* 构建响应 Payload */
-  CommandResponse resp = {0};
-  resp.result_code = 2; /* 参数错误 */
-  build_response_name(command_name, resp.response_name,
-                      sizeof(resp.response_name));
-  strncpy(resp.result, "failed", sizeof(resp.result) - 1);
-  strncpy(resp.error, error_msg, sizeof(resp.error) - 1);
-  resp.has_error = true;
-
-  err = aqua_build_response_json(&resp, result->response_payload,
-                                 sizeof(result->response_payload),
-                                 &result->response_payload_len);
-
-  return err;
+#include "aquarium_schema.def"
+    break;
+  }
+  default:
+    break;
+  }
+  aqua_jw_end_obj(w);
 }
 
 /* ============================================================================
- * 辅助函数：构建成功响应
+ * 辅助函数：构建命令响应
  * ============================================================================
  */
 
-static AquaError build_success_response(const char *device_id,
+static AquaError build_command_response(const char *device_id,
                                         const char *request_id,
                                         const char *command_name,
+                                        int32_t result_code,
+                                        const char *error_msg,
+                                        const StateSnapshot *snapshot,
                                         IoTDACommandResult *result) {
   result->has_response = true;
 
@@ -125,19 +135,12 @@ static AquaError build_success_response(const char *device_id,
     return err;
   }
 
-  /* 构建响应 Payload */
-  CommandResponse resp = {0};
-  resp.result_code = 0; /* 成功 */
-  build_response_name(command_name, resp.response_name,
-                      sizeof(resp.response_name));
-  strncpy(resp.result, "success", sizeof(resp.result) - 1);
-  resp.has_error = false;
-
-  err = aqua_build_response_json(&resp, result->response_payload,
-                                 sizeof(result->response_payload),
-                                 &result->response_payload_len);
-
-  return err;
+  /* 构建响应 Payload：直接写入结果缓冲区 */
+  return aqua_build_command_response_paras_json(
+      result_code, command_name, error_msg,
+      snapshot ? write_state_snapshot : NULL, snapshot,
+      result->response_payload, sizeof(result->response_payload),
+      &result->response_payload_len);
 }
 
 /* ============================================================================
@@ -147,7 +150,7 @@ static AquaError build_success_response(const char *device_id,
 
 AquaError aqua_iotda_handle_command(const char *device_id, const char *in_topic,
                                     const char *in_payload, size_t payload_len,
-                                    AquariumState *state,
+                                    AquariumState *state, uint32_t options,
                                     IoTDACommandResult *result) {
   if (!device_id || !in_topic || !in_payload || !state || !result) {
     return AQUA_ERR_NULL_PTR;
@@ -175,21 +178,155 @@ AquaError aqua_iotda_handle_command(const char *device_id, const char *in_topic,
       error_msg = "missing required field";
     } else if (err == AQUA_ERR_INVALID_COMMAND) {
       error_msg = "unknown command";
+    } else if (err == AQUA_ERR_INVALID_VALUE) {
+      error_msg = "parameter value too long";
     }
     const char *command_name =
         (cmd.command_name[0] != '\0') ? cmd.command_name : "unknown";
-    return build_error_response(device_id, request_id, command_name, error_msg,
-                                result);
+    return build_command_response(device_id, request_id, command_name,
+                                  2 /* 参数错误 */, error_msg, NULL, result);
   }
 
   /* 3. 应用命令到状态 */
+  StateSnapshot snapshot = {state, &cmd};
+  const StateSnapshot *snap =
+      (options & IOTDA_CMD_RESPONSE_STATE) ? &snapshot : NULL;
   err = aqua_logic_apply_command(state, &cmd);
   if (err != AQUA_OK) {
-    return build_error_response(device_id, request_id, cmd.command_name,
-                                "command apply failed", result);
+    return build_command_response(device_id, request_id, cmd.command_name,
+                                  2 /* 参数错误 */, "command apply failed",
+                                  snap, result);
   }
 
   /* 4. 构建成功响应 */
-  return build_success_response(device_id, request_id, cmd.command_name,
-                                result);
+  return build_command_response(device_id, request_id, cmd.command_name,
+                                0 /* 成功 */, NULL, snap, result);
+}
+
+/* ============================================================================
+ * 属性设置/查询
+ * ============================================================================
+ */
+
+static const char *parse_error_desc(AquaError err) {
+  switch (err) {
+  case AQUA_ERR_MISSING_FIELD:
+    return "missing required field";
+  case AQUA_ERR_INVALID_SERVICE:
+    return "unknown service";
+  case AQUA_ERR_INVALID_COMMAND:
+    return "property not writable";
+  default:
+    return "JSON parse error";
+  }
+}
+
+static AquaError build_properties_set_response(const char *device_id,
+                                               const char *request_id,
+                                               int32_t result_code,
+                                               const char *result_desc,
+                                               IoTDACommandResult *result) {
+  result->has_response = true;
+
+  AquaError err = aqua_build_downlink_response_topic(
+      device_id, AQUA_DOWNLINK_PROPERTIES_SET, request_id,
+      result->response_topic, sizeof(result->response_topic),
+      &result->response_topic_len);
+  if (err != AQUA_OK) {
+    return err;
+  }
+
+  return aqua_build_properties_set_response_json(
+      result_code, result_desc, result->response_payload,
+      sizeof(result->response_payload), &result->response_payload_len);
+}
+
+AquaError aqua_iotda_handle_properties_set(const char *device_id,
+                                           const char *in_topic,
+                                           const char *in_payload,
+                                           size_t payload_len,
+                                           AquariumState *state,
+                                           IoTDACommandResult *result) {
+  if (!device_id || !in_topic || !in_payload || !state || !result) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  memset(result, 0, sizeof(IoTDACommandResult));
+
+  char request_id[64] = {0};
+  AquaError err =
+      aqua_extract_request_id(in_topic, request_id, sizeof(request_id));
+  if (err != AQUA_OK) {
+    return err;
+  }
+
+  ParsedCommand cmd;
+  err = aqua_parse_properties_set_json(in_payload, payload_len, &cmd);
+  if (err != AQUA_OK) {
+    return build_properties_set_response(device_id, request_id, 1,
+                                         parse_error_desc(err), result);
+  }
+
+  err = aqua_logic_apply_command(state, &cmd);
+  if (err != AQUA_OK) {
+    return build_properties_set_response(device_id, request_id, 1,
+                                         "property apply failed", result);
+  }
+
+  return build_properties_set_response(device_id, request_id, 0, NULL,
+                                       result);
+}
+
+AquaError aqua_iotda_handle_properties_get(const char *device_id,
+                                           const char *in_topic,
+                                           const AquariumProperties *props,
+                                           IoTDACommandResult *result) {
+  if (!device_id || !in_topic || !props || !result) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  memset(result, 0, sizeof(IoTDACommandResult));
+
+  char request_id[64] = {0};
+  AquaError err =
+      aqua_extract_request_id(in_topic, request_id, sizeof(request_id));
+  if (err != AQUA_OK) {
+    return err;
+  }
+
+  result->has_response = true;
+  err = aqua_build_downlink_response_topic(
+      device_id, AQUA_DOWNLINK_PROPERTIES_GET, request_id,
+      result->response_topic, sizeof(result->response_topic),
+      &result->response_topic_len);
+  if (err != AQUA_OK) {
+    return err;
+  }
+
+  return aqua_build_properties_json(props, result->response_payload,
+                                    sizeof(result->response_payload),
+                                    &result->response_payload_len);
+}
+
+AquaError aqua_iotda_handle_downlink(const char *device_id,
+                                     const char *in_topic,
+                                     const char *in_payload,
+                                     size_t payload_len, AquariumState *state,
+                                     uint32_t options,
+                                     IoTDACommandResult *result) {
+  if (!state) {
+    return AQUA_ERR_NULL_PTR;
+  }
+
+  switch (aqua_parse_downlink_topic(in_topic)) {
+  case AQUA_DOWNLINK_PROPERTIES_SET:
+    return aqua_iotda_handle_properties_set(device_id, in_topic, in_payload,
+                                            payload_len, state, result);
+  case AQUA_DOWNLINK_PROPERTIES_GET:
+    return aqua_iotda_handle_properties_get(device_id, in_topic, &state->props,
+                                            result);
+  default:
+    return aqua_iotda_handle_command(device_id, in_topic, in_payload,
+                                     payload_len, state, options, result);
+  }
 }
@@ -5,6 +5,7 @@
  * 将 aquarium_core（协议编解码）与 aquarium_logic（业务逻辑）串联：
  * - 生成属性上报 Topic + Payload
  * - 处理命令请求并生成响应 Topic + Payload
+ * - 处理属性设置/查询请求并生成响应 Topic + Payload
  */
 
 #ifndef AQUARIUM_IOTDA_H
@@ -71,6 +72,9 @@ typedef struct {
  * ============================================================================
  */
 
+/* 命令处理选项（aqua_iotda_handle_command 的 options 参数） */
+#define IOTDA_CMD_RESPONSE_STATE (1u << 0) /* paras.state 附带命令生效后的状态 */
+
 /**
  * @brief 处理 MQTT 命令请求
  *
@@ -85,19 +89,92 @@ typedef struct {
  * - 成功：result_code=0, result="success"
  * - 解析/参数错误：result_code=2, result="failed", error="..."
  *
+ * options 含 IOTDA_CMD_RESPONSE_STATE 时，只要命令解析成功（无论是否应用成功），
+ * paras 中附带 "state" 对象，内容为该命令涉及字段的当前值，
+ * 云端与 App 无需等待下一次属性上报即可确认：
+ * - control：heater/pump_in/pump_out/auto_mode/feed_countdown/
+ *   feeding_in_progress/alarm_muted（自动模式下执行器为按当前状态
+ *   计算出的期望值）及 target_temp
+ * - set_thresholds：全部阈值、target_temp 与 feed_countdown
+ * - set_config：ph_offset/tds_factor（Wi-Fi 凭据不回显）
+ *
  * @param device_id     设备 ID
  * @param in_topic      输入命令 Topic
  * @param in_payload    输入命令 Payload（JSON）
  * @param payload_len   Payload 长度
  * @param state         设备状态指针（会被更新）
+ * @param options       IOTDA_CMD_* 选项位组合，0 为默认行为
  * @param result        [输出] 命令处理结果
  * @return AquaError 错误码（表示函数执行状态，非命令执行结果）
  */
 AquaError aqua_iotda_handle_command(const char *device_id, const char *in_topic,
                                     const char *in_payload, size_t payload_len,
-                                    AquariumState *state,
+                                    AquariumState *state, uint32_t options,
                                     IoTDACommandResult *result);
 
+/* ============================================================================
+ * 属性设置/查询
+ * ============================================================================
+ */
+
+/**
+ * @brief 处理属性设置请求（sys/properties/set）
+ *
+ * 请求由 aqua_parse_properties_set_json 映射为命令后经
+ * aqua_logic_apply_command 校验并应用，与命令下发的校验规则一致。
+ * 响应发布到 sys/properties/set/response/request_id={request_id}：
+ * - 成功：{"result_code":0,"result_desc":"success"}
+ * - 解析/参数错误：result_code=1，result_desc 为错误描述
+ *
+ * @param device_id     设备 ID
+ * @param in_topic      输入请求 Topic
+ * @param in_payload    输入请求 Payload（JSON）
+ * @param payload_len   Payload 长度
+ * @param state         设备状态指针（会被更新）
+ * @param result        [输出] 处理结果
+ * @return AquaError 错误码（表示函数执行状态，非设置结果）
+ */
+AquaError aqua_iotda_handle_properties_set(const char *device_id,
+                                           const char *in_topic,
+                                           const char *in_payload,
+                                           size_t payload_len,
+                                           AquariumState *state,
+                                           IoTDACommandResult *result);
+
+/**
+ * @brief 处理属性查询请求（sys/properties/get）
+ *
+ * 直接以内存中的当前属性（与周期上报同源）生成响应，不触发传感器采集，
+ * 也不影响上报周期与增量上报的基准。响应发布到
+ * sys/properties/get/response/request_id={request_id}，格式同属性上报：
+ * {"services":[{"service_id":"Aquarium","properties":{...}}]}
+ *
+ * @param device_id     设备 ID
+ * @param in_topic      输入请求 Topic
+ * @param props         当前属性
+ * @param result        [输出] 处理结果
+ * @return AquaError 错误码
+ */
+AquaError aqua_iotda_handle_properties_get(const char *device_id,
+                                           const char *in_topic,
+                                           const AquariumProperties *props,
+                                           IoTDACommandResult *result);
+
+/**
+ * @brief 按 Topic 分发下行请求
+ *
+ * sys/properties/set、sys/properties/get 分别交给上面两个函数，
+ * 其余 Topic 按命令请求处理（aqua_iotda_handle_command）。
+ *
+ * @param options 命令处理选项，仅对命令请求生效
+ */
+AquaError aqua_iotda_handle_downlink(const char *device_id,
+                                     const char *in_topic,
+                                     const char *in_payload,
+                                     size_t payload_len, AquariumState *state,
+                                     uint32_t options,
+                                     IoTDACommandResult *result);
+
 #ifdef __cplusplus
 }
 #endif
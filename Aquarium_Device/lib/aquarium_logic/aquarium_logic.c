@@ -4,29 +4,65 @@
  */
 
 #include "aquarium_logic.h"
+#include <stddef.h>
 #include <string.h>
 
-/* Firmware-side command boundary validation (defense in depth). */
-#define TEMP_PHYS_MIN (-55.0f)
-#define TEMP_PHYS_MAX (125.0f)
-#define PH_PHYS_MIN (0.0f)
-#define PH_PHYS_MAX (14.0f)
-#define TDS_PHYS_MIN (0)
-#define TDS_PHYS_MAX (5000)
-#define TURBIDITY_PHYS_MIN (0)
-#define TURBIDITY_PHYS_MAX (3000)
-#define LEVEL_PHYS_MIN (0)
-#define LEVEL_PHYS_MAX (100)
-#define FEED_INTERVAL_MIN (1)
-#define FEED_INTERVAL_MAX (168)
-#define FEED_AMOUNT_MIN (1)
-#define FEED_AMOUNT_MAX (10)
-#define PH_OFFSET_MIN (-5.0f)
-#define PH_OFFSET_MAX (5.0f)
-#define TDS_FACTOR_MIN (0.1f)
-#define TDS_FACTOR_MAX (10.0f)
-#define TARGET_TEMP_MIN (0.0f)
-#define TARGET_TEMP_MAX (40.0f)
+/* ============================================================================
+ * 命令参数字段表（由 aquarium_schema.def 展开）
+ *
+ * 单字段范围校验与落盘拷贝共用一张表；跨字段约束见各 validate 函数。
+ * ============================================================================
+ */
+
+/* 不直接写入持久化结构的字段（由 apply 函数单独处理） */
+#define LOGIC_FIELD_NO_STORE 0xFFFFu
+
+typedef struct {
+  uint8_t type;          /* AquaFieldType */
+  uint16_t param_offset; /* 值在命令参数结构体中的偏移 */
+  uint16_t has_offset;   /* has_* 标志在命令参数结构体中的偏移 */
+  uint16_t store_offset; /* 在 ThresholdConfig / DeviceConfig 中的偏移 */
+  uint16_t size;
+  float min; /* STRING 为长度范围 */
+  float max;
+} LogicFieldDesc;
+
+#define LOGIC_FIELD(params_type, name, field_type, lo, hi, store)              \
+  {(uint8_t)(field_type), (uint16_t)offsetof(params_type, name),               \
+   (uint16_t)offsetof(params_type, has_##name), (uint16_t)(store),             \
+   (uint16_t)sizeof(((params_type *)0)->name), (float)(lo), (float)(hi)}
+
+static const LogicFieldDesc CONTROL_FIELDS[] = {
+#define AQUA_CONTROL_PARAM(name, type, min, max)                               \
+  LOGIC_FIELD(ControlCommandParams, name, AQUA_FIELD_##type, min, max,         \
+              LOGIC_FIELD_NO_STORE),
+#include "aquarium_schema.def"
+};
+
+static const LogicFieldDesc THRESHOLD_FIELDS[] = {
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  LOGIC_FIELD(ThresholdCommandParams, name, AQUA_FIELD_##type, min, max,       \
+              offsetof(ThresholdConfig, name)),
+#define AQUA_THRESHOLD_RUNTIME(name, type, min, max)                           \
+  LOGIC_FIELD(ThresholdCommandParams, name, AQUA_FIELD_##type, min, max,       \
+              LOGIC_FIELD_NO_STORE),
+#include "aquarium_schema.def"
+};
+
+static const LogicFieldDesc CONFIG_FIELDS[] = {
+#define AQUA_CONFIG_PARAM(name, type, min, max, def)                           \
+  LOGIC_FIELD(ConfigCommandParams, name, AQUA_FIELD_##type, min, max,          \
+              offsetof(DeviceConfig, name)),
+#include "aquarium_schema.def"
+};
+
+#define LOGIC_FIELD_COUNT(table) (sizeof(table) / sizeof((table)[0]))
+
+#define LOGIC_DEFAULT_BOOL(dst, def) (dst) = (def);
+#define LOGIC_DEFAULT_INT(dst, def) (dst) = (def);
+#define LOGIC_DEFAULT_INT_OR_STRING(dst, def) (dst) = (def);
+#define LOGIC_DEFAULT_FLOAT(dst, def) (dst) = (def);
+#define LOGIC_DEFAULT_STRING(dst, def)
 
 /* 静态函数前向声明 */
 static AquaError aqua_logic_apply_control(AquariumState *state,
@@ -49,8 +85,60 @@ static bool aqua_logic_in_rangef(float v, float min, float max) {
   return aqua_logic_is_finitef(v) && v >= min && v <= max;
 }
 
-static bool aqua_logic_in_rangei(int32_t v, int32_t min, int32_t max) {
-  return v >= min && v <= max;
+static bool aqua_logic_field_present(const LogicFieldDesc *field,
+                                     const void *params) {
+  return *((const bool *)((const uint8_t *)params + field->has_offset));
+}
+
+/* 校验所有出现的字段是否在 schema 给定的范围内 */
+static bool aqua_logic_fields_in_range(const LogicFieldDesc *fields,
+                                       size_t count, const void *params) {
+  for (size_t i = 0; i < count; ++i) {
+    const LogicFieldDesc *field = &fields[i];
+    if (!aqua_logic_field_present(field, params)) {
+      continue;
+    }
+
+    const uint8_t *value = (const uint8_t *)params + field->param_offset;
+    float v;
+    switch (field->type) {
+    case AQUA_FIELD_INT:
+    case AQUA_FIELD_INT_OR_STRING:
+      v = (float)*(const int32_t *)value;
+      break;
+    case AQUA_FIELD_FLOAT:
+      v = *(const float *)value;
+      break;
+    case AQUA_FIELD_STRING: {
+      const uint8_t *nul = memchr(value, '\0', field->size);
+      v = (float)(nul ? (size_t)(nul - value) : field->size);
+      break;
+    }
+    default:
+      continue;
+    }
+    if (!aqua_logic_in_rangef(v, field->min, field->max)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* 将出现的字段拷贝到持久化结构；返回是否有字段被写入 */
+static bool aqua_logic_fields_store(const LogicFieldDesc *fields, size_t count,
+                                    const void *params, void *store) {
+  bool changed = false;
+  for (size_t i = 0; i < count; ++i) {
+    const LogicFieldDesc *field = &fields[i];
+    if (field->store_offset == LOGIC_FIELD_NO_STORE ||
+        !aqua_logic_field_present(field, params)) {
+      continue;
+    }
+    memcpy((uint8_t *)store + field->store_offset,
+           (const uint8_t *)params + field->param_offset, field->size);
+    changed = true;
+  }
+  return changed;
 }
 
 /* ============================================================================
@@ -64,23 +152,13 @@ void aqua_logic_init(AquariumState *state) {
 
   memset(state, 0, sizeof(AquariumState));
 
-  /* 默认阈值 */
-  state->thresholds.temp_min = DEFAULT_TEMP_MIN;
-  state->thresholds.temp_max = DEFAULT_TEMP_MAX;
-  state->thresholds.ph_min = DEFAULT_PH_MIN;
-  state->thresholds.ph_max = DEFAULT_PH_MAX;
-  state->thresholds.tds_warn = DEFAULT_TDS_WARN;
-  state->thresholds.tds_critical = DEFAULT_TDS_CRITICAL;
-  state->thresholds.turbidity_warn = DEFAULT_TURBIDITY_WARN;
-  state->thresholds.turbidity_critical = DEFAULT_TURBIDITY_CRITICAL;
-  state->thresholds.level_min = DEFAULT_LEVEL_MIN;
-  state->thresholds.level_max = DEFAULT_LEVEL_MAX;
-  state->thresholds.feed_interval = DEFAULT_FEED_INTERVAL;
-  state->thresholds.feed_amount = DEFAULT_FEED_AMOUNT;
-
-  /* 默认配置 */
-  state->config.ph_offset = 0.0f;
-  state->config.tds_factor = 1.0f;
+  /* 默认阈值与配置（字符串默认为空，已由 memset 清零） */
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  state->thresholds.name = (def);
+#include "aquarium_schema.def"
+#define AQUA_CONFIG_PARAM(name, type, min, max, def)                           \
+  LOGIC_DEFAULT_##type(state->config.name, def)
+#include "aquarium_schema.def"
 
   /* 默认运行态 */
   state->target_temp = DEFAULT_TARGET_TEMP;
@@ -125,14 +203,8 @@ AquaError aqua_logic_apply_command(AquariumState *state,
 /* 应用 control 命令 */
 static AquaError aqua_logic_apply_control(AquariumState *state,
                                           const ControlCommandParams *p) {      
-  if (p->has_feed_once_delay) {
-    if (p->feed_once_delay <= 0 ||
-        p->feed_once_delay > FEED_ONCE_DELAY_MAX_SECONDS) {
-      return AQUA_ERR_INVALID_COMMAND;
-    }
-  }
-  if (p->has_target_temp &&
-      !aqua_logic_in_rangef(p->target_temp, TARGET_TEMP_MIN, TARGET_TEMP_MAX)) {
+  if (!aqua_logic_fields_in_range(CONTROL_FIELDS,
+                                  LOGIC_FIELD_COUNT(CONTROL_FIELDS), p)) {
     return AQUA_ERR_INVALID_COMMAND;
   }
   if (p->has_heater) {
@@ -175,36 +247,14 @@ static AquaError aqua_logic_apply_threshold(AquariumState *state,
     return valid_err;
   }
 
-  if (p->has_temp_min)
-    state->thresholds.temp_min = p->temp_min;
-  if (p->has_temp_max)
-    state->thresholds.temp_max = p->temp_max;
-  if (p->has_ph_min)
-    state->thresholds.ph_min = p->ph_min;
-  if (p->has_ph_max)
-    state->thresholds.ph_max = p->ph_max;
-  if (p->has_tds_warn)
-    state->thresholds.tds_warn = p->tds_warn;
-  if (p->has_tds_critical)
-    state->thresholds.tds_critical = p->tds_critical;
-  if (p->has_turbidity_warn)
-    state->thresholds.turbidity_warn = p->turbidity_warn;
-  if (p->has_turbidity_critical)
-    state->thresholds.turbidity_critical = p->turbidity_critical;
-  if (p->has_level_min)
-    state->thresholds.level_min = p->level_min;
-  if (p->has_level_max)
-    state->thresholds.level_max = p->level_max;
+  aqua_logic_fields_store(THRESHOLD_FIELDS, LOGIC_FIELD_COUNT(THRESHOLD_FIELDS),
+                          p, &state->thresholds);
 
   if (p->has_feed_interval) {
-    state->thresholds.feed_interval = p->feed_interval;
     /* 重置投喂计时器 */
     state->feed_timer = p->feed_interval * 3600;
     state->props.feed_countdown = state->feed_timer;
   }
-  if (p->has_feed_amount) {
-    state->thresholds.feed_amount = p->feed_amount;
-  }
   if (p->has_target_temp) {
     state->target_temp = p->target_temp;
   }
@@ -219,29 +269,8 @@ static AquaError aqua_logic_apply_config(AquariumState *state,
     return valid_err;
   }
 
-  bool changed = false;
-
-  if (p->has_wifi_ssid) {
-    strncpy(state->config.wifi_ssid, p->wifi_ssid, WIFI_SSID_MAX_LEN);
-    state->config.wifi_ssid[WIFI_SSID_MAX_LEN] = '\0';
-    changed = true;
-  }
-  if (p->has_wifi_password) {
-    strncpy(state->config.wifi_password, p->wifi_password,
-            WIFI_PASSWORD_MAX_LEN);
-    state->config.wifi_password[WIFI_PASSWORD_MAX_LEN] = '\0';
-    changed = true;
-  }
-  if (p->has_ph_offset) {
-    state->config.ph_offset = p->ph_offset;
-    changed = true;
-  }
-  if (p->has_tds_factor) {
-    state->config.tds_factor = p->tds_factor;
-    changed = true;
-  }
-
-  if (changed) {
+  if (aqua_logic_fields_store(CONFIG_FIELDS, LOGIC_FIELD_COUNT(CONFIG_FIELDS), p,
+                              &state->config)) {
     state->config_dirty = true;
   }
   return AQUA_OK;
@@ -253,82 +282,24 @@ static AquaError aqua_logic_validate_threshold_update(
     return AQUA_ERR_NULL_PTR;
   }
 
-  ThresholdConfig next = state->thresholds;
-
-  if (p->has_temp_min)
-    next.temp_min = p->temp_min;
-  if (p->has_temp_max)
-    next.temp_max = p->temp_max;
-  if (p->has_ph_min)
-    next.ph_min = p->ph_min;
-  if (p->has_ph_max)
-    next.ph_max = p->ph_max;
-  if (p->has_tds_warn)
-    next.tds_warn = p->tds_warn;
-  if (p->has_tds_critical)
-    next.tds_critical = p->tds_critical;
-  if (p->has_turbidity_warn)
-    next.turbidity_warn = p->turbidity_warn;
-  if (p->has_turbidity_critical)
-    next.turbidity_critical = p->turbidity_critical;
-  if (p->has_level_min)
-    next.level_min = p->level_min;
-  if (p->has_level_max)
-    next.level_max = p->level_max;
-  if (p->has_feed_interval)
-    next.feed_interval = p->feed_interval;
-  if (p->has_feed_amount)
-    next.feed_amount = p->feed_amount;
-
-  float next_target_temp = state->target_temp;
-  if (p->has_target_temp) {
-    next_target_temp = p->target_temp;
-  }
-
-  if (!aqua_logic_in_rangef(next.temp_min, TEMP_PHYS_MIN, TEMP_PHYS_MAX) ||
-      !aqua_logic_in_rangef(next.temp_max, TEMP_PHYS_MIN, TEMP_PHYS_MAX) ||
-      next.temp_min >= next.temp_max) {
+  /* 单字段范围；已生效的值均经过校验，只需检查本次出现的字段 */
+  if (!aqua_logic_fields_in_range(THRESHOLD_FIELDS,
+                                  LOGIC_FIELD_COUNT(THRESHOLD_FIELDS), p)) {
     return AQUA_ERR_INVALID_COMMAND;
   }
 
-  if (!aqua_logic_in_rangef(next.ph_min, PH_PHYS_MIN, PH_PHYS_MAX) ||
-      !aqua_logic_in_rangef(next.ph_max, PH_PHYS_MIN, PH_PHYS_MAX) ||
-      next.ph_min >= next.ph_max) {
-    return AQUA_ERR_INVALID_COMMAND;
-  }
-
-  if (!aqua_logic_in_rangei(next.tds_warn, TDS_PHYS_MIN, TDS_PHYS_MAX) ||
-      !aqua_logic_in_rangei(next.tds_critical, TDS_PHYS_MIN, TDS_PHYS_MAX) ||
-      next.tds_warn >= next.tds_critical) {
-    return AQUA_ERR_INVALID_COMMAND;
-  }
-
-  if (!aqua_logic_in_rangei(next.turbidity_warn, TURBIDITY_PHYS_MIN,
-                            TURBIDITY_PHYS_MAX) ||
-      !aqua_logic_in_rangei(next.turbidity_critical, TURBIDITY_PHYS_MIN,
-                            TURBIDITY_PHYS_MAX) ||
-      next.turbidity_warn >= next.turbidity_critical) {
-    return AQUA_ERR_INVALID_COMMAND;
-  }
+  /* 跨字段约束作用于合并后的阈值 */
+  ThresholdConfig next = state->thresholds;
+  aqua_logic_fields_store(THRESHOLD_FIELDS, LOGIC_FIELD_COUNT(THRESHOLD_FIELDS),
+                          p, &next);
 
-  if (!aqua_logic_in_rangei(next.level_min, LEVEL_PHYS_MIN, LEVEL_PHYS_MAX) ||
-      !aqua_logic_in_rangei(next.level_max, LEVEL_PHYS_MIN, LEVEL_PHYS_MAX) ||
+  if (next.temp_min >= next.temp_max || next.ph_min >= next.ph_max ||
+      next.tds_warn >= next.tds_critical ||
+      next.turbidity_warn >= next.turbidity_critical ||
       next.level_min >= next.level_max) {
     return AQUA_ERR_INVALID_COMMAND;
   }
 
-  if (!aqua_logic_in_rangei(next.feed_interval, FEED_INTERVAL_MIN,
-                            FEED_INTERVAL_MAX) ||
-      !aqua_logic_in_rangei(next.feed_amount, FEED_AMOUNT_MIN,
-                            FEED_AMOUNT_MAX)) {
-    return AQUA_ERR_INVALID_COMMAND;
-  }
-
-  if (!aqua_logic_in_rangef(next_target_temp, TARGET_TEMP_MIN,
-                            TARGET_TEMP_MAX)) {
-    return AQUA_ERR_INVALID_COMMAND;
-  }
-
   return AQUA_OK;
 }
 
@@ -337,23 +308,13 @@ static AquaError aqua_logic_validate_config_update(const ConfigCommandParams *p)
     return AQUA_ERR_NULL_PTR;
   }
 
+  /* Wi-Fi 名称与密码必须成对下发（非空由长度范围保证） */
   if (p->has_wifi_ssid != p->has_wifi_password) {
     return AQUA_ERR_INVALID_COMMAND;
   }
 
-  if (p->has_wifi_ssid && p->has_wifi_password) {
-    if (p->wifi_ssid[0] == '\0' || p->wifi_password[0] == '\0') {
-      return AQUA_ERR_INVALID_COMMAND;
-    }
-  }
-
-  if (p->has_ph_offset &&
-      !aqua_logic_in_rangef(p->ph_offset, PH_OFFSET_MIN, PH_OFFSET_MAX)) {
-    return AQUA_ERR_INVALID_COMMAND;
-  }
-
-  if (p->has_tds_factor &&
-      !aqua_logic_in_rangef(p->tds_factor, TDS_FACTOR_MIN, TDS_FACTOR_MAX)) {
+  if (!aqua_logic_fields_in_range(CONFIG_FIELDS, LOGIC_FIELD_COUNT(CONFIG_FIELDS),
+                                  p)) {
     return AQUA_ERR_INVALID_COMMAND;
   }
 
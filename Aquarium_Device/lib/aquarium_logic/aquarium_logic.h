@@ -39,6 +39,13 @@ extern "C" {
 #define DEFAULT_FEED_AMOUNT 2    /* 档位 */
 #define DEFAULT_TARGET_TEMP 26.0f
 
+/* 增量上报默认死区 */
+#define DEFAULT_TEMP_DEADBAND 0.1f      /* ℃ */
+#define DEFAULT_PH_DEADBAND 0.05f       /* pH */
+#define DEFAULT_TDS_DEADBAND 5.0f       /* ppm */
+#define DEFAULT_TURBIDITY_DEADBAND 1.0f /* NTU */
+#define DEFAULT_LEVEL_DEADBAND 1.0f     /* % */
+
 /* 投喂持续时间（秒） */
 #define FEEDING_DURATION_SECONDS 5
 /* 一次性倒计时投喂最大等待秒数（24h） */
@@ -51,19 +58,11 @@ extern "C" {
  * ============================================================================
  */
 
+/* set_thresholds 中 AQUA_THRESHOLD_PARAM 字段（见 aquarium_schema.def） */
 typedef struct {
-  float temp_min;
-  float temp_max;
-  float ph_min;
-  float ph_max;
-  int32_t tds_warn;
-  int32_t tds_critical;
-  int32_t turbidity_warn;
-  int32_t turbidity_critical;
-  int32_t level_min;
-  int32_t level_max;
-  int32_t feed_interval; /* 小时 */
-  int32_t feed_amount;   /* 档位 */
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  AQUA_SCHEMA_MEMBER_##type(name, max)
+#include "aquarium_schema.def"
 } ThresholdConfig;
 
 /* ============================================================================
@@ -71,11 +70,11 @@ typedef struct {
  * ============================================================================
  */
 
+/* 布局随 aquarium_schema.def 中 AQUA_CONFIG_PARAM 的顺序，持久化到 Flash */
 typedef struct {
-  char wifi_ssid[WIFI_SSID_MAX_LEN + 1];
-  char wifi_password[WIFI_PASSWORD_MAX_LEN + 1];
-  float ph_offset;
-  float tds_factor;
+#define AQUA_CONFIG_PARAM(name, type, min, max, def)                           \
+  AQUA_SCHEMA_MEMBER_##type(name, max)
+#include "aquarium_schema.def"
 } DeviceConfig;
 
 /* ============================================================================
@@ -0,0 +1,455 @@
+/**
+ * @file aquarium_telemetry.c
+ * @brief 主机端列式遥测存储实现
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "aquarium_telemetry.h"
+#include <stddef.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* 文件头须放得下 */
+typedef char aqua_tm_header_fits[(sizeof(AquaTmHeader) <= AQUA_TM_HEADER_SIZE)
+                                     ? 1
+                                     : -1];
+
+/* ============================================================================
+ * 列描述（由 aquarium_schema.def 展开）
+ * ============================================================================
+ */
+
+/* 单条上报 JSON 中最多的采样数（设备端批量上报为 AQUA_APP_BATCH_MAX_SAMPLES） */
+#define TM_PARSE_MAX_SAMPLES 16
+
+#define TM_SIZE_FLOAT 4
+#define TM_SIZE_INT 4
+#define TM_SIZE_BOOL 1
+
+typedef struct {
+  uint8_t size;    /* 列元素字节数 */
+  uint16_t offset; /* 在 AquariumProperties 中的偏移 */
+} TmFieldDesc;
+
+static const TmFieldDesc TM_FIELDS[AQUA_REPORT_FIELD_COUNT] = {
+#define AQUA_PROPERTY(name, NAME, type)                                        \
+  {TM_SIZE_##type, (uint16_t)offsetof(AquariumProperties, name)},
+#include "aquarium_schema.def"
+};
+
+static uint8_t tm_column_size(size_t column) {
+  if (column == AQUA_TM_COL_TIME) {
+    return 4;
+  }
+  if (column == AQUA_TM_COL_MASK) {
+    return 2;
+  }
+  return TM_FIELDS[column].size;
+}
+
+/* 按元素大小从大到小排列各列，保证块内每列自然对齐 */
+static void tm_layout(AquaTelemetryStore *tm) {
+  static const uint8_t SIZES[] = {4, 2, 1};
+  uint32_t offset = 0;
+
+  for (size_t s = 0; s < sizeof(SIZES); ++s) {
+    for (size_t col = 0; col < AQUA_TM_COLUMN_COUNT; ++col) {
+      if (tm_column_size(col) == SIZES[s]) {
+        tm->col_offset[col] = offset;
+        offset += (uint32_t)SIZES[s] * AQUA_TM_BLOCK_ROWS;
+      }
+    }
+  }
+  tm->block_size = offset;
+}
+
+static uint8_t *tm_cell(const AquaTelemetryStore *tm, size_t column,
+                        uint64_t row) {
+  uint64_t block = row / AQUA_TM_BLOCK_ROWS;
+  size_t index = (size_t)(row % AQUA_TM_BLOCK_ROWS);
+  return tm->base + AQUA_TM_HEADER_SIZE + block * tm->block_size +
+         tm->col_offset[column] + index * tm_column_size(column);
+}
+
+/* ============================================================================
+ * 文件映射（平台相关）
+ * ============================================================================
+ */
+
+#ifdef _WIN32
+
+static bool tm_file_open(AquaTelemetryStore *tm, const char *path,
+                         uint64_t *size) {
+  HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ, NULL, OPEN_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER li;
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  if (!GetFileSizeEx(file, &li)) {
+    CloseHandle(file);
+    return false;
+  }
+  tm->file = file;
+  *size = (uint64_t)li.QuadPart;
+  return true;
+}
+
+static void tm_unmap(AquaTelemetryStore *tm) {
+  if (tm->base) {
+    UnmapViewOfFile(tm->base);
+    tm->base = NULL;
+  }
+  if (tm->mapping) {
+    CloseHandle((HANDLE)tm->mapping);
+    tm->mapping = NULL;
+  }
+  tm->hdr = NULL;
+  tm->mapped = 0;
+}
+
+/* 映射文件前 size 字节，文件不足时扩展 */
+static bool tm_map(AquaTelemetryStore *tm, uint64_t size) {
+  tm_unmap(tm);
+  HANDLE mapping =
+      CreateFileMappingA((HANDLE)tm->file, NULL, PAGE_READWRITE,
+                         (DWORD)(size >> 32), (DWORD)size, NULL);
+  if (!mapping) {
+    return false;
+  }
+  void *base = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+  if (!base) {
+    CloseHandle(mapping);
+    return false;
+  }
+  tm->mapping = mapping;
+  tm->base = (uint8_t *)base;
+  tm->mapped = size;
+  tm->hdr = (AquaTmHeader *)base;
+  return true;
+}
+
+static bool tm_file_sync(AquaTelemetryStore *tm) {
+  return FlushViewOfFile(tm->base, 0) && FlushFileBuffers((HANDLE)tm->file);
+}
+
+static void tm_file_close(AquaTelemetryStore *tm) {
+  if (tm->file) {
+    CloseHandle((HANDLE)tm->file);
+    tm->file = NULL;
+  }
+}
+
+#else
+
+static bool tm_file_open(AquaTelemetryStore *tm, const char *path,
+                         uint64_t *size) {
+  struct stat st;
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  tm->fd = fd;
+  *size = (uint64_t)st.st_size;
+  return true;
+}
+
+static void tm_unmap(AquaTelemetryStore *tm) {
+  if (tm->base) {
+    munmap(tm->base, (size_t)tm->mapped);
+    tm->base = NULL;
+  }
+  tm->hdr = NULL;
+  tm->mapped = 0;
+}
+
+/* 映射文件前 size 字节，文件不足时扩展 */
+static bool tm_map(AquaTelemetryStore *tm, uint64_t size) {
+  struct stat st;
+
+  tm_unmap(tm);
+  if (fstat(tm->fd, &st) != 0) {
+    return false;
+  }
+  if ((uint64_t)st.st_size < size && ftruncate(tm->fd, (off_t)size) != 0) {
+    return false;
+  }
+  void *base = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    tm->fd, 0);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+  tm->base = (uint8_t *)base;
+  tm->mapped = size;
+  tm->hdr = (AquaTmHeader *)base;
+  return true;
+}
+
+static bool tm_file_sync(AquaTelemetryStore *tm) {
+  return msync(tm->base, (size_t)tm->mapped, MS_SYNC) == 0;
+}
+
+static void tm_file_close(AquaTelemetryStore *tm) {
+  if (tm->fd >= 0) {
+    close(tm->fd);
+    tm->fd = -1;
+  }
+}
+
+#endif
+
+static uint64_t tm_file_size(const AquaTelemetryStore *tm, uint64_t blocks) {
+  return AQUA_TM_HEADER_SIZE + blocks * tm->block_size;
+}
+
+/* 容量翻倍，摊销后每行的扩展开销为常数 */
+static bool tm_grow(AquaTelemetryStore *tm) {
+  uint64_t blocks = (tm->blocks == 0) ? 1 : tm->blocks * 2;
+  if (!tm_map(tm, tm_file_size(tm, blocks))) {
+    return false;
+  }
+  tm->blocks = blocks;
+  return true;
+}
+
+/* ============================================================================
+ * API 实现
+ * ============================================================================
+ */
+
+TelemetryError aqua_tm_open(AquaTelemetryStore *tm, const char *path) {
+  if (!tm || !path) {
+    return TELEMETRY_ERR_NULL_PTR;
+  }
+
+  memset(tm, 0, sizeof(*tm));
+#ifndef _WIN32
+  tm->fd = -1;
+#endif
+  tm_layout(tm);
+
+  uint64_t size = 0;
+  if (!tm_file_open(tm, path, &size)) {
+    return TELEMETRY_ERR_IO;
+  }
+
+  if (size == 0) {
+    if (!tm_grow(tm)) {
+      aqua_tm_close(tm);
+      return TELEMETRY_ERR_IO;
+    }
+    memset(tm->hdr, 0, AQUA_TM_HEADER_SIZE);
+    tm->hdr->magic = AQUA_TM_MAGIC;
+    tm->hdr->version = AQUA_TM_VERSION;
+    tm->hdr->field_count = AQUA_REPORT_FIELD_COUNT;
+    tm->hdr->block_rows = AQUA_TM_BLOCK_ROWS;
+    tm->hdr->row_size = tm->block_size / AQUA_TM_BLOCK_ROWS;
+    tm->hdr->rows = 0;
+    return TELEMETRY_OK;
+  }
+
+  if (size < AQUA_TM_HEADER_SIZE) {
+    aqua_tm_close(tm);
+    return TELEMETRY_ERR_FORMAT;
+  }
+
+  tm->blocks = (size - AQUA_TM_HEADER_SIZE) / tm->block_size;
+  if (!tm_map(tm, tm_file_size(tm, tm->blocks))) {
+    aqua_tm_close(tm);
+    return TELEMETRY_ERR_IO;
+  }
+
+  const AquaTmHeader *hdr = tm->hdr;
+  if (hdr->magic != AQUA_TM_MAGIC || hdr->version != AQUA_TM_VERSION ||
+      hdr->field_count != AQUA_REPORT_FIELD_COUNT ||
+      hdr->block_rows != AQUA_TM_BLOCK_ROWS ||
+      hdr->row_size != tm->block_size / AQUA_TM_BLOCK_ROWS ||
+      hdr->rows > tm->blocks * AQUA_TM_BLOCK_ROWS) {
+    aqua_tm_close(tm);
+    return TELEMETRY_ERR_FORMAT;
+  }
+  return TELEMETRY_OK;
+}
+
+TelemetryError aqua_tm_append(AquaTelemetryStore *tm,
+                              const AquaPropertySample *sample,
+                              uint32_t recv_time) {
+  if (!tm || !tm->hdr || !sample) {
+    return TELEMETRY_ERR_NULL_PTR;
+  }
+
+  uint64_t row = tm->hdr->rows;
+  if (row >= tm->blocks * AQUA_TM_BLOCK_ROWS && !tm_grow(tm)) {
+    return TELEMETRY_ERR_IO;
+  }
+
+  const uint8_t *src = (const uint8_t *)&sample->props;
+  for (size_t col = 0; col < AQUA_REPORT_FIELD_COUNT; ++col) {
+    const TmFieldDesc *field = &TM_FIELDS[col];
+    uint8_t *dst = tm_cell(tm, col, row);
+
+    if (!(sample->field_mask & (1u << col))) {
+      /* 未上报：沿用上一行，首行为 0 */
+      if (row == 0) {
+        memset(dst, 0, field->size);
+      } else {
+        memcpy(dst, tm_cell(tm, col, row - 1), field->size);
+      }
+    } else if (field->size == TM_SIZE_BOOL) {
+      *dst = *(const bool *)(src + field->offset) ? 1u : 0u;
+    } else {
+      memcpy(dst, src + field->offset, field->size);
+    }
+  }
+
+  uint32_t time = sample->event_time ? sample->event_time : recv_time;
+  uint16_t mask = (uint16_t)(sample->field_mask & AQUA_PROP_ALL);
+  memcpy(tm_cell(tm, AQUA_TM_COL_TIME, row), &time, sizeof(time));
+  memcpy(tm_cell(tm, AQUA_TM_COL_MASK, row), &mask, sizeof(mask));
+
+  /* 整行写完后再提交行数 */
+  tm->hdr->rows = row + 1;
+  return TELEMETRY_OK;
+}
+
+static TelemetryError tm_append_samples(AquaTelemetryStore *tm,
+                                        const AquaPropertySample *samples,
+                                        size_t count, uint32_t recv_time,
+                                        size_t *appended) {
+  for (size_t i = 0; i < count; ++i) {
+    TelemetryError err = aqua_tm_append(tm, &samples[i], recv_time);
+    if (err != TELEMETRY_OK) {
+      return err;
+    }
+    if (appended) {
+      (*appended)++;
+    }
+  }
+  return TELEMETRY_OK;
+}
+
+TelemetryError aqua_tm_append_json(AquaTelemetryStore *tm, const char *json,
+                                   size_t json_len, uint32_t recv_time,
+                                   size_t *appended) {
+  AquaPropertySample samples[TM_PARSE_MAX_SAMPLES];
+  size_t count = 0;
+
+  if (appended) {
+    *appended = 0;
+  }
+  if (!tm || !json) {
+    return TELEMETRY_ERR_NULL_PTR;
+  }
+
+  if (aqua_parse_properties_json(json, json_len, samples, TM_PARSE_MAX_SAMPLES,
+                                 &count) != AQUA_OK) {
+    return TELEMETRY_ERR_PARSE;
+  }
+  return tm_append_samples(tm, samples, count, recv_time, appended);
+}
+
+TelemetryError aqua_tm_append_cbor(AquaTelemetryStore *tm, const uint8_t *data,
+                                   size_t len, uint32_t recv_time,
+                                   size_t *appended) {
+  AquaPropertySample samples[TM_PARSE_MAX_SAMPLES];
+  size_t count = 0;
+
+  if (appended) {
+    *appended = 0;
+  }
+  if (!tm || !data) {
+    return TELEMETRY_ERR_NULL_PTR;
+  }
+
+  if (aqua_parse_properties_cbor(data, len, samples, TM_PARSE_MAX_SAMPLES,
+                                 &count) != AQUA_OK) {
+    return TELEMETRY_ERR_PARSE;
+  }
+  return tm_append_samples(tm, samples, count, recv_time, appended);
+}
+
+uint64_t aqua_tm_rows(const AquaTelemetryStore *tm) {
+  return (tm && tm->hdr) ? tm->hdr->rows : 0;
+}
+
+uint64_t aqua_tm_block_count(const AquaTelemetryStore *tm) {
+  return (aqua_tm_rows(tm) + AQUA_TM_BLOCK_ROWS - 1) / AQUA_TM_BLOCK_ROWS;
+}
+
+const void *aqua_tm_column(const AquaTelemetryStore *tm, size_t column,
+                           uint64_t block, size_t *rows) {
+  if (rows) {
+    *rows = 0;
+  }
+  if (!tm || !tm->hdr || column >= AQUA_TM_COLUMN_COUNT ||
+      block >= aqua_tm_block_count(tm)) {
+    return NULL;
+  }
+
+  uint64_t first = block * AQUA_TM_BLOCK_ROWS;
+  uint64_t remaining = tm->hdr->rows - first;
+  if (rows) {
+    *rows = (remaining < AQUA_TM_BLOCK_ROWS) ? (size_t)remaining
+                                             : AQUA_TM_BLOCK_ROWS;
+  }
+  return tm_cell(tm, column, first);
+}
+
+TelemetryError aqua_tm_read_row(const AquaTelemetryStore *tm, uint64_t row,
+                                AquaPropertySample *sample) {
+  if (!tm || !tm->hdr || !sample) {
+    return TELEMETRY_ERR_NULL_PTR;
+  }
+  if (row >= tm->hdr->rows) {
+    return TELEMETRY_ERR_FORMAT;
+  }
+
+  memset(sample, 0, sizeof(*sample));
+  uint8_t *dst = (uint8_t *)&sample->props;
+  for (size_t col = 0; col < AQUA_REPORT_FIELD_COUNT; ++col) {
+    const TmFieldDesc *field = &TM_FIELDS[col];
+    const uint8_t *src = tm_cell(tm, col, row);
+    if (field->size == TM_SIZE_BOOL) {
+      *(bool *)(dst + field->offset) = (*src != 0);
+    } else {
+      memcpy(dst + field->offset, src, field->size);
+    }
+  }
+  memcpy(&sample->event_time, tm_cell(tm, AQUA_TM_COL_TIME, row),
+         sizeof(sample->event_time));
+  memcpy(&sample->field_mask, tm_cell(tm, AQUA_TM_COL_MASK, row),
+         sizeof(sample->field_mask));
+  return TELEMETRY_OK;
+}
+
+TelemetryError aqua_tm_sync(AquaTelemetryStore *tm) {
+  if (!tm || !tm->hdr) {
+    return TELEMETRY_ERR_NULL_PTR;
+  }
+  return tm_file_sync(tm) ? TELEMETRY_OK : TELEMETRY_ERR_IO;
+}
+
+void aqua_tm_close(AquaTelemetryStore *tm) {
+  if (!tm) {
+    return;
+  }
+  tm_unmap(tm);
+  tm_file_close(tm);
+}
@@ -0,0 +1,177 @@
+/**
+ * @file aquarium_telemetry.h
+ * @brief 主机端列式遥测存储（仅 native 环境）
+ *
+ * 把解析后的属性上报追加到内存映射文件中：每个属性一列，
+ * 另有时间戳列与字段掩码列，供 PC 侧工具批量分析历史数据。
+ *
+ * 文件布局：
+ *   [文件头 AQUA_TM_HEADER_SIZE 字节][块 0][块 1]...
+ * 每块 AQUA_TM_BLOCK_ROWS 行，块内各列连续存放（先 4 字节列，
+ * 再掩码列与布尔列）。扫描某一列时只访问该列所在的页，
+ * 且每块内的列数据是可直接向量化遍历的普通数组。
+ *
+ * 增量上报只携带变化字段，追加时未携带的字段沿用上一行的值，
+ * 因此每一行都是完整状态；掩码列记录该行实际上报了哪些字段。
+ *
+ * 用法：
+ *   AquaTelemetryStore tm;
+ *   aqua_tm_open(&tm, "aquarium.aqtm");
+ *   aqua_tm_append_json(&tm, payload, len, recv_time, NULL);
+ *   for (uint64_t b = 0; b < aqua_tm_block_count(&tm); ++b) {
+ *     size_t n;
+ *     const float *t = aqua_tm_column(&tm, AQUA_PROP_BIT_TEMPERATURE, b, &n);
+ *     ...
+ *   }
+ *   aqua_tm_close(&tm);
+ */
+
+#ifndef AQUARIUM_TELEMETRY_H
+#define AQUARIUM_TELEMETRY_H
+
+#include "aquarium_cbor.h"
+#include "aquarium_protocol.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================================
+ * 存储格式
+ * ============================================================================
+ */
+
+#define AQUA_TM_MAGIC 0x4D545141 /* "AQTM" in ASCII */
+#define AQUA_TM_VERSION 1
+#define AQUA_TM_HEADER_SIZE 4096 /* 块从页边界开始 */
+#define AQUA_TM_BLOCK_ROWS 4096
+
+/* 列编号：属性列即 AQUA_PROP_BIT_*，随后是时间戳列与掩码列 */
+enum {
+  AQUA_TM_COL_TIME = AQUA_REPORT_FIELD_COUNT, /* uint32_t，UTC Unix 秒 */
+  AQUA_TM_COL_MASK,                           /* uint16_t，AQUA_PROP_* 位 */
+  AQUA_TM_COLUMN_COUNT
+};
+
+/*
+ * 属性列元素类型：FLOAT 为 float，INT 为 int32_t，BOOL 为 uint8_t（0/1）
+ */
+
+typedef struct {
+  uint32_t magic;       /* AQUA_TM_MAGIC */
+  uint16_t version;     /* AQUA_TM_VERSION */
+  uint16_t field_count; /* AQUA_REPORT_FIELD_COUNT */
+  uint32_t block_rows;  /* AQUA_TM_BLOCK_ROWS */
+  uint32_t row_size;    /* 每行字节数，用于发现字段清单变化 */
+  uint64_t rows;        /* 已写入行数 */
+} AquaTmHeader;
+
+/* ============================================================================
+ * 错误码
+ * ============================================================================
+ */
+
+typedef enum {
+  TELEMETRY_OK = 0,
+  TELEMETRY_ERR_NULL_PTR,
+  TELEMETRY_ERR_IO,     /* 打开、扩展或映射文件失败 */
+  TELEMETRY_ERR_FORMAT, /* 文件头不匹配（非本格式或字段清单已变化） */
+  TELEMETRY_ERR_PARSE   /* 上报 JSON / CBOR 解析失败 */
+} TelemetryError;
+
+/* ============================================================================
+ * 存储句柄
+ * ============================================================================
+ */
+
+typedef struct {
+  uint8_t *base;    /* 映射首地址 */
+  uint64_t mapped;  /* 映射字节数 */
+  uint64_t blocks;  /* 文件中已分配的块数 */
+  AquaTmHeader *hdr;
+  uint32_t col_offset[AQUA_TM_COLUMN_COUNT]; /* 各列在块内的偏移 */
+  uint32_t block_size;
+#ifdef _WIN32
+  void *file;
+  void *mapping;
+#else
+  int fd;
+#endif
+} AquaTelemetryStore;
+
+/* ============================================================================
+ * API 函数
+ * ============================================================================
+ */
+
+/**
+ * @brief 打开存储文件，不存在时创建
+ *
+ * @return TELEMETRY_ERR_FORMAT 文件不是本格式，或由不同字段清单写入
+ */
+TelemetryError aqua_tm_open(AquaTelemetryStore *tm, const char *path);
+
+/**
+ * @brief 追加一行
+ *
+ * @param sample    采样；未置位 field_mask 的字段沿用上一行的值
+ * @param recv_time sample->event_time 为 0 时使用的时间戳
+ */
+TelemetryError aqua_tm_append(AquaTelemetryStore *tm,
+                              const AquaPropertySample *sample,
+                              uint32_t recv_time);
+
+/**
+ * @brief 解析一条属性上报 JSON 并逐个采样追加
+ *
+ * @param appended [输出，可为 NULL] 追加的行数
+ */
+TelemetryError aqua_tm_append_json(AquaTelemetryStore *tm, const char *json,
+                                   size_t json_len, uint32_t recv_time,
+                                   size_t *appended);
+
+/**
+ * @brief 解析一条 CBOR 属性上报（aquarium_cbor.h）并逐个采样追加
+ *
+ * @param appended [输出，可为 NULL] 追加的行数
+ */
+TelemetryError aqua_tm_append_cbor(AquaTelemetryStore *tm, const uint8_t *data,
+                                   size_t len, uint32_t recv_time,
+                                   size_t *appended);
+
+/* 已写入的行数 */
+uint64_t aqua_tm_rows(const AquaTelemetryStore *tm);
+
+/* 含数据的块数 */
+uint64_t aqua_tm_block_count(const AquaTelemetryStore *tm);
+
+/**
+ * @brief 取第 block 块中某一列的数组
+ *
+ * @param column AQUA_PROP_BIT_* / AQUA_TM_COL_TIME / AQUA_TM_COL_MASK
+ * @param rows   [输出] 该块中的有效行数
+ * @return 列数组首地址；参数越界时返回 NULL。追加可能重新映射文件，
+ *         之前取得的指针随之失效
+ */
+const void *aqua_tm_column(const AquaTelemetryStore *tm, size_t column,
+                           uint64_t block, size_t *rows);
+
+/**
+ * @brief 读取第 row 行的完整状态
+ */
+TelemetryError aqua_tm_read_row(const AquaTelemetryStore *tm, uint64_t row,
+                                AquaPropertySample *sample);
+
+/* 将映射内容刷回磁盘 */
+TelemetryError aqua_tm_sync(AquaTelemetryStore *tm);
+
+void aqua_tm_close(AquaTelemetryStore *tm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AQUARIUM_TELEMETRY_H */
@@ -0,0 +1,190 @@
+"""Generate the command key perfect-hash table (aquarium_cmd_keys.inc).
+
+Keys come from lib/aquarium_core/aquarium_schema.def (command parameters)
+and lib/aquarium_core/aquarium_types.h (service_id / command_name values),
+plus the fixed top-level keys of an IoTDA command document.
+
+The hash is a two-level minimal perfect hash (hash and displace):
+
+    h    = FNV-1a(key)
+    d    = DISP[h % BUCKETS]
+    slot = ((((h ^ (d * MIX_A)) * MIX_B) mod 2^32) >> 16) % COUNT
+
+The first level can be computed one byte at a time while the parser reads
+the key. The lookup helpers in aquarium_protocol.c must match hash_key() and
+slot() below.
+
+Usage (from Aquarium_Device/):
+    python scripts/gen_cmd_keys.py
+Re-run whenever a command parameter, service_id or command_name changes;
+test_parse_command_schema_covers_all_fields fails if the table is stale.
+"""
+
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+CORE = os.path.join(ROOT, "lib", "aquarium_core")
+SCHEMA = os.path.join(CORE, "aquarium_schema.def")
+TYPES = os.path.join(CORE, "aquarium_types.h")
+OUTPUT = os.path.join(CORE, "aquarium_cmd_keys.inc")
+
+FNV_BASIS = 2166136261
+FNV_PRIME = 16777619
+MIX_A = 0x9E3779B1
+MIX_B = 0x85EBCA6B
+MASK = 0xFFFFFFFF
+
+# Field tables in CMD_PARAM_TABLES order, with the schema macros feeding each.
+TABLES = [
+    ("CONTROL", ("AQUA_CONTROL_PARAM",)),
+    ("THRESHOLD", ("AQUA_THRESHOLD_PARAM", "AQUA_THRESHOLD_RUNTIME")),
+    ("CONFIG", ("AQUA_CONFIG_PARAM",)),
+]
+
+TOP_KEYS = [
+    ("service_id", "CMD_CAPTURE_SERVICE_ID"),
+    ("command_name", "CMD_CAPTURE_COMMAND_NAME"),
+    ("paras", "CMD_CAPTURE_PARAS"),
+]
+
+# (service_id macro, command_name macro, CommandType)
+COMMANDS = [
+    ("SERVICE_ID_AQUARIUM_CONTROL", "COMMAND_NAME_CONTROL",
+     "COMMAND_TYPE_CONTROL"),
+    ("SERVICE_ID_AQUARIUM_THRESHOLD", "COMMAND_NAME_SET_THRESHOLDS",
+     "COMMAND_TYPE_SET_THRESHOLDS"),
+    ("SERVICE_ID_AQUARIUM_CONFIG", "COMMAND_NAME_SET_CONFIG",
+     "COMMAND_TYPE_SET_CONFIG"),
+]
+
+
+def hash_key(key):
+    h = FNV_BASIS
+    for b in key.encode("ascii"):
+        h = ((h ^ b) * FNV_PRIME) & MASK
+    return h
+
+
+def slot(h, d, count):
+    x = h ^ ((d * MIX_A) & MASK)
+    x = (x * MIX_B) & MASK
+    return (x >> 16) % count
+
+
+def read_schema():
+    text = open(SCHEMA, encoding="utf-8").read()
+    fields = {name: [] for name, _ in TABLES}
+    for macro, name in re.findall(r"^(AQUA_\w+)\((\w+)", text, re.M):
+        for table, macros in TABLES:
+            if macro in macros:
+                fields[table].append(name)
+    return fields
+
+
+def read_defines():
+    text = open(TYPES, encoding="utf-8").read()
+    return dict(re.findall(r'^#define\s+(\w+)\s+"([^"]*)"', text, re.M))
+
+
+def collect_entries():
+    entries = {}
+
+    def entry(key):
+        return entries.setdefault(key, {
+            "capture": "CMD_CAPTURE_NONE",
+            "service": "COMMAND_TYPE_UNKNOWN",
+            "command": "COMMAND_TYPE_UNKNOWN",
+            "fields": ["-1", "-1", "-1"],
+        })
+
+    for key, capture in TOP_KEYS:
+        entry(key)["capture"] = capture
+
+    defines = read_defines()
+    for service, command, cmd_type in COMMANDS:
+        entry(defines[service])["service"] = cmd_type
+        entry(defines[command])["command"] = cmd_type
+
+    fields = read_schema()
+    for i, (table, _) in enumerate(TABLES):
+        for name in fields[table]:
+            entry(name)["fields"][i] = "CMD_%s_IDX_%s" % (table, name)
+
+    return entries
+
+
+def build(keys):
+    count = len(keys)
+    for buckets in range(max(1, count // 4), count + 1):
+        groups = [[] for _ in range(buckets)]
+        for key in keys:
+            groups[hash_key(key) % buckets].append(key)
+
+        disp = [0] * buckets
+        taken = [None] * count
+        ok = True
+        for b in sorted(range(buckets), key=lambda i: -len(groups[i])):
+            if not groups[b]:
+                continue
+            for d in range(256):
+                slots = [slot(hash_key(k), d, count) for k in groups[b]]
+                if len(set(slots)) == len(slots) and all(
+                        taken[s] is None for s in slots):
+                    for k, s in zip(groups[b], slots):
+                        taken[s] = k
+                    disp[b] = d
+                    break
+            else:
+                ok = False
+                break
+        if ok:
+            return buckets, disp, taken
+    sys.exit("gen_cmd_keys: no perfect hash found")
+
+
+def main():
+    entries = collect_entries()
+    keys = sorted(entries)
+    buckets, disp, table = build(keys)
+
+    out = []
+    out.append("/**")
+    out.append(" * @file aquarium_cmd_keys.inc")
+    out.append(" * @brief 命令键完美哈希表")
+    out.append(" *")
+    out.append(" * 由 scripts/gen_cmd_keys.py 根据 aquarium_schema.def 与")
+    out.append(" * aquarium_types.h 生成，请勿手工修改。")
+    out.append(" */")
+    out.append("")
+    out.append("#define CMD_KEY_HASH_BASIS %uu" % FNV_BASIS)
+    out.append("#define CMD_KEY_HASH_PRIME %uu" % FNV_PRIME)
+    out.append("#define CMD_KEY_MIX_A 0x%08Xu" % MIX_A)
+    out.append("#define CMD_KEY_MIX_B 0x%08Xu" % MIX_B)
+    out.append("#define CMD_KEY_COUNT %du" % len(keys))
+    out.append("#define CMD_KEY_BUCKETS %du" % buckets)
+    out.append("#define CMD_KEY_MAX_LEN %du" % max(len(k) for k in keys))
+    out.append("")
+    out.append("static const uint8_t CMD_KEY_DISP[CMD_KEY_BUCKETS] = {")
+    for i in range(0, buckets, 12):
+        out.append("    " + ", ".join(str(d) for d in disp[i:i + 12]) + ",")
+    out.append("};")
+    out.append("")
+    out.append("static const CmdKeyEntry CMD_KEYS[CMD_KEY_COUNT] = {")
+    for key in table:
+        e = entries[key]
+        out.append("    {\"%s\", %d, %s," % (key, len(key), e["capture"]))
+        out.append("     %s, %s," % (e["service"], e["command"]))
+        out.append("     {%s}}," % ", ".join(e["fields"]))
+    out.append("};")
+    out.append("")
+
+    with open(OUTPUT, "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(out))
+    print("gen_cmd_keys: %d keys, %d buckets -> %s" %
+          (len(keys), buckets, os.path.relpath(OUTPUT, ROOT)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,47 @@
+Import("env")
+
+import glob
+import os
+import subprocess
+
+# Runs scripts/stack_usage.py before each test program is linked, so
+# `pio test -e native` fails when a stack root exceeds its budget. The
+# result is stamped in the build directory and only re-checked after a
+# lib/ source or the script changes. The check needs gcc >= 10; point
+# STACK_USAGE_CC at one when the toolchain's gcc is older.
+
+
+def _inputs(project_dir):
+    return (glob.glob(os.path.join(project_dir, "lib", "*", "*.[ch]")) +
+            glob.glob(os.path.join(project_dir, "lib", "*", "*.def")) +
+            [os.path.join(project_dir, "scripts", "stack_usage.py")])
+
+
+def _up_to_date(stamp, inputs):
+    if not os.path.isfile(stamp):
+        return False
+    built = os.path.getmtime(stamp)
+    return all(os.path.getmtime(path) <= built for path in inputs)
+
+
+def _check_stack(target, source, env):
+    project_dir = env.subst("$PROJECT_DIR")
+    stamp = os.path.join(env.subst("$BUILD_DIR"), "stack_usage.ok")
+    if _up_to_date(stamp, _inputs(project_dir)):
+        return 0
+
+    cc = os.environ.get("STACK_USAGE_CC") or env.subst("$CC")
+    result = subprocess.run(
+        [env.subst("$PYTHONEXE"),
+         os.path.join(project_dir, "scripts", "stack_usage.py"), "--cc", cc],
+        cwd=project_dir)
+    if result.returncode != 0:
+        print("stack_check: stack usage check failed")
+        return 1
+
+    with open(stamp, "w", encoding="utf-8"):
+        pass
+    return 0
+
+
+env.AddPreAction("$PROGPATH", _check_stack)
@@ -0,0 +1,183 @@
+"""Check the worst-case stack depth of the command handling path.
+
+Every lib/*/*.c is compiled with -fcallgraph-info=su, which makes gcc write a
+per-unit call graph (.ci) with each function's static frame size. The graphs
+are merged and the deepest call chain below each root is summed and compared
+against its budget.
+
+Roots and budgets (bytes):
+    aqua_parse_command_json     command JSON parser entry
+    aqua_iotda_handle_command   full IoTDA command handler (parse + apply +
+                                response build)
+    aqua_mqtt_poll_commands     main-loop downlink entry: +MQTTSUBRECV
+                                dispatch through gateway/app to the handler
+                                and the response publish
+
+Indirect calls are resolved through INDIRECT below, which lists the
+callbacks each caller can reach on these paths. Unlisted indirect calls,
+recursion and unbounded dynamic frames (VLA / alloca) are reported and fail
+the check, since the sum would no longer be an upper bound. Library
+functions outside lib/ (memcpy, snprintf, ...) are counted as 0 and listed.
+
+`pio test -e native` runs this check before linking each test program
+(scripts/stack_check.py) and fails when it fails.
+
+Usage (from Aquarium_Device/):
+    python scripts/stack_usage.py
+    python scripts/stack_usage.py --cc arm-none-eabi-gcc \\
+        --cflags "-mcpu=cortex-m3 -mthumb -Os"
+Needs gcc >= 10. The host numbers differ from the target's; use the cross
+compiler for figures that matter on the STM32.
+"""
+
+import argparse
+import glob
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+LIB = os.path.join(ROOT, "lib")
+
+ROOTS = [
+    ("aqua_parse_command_json", 768),
+    ("aqua_iotda_handle_command", 1536),
+    ("aqua_mqtt_poll_commands", 4608),
+]
+
+# Callback targets of indirect calls, by caller (static names unqualified).
+INDIRECT = {
+    # paras_writer of aqua_build_command_response_paras_json
+    "response_write": ["write_state_snapshot"],
+    # The JSON writers on these paths write into a buffer, never a sink.
+    "fmt_sink_emit": [],
+    # AtClient's now_ms_func / write_func: the board's tick and UART write
+    # (src/main.c), leaf functions outside lib/.
+    "aqua_mqtt_poll_commands": [],
+    "at_begin": [],
+    "at_tx_flush": [],
+}
+
+NODE_RE = re.compile(r'^node: \{ title: "([^"]+)" label: "([^"]*)"')
+EDGE_RE = re.compile(r'^edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+SIZE_RE = re.compile(r"\\n(\d+) bytes \(([a-z,]+)\)")
+
+
+def compile_graphs(cc, cflags, outdir):
+    sources = sorted(glob.glob(os.path.join(LIB, "*", "*.c")))
+    includes = ["-I" + d
+                for d in sorted(glob.glob(os.path.join(LIB, "*", "")))]
+    for src in sources:
+        obj = os.path.join(outdir, os.path.basename(src)[:-2] + ".o")
+        cmd = ([cc, "-std=c99", "-fcallgraph-info=su", "-c", src, "-o", obj] +
+               includes + cflags)
+        subprocess.run(cmd, check=True)
+    return sorted(glob.glob(os.path.join(outdir, "*.ci")))
+
+
+def load_graph(ci_files):
+    frames = {}  # name -> (bytes, qualifier)
+    edges = {}   # name -> set of callee names
+    for path in ci_files:
+        with open(path, encoding="utf-8") as f:
+            for line in f:
+                m = NODE_RE.match(line)
+                if m:
+                    size = SIZE_RE.search(m.group(2))
+                    if size:
+                        frames[m.group(1)] = (int(size.group(1)),
+                                              size.group(2))
+                    continue
+                m = EDGE_RE.match(line)
+                if m:
+                    edges.setdefault(m.group(1), set()).add(m.group(2))
+    return frames, edges
+
+
+def short(name):
+    # Static functions are qualified with their source path.
+    return name.rsplit(":", 1)[-1]
+
+
+def callees(name, frames, edges, problems):
+    result = set()
+    for callee in edges.get(name, ()):
+        if not callee.startswith("__indirect_call"):
+            result.add(callee)
+        elif short(name) in INDIRECT:
+            targets = INDIRECT[short(name)]
+            result.update(n for n in frames if short(n) in targets)
+        else:
+            problems.add("indirect call in %s" % short(name))
+    return sorted(result)
+
+
+def worst_path(name, frames, edges, problems, external, active, memo):
+    """Return (bytes, chain) of the deepest call chain starting at name."""
+    if name in memo:
+        return memo[name]
+    if name in active:
+        problems.add("recursion through %s" % short(name))
+        return 0, [name]
+    if name not in frames:
+        external.add(name)
+        return 0, [name]
+
+    size, qualifier = frames[name]
+    if "dynamic" in qualifier and "bounded" not in qualifier:
+        problems.add("unbounded dynamic frame in %s" % short(name))
+
+    active.add(name)
+    best = (0, [])
+    for callee in callees(name, frames, edges, problems):
+        sub = worst_path(callee, frames, edges, problems, external, active,
+                         memo)
+        if sub[0] > best[0]:
+            best = sub
+    active.discard(name)
+
+    memo[name] = (size + best[0], [name] + best[1])
+    return memo[name]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cc", default="gcc")
+    parser.add_argument("--cflags", default="-O1")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as outdir:
+        try:
+            frames, edges = load_graph(
+                compile_graphs(args.cc, shlex.split(args.cflags), outdir))
+        except (OSError, subprocess.CalledProcessError) as e:
+            print("stack_usage: %s failed (%s); needs gcc >= 10 for "
+                  "-fcallgraph-info" % (args.cc, e))
+            return 1
+
+    failed = False
+    for root, budget in ROOTS:
+        problems = set()
+        external = set()
+        used, chain = worst_path(root, frames, edges, problems, external,
+                                 set(), {})
+        ok = used <= budget and not problems
+        failed = failed or not ok
+        print("%-28s %5d B / %5d B  %s" % (root, used, budget,
+                                          "ok" if ok else "FAIL"))
+        print("  worst chain: " + " -> ".join(
+            "%s(%d)" % (short(n), frames.get(n, (0,))[0]) for n in chain))
+        for problem in sorted(problems):
+            print("  unbounded: " + problem)
+        if external:
+            print("  external (counted as 0): " +
+                  ", ".join(sorted(short(n) for n in external)))
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,5 +1,6 @@
 #include "app_config.h"
 #include "aquarium_ds18b20.h"
+#include "aquarium_at_rx.h"
 #include "aquarium_firmware.h"
 #include "aquarium_oled.h"
 #include "aquarium_sensors.h"
@@ -13,6 +14,8 @@ ADC_HandleTypeDef hadc1;
 I2C_HandleTypeDef hi2c1;
 TIM_HandleTypeDef htim3;
 UART_HandleTypeDef huart2;
+DMA_HandleTypeDef hdma_esp32_rx;
+DMA_HandleTypeDef hdma_esp32_tx;
 
 /* 固件编排器相关 */
 static AtClient g_at;
@@ -39,26 +42,69 @@ static void MX_USART2_UART_Init(void);
 
 static void Error_Handler(void);
 
-/* AT 命令写回调：通过 ESP32 UART 发送 */
+/* UART TX RingBuffer：主循环只入队，DMA 在后台发出，避免大 payload 阻塞主循环
+ * （512 B @115200 约 45 ms）。发送环满时写回调只接收部分字节，AtClient 稍后续发
+ */
+#define UART_TX_RING_SIZE 1024
+static uint8_t g_uart_tx_ring[UART_TX_RING_SIZE];
+static volatile uint16_t g_uart_tx_head = 0;     /* 主循环写入 */
+static volatile uint16_t g_uart_tx_tail = 0;     /* 发送完成中断推进 */
+static volatile uint16_t g_uart_tx_inflight = 0; /* 正在 DMA 发送的字节数 */
+
+/* 启动下一段连续数据的 DMA 发送（在发送完成中断中，或关中断后调用） */
+static void uart_tx_kick(void) {
+  uint16_t head = g_uart_tx_head;
+  uint16_t tail = g_uart_tx_tail;
+  if (g_uart_tx_inflight > 0U || head == tail) {
+    return;
+  }
+
+  uint16_t len = (head > tail) ? (uint16_t)(head - tail)
+                               : (uint16_t)(UART_TX_RING_SIZE - tail);
+  if (HAL_UART_Transmit_DMA(&huart2, &g_uart_tx_ring[tail], len) == HAL_OK) {
+    g_uart_tx_inflight = len;
+  }
+}
+
+/* DMA 发送结束（完成或出错）：推进读指针并接着发送剩余数据 */
+static void uart_tx_done(void) {
+  g_uart_tx_tail =
+      (uint16_t)((g_uart_tx_tail + g_uart_tx_inflight) % UART_TX_RING_SIZE);
+  g_uart_tx_inflight = 0;
+  uart_tx_kick();
+}
+
+/* AT 命令写回调：放入 TX 环，返回实际接收的字节数 */
 static size_t at_write_cb(const uint8_t *data, size_t len) {
-  HAL_UART_Transmit(&huart2, (uint8_t *)data, (uint16_t)len, 100);
-  return len;
+  uint16_t head = g_uart_tx_head;
+  size_t free_space =
+      (size_t)((g_uart_tx_tail + UART_TX_RING_SIZE - head - 1U) %
+               UART_TX_RING_SIZE);
+  size_t n = (len < free_space) ? len : free_space;
+
+  size_t to_end = UART_TX_RING_SIZE - head;
+  size_t first = (n < to_end) ? n : to_end;
+  memcpy(&g_uart_tx_ring[head], data, first);
+  memcpy(g_uart_tx_ring, data + first, n - first);
+  g_uart_tx_head = (uint16_t)((head + n) % UART_TX_RING_SIZE);
+
+  __disable_irq();
+  uart_tx_kick();
+  __enable_irq();
+  return n;
 }
 
 /* 时间获取回调 */
 static uint32_t get_tick_ms(void) { return HAL_GetTick(); }
 
-/* UART 接收缓冲区（单字节中断模式） */
-static uint8_t g_uart_rx_byte;
+/* UART RX：DMA 循环接收 + IDLE 中断。ISR 只报告 DMA 写位置，主循环中再把
+ * 新数据段喂给 AT 引擎，避免 ISR/主线程并发访问 AtClient */
+#define UART_RX_RING_SIZE 2048 /* 必须为 2 的幂 */
+static uint8_t g_uart_rx_dma[UART_RX_RING_SIZE];
+static AtRxRing g_uart_rx;
+static volatile bool g_uart_rx_restart = false; /* DMA 因 UART 错误被中止 */
 volatile uint32_t g_uart_rx_total = 0;
 
-/* UART RX RingBuffer：ISR 只收集字节，主循环中再喂给 AT 引擎，避免
- * ISR/主线程并发访问 AtClient */
-#define UART_RX_RING_SIZE 2048
-static uint8_t g_uart_rx_ring[UART_RX_RING_SIZE];
-static volatile uint16_t g_uart_rx_head = 0;
-static volatile uint16_t g_uart_rx_tail = 0;
-
 /* 水位分段映射（基于 A3 原始 ADC）+ 一阶平滑，避免突跳
  * 现场经验锚点：空≈0，半浸≈1650，全浸≈1750
  */
@@ -68,23 +114,24 @@ static volatile uint16_t g_uart_rx_tail = 0;
 #define WATER_LEVEL_FILTER_ALPHA 0.35f
 static float g_water_level_filtered = 0.0f;
 
-static bool uart_rx_push(uint8_t b) {
-  uint16_t next = (uint16_t)((g_uart_rx_head + 1U) % UART_RX_RING_SIZE);
-  if (next == g_uart_rx_tail) {
-    return false; /* full */
+static void uart_rx_start(void) {
+  aqua_at_rx_init(&g_uart_rx, g_uart_rx_dma, UART_RX_RING_SIZE);
+  /* 循环模式下半满、全满与 IDLE 都会触发 HAL_UARTEx_RxEventCallback */
+  if (HAL_UARTEx_ReceiveToIdle_DMA(&huart2, g_uart_rx_dma,
+                                   UART_RX_RING_SIZE) != HAL_OK) {
+    g_uart_rx_restart = true; /* 下一轮主循环重试 */
   }
-  g_uart_rx_ring[g_uart_rx_head] = b;
-  g_uart_rx_head = next;
-  return true;
 }
 
-static bool uart_rx_pop(uint8_t *out) {
-  if (g_uart_rx_tail == g_uart_rx_head) {
-    return false; /* empty */
+/* 把 DMA 已写入的数据按两段（回绕时）批量喂给 AT 引擎 */
+static void uart_rx_drain(void) {
+  aqua_at_rx_feed(&g_uart_rx, &g_at);
+
+  if (g_uart_rx_restart) {
+    /* UART 错误（如 ORE）后 HAL 已停止 DMA：上面已取走残余数据，从头重启 */
+    g_uart_rx_restart = false;
+    uart_rx_start();
   }
-  *out = g_uart_rx_ring[g_uart_rx_tail];
-  g_uart_rx_tail = (uint16_t)((g_uart_rx_tail + 1U) % UART_RX_RING_SIZE);
-  return true;
 }
 
 /* ========================================================================== */
@@ -246,7 +293,7 @@ static void print_ap_credentials_serial(const char *ssid,
   if (len > (int)sizeof(msg)) {
     len = (int)sizeof(msg);
   }
-  HAL_UART_Transmit(&huart2, (uint8_t *)msg, (uint16_t)len, 100);
+  (void)at_write_cb((const uint8_t *)msg, (size_t)len);
 }
 
 static void show_ap_credentials_oled(const char *ssid, const char *password) {
@@ -457,6 +504,10 @@ int main(void) {
 
   /* 初始化应用层 */
   aqua_app_init(&g_app, IOTDA_DEVICE_ID);
+  aqua_app_set_report_frame_mode(&g_app, true);
+  aqua_app_set_delta_report(&g_app, true, DEFAULT_KEYFRAME_INTERVAL);
+  aqua_app_set_batch_report(&g_app, 10);
+  aqua_app_set_command_state_response(&g_app, true);
 
   /* 初始化 MQTT 客户端 */
   aqua_mqtt_init(&g_mqtt, &g_at, &g_app);
@@ -526,8 +577,8 @@ int main(void) {
   oled_init(&g_oled, &g_oled_hw_ops, oled_addr);
   show_ap_credentials_oled(g_ap_ssid, g_ap_password);
 
-  /* 启动 UART 接收中断（单字节模式） */
-  HAL_UART_Receive_IT(&huart2, &g_uart_rx_byte, 1);
+  /* 启动 UART DMA 循环接收 */
+  uart_rx_start();
 
   /* 启动 MQTT 连接 */
   aqua_mqtt_start(&g_mqtt);
@@ -536,14 +587,11 @@ int main(void) {
   uint32_t config_save_retry_delay_ms = CONFIG_SAVE_RETRY_INIT_MS;
 
   while (1) {
+    uint32_t loop_start_ms = HAL_GetTick();
+
     /* 先处理 UART RX 缓冲，把数据喂给 AT 引擎（避免在 ISR 中直接操作 AtClient）
      */
-    uint8_t b;
-    uint16_t rx_budget = 256U;
-    while (rx_budget > 0U && uart_rx_pop(&b)) {
-      aqua_at_feed_rx(&g_at, &b, 1);
-      rx_budget--;
-    }
+    uart_rx_drain();
 
     /* 每秒采样 ADC 传感器并更新 */
     static uint32_t last_adc_ms = 0;
@@ -701,7 +749,11 @@ int main(void) {
       oled_render(&g_oled);
     }
 
-    HAL_Delay(10); /* 10ms 循环周期 */
+    /* 10ms 循环周期：以忙等代替 HAL_Delay(10) 的空闲等待，期间持续收取
+     * UART，排队命令的 OK 一到即发出下一条 */
+    while (HAL_GetTick() - loop_start_ms < 10) {
+      uart_rx_drain();
+    }
   }
 }
 
@@ -936,7 +988,42 @@ static void MX_USART2_UART_Init(void) {
     Error_Handler();
   }
 
-  /* Enable UART IRQ so HAL_UART_Receive_IT() callbacks can fire. */
+  /* RX DMA：循环模式，数据写入 g_uart_rx_dma */
+  ESP32_UART_RX_DMA_RCC_ENABLE();
+  hdma_esp32_rx.Instance = ESP32_UART_RX_DMA_CHANNEL;
+  hdma_esp32_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  hdma_esp32_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_esp32_rx.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_esp32_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  hdma_esp32_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  hdma_esp32_rx.Init.Mode = DMA_CIRCULAR;
+  hdma_esp32_rx.Init.Priority = DMA_PRIORITY_HIGH;
+  if (HAL_DMA_Init(&hdma_esp32_rx) != HAL_OK) {
+    Error_Handler();
+  }
+  __HAL_LINKDMA(&huart2, hdmarx, hdma_esp32_rx);
+
+  /* TX DMA：普通模式，每次发送 TX 环中的一段连续数据 */
+  hdma_esp32_tx.Instance = ESP32_UART_TX_DMA_CHANNEL;
+  hdma_esp32_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  hdma_esp32_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+  hdma_esp32_tx.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_esp32_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  hdma_esp32_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  hdma_esp32_tx.Init.Mode = DMA_NORMAL;
+  hdma_esp32_tx.Init.Priority = DMA_PRIORITY_MEDIUM;
+  if (HAL_DMA_Init(&hdma_esp32_tx) != HAL_OK) {
+    Error_Handler();
+  }
+  __HAL_LINKDMA(&huart2, hdmatx, hdma_esp32_tx);
+
+  HAL_NVIC_SetPriority(ESP32_UART_TX_DMA_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(ESP32_UART_TX_DMA_IRQn);
+
+  HAL_NVIC_SetPriority(ESP32_UART_RX_DMA_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(ESP32_UART_RX_DMA_IRQn);
+
+  /* UART IRQ：IDLE 检测与错误处理 */
   HAL_NVIC_SetPriority(ESP32_UART_IRQn, 1, 0);
   HAL_NVIC_EnableIRQ(ESP32_UART_IRQn);
 }
@@ -956,14 +1043,30 @@ static void Error_Handler(void) {
   }
 }
 
-/* UART 接收完成回调（中断触发） */
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart) {
+/* UART 接收事件回调：DMA 半满/全满或 IDLE，Size 为当前 DMA 写位置 */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size) {
+  if (huart->Instance == ESP32_UART_INSTANCE) {
+    /* ISR 中只记录写位置，避免与主循环并发访问 AtClient */
+    aqua_at_rx_on_dma(&g_uart_rx, Size);
+    g_uart_rx_total = g_uart_rx.written;
+  }
+}
+
+/* UART 发送完成回调：继续发送 TX 环中的剩余数据 */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
+  if (huart->Instance == ESP32_UART_INSTANCE) {
+    uart_tx_done();
+  }
+}
+
+/* UART 错误回调：HAL 已中止 DMA 接收，交给主循环重启 */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
   if (huart->Instance == ESP32_UART_INSTANCE) {
-    g_uart_rx_total++;
-    /* ISR 中仅入队字节，避免与主循环并发访问 AtClient */
-    (void)uart_rx_push(g_uart_rx_byte);
-    /* 继续开启接收下一个字节 */
-    HAL_UART_Receive_IT(&huart2, &g_uart_rx_byte, 1);
+    g_uart_rx_restart = true;
+    /* DMA 发送出错时 HAL 已结束发送：丢弃这一段，避免发送停滞 */
+    if (g_uart_tx_inflight > 0U && huart->gState == HAL_UART_STATE_READY) {
+      uart_tx_done();
+    }
   }
 }
 
@@ -973,3 +1076,7 @@ void SysTick_Handler(void) {
 }
 
 void ESP32_UART_IRQ_HANDLER(void) { HAL_UART_IRQHandler(&huart2); }
+
+void ESP32_UART_RX_DMA_IRQ_HANDLER(void) { HAL_DMA_IRQHandler(&hdma_esp32_rx); }
+
+void ESP32_UART_TX_DMA_IRQ_HANDLER(void) { HAL_DMA_IRQHandler(&hdma_esp32_tx); }
@@ -194,6 +194,328 @@ void test_report_triggered_after_interval(void) {
   TEST_ASSERT_EQUAL(30, app.report_timer);
 }
 
+void test_report_frame_mode(void) {
+  static AquariumApp app;
+  aqua_app_init(&app, TEST_DEVICE_ID);
+  aqua_app_set_report_interval(&app, 1);
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_app_set_report_frame_mode(&app, true));
+
+  aqua_app_update_sensors(&app, 26.0f, 7.0f, 300.0f, 15.0f, 50.0f);
+
+  char topic[256], payload[1024];
+  ActuatorDesired actuators;
+  bool has_publish;
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 1, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_NOT_NULL(strstr(topic, "/sys/properties/report"));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"temperature\":    26.00,"));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"tds\":   300.00,"));
+  size_t frame_len = strlen(payload);
+
+  /* 数值变化后帧长度不变 */
+  aqua_app_update_sensors(&app, 25.5f, 7.1f, 1200.0f, 3.0f, 80.0f);
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 1, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_EQUAL(frame_len, strlen(payload));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"tds\":  1200.00,"));
+
+  /* 关闭后回到紧凑格式 */
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_app_set_report_frame_mode(&app, false));
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 1, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"tds\":1200.00,"));
+}
+
+/* ============================================================================
+ * 测试：增量上报
+ * ============================================================================
+ */
+
+void test_delta_report_deadbands_and_keyframes(void) {
+  static AquariumApp app;
+  aqua_app_init(&app, TEST_DEVICE_ID);
+  aqua_app_set_report_interval(&app, 30);
+  aqua_app_set_delta_report(&app, true, 4);
+  aqua_app_update_sensors(&app, 26.0f, 7.0f, 300.0f, 15.0f, 50.0f);
+
+  char topic[256], payload[1024];
+  ActuatorDesired actuators;
+  bool has_publish;
+
+  /* 第 1 个周期：关键帧，包含全部字段 */
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"alarm_muted\""));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"feed_countdown\""));
+
+  /* 第 2 个周期：变化都在死区内（倒计时正常递减），不发布 */
+  aqua_app_update_sensors(&app, 26.05f, 7.02f, 303.0f, 15.5f, 50.5f);
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_FALSE(has_publish);
+  TEST_ASSERT_EQUAL(30, app.report_timer);
+
+  /* 第 3 个周期：相对上次上报值累计越过死区的字段才发布 */
+  aqua_app_update_sensors(&app, 26.15f, 7.02f, 303.0f, 15.5f, 50.5f);
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"properties\":{\"temperature\":26.15}"));
+
+  /* 第 4 个周期：无变化 */
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_FALSE(has_publish);
+
+  /* 第 5 个周期：距上个关键帧 4 个周期，重新发送全部字段 */
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"tds\":303.00"));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"alarm_muted\""));
+}
+
+void test_delta_report_bool_flip_and_deadband_command(void) {
+  static AquariumApp app;
+  aqua_app_init(&app, TEST_DEVICE_ID);
+  aqua_app_set_report_interval(&app, 30);
+  aqua_app_set_delta_report(&app, true, 100);
+  aqua_app_update_sensors(&app, 26.0f, 7.0f, 300.0f, 15.0f, 50.0f);
+
+  char topic[256], payload[1024];
+  ActuatorDesired actuators;
+  bool has_publish;
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+
+  /* 通过 set_thresholds 把 TDS 死区调到 50 ppm，并静音告警 */
+  const char *cmd_topic =
+      "$oc/devices/" TEST_DEVICE_ID "/sys/commands/request_id=db1";
+  const char *threshold = "{\"service_id\":\"aquarium_threshold\","
+                          "\"command_name\":\"set_thresholds\","
+                          "\"paras\":{\"tds_deadband\":50}}";
+  const char *mute = "{\"service_id\":\"aquarium_control\","
+                     "\"command_name\":\"control\",\"paras\":{\"mute\":true}}";
+  bool has_response;
+  char resp_topic[256], resp_payload[512];
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_app_on_mqtt_command(
+                                 &app, cmd_topic, threshold, strlen(threshold),
+                                 &has_response, resp_topic, sizeof(resp_topic),
+                                 resp_payload, sizeof(resp_payload)));
+  TEST_ASSERT_NOT_NULL(strstr(resp_payload, "\"result_code\":0"));
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_app_on_mqtt_command(
+                                 &app, cmd_topic, mute, strlen(mute),
+                                 &has_response, resp_topic, sizeof(resp_topic),
+                                 resp_payload, sizeof(resp_payload)));
+
+  aqua_app_update_sensors(&app, 26.0f, 7.0f, 340.0f, 15.0f, 50.0f);
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_NOT_NULL(
+      strstr(payload, "\"properties\":{\"alarm_muted\":true}"));
+
+  /* 上报未能发出：下一周期补发关键帧 */
+  aqua_app_request_keyframe(&app);
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"tds\":340.00"));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"alarm_level\""));
+}
+
+/* ============================================================================
+ * 测试：批量上报
+ * ============================================================================
+ */
+
+static int count_occurrences(const char *haystack, const char *needle) {
+  int n = 0;
+  for (const char *p = strstr(haystack, needle); p; p = strstr(p + 1, needle))
+    n++;
+  return n;
+}
+
+void test_batch_report_samples_between_reports(void) {
+  static AquariumApp app;
+  aqua_app_init(&app, TEST_DEVICE_ID);
+  aqua_app_set_report_interval(&app, 60);
+  aqua_app_set_batch_report(&app, 10);
+  aqua_app_update_sensors(&app, 26.0f, 7.0f, 300.0f, 15.0f, 50.0f);
+
+  char topic[256], payload[1024];
+  ActuatorDesired actuators;
+  bool has_publish;
+
+  /* 未校时：不记录中间采样，上报与普通模式一致 */
+  for (int i = 0; i < 6; ++i) {
+    TEST_ASSERT_EQUAL(AQUA_OK,
+                      aqua_app_step(&app, 10, &actuators, &has_publish, topic,
+                                    sizeof(topic), payload, sizeof(payload)));
+  }
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_EQUAL(1, count_occurrences(payload, "\"service_id\""));
+  TEST_ASSERT_NULL(strstr(payload, "\"event_time\""));
+
+  /* 校时后每 10 s 采样一次；缓存上限 4 个，丢弃最早的 */
+  aqua_app_set_utc_time(&app, 1760515200u); /* 2025-10-15 08:00:00 UTC */
+  for (int i = 0; i < 5; ++i) {
+    aqua_app_update_sensors(&app, 26.0f + (float)i, 7.0f, 300.0f, 15.0f,
+                            50.0f);
+    TEST_ASSERT_EQUAL(AQUA_OK,
+                      aqua_app_step(&app, 10, &actuators, &has_publish, topic,
+                                    sizeof(topic), payload, sizeof(payload)));
+    TEST_ASSERT_FALSE(has_publish);
+  }
+  TEST_ASSERT_EQUAL(AQUA_APP_BATCH_MAX_SAMPLES, app.batch_count);
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 10, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_EQUAL(0, app.batch_count);
+
+  /* 4 个中间采样 + 1 个当前全量属性，均带 event_time */
+  TEST_ASSERT_EQUAL(5, count_occurrences(payload, "\"service_id\""));
+  TEST_ASSERT_EQUAL(5, count_occurrences(payload, "\"event_time\""));
+  TEST_ASSERT_NULL(strstr(payload, "\"temperature\":26.00"));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "{\"temperature\":27.00,\"ph\":7.00,"
+                                       "\"tds\":300.00,\"turbidity\":15.00,"
+                                       "\"water_level\":50.00},"
+                                       "\"event_time\":\"20251015T080020Z\"}"));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"event_time\":\"20251015T080050Z\"}"));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"alarm_muted\":false},\"event_time\":"
+                                       "\"20251015T080100Z\"}]}"));
+  TEST_ASSERT_EQUAL(1760515260u, app.utc_time);
+}
+
+void test_batch_report_delta_samples(void) {
+  static AquariumApp app;
+  aqua_app_init(&app, TEST_DEVICE_ID);
+  aqua_app_set_report_interval(&app, 60);
+  aqua_app_set_delta_report(&app, true, 100);
+  aqua_app_set_batch_report(&app, 20);
+  aqua_app_set_utc_time(&app, 1760515200u);
+  aqua_app_update_sensors(&app, 26.0f, 7.0f, 300.0f, 15.0f, 50.0f);
+
+  char topic[256], payload[1024];
+  ActuatorDesired actuators;
+  bool has_publish;
+
+  /* 第 1 个周期：关键帧 */
+  for (int i = 0; i < 3; ++i) {
+    TEST_ASSERT_EQUAL(AQUA_OK,
+                      aqua_app_step(&app, 20, &actuators, &has_publish, topic,
+                                    sizeof(topic), payload, sizeof(payload)));
+  }
+  TEST_ASSERT_TRUE(has_publish);
+
+  /* 周期内只有温度越过死区，随后回落到原值 */
+  aqua_app_update_sensors(&app, 27.0f, 7.0f, 300.0f, 15.0f, 50.0f);
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 20, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_FALSE(has_publish);
+  TEST_ASSERT_EQUAL(1, app.batch_count);
+
+  aqua_app_update_sensors(&app, 26.0f, 7.0f, 300.0f, 15.0f, 50.0f);
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 20, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_EQUAL(2, app.batch_count);
+
+  /* 上报周期：两个中间采样，当前值与上一采样相同不再附带 */
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 20, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_EQUAL(2, count_occurrences(payload, "\"service_id\""));
+  TEST_ASSERT_NOT_NULL(
+      strstr(payload, "{\"temperature\":27.00},\"event_time\":"
+                      "\"20251015T080120Z\"}"));
+  TEST_ASSERT_NOT_NULL(
+      strstr(payload, "{\"temperature\":26.00},\"event_time\":"
+                      "\"20251015T080140Z\"}]}"));
+}
+
+void test_cbor_report_codec(void) {
+  static AquariumApp app;
+  aqua_app_init(&app, TEST_DEVICE_ID);
+  aqua_app_set_report_interval(&app, 30);
+  aqua_app_set_batch_report(&app, 10);
+  aqua_app_set_report_codec(&app, AQUA_REPORT_CODEC_CBOR);
+  aqua_app_update_sensors(&app, 26.0f, 7.0f, 300.0f, 15.0f, 50.0f);
+
+  char topic[256], payload[1024];
+  ActuatorDesired actuators;
+  bool has_publish;
+  AquaPropertySample samples[AQUA_APP_BATCH_MAX_SAMPLES + 1];
+  size_t count = 0;
+
+  /* 未校时：单个全量采样，不带 event_time */
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_EQUAL_STRING("$oc/devices/" TEST_DEVICE_ID "/sys/messages/up",
+                           topic);
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_properties_cbor(
+                                 (const uint8_t *)payload,
+                                 aqua_app_get_report_len(&app), samples,
+                                 AQUA_APP_BATCH_MAX_SAMPLES + 1, &count));
+  TEST_ASSERT_EQUAL(1, count);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_ALL, samples[0].field_mask);
+  TEST_ASSERT_EQUAL(0, samples[0].event_time);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 300.0f, samples[0].props.tds);
+
+  /* 校时后中间采样与当前属性合并为一条二进制消息 */
+  aqua_app_set_utc_time(&app, 1760515200u);
+  for (int i = 0; i < 3; ++i) {
+    aqua_app_update_sensors(&app, 26.0f + (float)i, 7.0f, 300.0f, 15.0f,
+                            50.0f);
+    TEST_ASSERT_EQUAL(AQUA_OK,
+                      aqua_app_step(&app, 10, &actuators, &has_publish, topic,
+                                    sizeof(topic), payload, sizeof(payload)));
+  }
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_properties_cbor(
+                                 (const uint8_t *)payload,
+                                 aqua_app_get_report_len(&app), samples,
+                                 AQUA_APP_BATCH_MAX_SAMPLES + 1, &count));
+  TEST_ASSERT_EQUAL(3, count);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_SENSORS, samples[0].field_mask);
+  TEST_ASSERT_EQUAL_UINT32(1760515210u, samples[0].event_time);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 27.0f, samples[1].props.temperature);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_ALL, samples[2].field_mask);
+  TEST_ASSERT_EQUAL_UINT32(1760515230u, samples[2].event_time);
+
+  /* 切回 JSON：payload 长度仍由 get_report_len 给出 */
+  aqua_app_set_report_codec(&app, AQUA_REPORT_CODEC_JSON);
+  aqua_app_set_batch_report(&app, 0);
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 30, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_NOT_NULL(strstr(topic, "/sys/properties/report"));
+  TEST_ASSERT_EQUAL(strlen(payload), aqua_app_get_report_len(&app));
+}
+
 /* ============================================================================
  * 测试：命令响应生成
  * ============================================================================
@@ -229,6 +551,82 @@ void test_command_response_generated(void) {
 
   /* 验证状态已更新 */
   TEST_ASSERT_TRUE(app.state.props.heater);
+
+  /* 默认不带状态快照 */
+  TEST_ASSERT_NULL(strstr(resp_payload, "\"state\""));
+}
+
+void test_command_response_state_snapshot(void) {
+  static AquariumApp app;
+  aqua_app_init(&app, TEST_DEVICE_ID);
+  aqua_app_set_command_state_response(&app, true);
+
+  const char *cmd_topic =
+      "$oc/devices/" TEST_DEVICE_ID "/sys/commands/request_id=cmd002";
+  const char *cmd_payload = "{\"service_id\":\"aquarium_control\","
+                            "\"command_name\":\"control\","
+                            "\"paras\":{\"auto_mode\":false,"
+                            "\"pump_out\":true,\"feed_once_delay\":90}}";
+
+  char resp_topic[256], resp_payload[1024];
+  bool has_response;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_app_on_mqtt_command(
+                                 &app, cmd_topic, cmd_payload,
+                                 strlen(cmd_payload), &has_response, resp_topic,
+                                 sizeof(resp_topic), resp_payload,
+                                 sizeof(resp_payload)));
+  TEST_ASSERT_TRUE(has_response);
+  TEST_ASSERT_NOT_NULL(
+      strstr(resp_payload, "\"state\":{\"heater\":false,\"pump_in\":false,"
+                           "\"pump_out\":true,\"auto_mode\":false,"
+                           "\"feed_countdown\":90,"));
+}
+
+void test_properties_get_and_set_between_reports(void) {
+  static AquariumApp app;
+  aqua_app_init(&app, TEST_DEVICE_ID);
+  aqua_app_set_report_interval(&app, 60);
+  aqua_app_update_sensors(&app, 26.5f, 7.2f, 300.0f, 10.0f, 80.0f);
+
+  char topic[256], payload[1024];
+  char resp_topic[256], resp_payload[1024];
+  ActuatorDesired actuators;
+  bool has_publish, has_response;
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_step(&app, 10, &actuators, &has_publish, topic,
+                                  sizeof(topic), payload, sizeof(payload)));
+  TEST_ASSERT_FALSE(has_publish);
+
+  /* 查询立即以当前状态回包，不改变上报周期 */
+  const char *get_topic = "$oc/devices/" TEST_DEVICE_ID
+                          "/sys/properties/get/request_id=get01";
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_on_mqtt_command(&app, get_topic, "{}", 2,
+                                             &has_response, resp_topic,
+                                             sizeof(resp_topic), resp_payload,
+                                             sizeof(resp_payload)));
+  TEST_ASSERT_TRUE(has_response);
+  TEST_ASSERT_NOT_NULL(strstr(resp_topic, "/sys/properties/get/response/"));
+  TEST_ASSERT_NOT_NULL(strstr(resp_payload, "\"temperature\":26.50"));
+  TEST_ASSERT_EQUAL(50, app.report_timer);
+
+  /* 设置走命令校验并立即生效 */
+  const char *set_topic = "$oc/devices/" TEST_DEVICE_ID
+                          "/sys/properties/set/request_id=set01";
+  const char *set_payload = "{\"services\":[{\"service_id\":\"Aquarium\","
+                            "\"properties\":{\"alarm_muted\":true}}]}";
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_app_on_mqtt_command(&app, set_topic, set_payload,
+                                             strlen(set_payload),
+                                             &has_response, resp_topic,
+                                             sizeof(resp_topic), resp_payload,
+                                             sizeof(resp_payload)));
+  TEST_ASSERT_TRUE(has_response);
+  TEST_ASSERT_NOT_NULL(strstr(resp_topic, "/sys/properties/set/response/"));
+  TEST_ASSERT_NOT_NULL(strstr(resp_payload, "\"result_code\":0"));
+  TEST_ASSERT_TRUE(app.state.props.alarm_muted);
 }
 
 /* ============================================================================
@@ -416,9 +814,17 @@ int main(void) {
 
   /* 周期上报测试 */
   RUN_TEST(test_report_triggered_after_interval);
+  RUN_TEST(test_report_frame_mode);
+  RUN_TEST(test_delta_report_deadbands_and_keyframes);
+  RUN_TEST(test_delta_report_bool_flip_and_deadband_command);
+  RUN_TEST(test_batch_report_samples_between_reports);
+  RUN_TEST(test_batch_report_delta_samples);
+  RUN_TEST(test_cbor_report_codec);
 
   /* 命令响应测试 */
   RUN_TEST(test_command_response_generated);
+  RUN_TEST(test_command_response_state_snapshot);
+  RUN_TEST(test_properties_get_and_set_between_reports);
 
   /* 告警测试 */
   RUN_TEST(test_alarm_affects_buzzer_led);
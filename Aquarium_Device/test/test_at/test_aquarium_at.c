@@ -4,6 +4,7 @@
  */
 
 #include "aquarium_at.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <unity.h>
@@ -16,9 +17,16 @@
 
 static uint8_t g_tx_buffer[256];
 static size_t g_tx_len = 0;
+static size_t g_tx_calls = 0;
+static size_t g_tx_room = SIZE_MAX; /* 模拟发送队列剩余空间 */
 static uint32_t g_mock_time_ms = 0;
 
 static size_t mock_write(const uint8_t *data, size_t len) {
+  g_tx_calls++;
+  if (len > g_tx_room) {
+    len = g_tx_room;
+  }
+  g_tx_room -= len;
   if (g_tx_len + len <= sizeof(g_tx_buffer)) {
     memcpy(g_tx_buffer + g_tx_len, data, len);
     g_tx_len += len;
@@ -30,6 +38,8 @@ static uint32_t mock_now_ms(void) { return g_mock_time_ms; }
 
 static void reset_mocks(void) {
   g_tx_len = 0;
+  g_tx_calls = 0;
+  g_tx_room = SIZE_MAX;
   g_mock_time_ms = 0;
   memset(g_tx_buffer, 0, sizeof(g_tx_buffer));
 }
@@ -86,6 +96,97 @@ void test_at_begin_busy(void) {
   TEST_ASSERT_EQUAL(AT_ERR_BUSY, err);
 }
 
+void test_at_begin_writes_once(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  aqua_at_begin_with_prompt(&client, "AT+MQTTPUBRAW=0,\"t\",2,0,0", 1000);
+
+  /* 命令与 \r\n 一次写出 */
+  TEST_ASSERT_EQUAL(1, g_tx_calls);
+  TEST_ASSERT_EQUAL(0, aqua_at_tx_pending(&client));
+}
+
+void test_at_begin_backpressure_resumes_in_step(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  /* 发送队列只剩 3 字节：命令行剩余部分暂存，不阻塞 */
+  g_tx_room = 3;
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_begin(&client, "AT+GMR", 1000));
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, client.state);
+  TEST_ASSERT_EQUAL(5, aqua_at_tx_pending(&client));
+
+  /* 队列仍满：step 重试不出错 */
+  g_tx_room = 0;
+  g_mock_time_ms = 800;
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, aqua_at_step(&client));
+  TEST_ASSERT_EQUAL(5, aqua_at_tx_pending(&client));
+
+  /* 队列腾出空间后续发，超时从发完时重新计时 */
+  g_tx_room = SIZE_MAX;
+  g_mock_time_ms = 900;
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, aqua_at_step(&client));
+  TEST_ASSERT_EQUAL(0, aqua_at_tx_pending(&client));
+  TEST_ASSERT_EQUAL(8, g_tx_len);
+  TEST_ASSERT_EQUAL_STRING_LEN("AT+GMR\r\n", (char *)g_tx_buffer, 8);
+
+  g_mock_time_ms = 1500;
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, aqua_at_step(&client));
+  g_mock_time_ms = 1900;
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_TIMEOUT, aqua_at_step(&client));
+}
+
+void test_at_begin_queues_after_unsent_command(void) {
+  AtClient client;
+  char cmd[AT_TX_BUFFER_SIZE];
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  g_tx_room = 0;
+  aqua_at_begin(&client, "AT", 1000);
+  aqua_at_reset(&client);
+
+  /* 上一条未发出：新命令接在其后，保持顺序 */
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_begin(&client, "ATE0", 1000));
+  TEST_ASSERT_EQUAL(10, aqua_at_tx_pending(&client));
+  aqua_at_reset(&client);
+
+  /* 暂存空间不足 */
+  memset(cmd, 'A', sizeof(cmd) - 1);
+  cmd[sizeof(cmd) - 1] = '\0';
+  TEST_ASSERT_EQUAL(AT_ERR_BUFFER_FULL, aqua_at_begin(&client, cmd, 1000));
+  TEST_ASSERT_EQUAL(AT_STATE_IDLE, client.state);
+
+  g_tx_room = SIZE_MAX;
+  aqua_at_step(&client);
+  TEST_ASSERT_EQUAL_STRING_LEN("AT\r\nATE0\r\n", (char *)g_tx_buffer, 10);
+}
+
+void test_at_send_data_backpressure(void) {
+  AtClient client;
+  static const char payload[] = "{\"services\":[]}";
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  aqua_at_begin_with_prompt(&client, "AT+MQTTPUBRAW=0,\"t\",15,0,0", 1000);
+  const char *rx = ">";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, 1);
+  TEST_ASSERT_EQUAL(AT_STATE_GOT_PROMPT, aqua_at_step(&client));
+
+  g_tx_len = 0;
+  g_tx_room = 4;
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_send_data(&client, (const uint8_t *)payload,
+                                             strlen(payload)));
+  TEST_ASSERT_EQUAL(strlen(payload) - 4, aqua_at_tx_pending(&client));
+  TEST_ASSERT_EQUAL(AT_ERR_BUSY,
+                    aqua_at_send_data(&client, (const uint8_t *)payload, 1));
+
+  g_tx_room = SIZE_MAX;
+  aqua_at_step(&client);
+  TEST_ASSERT_EQUAL(0, aqua_at_tx_pending(&client));
+  TEST_ASSERT_EQUAL(strlen(payload), g_tx_len);
+  TEST_ASSERT_EQUAL_STRING_LEN(payload, (char *)g_tx_buffer, strlen(payload));
+}
+
 /* ============================================================================
  * 测试：CRLF 行解析
  * ============================================================================
@@ -161,6 +262,58 @@ void test_feed_rx_empty_lines_ignored(void) {
   TEST_ASSERT_EQUAL_STRING("Data", line.data);
 }
 
+/* 逐字节喂入，作为批量路径的参照 */
+static void feed_bytewise(AtClient *client, const char *rx, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    aqua_at_feed_rx(client, (const uint8_t *)rx + i, 1);
+  }
+}
+
+static void assert_same_lines(AtClient *expected, AtClient *actual) {
+  TEST_ASSERT_EQUAL(aqua_at_get_state(expected), aqua_at_get_state(actual));
+  TEST_ASSERT_EQUAL(expected->urc_count, actual->urc_count);
+  while (aqua_at_has_urc(expected)) {
+    AtLine want, got;
+    aqua_at_pop_line(expected, &want);
+    aqua_at_pop_line(actual, &got);
+    TEST_ASSERT_EQUAL(want.len, got.len);
+    TEST_ASSERT_EQUAL_STRING(want.data, got.data);
+  }
+}
+
+void test_feed_rx_spans_match_bytewise_at_every_wrap(void) {
+  /* 覆盖 CRLF、单独 CR、空行、裸 > 与跨字长的长行 */
+  const char *rx = "AT+CIPSEND=0,5\r\r\nOK\r\n>+IPD,0,5:hello\r\n"
+                   "A\rB\r\n\r\n0123456789abcdef0123456789\r\nSEND OK\r\n";
+  size_t len = strlen(rx);
+
+  for (size_t split = 0; split <= len; ++split) {
+    AtClient expected, actual;
+    aqua_at_init(&expected, mock_write, mock_now_ms);
+    aqua_at_init(&actual, mock_write, mock_now_ms);
+    aqua_at_begin_with_prompt(&expected, "AT+CIPSEND=0,5", 1000);
+    aqua_at_begin_with_prompt(&actual, "AT+CIPSEND=0,5", 1000);
+
+    feed_bytewise(&expected, rx, len);
+    TEST_ASSERT_EQUAL(AT_OK, aqua_at_feed_rx_spans(
+                                 &actual, (const uint8_t *)rx, split,
+                                 (const uint8_t *)rx + split, len - split));
+    assert_same_lines(&expected, &actual);
+  }
+}
+
+void test_feed_rx_spans_null_ptr(void) {
+  AtClient client;
+  const uint8_t byte = 'A';
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_feed_rx_spans(&client, NULL, 0, NULL, 0));
+  TEST_ASSERT_EQUAL(AT_ERR_NULL_PTR,
+                    aqua_at_feed_rx_spans(&client, NULL, 1, &byte, 1));
+  TEST_ASSERT_EQUAL(AT_ERR_NULL_PTR,
+                    aqua_at_feed_rx_spans(NULL, &byte, 1, NULL, 0));
+}
+
 /* ============================================================================
  * 测试：OK/ERROR 终止识别
  * ============================================================================
@@ -261,6 +414,383 @@ void test_reset_to_idle(void) {
   TEST_ASSERT_EQUAL(AT_STATE_IDLE, client.state);
 }
 
+/* ============================================================================
+ * 测试：命令队列
+ * ============================================================================
+ */
+
+#define TEST_CMD_LOG_SIZE 8
+
+static int g_cmd_cb_calls = 0;
+static AtState g_cmd_results[TEST_CMD_LOG_SIZE];
+static char g_cmd_responses[TEST_CMD_LOG_SIZE][AT_LINE_MAX_LEN + 1];
+static uintptr_t g_cmd_tags[TEST_CMD_LOG_SIZE];
+
+static void record_cmd(AtState result, const AtLine *response,
+                       void *user_data) {
+  if (g_cmd_cb_calls < TEST_CMD_LOG_SIZE) {
+    g_cmd_results[g_cmd_cb_calls] = result;
+    g_cmd_tags[g_cmd_cb_calls] = (uintptr_t)user_data;
+    strcpy(g_cmd_responses[g_cmd_cb_calls], response ? response->data : "");
+  }
+  g_cmd_cb_calls++;
+}
+
+static void reset_cmd_log(void) {
+  g_cmd_cb_calls = 0;
+  memset(g_cmd_results, 0, sizeof(g_cmd_results));
+  memset(g_cmd_responses, 0, sizeof(g_cmd_responses));
+  memset(g_cmd_tags, 0, sizeof(g_cmd_tags));
+}
+
+void test_enqueue_sends_next_as_soon_as_ok_arrives(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+  reset_cmd_log();
+
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_enqueue(&client, "AT", 500, false,
+                                           record_cmd, (void *)1));
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_enqueue(&client, "AT+GMR", 500, false,
+                                           record_cmd, (void *)2));
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_enqueue(&client, "AT+CWMODE=1", 500,
+                                           false, record_cmd, (void *)3));
+
+  /* 队首立即发出，其余等待 */
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, client.state);
+  TEST_ASSERT_EQUAL(2, aqua_at_queue_pending(&client));
+  TEST_ASSERT_EQUAL_STRING_LEN("AT\r\n", (char *)g_tx_buffer, g_tx_len);
+
+  /* 一次喂入即完成前两条：不需要 step，下一条在 OK 到达时已发出 */
+  const char *rx = "OK\r\nv1.0\r\nERROR\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+
+  TEST_ASSERT_EQUAL(2, g_cmd_cb_calls);
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_OK, g_cmd_results[0]);
+  TEST_ASSERT_EQUAL(1, g_cmd_tags[0]);
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_ERROR, g_cmd_results[1]);
+  TEST_ASSERT_EQUAL(2, g_cmd_tags[1]);
+  TEST_ASSERT_EQUAL_STRING("v1.0", g_cmd_responses[1]);
+
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, client.state);
+  TEST_ASSERT_EQUAL(0, aqua_at_queue_pending(&client));
+  TEST_ASSERT_EQUAL_STRING_LEN("AT\r\nAT+GMR\r\nAT+CWMODE=1\r\n",
+                               (char *)g_tx_buffer, g_tx_len);
+
+  /* 最后一条完成后客户端回到 IDLE，上一条的响应不会遗留 */
+  rx = "OK\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_EQUAL(3, g_cmd_cb_calls);
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_OK, g_cmd_results[2]);
+  TEST_ASSERT_EQUAL_STRING("", g_cmd_responses[2]);
+  TEST_ASSERT_EQUAL(AT_STATE_IDLE, client.state);
+}
+
+void test_enqueue_timeout_completes_in_step(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+  reset_cmd_log();
+
+  g_mock_time_ms = 1000;
+  aqua_at_enqueue(&client, "AT", 500, false, record_cmd, NULL);
+  aqua_at_enqueue(&client, "ATE0", 500, false, record_cmd, NULL);
+
+  g_mock_time_ms = 1499;
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, aqua_at_step(&client));
+  TEST_ASSERT_EQUAL(0, g_cmd_cb_calls);
+
+  /* 超时交给回调，随后立即发出下一条，超时从新命令发出时起算 */
+  g_mock_time_ms = 1500;
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, aqua_at_step(&client));
+  TEST_ASSERT_EQUAL(1, g_cmd_cb_calls);
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_TIMEOUT, g_cmd_results[0]);
+  TEST_ASSERT_EQUAL_STRING_LEN("AT\r\nATE0\r\n", (char *)g_tx_buffer,
+                               g_tx_len);
+
+  g_mock_time_ms = 1999;
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, aqua_at_step(&client));
+}
+
+void test_enqueue_rejects_when_full(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  TEST_ASSERT_EQUAL(AT_ERR_NULL_PTR,
+                    aqua_at_enqueue(&client, NULL, 500, false, NULL, NULL));
+
+  /* 队首已发出，不占队列位置 */
+  aqua_at_enqueue(&client, "AT", 500, false, NULL, NULL);
+  for (int i = 0; i < AT_CMD_QUEUE_SIZE; ++i) {
+    TEST_ASSERT_EQUAL(AT_OK,
+                      aqua_at_enqueue(&client, "AT", 500, false, NULL, NULL));
+  }
+  TEST_ASSERT_EQUAL(AT_ERR_BUFFER_FULL,
+                    aqua_at_enqueue(&client, "AT", 500, false, NULL, NULL));
+  TEST_ASSERT_EQUAL(AT_CMD_QUEUE_SIZE, aqua_at_queue_pending(&client));
+
+  /* 文本池满 */
+  char long_cmd[AT_CMD_POOL_SIZE];
+  memset(long_cmd, 'A', sizeof(long_cmd) - 1);
+  long_cmd[sizeof(long_cmd) - 1] = '\0';
+  aqua_at_cancel_queue(&client);
+  TEST_ASSERT_EQUAL(AT_OK,
+                    aqua_at_enqueue(&client, "AT", 500, false, NULL, NULL));
+  TEST_ASSERT_EQUAL(AT_ERR_BUFFER_FULL, aqua_at_enqueue(&client, long_cmd, 500,
+                                                        false, NULL, NULL));
+  TEST_ASSERT_EQUAL(1, aqua_at_queue_pending(&client));
+}
+
+void test_cancel_queue_drops_pending_commands(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+  reset_cmd_log();
+
+  aqua_at_enqueue(&client, "AT", 500, false, record_cmd, NULL);
+  aqua_at_enqueue(&client, "ATE0", 500, false, record_cmd, NULL);
+  aqua_at_cancel_queue(&client);
+  TEST_ASSERT_EQUAL(0, aqua_at_queue_pending(&client));
+
+  /* 已发出的命令照常结束，但不再回调，也不再发出后续命令 */
+  const char *rx = "OK\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_EQUAL(0, g_cmd_cb_calls);
+  TEST_ASSERT_EQUAL_STRING_LEN("AT\r\n", (char *)g_tx_buffer, g_tx_len);
+}
+
+void test_enqueue_without_callback_waits_for_reset(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  aqua_at_enqueue(&client, "AT", 500, false, NULL, NULL);
+  aqua_at_enqueue(&client, "ATE0", 500, false, NULL, NULL);
+
+  /* 无回调：与 aqua_at_begin 相同，由调用方读取结果并复位 */
+  const char *rx = "OK\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_OK, aqua_at_step(&client));
+  TEST_ASSERT_EQUAL(1, aqua_at_queue_pending(&client));
+
+  aqua_at_reset(&client);
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, client.state);
+  TEST_ASSERT_EQUAL_STRING_LEN("AT\r\nATE0\r\n", (char *)g_tx_buffer,
+                               g_tx_len);
+}
+
+void test_enqueue_prompt_pauses_queue_until_reset(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+  reset_cmd_log();
+
+  aqua_at_enqueue(&client, "AT+CIPSEND=0,3", 500, true, record_cmd, NULL);
+  aqua_at_enqueue(&client, "AT", 500, false, record_cmd, NULL);
+
+  const char *rx = "OK\r\n>";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_EQUAL(1, g_cmd_cb_calls);
+  TEST_ASSERT_EQUAL(AT_STATE_GOT_PROMPT, g_cmd_results[0]);
+  TEST_ASSERT_EQUAL(AT_STATE_GOT_PROMPT, aqua_at_step(&client));
+  TEST_ASSERT_EQUAL(1, aqua_at_queue_pending(&client));
+
+  aqua_at_reset(&client);
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, client.state);
+  TEST_ASSERT_EQUAL(0, aqua_at_queue_pending(&client));
+}
+
+/* ============================================================================
+ * 测试：自适应超时
+ * ============================================================================
+ */
+
+/* 在 now_ms 发出 cmd，经过 latency_ms 收到 OK 并复位 */
+static void run_cmd_with_latency(AtClient *client, const char *cmd,
+                                 uint32_t latency_ms) {
+  aqua_at_begin(client, cmd, 2000);
+  g_mock_time_ms += latency_ms;
+  const char *rx = "OK\r\n";
+  aqua_at_feed_rx(client, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_OK, client->state);
+  aqua_at_reset(client);
+}
+
+void test_timeout_tracks_measured_latency(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  /* 尚无样本：使用调用方给出的上限 */
+  TEST_ASSERT_EQUAL(2000,
+                    aqua_at_timeout_for(&client, AT_CMD_CLASS_LOCAL, 2000));
+
+  /* 首个样本 R = 400：SRTT = 400，RTTVAR = 200，超时 1200 */
+  run_cmd_with_latency(&client, "AT", 400);
+  TEST_ASSERT_EQUAL(1, client.rtt[AT_CMD_CLASS_LOCAL].samples);
+  TEST_ASSERT_EQUAL(1200,
+                    aqua_at_timeout_for(&client, AT_CMD_CLASS_LOCAL, 2000));
+
+  /* 相同延迟：RTTVAR 收敛到 150，超时 1000 */
+  run_cmd_with_latency(&client, "ATE0", 400);
+  TEST_ASSERT_EQUAL(1000,
+                    aqua_at_timeout_for(&client, AT_CMD_CLASS_LOCAL, 2000));
+
+  /* 延迟很小时不低于下限，也不超过上限 */
+  for (int i = 0; i < 16; ++i) {
+    run_cmd_with_latency(&client, "AT", 5);
+  }
+  TEST_ASSERT_EQUAL(AT_RTO_MIN_MS,
+                    aqua_at_timeout_for(&client, AT_CMD_CLASS_LOCAL, 2000));
+  TEST_ASSERT_EQUAL(300,
+                    aqua_at_timeout_for(&client, AT_CMD_CLASS_LOCAL, 300));
+
+  /* 下一条命令按估计超时 */
+  g_mock_time_ms = 10000;
+  aqua_at_begin(&client, "AT", 2000);
+  TEST_ASSERT_EQUAL(AT_RTO_MIN_MS, client.cmd_timeout_ms);
+  g_mock_time_ms = 10000 + AT_RTO_MIN_MS;
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_TIMEOUT, aqua_at_step(&client));
+}
+
+void test_timeout_backs_off_until_next_sample(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+  run_cmd_with_latency(&client, "AT", 400); /* 超时 1200 */
+
+  /* 连续超时：不取样本，超时逐次翻倍，受上限约束 */
+  aqua_at_begin(&client, "AT", 3000);
+  TEST_ASSERT_EQUAL(1200, client.cmd_timeout_ms);
+  g_mock_time_ms += 1200;
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_TIMEOUT, aqua_at_step(&client));
+  aqua_at_reset(&client);
+  TEST_ASSERT_EQUAL(1, client.rtt[AT_CMD_CLASS_LOCAL].samples);
+  TEST_ASSERT_EQUAL(2400,
+                    aqua_at_timeout_for(&client, AT_CMD_CLASS_LOCAL, 3000));
+
+  aqua_at_begin(&client, "AT", 3000);
+  g_mock_time_ms += 2400;
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_TIMEOUT, aqua_at_step(&client));
+  aqua_at_reset(&client);
+  TEST_ASSERT_EQUAL(3000,
+                    aqua_at_timeout_for(&client, AT_CMD_CLASS_LOCAL, 3000));
+
+  /* 按时应答后退避清除 */
+  run_cmd_with_latency(&client, "AT", 400);
+  TEST_ASSERT_EQUAL(0, client.rtt[AT_CMD_CLASS_LOCAL].backoff);
+  TEST_ASSERT_TRUE(aqua_at_timeout_for(&client, AT_CMD_CLASS_LOCAL, 3000) <
+                   2400);
+}
+
+void test_timeout_classes_are_independent(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  run_cmd_with_latency(&client, "AT", 200);
+  run_cmd_with_latency(&client, "AT+MQTTCONN=0,\"h\",1883,1", 1500);
+  TEST_ASSERT_EQUAL(1, client.rtt[AT_CMD_CLASS_LOCAL].samples);
+  TEST_ASSERT_EQUAL(1, client.rtt[AT_CMD_CLASS_MQTT].samples);
+  TEST_ASSERT_EQUAL(4500,
+                    aqua_at_timeout_for(&client, AT_CMD_CLASS_MQTT, 10000));
+
+  /* 入网不做估计：始终使用上限 */
+  run_cmd_with_latency(&client, "AT+CWJAP=\"s\",\"p\"", 100);
+  aqua_at_begin(&client, "AT+CWJAP=\"s\",\"p\"", 35000);
+  TEST_ASSERT_EQUAL(35000, client.cmd_timeout_ms);
+}
+
+void test_slow_config_commands_keep_caller_timeout(void) {
+  static const char *const slow_cmds[] = {
+      "AT+CWMODE=3", "AT+CWSAP=\"Aquarium_Setup\",\"12345678\",1,3",
+      "AT+CIPSERVER=1,80", "AT+MQTTUSERCFG=0,1,\"c\",\"u\",\"p\",0,0,\"\""};
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  /* 大量立即应答的样本把 LOCAL 的估计压到下限 */
+  for (int i = 0; i < 16; ++i) {
+    run_cmd_with_latency(&client, "AT", 5);
+  }
+  TEST_ASSERT_EQUAL(AT_RTO_MIN_MS,
+                    aqua_at_timeout_for(&client, AT_CMD_CLASS_LOCAL, 2000));
+
+  /* 慢命令不受影响：700 ms 后的应答仍按时完成 */
+  for (size_t i = 0; i < sizeof(slow_cmds) / sizeof(slow_cmds[0]); ++i) {
+    aqua_at_begin(&client, slow_cmds[i], 2000);
+    TEST_ASSERT_EQUAL(2000, client.cmd_timeout_ms);
+    g_mock_time_ms += 700;
+    TEST_ASSERT_EQUAL(AT_STATE_WAITING, aqua_at_step(&client));
+    const char *rx = "OK\r\n";
+    aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+    TEST_ASSERT_EQUAL(AT_STATE_DONE_OK, aqua_at_step(&client));
+    aqua_at_reset(&client);
+  }
+  TEST_ASSERT_EQUAL(4, client.stats.cmd[AT_CMD_CLASS_CONFIG].ok);
+  TEST_ASSERT_EQUAL(0, client.rtt[AT_CMD_CLASS_CONFIG].samples);
+}
+
+void test_prompt_wait_is_estimated_and_times_out_early(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  /* 首个样本前使用调用方的上限 */
+  aqua_at_begin_with_prompt(&client, "AT+MQTTPUBRAW=0,\"t\",2,0,0", 10000);
+  TEST_ASSERT_EQUAL(AT_CMD_CLASS_PROMPT, client.cmd_class);
+  TEST_ASSERT_EQUAL(10000, client.cmd_timeout_ms);
+  aqua_at_reset(&client);
+
+  /* '>' 由模组立即给出：样本只计到提示符为止 */
+  for (int i = 0; i < 8; ++i) {
+    aqua_at_begin_with_prompt(&client, "AT+MQTTPUBRAW=0,\"t\",2,0,0",
+                              10000);
+    g_mock_time_ms += 20;
+    const char *rx = "OK\r\n>";
+    aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+    TEST_ASSERT_EQUAL(AT_STATE_GOT_PROMPT, client.state);
+    aqua_at_reset(&client);
+  }
+  TEST_ASSERT_EQUAL(8, client.rtt[AT_CMD_CLASS_PROMPT].samples);
+  TEST_ASSERT_EQUAL(8, client.stats.cmd[AT_CMD_CLASS_PROMPT].ok);
+
+  /* 模组卡死：在估计的超时（下限）处结束，而不是等满 10 s */
+  aqua_at_begin_with_prompt(&client, "AT+MQTTPUBRAW=0,\"t\",2,0,0", 10000);
+  TEST_ASSERT_EQUAL(AT_RTO_MIN_MS, client.cmd_timeout_ms);
+  g_mock_time_ms += AT_RTO_MIN_MS - 1;
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, aqua_at_step(&client));
+  g_mock_time_ms += 1;
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_TIMEOUT, aqua_at_step(&client));
+  TEST_ASSERT_EQUAL(1, client.stats.cmd[AT_CMD_CLASS_PROMPT].timeout);
+  aqua_at_reset(&client);
+
+  /* AT+CIPSEND 同属此类 */
+  aqua_at_begin_with_prompt(&client, "AT+CIPSEND=0,2", 5000);
+  TEST_ASSERT_EQUAL(AT_CMD_CLASS_PROMPT, client.cmd_class);
+}
+
+void test_await_result_and_complete_keep_publish_timeout_fixed(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  aqua_at_begin_with_prompt(&client, "AT+MQTTPUBRAW=0,\"t\",2,0,0", 10000);
+  const char *rx = "OK\r\n>";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_EQUAL(AT_STATE_GOT_PROMPT, client.state);
+  aqua_at_send_data(&client, (const uint8_t *)"{}", 2);
+
+  aqua_at_await_result(&client, AT_CMD_CLASS_PUBLISH, 15000);
+  TEST_ASSERT_EQUAL(AT_STATE_WAITING, client.state);
+  TEST_ASSERT_EQUAL(15000, client.cmd_timeout_ms);
+
+  /* 上层从 URC 判定结束：与收到 OK 等价，计入发布类别的统计 */
+  g_mock_time_ms += 300;
+  aqua_at_complete(&client, AT_STATE_DONE_OK);
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_OK, client.state);
+  TEST_ASSERT_EQUAL(1, client.stats.cmd[AT_CMD_CLASS_PUBLISH].ok);
+
+  /* 不在等待中时忽略 */
+  aqua_at_complete(&client, AT_STATE_DONE_ERROR);
+  TEST_ASSERT_EQUAL(AT_STATE_DONE_OK, client.state);
+  TEST_ASSERT_EQUAL(0, client.stats.cmd[AT_CMD_CLASS_PUBLISH].error);
+
+  /* 发布结果的等待不做估计：失败结果可能很晚才到 */
+  aqua_at_reset(&client);
+  aqua_at_await_result(&client, AT_CMD_CLASS_PUBLISH, 15000);
+  TEST_ASSERT_EQUAL(15000, client.cmd_timeout_ms);
+}
+
 /* ============================================================================
  * 测试：URC 队列
  * ============================================================================
@@ -347,6 +877,175 @@ void test_pop_line_empty_queue(void) {
   TEST_ASSERT_EQUAL(AT_ERR_NO_LINE, err);
 }
 
+void test_peek_and_consume_middle_line(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  const char *rx = "first\r\n+MQTTPUB:OK\r\nthird\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+
+  /* peek 不出队 */
+  AtLineView view;
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_peek_line(&client, 1, &view));
+  TEST_ASSERT_EQUAL_STRING("+MQTTPUB:OK", view.data);
+  TEST_ASSERT_EQUAL(11, view.len);
+  TEST_ASSERT_EQUAL(AT_ERR_NO_LINE, aqua_at_peek_line(&client, 3, &view));
+  TEST_ASSERT_EQUAL(3, client.urc_count);
+
+  /* 消费中间一行：其余行顺序不变，已取得的视图仍然有效 */
+  AtLineView first;
+  aqua_at_peek_line(&client, 0, &first);
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_consume_line(&client, 1));
+  TEST_ASSERT_EQUAL(2, client.urc_count);
+  TEST_ASSERT_EQUAL_STRING("first", first.data);
+  aqua_at_peek_line(&client, 1, &view);
+  TEST_ASSERT_EQUAL_STRING("third", view.data);
+
+  AtLine line;
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL_STRING("first", line.data);
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL_STRING("third", line.data);
+  TEST_ASSERT_EQUAL(AT_ERR_NO_LINE, aqua_at_consume_line(&client, 0));
+  TEST_ASSERT_EQUAL(0, client.urc_used); /* 空洞随之回收 */
+}
+
+void test_urc_arena_full_evicts_oldest_and_wraps(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  /* 每行占存储区 len + 1 字节：放满后挤掉最旧行，而不是截断新行 */
+  char rx[AT_LINE_MAX_LEN + 4];
+  size_t per_line = AT_URC_ARENA_SIZE / 3;
+  size_t fit = AT_URC_ARENA_SIZE / (per_line + 1);
+  for (size_t i = 0; i < fit + 2; ++i) {
+    memset(rx, (int)('a' + i), per_line);
+    memcpy(rx + per_line, "\r\n", 2);
+    aqua_at_feed_rx(&client, (const uint8_t *)rx, per_line + 2);
+  }
+
+  TEST_ASSERT_EQUAL(fit, client.urc_count);
+  for (size_t i = 0; i < fit; ++i) {
+    AtLineView view;
+    TEST_ASSERT_EQUAL(AT_OK, aqua_at_peek_line(&client, i, &view));
+    TEST_ASSERT_EQUAL(per_line, view.len);
+    TEST_ASSERT_EQUAL('a' + 2 + i, view.data[0]);
+    TEST_ASSERT_EQUAL('\0', view.data[per_line]);
+    TEST_ASSERT_TRUE(view.data >= client.urc_arena);
+    TEST_ASSERT_TRUE(view.data + per_line <
+                     client.urc_arena + AT_URC_ARENA_SIZE);
+  }
+}
+
+void test_urc_arena_full_preserves_priority_line(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  const char *ipd = "+IPD,0,5:hello\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)ipd, strlen(ipd));
+
+  /* 存储区放不下的普通长行被丢弃，最旧的 +IPD 保留 */
+  char rx[AT_LINE_MAX_LEN + 4];
+  memset(rx, 'x', AT_LINE_MAX_LEN);
+  memcpy(rx + AT_LINE_MAX_LEN, "\r\n", 2);
+  for (int i = 0; i < 4; ++i) {
+    aqua_at_feed_rx(&client, (const uint8_t *)rx, AT_LINE_MAX_LEN + 2);
+  }
+
+  AtLineView view;
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_peek_line(&client, 0, &view));
+  TEST_ASSERT_EQUAL_STRING("+IPD,0,5:hello", view.data);
+  TEST_ASSERT_TRUE(client.urc_count < 5);
+}
+
+/* ============================================================================
+ * 测试：URC 分类与处理回调
+ * ============================================================================
+ */
+
+void test_urc_lines_are_tagged_at_ingest(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  static const struct {
+    const char *line;
+    AtUrcType type;
+  } cases[] = {
+      {"+IPD,0,3:abc", AT_URC_IPD},
+      {"+MQTTSUBRECV:0,\"t\"", AT_URC_MQTT_SUBRECV},
+      {"+MQTTPUB:OK", AT_URC_MQTT_PUB_OK},
+      {"+MQTTPUB:FAIL", AT_URC_MQTT_PUB_FAIL},
+      {"SEND OK", AT_URC_SEND_OK},
+      {"SEND FAIL", AT_URC_SEND_FAIL},
+      {"+CIPSNTPTIME:Thu Oct 16 08:00:00 2025", AT_URC_SNTP_TIME},
+      {"+MQTTPUB:", AT_URC_UNKNOWN},
+      {"+MQTTCONNECTED:0", AT_URC_UNKNOWN},
+      {"+IP", AT_URC_UNKNOWN},
+      {"SEND", AT_URC_UNKNOWN},
+      {"WIFI GOT IP", AT_URC_UNKNOWN},
+  };
+  size_t n = sizeof(cases) / sizeof(cases[0]);
+
+  /* 分两批喂入，避免超过队列容量 */
+  for (size_t base = 0; base < n; base += AT_URC_QUEUE_SIZE) {
+    size_t end = (base + AT_URC_QUEUE_SIZE < n) ? base + AT_URC_QUEUE_SIZE : n;
+    for (size_t i = base; i < end; ++i) {
+      aqua_at_feed_rx(&client, (const uint8_t *)cases[i].line,
+                      strlen(cases[i].line));
+      aqua_at_feed_rx(&client, (const uint8_t *)"\r\n", 2);
+    }
+    for (size_t i = base; i < end; ++i) {
+      AtLine line;
+      TEST_ASSERT_EQUAL(AT_OK, aqua_at_pop_line(&client, &line));
+      TEST_ASSERT_EQUAL_STRING(cases[i].line, line.data);
+      TEST_ASSERT_EQUAL_MESSAGE(cases[i].type, line.type, cases[i].line);
+    }
+  }
+}
+
+static int g_handler_calls = 0;
+static bool g_handler_consume = false;
+static AtLineView g_handler_last;
+
+static bool count_handler(const AtLineView *line, void *user_data) {
+  g_handler_calls++;
+  g_handler_last = *line;
+  *(int *)user_data += 1;
+  return g_handler_consume;
+}
+
+void test_urc_handler_dispatch_by_type(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+  int user = 0;
+  g_handler_calls = 0;
+
+  aqua_at_set_urc_handler(&client, AT_URC_SEND_OK, count_handler, &user);
+  aqua_at_set_urc_handler(&client, AT_URC_TYPE_COUNT, count_handler, &user);
+
+  /* 回调返回 true：行已处理，不入队 */
+  g_handler_consume = true;
+  const char *rx = "SEND OK\r\nSEND FAIL\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_EQUAL(1, g_handler_calls);
+  TEST_ASSERT_EQUAL(1, user);
+  TEST_ASSERT_EQUAL(AT_URC_SEND_OK, g_handler_last.type);
+  TEST_ASSERT_EQUAL(7, g_handler_last.len);
+  TEST_ASSERT_EQUAL(1, client.urc_count);
+
+  /* 回调返回 false：照常入队 */
+  g_handler_consume = false;
+  aqua_at_feed_rx(&client, (const uint8_t *)"SEND OK\r\n", 9);
+  TEST_ASSERT_EQUAL(2, g_handler_calls);
+  TEST_ASSERT_EQUAL(2, client.urc_count);
+
+  /* 取消注册 */
+  aqua_at_set_urc_handler(&client, AT_URC_SEND_OK, NULL, NULL);
+  aqua_at_feed_rx(&client, (const uint8_t *)"SEND OK\r\n", 9);
+  TEST_ASSERT_EQUAL(2, g_handler_calls);
+  TEST_ASSERT_EQUAL(3, client.urc_count);
+}
+
 /* ============================================================================
  * 测试：行过长
  * ============================================================================
@@ -375,6 +1074,255 @@ void test_line_too_long_truncated(void) {
   TEST_ASSERT_EQUAL(AT_LINE_MAX_LEN, line.len);
 }
 
+void test_line_too_long_across_spans(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  /* 超长行跨两段：截断位置与单段一致，下一行不受影响 */
+  static const char tail[] = "\r\nOK\r\n";
+  char rx[AT_LINE_MAX_LEN + 8 + sizeof(tail) - 1];
+  memset(rx, 'B', AT_LINE_MAX_LEN + 8);
+  memcpy(rx + AT_LINE_MAX_LEN + 8, tail, sizeof(tail) - 1);
+  size_t half = AT_LINE_MAX_LEN / 2 + 3;
+
+  TEST_ASSERT_EQUAL(AT_ERR_LINE_TOO_LONG,
+                    aqua_at_feed_rx_spans(&client, (const uint8_t *)rx, half,
+                                          (const uint8_t *)rx + half,
+                                          sizeof(rx) - half));
+
+  AtLine line;
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL(AT_LINE_MAX_LEN, line.len);
+  TEST_ASSERT_EQUAL('B', line.data[AT_LINE_MAX_LEN - 1]);
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL_STRING("OK", line.data);
+}
+
+/* ============================================================================
+ * 测试：+MQTTSUBRECV 原始捕获
+ * ============================================================================
+ */
+
+void test_subrecv_payload_captured_raw_with_crlf(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  /* payload 内含 CRLF，按长度捕获而不是按行切分；之后的行照常解析 */
+  const char *rx = "+MQTTSUBRECV:0,\"a/b\",9,{\"x\":\r\n1}\r\nOK\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+
+  TEST_ASSERT_EQUAL(2, client.urc_count);
+  AtLine line;
+  size_t len = 0;
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL_STRING("+MQTTSUBRECV:0,\"a/b\",9,", line.data);
+  const char *payload = aqua_at_get_raw_payload(&client, line.raw_id, &len);
+  TEST_ASSERT_NOT_NULL(payload);
+  TEST_ASSERT_EQUAL(9, len);
+  TEST_ASSERT_EQUAL_MEMORY("{\"x\":\r\n1}", payload, 9);
+
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL_STRING("OK", line.data);
+  TEST_ASSERT_NULL(aqua_at_get_raw_payload(&client, line.raw_id, &len));
+}
+
+void test_subrecv_payload_longer_than_line_arrives_intact(void) {
+  static char rx[AT_RAW_PAYLOAD_MAX_LEN + 64];
+  static char payload[AT_RAW_PAYLOAD_MAX_LEN];
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  for (size_t i = 0; i < sizeof(payload); ++i) {
+    payload[i] = (char)('a' + i % 26);
+  }
+  int n = snprintf(rx, sizeof(rx), "+MQTTSUBRECV:0,\"t\",%u,",
+                   (unsigned)sizeof(payload));
+  memcpy(rx + n, payload, sizeof(payload));
+  memcpy(rx + n + sizeof(payload), "\r\n", 2);
+  size_t total = (size_t)n + sizeof(payload) + 2;
+
+  /* 按小块喂入，头部与 payload 都跨越分片 */
+  for (size_t off = 0; off < total; off += 7) {
+    size_t chunk = (total - off < 7) ? total - off : 7;
+    TEST_ASSERT_EQUAL(AT_OK, aqua_at_feed_rx(&client, (const uint8_t *)rx + off,
+                                             chunk));
+  }
+
+  AtLine line;
+  size_t len = 0;
+  TEST_ASSERT_EQUAL(1, client.urc_count);
+  aqua_at_pop_line(&client, &line);
+  const char *got = aqua_at_get_raw_payload(&client, line.raw_id, &len);
+  TEST_ASSERT_NOT_NULL(got);
+  TEST_ASSERT_EQUAL(sizeof(payload), len);
+  TEST_ASSERT_EQUAL_MEMORY(payload, got, sizeof(payload));
+}
+
+void test_subrecv_falls_back_to_line_when_buffer_busy(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  const char *rx = "+MQTTSUBRECV:0,\"t\",3,abc\r\n"
+                   "+MQTTSUBRECV:0,\"t\",3,def\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+
+  /* 第一条仍在队列中：第二条按普通行保留 payload */
+  AtLine line;
+  size_t len = 0;
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL_STRING("abc",
+                           aqua_at_get_raw_payload(&client, line.raw_id, &len));
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL(0, line.raw_id);
+  TEST_ASSERT_EQUAL_STRING("+MQTTSUBRECV:0,\"t\",3,def", line.data);
+
+  /* 队列中已无引用：下一条重新按原始捕获，旧行不再对应 payload */
+  const char *rx2 = "+MQTTSUBRECV:0,\"t\",3,ghi\r\n";
+  AtLine old = line;
+  aqua_at_feed_rx(&client, (const uint8_t *)rx2, strlen(rx2));
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL_STRING("ghi",
+                           aqua_at_get_raw_payload(&client, line.raw_id, &len));
+  TEST_ASSERT_NULL(aqua_at_get_raw_payload(&client, old.raw_id, &len));
+}
+
+void test_subrecv_stalled_capture_delivered_on_timeout(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  const char *rx = "+MQTTSUBRECV:0,\"t\",50,{\"partial\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_FALSE(aqua_at_has_urc(&client));
+
+  g_mock_time_ms = AT_RAW_CAPTURE_TIMEOUT_MS - 1;
+  aqua_at_step(&client);
+  TEST_ASSERT_FALSE(aqua_at_has_urc(&client));
+
+  g_mock_time_ms = AT_RAW_CAPTURE_TIMEOUT_MS;
+  aqua_at_step(&client);
+  TEST_ASSERT_TRUE(aqua_at_has_urc(&client));
+
+  AtLine line;
+  size_t len = 0;
+  aqua_at_pop_line(&client, &line);
+  const char *payload = aqua_at_get_raw_payload(&client, line.raw_id, &len);
+  TEST_ASSERT_EQUAL(11, len);
+  TEST_ASSERT_EQUAL_MEMORY("{\"partial\r\n", payload, 11);
+
+  /* 之后回到行模式 */
+  const char *ok = "OK\r\n";
+  aqua_at_feed_rx(&client, (const uint8_t *)ok, strlen(ok));
+  aqua_at_pop_line(&client, &line);
+  TEST_ASSERT_EQUAL_STRING("OK", line.data);
+}
+
+/* ============================================================================
+ * 测试：运行统计
+ * ============================================================================
+ */
+
+void test_stats_count_results_and_latency_buckets(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  run_cmd_with_latency(&client, "AT", 5); /* 5 ms：桶 3 [4, 8) */
+
+  aqua_at_begin(&client, "ATE0", 2000);
+  const char *rx = "ERROR\r\n"; /* 0 ms：桶 0 */
+  aqua_at_feed_rx(&client, (const uint8_t *)rx, strlen(rx));
+  aqua_at_reset(&client);
+
+  aqua_at_begin(&client, "AT", 2000);
+  g_mock_time_ms += 2000;
+  aqua_at_step(&client);
+  aqua_at_reset(&client);
+
+  run_cmd_with_latency(&client, "AT+CWJAP=\"s\",\"p\"", 3000); /* 桶 12 */
+
+  const AtStats *stats = aqua_at_get_stats(&client);
+  const AtCmdStats *local = &stats->cmd[AT_CMD_CLASS_LOCAL];
+  TEST_ASSERT_EQUAL(1, local->ok);
+  TEST_ASSERT_EQUAL(1, local->error);
+  TEST_ASSERT_EQUAL(1, local->timeout);
+  TEST_ASSERT_EQUAL(1, local->latency_hist[0]);
+  TEST_ASSERT_EQUAL(1, local->latency_hist[3]);
+
+  const AtCmdStats *join = &stats->cmd[AT_CMD_CLASS_FIXED];
+  TEST_ASSERT_EQUAL(1, join->ok);
+  TEST_ASSERT_EQUAL(1, join->latency_hist[12]);
+
+  /* 超长延迟归入最后一桶 */
+  run_cmd_with_latency(&client, "AT+CWJAP=\"s\",\"p\"", 40000);
+  TEST_ASSERT_EQUAL(1, join->latency_hist[AT_LATENCY_HIST_BUCKETS - 1]);
+}
+
+void test_stats_latency_percentile(void) {
+  AtCmdStats stats;
+  memset(&stats, 0, sizeof(stats));
+  TEST_ASSERT_EQUAL(0, aqua_at_latency_percentile(&stats, 50));
+
+  stats.latency_hist[4] = 90; /* [8, 16) ms */
+  stats.latency_hist[9] = 10; /* [256, 512) ms */
+  TEST_ASSERT_EQUAL(15, aqua_at_latency_percentile(&stats, 50));
+  TEST_ASSERT_EQUAL(15, aqua_at_latency_percentile(&stats, 90));
+  TEST_ASSERT_EQUAL(511, aqua_at_latency_percentile(&stats, 99));
+
+  stats.latency_hist[AT_LATENCY_HIST_BUCKETS - 1] = 100;
+  TEST_ASSERT_EQUAL(UINT32_MAX, aqua_at_latency_percentile(&stats, 99));
+}
+
+void test_stats_count_line_overflow_once_and_urc_drops(void) {
+  AtClient client;
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  /* 一行超长，分多次到达也只计一次 */
+  char chunk[AT_LINE_MAX_LEN];
+  memset(chunk, 'x', sizeof(chunk));
+  aqua_at_feed_rx(&client, (const uint8_t *)chunk, sizeof(chunk));
+  aqua_at_feed_rx(&client, (const uint8_t *)chunk, sizeof(chunk));
+  aqua_at_feed_rx(&client, (const uint8_t *)"\r\n", 2);
+  TEST_ASSERT_EQUAL(1, client.stats.line_overflows);
+
+  for (int i = 0; i < AT_URC_QUEUE_SIZE + 2; i++) {
+    char line[32];
+    snprintf(line, sizeof(line), "URC%d\r\n", i);
+    aqua_at_feed_rx(&client, (const uint8_t *)line, strlen(line));
+  }
+  TEST_ASSERT_EQUAL(3, client.stats.urc_drops); /* 含开头的超长行 */
+}
+
+void test_stats_snapshot_resets_and_formats_json(void) {
+  AtClient client;
+  AtStats snap;
+  char json[512];
+  aqua_at_init(&client, mock_write, mock_now_ms);
+
+  run_cmd_with_latency(&client, "AT", 5);
+  run_cmd_with_latency(&client, "AT+MQTTSUB=0,\"t\",1", 0);
+  client.stats.urc_drops = 2;
+
+  aqua_at_stats_snapshot(&client, &snap, true);
+  TEST_ASSERT_EQUAL(1, snap.cmd[AT_CMD_CLASS_LOCAL].ok);
+  TEST_ASSERT_EQUAL(0, client.stats.cmd[AT_CMD_CLASS_LOCAL].ok);
+  TEST_ASSERT_EQUAL(0, client.stats.urc_drops);
+
+  size_t len = aqua_at_stats_to_json(&snap, json, sizeof(json));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"rx_overruns\":0,\"line_overflows\":0,\"urc_drops\":2,"
+      "\"fixed\":{\"ok\":0,\"error\":0,\"timeout\":0,\"hist\":[]},"
+      "\"local\":{\"ok\":1,\"error\":0,\"timeout\":0,\"hist\":[0,0,0,1]},"
+      "\"config\":{\"ok\":0,\"error\":0,\"timeout\":0,\"hist\":[]},"
+      "\"mqtt\":{\"ok\":1,\"error\":0,\"timeout\":0,\"hist\":[1]},"
+      "\"prompt\":{\"ok\":0,\"error\":0,\"timeout\":0,\"hist\":[]},"
+      "\"publish\":{\"ok\":0,\"error\":0,\"timeout\":0,\"hist\":[]}}",
+      json);
+  TEST_ASSERT_EQUAL(strlen(json), len);
+
+  /* 缓冲区不足时返回 0 */
+  TEST_ASSERT_EQUAL(0, aqua_at_stats_to_json(&snap, json, len));
+  TEST_ASSERT_EQUAL(len, aqua_at_stats_to_json(&snap, json, len + 1));
+}
+
 /* ============================================================================
  * 主函数
  * ============================================================================
@@ -390,12 +1338,18 @@ int main(void) {
   /* 命令发送测试 */
   RUN_TEST(test_at_begin_sends_command);
   RUN_TEST(test_at_begin_busy);
+  RUN_TEST(test_at_begin_writes_once);
+  RUN_TEST(test_at_begin_backpressure_resumes_in_step);
+  RUN_TEST(test_at_begin_queues_after_unsent_command);
+  RUN_TEST(test_at_send_data_backpressure);
 
   /* CRLF 行解析测试 */
   RUN_TEST(test_feed_rx_single_line_crlf);
   RUN_TEST(test_feed_rx_crlf_split_across_fragments);
   RUN_TEST(test_feed_rx_multiple_lines_at_once);
   RUN_TEST(test_feed_rx_empty_lines_ignored);
+  RUN_TEST(test_feed_rx_spans_match_bytewise_at_every_wrap);
+  RUN_TEST(test_feed_rx_spans_null_ptr);
 
   /* OK/ERROR 终止测试 */
   RUN_TEST(test_command_ok_response);
@@ -409,14 +1363,48 @@ int main(void) {
   /* 重置测试 */
   RUN_TEST(test_reset_to_idle);
 
+  /* 命令队列测试 */
+  RUN_TEST(test_enqueue_sends_next_as_soon_as_ok_arrives);
+  RUN_TEST(test_enqueue_timeout_completes_in_step);
+  RUN_TEST(test_enqueue_rejects_when_full);
+  RUN_TEST(test_cancel_queue_drops_pending_commands);
+  RUN_TEST(test_enqueue_without_callback_waits_for_reset);
+  RUN_TEST(test_enqueue_prompt_pauses_queue_until_reset);
+
+  /* 自适应超时测试 */
+  RUN_TEST(test_timeout_tracks_measured_latency);
+  RUN_TEST(test_timeout_backs_off_until_next_sample);
+  RUN_TEST(test_timeout_classes_are_independent);
+  RUN_TEST(test_slow_config_commands_keep_caller_timeout);
+  RUN_TEST(test_prompt_wait_is_estimated_and_times_out_early);
+  RUN_TEST(test_await_result_and_complete_keep_publish_timeout_fixed);
+
   /* URC 队列测试 */
   RUN_TEST(test_urc_queue_overflow);
   RUN_TEST(test_urc_queue_overflow_preserves_ipd_line);
   RUN_TEST(test_urc_queue_overflow_preserves_mqttpub_result_line);
   RUN_TEST(test_pop_line_empty_queue);
+  RUN_TEST(test_peek_and_consume_middle_line);
+  RUN_TEST(test_urc_arena_full_evicts_oldest_and_wraps);
+  RUN_TEST(test_urc_arena_full_preserves_priority_line);
+  RUN_TEST(test_urc_lines_are_tagged_at_ingest);
+  RUN_TEST(test_urc_handler_dispatch_by_type);
 
   /* 行过长测试 */
   RUN_TEST(test_line_too_long_truncated);
+  RUN_TEST(test_line_too_long_across_spans);
+
+  /* +MQTTSUBRECV 原始捕获 */
+  RUN_TEST(test_subrecv_payload_captured_raw_with_crlf);
+  RUN_TEST(test_subrecv_payload_longer_than_line_arrives_intact);
+  RUN_TEST(test_subrecv_falls_back_to_line_when_buffer_busy);
+  RUN_TEST(test_subrecv_stalled_capture_delivered_on_timeout);
+
+  /* 运行统计 */
+  RUN_TEST(test_stats_count_results_and_latency_buckets);
+  RUN_TEST(test_stats_latency_percentile);
+  RUN_TEST(test_stats_count_line_overflow_once_and_urc_drops);
+  RUN_TEST(test_stats_snapshot_resets_and_formats_json);
 
   return UNITY_END();
 }
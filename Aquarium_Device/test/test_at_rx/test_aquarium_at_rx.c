@@ -0,0 +1,201 @@
+/**
+ * @file test_aquarium_at_rx.c
+ * @brief UART DMA 循环接收环单元测试
+ */
+
+#include "aquarium_at_rx.h"
+#include <string.h>
+#include <unity.h>
+
+#define TEST_RING_SIZE 16
+
+static uint8_t g_dma_buf[TEST_RING_SIZE];
+static uint32_t g_dma_pos = 0;
+static AtRxRing g_ring;
+
+static size_t mock_write(const uint8_t *data, size_t len) {
+  (void)data;
+  return len;
+}
+
+static uint32_t mock_now_ms(void) { return 0; }
+
+/*
+ * 模拟 DMA 循环写入：逐字节写入缓冲区，经过半满/全满位置时
+ * 产生对应事件，最后在 idle 为 true 时产生一次 IDLE 事件
+ */
+static void dma_receive(const char *data, bool idle) {
+  for (size_t i = 0; data[i] != '\0'; ++i) {
+    g_dma_buf[g_dma_pos] = (uint8_t)data[i];
+    g_dma_pos++;
+    if (g_dma_pos == TEST_RING_SIZE / 2) {
+      aqua_at_rx_on_dma(&g_ring, g_dma_pos); /* 半满 */
+    } else if (g_dma_pos == TEST_RING_SIZE) {
+      aqua_at_rx_on_dma(&g_ring, g_dma_pos); /* 全满 */
+      g_dma_pos = 0;
+    }
+  }
+  if (idle) {
+    aqua_at_rx_on_dma(&g_ring, g_dma_pos);
+  }
+}
+
+void setUp(void) {
+  memset(g_dma_buf, 0, sizeof(g_dma_buf));
+  g_dma_pos = 0;
+  TEST_ASSERT_EQUAL(AT_OK,
+                    aqua_at_rx_init(&g_ring, g_dma_buf, TEST_RING_SIZE));
+}
+
+void tearDown(void) {}
+
+/* ============================================================================
+ * 测试：初始化
+ * ============================================================================
+ */
+
+void test_rx_init_rejects_bad_args(void) {
+  AtRxRing ring;
+  uint8_t buf[12];
+
+  TEST_ASSERT_EQUAL(AT_ERR_NULL_PTR, aqua_at_rx_init(NULL, buf, 8));
+  TEST_ASSERT_EQUAL(AT_ERR_NULL_PTR, aqua_at_rx_init(&ring, NULL, 8));
+  TEST_ASSERT_EQUAL(AT_ERR_BUFFER_FULL, aqua_at_rx_init(&ring, buf, 0));
+  TEST_ASSERT_EQUAL(AT_ERR_BUFFER_FULL, aqua_at_rx_init(&ring, buf, 12));
+}
+
+/* ============================================================================
+ * 测试：数据段
+ * ============================================================================
+ */
+
+void test_rx_idle_publishes_span(void) {
+  AtRxSpans spans;
+
+  dma_receive("OK\r\n", false);
+  TEST_ASSERT_EQUAL(0, aqua_at_rx_peek(&g_ring, &spans)); /* 尚无事件 */
+
+  aqua_at_rx_on_dma(&g_ring, g_dma_pos); /* IDLE */
+  TEST_ASSERT_EQUAL(4, aqua_at_rx_peek(&g_ring, &spans));
+  TEST_ASSERT_EQUAL_PTR(g_dma_buf, spans.first);
+  TEST_ASSERT_EQUAL(4, spans.first_len);
+  TEST_ASSERT_EQUAL(0, spans.second_len);
+
+  /* peek 不消费 */
+  TEST_ASSERT_EQUAL(4, aqua_at_rx_peek(&g_ring, &spans));
+  aqua_at_rx_consume(&g_ring, 4);
+  TEST_ASSERT_EQUAL(0, aqua_at_rx_peek(&g_ring, &spans));
+}
+
+void test_rx_wrap_yields_two_spans(void) {
+  AtRxSpans spans;
+
+  dma_receive("0123456789ab", true);
+  aqua_at_rx_consume(&g_ring, 12);
+
+  dma_receive("cdefghij", true); /* 4 字节到末尾 + 4 字节回绕 */
+  TEST_ASSERT_EQUAL(8, aqua_at_rx_peek(&g_ring, &spans));
+  TEST_ASSERT_EQUAL_PTR(g_dma_buf + 12, spans.first);
+  TEST_ASSERT_EQUAL(4, spans.first_len);
+  TEST_ASSERT_EQUAL_PTR(g_dma_buf, spans.second);
+  TEST_ASSERT_EQUAL(4, spans.second_len);
+  TEST_ASSERT_EQUAL_MEMORY("cdef", spans.first, 4);
+  TEST_ASSERT_EQUAL_MEMORY("ghij", spans.second, 4);
+}
+
+void test_rx_full_then_idle_counts_once(void) {
+  AtRxSpans spans;
+
+  /* 恰好写满一圈：全满事件之后紧跟的 IDLE 不重复计数 */
+  dma_receive("0123456789abcdef", true);
+  TEST_ASSERT_EQUAL(16, aqua_at_rx_peek(&g_ring, &spans));
+  TEST_ASSERT_EQUAL(16, spans.first_len);
+  TEST_ASSERT_EQUAL(0, g_ring.overruns);
+}
+
+void test_rx_overrun_drops_and_resyncs(void) {
+  AtRxSpans spans;
+
+  dma_receive("0123456789abcdef", false);
+  dma_receive("XYZ\r\n", true); /* 覆盖了未读数据 */
+
+  TEST_ASSERT_EQUAL(0, aqua_at_rx_peek(&g_ring, &spans));
+  TEST_ASSERT_EQUAL(1, g_ring.overruns);
+
+  dma_receive("OK\r\n", true);
+  TEST_ASSERT_EQUAL(4, aqua_at_rx_peek(&g_ring, &spans));
+  TEST_ASSERT_EQUAL_MEMORY("OK\r\n", spans.first, 4);
+}
+
+void test_rx_counter_wraps_around_32_bits(void) {
+  AtRxSpans spans;
+
+  /* 计数接近 2^32 时（长期运行）仍能正确计算可读字节 */
+  g_ring.written = 0xFFFFFFF8u;
+  g_ring.consumed = 0xFFFFFFF8u;
+  g_ring.dma_pos = 8;
+  g_dma_pos = 8;
+
+  dma_receive("abcdefghijkl", true);
+  TEST_ASSERT_EQUAL(12, aqua_at_rx_peek(&g_ring, &spans));
+  TEST_ASSERT_EQUAL_PTR(g_dma_buf + 8, spans.first);
+  TEST_ASSERT_EQUAL(8, spans.first_len);
+  TEST_ASSERT_EQUAL(4, spans.second_len);
+}
+
+/* ============================================================================
+ * 测试：喂给 AT 引擎
+ * ============================================================================
+ */
+
+void test_rx_feed_splits_lines_across_wrap(void) {
+  AtClient at;
+  AtLine line;
+  aqua_at_init(&at, mock_write, mock_now_ms);
+
+  dma_receive("+MQTTPUB:OK\r\n", true);
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_rx_feed(&g_ring, &at));
+  dma_receive("+IPD,0,3:abc\r\n", true); /* 跨越缓冲区末尾 */
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_rx_feed(&g_ring, &at));
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_rx_feed(&g_ring, &at)); /* 无新数据 */
+
+  TEST_ASSERT_EQUAL(2, at.urc_count);
+  aqua_at_pop_line(&at, &line);
+  TEST_ASSERT_EQUAL_STRING("+MQTTPUB:OK", line.data);
+  aqua_at_pop_line(&at, &line);
+  TEST_ASSERT_EQUAL_STRING("+IPD,0,3:abc", line.data);
+}
+
+void test_rx_feed_counts_overruns_in_client_stats(void) {
+  AtClient at;
+  aqua_at_init(&at, mock_write, mock_now_ms);
+
+  dma_receive("0123456789abcdef", false);
+  dma_receive("XYZ\r\n", true); /* 覆盖了未读数据 */
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_rx_feed(&g_ring, &at));
+  TEST_ASSERT_EQUAL(1, at.stats.rx_overruns);
+
+  dma_receive("OK\r\n", true);
+  TEST_ASSERT_EQUAL(AT_OK, aqua_at_rx_feed(&g_ring, &at));
+  TEST_ASSERT_EQUAL(1, at.stats.rx_overruns);
+}
+
+/* ============================================================================
+ * 主函数
+ * ============================================================================
+ */
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_rx_init_rejects_bad_args);
+  RUN_TEST(test_rx_idle_publishes_span);
+  RUN_TEST(test_rx_wrap_yields_two_spans);
+  RUN_TEST(test_rx_full_then_idle_counts_once);
+  RUN_TEST(test_rx_overrun_drops_and_resyncs);
+  RUN_TEST(test_rx_counter_wraps_around_32_bits);
+  RUN_TEST(test_rx_feed_splits_lines_across_wrap);
+  RUN_TEST(test_rx_feed_counts_overruns_in_client_stats);
+
+  return UNITY_END();
+}
@@ -0,0 +1,1067 @@
+/**
+ * @file test_bench.c
+ * @brief 协议层性能基准（native 环境）
+ *
+ * 使用 Unity 驱动，打印各路径的耗时；默认只断言输出一致、字节数、命令数等
+ * 确定性结果，耗时阈值见 BENCH_ASSERT_TIMING：
+ * - 命令解析耗时随 payload 长度线性增长
+ * - 真实 IoTDA 命令语料的解析耗时
+ * - 属性上报 JSON：整数格式化与 snprintf("%.2f") 的耗时对比
+ * - 预格式化上报帧：只改写槽位的耗时
+ * - CBOR 二进制上报：报文字节数与编码耗时对比 JSON
+ * - 列式遥测存储：按列扫描历史上报的吞吐
+ * - 对抗性输入：各下行解析器与 AT 行切分的单字节扫描步数上界（始终断言）
+ *   与单字节耗时
+ * - AT 接收：环形缓冲分段批量喂入与逐字节喂入的吞吐（字节/周期）
+ * - 启动到上线：同一命令队列代码下，两种主循环收取策略的模拟连接耗时
+ *
+ * 计时基于 clock()，每个测点重复执行直到累计足够长的时间，
+ * 取多轮中的最小值以降低调度抖动。
+ */
+
+#include "aquarium_app.h"
+#include "aquarium_at.h"
+#include "aquarium_cbor.h"
+#include "aquarium_esp32_mqtt.h"
+#include "aquarium_protocol.h"
+#include "aquarium_telemetry.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unity.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+void setUp(void) {}
+void tearDown(void) {}
+
+/* 单个测点的最短累计时间与重复轮数 */
+#define BENCH_MIN_CLOCKS (CLOCKS_PER_SEC / 20)
+#define BENCH_ROUNDS 5
+
+/*
+ * 宿主机挂钟耗时受调度、频率调节与编译选项影响，不适合作为默认的通过条件。
+ * 耗时比较只在定义 BENCH_ASSERT_TIMING 时断言，例如：
+ *   PLATFORMIO_BUILD_FLAGS=-DBENCH_ASSERT_TIMING \
+ *     pio test -e native -f test_bench
+ */
+#ifdef BENCH_ASSERT_TIMING
+#define BENCH_TIMING_ASSERT(cond) TEST_ASSERT_TRUE_MESSAGE((cond), #cond)
+#else
+#define BENCH_TIMING_ASSERT(cond) ((void)sizeof(cond)) /* 不求值 */
+#endif
+
+typedef void (*BenchFunc)(void *ctx);
+
+/* 返回单次调用的耗时（纳秒），取多轮最小值 */
+static double bench_ns_per_call(BenchFunc fn, void *ctx) {
+  double best = 0.0;
+
+  for (int round = 0; round < BENCH_ROUNDS; ++round) {
+    unsigned long iterations = 0;
+    clock_t start = clock();
+    clock_t elapsed = 0;
+    do {
+      for (int i = 0; i < 64; ++i) {
+        fn(ctx);
+      }
+      iterations += 64;
+      elapsed = clock() - start;
+    } while (elapsed < BENCH_MIN_CLOCKS);
+
+    double ns = ((double)elapsed * 1e9 / (double)CLOCKS_PER_SEC) /
+                (double)iterations;
+    if (round == 0 || ns < best) {
+      best = ns;
+    }
+  }
+
+  return best;
+}
+
+/*
+ * 每纳秒的 CPU 周期数（用 TSC 对 clock() 标定），用于把耗时换算为周期；
+ * 没有 TSC 的平台返回 0，只打印纳秒结果。
+ */
+static double bench_cycles_per_ns(void) {
+#ifdef BENCH_HAVE_TSC
+  clock_t start = clock();
+  unsigned long long tsc_start = __rdtsc();
+  clock_t elapsed = 0;
+  do {
+    elapsed = clock() - start;
+  } while (elapsed < BENCH_MIN_CLOCKS);
+  unsigned long long cycles = __rdtsc() - tsc_start;
+  return (double)cycles / ((double)elapsed * 1e9 / (double)CLOCKS_PER_SEC);
+#else
+  return 0.0;
+#endif
+}
+
+/* ============================================================================
+ * 命令解析：耗时随 payload 长度的增长
+ * ============================================================================
+ */
+
+typedef struct {
+  char json[1024];
+  size_t len;
+  ParsedCommand cmd;
+} ParseBenchCtx;
+
+static void bench_parse_command(void *ctx) {
+  ParseBenchCtx *c = (ParseBenchCtx *)ctx;
+  (void)aqua_parse_command_json(c->json, c->len, &c->cmd);
+}
+
+/*
+ * 生成 set_thresholds 命令：13 个真实字段之前插入 filler_keys 个未知键，
+ * 模拟平台侧附带的扩展参数，使 payload 长度近似按 filler_keys 线性增长。
+ */
+static size_t build_threshold_payload(char *buf, size_t size,
+                                      int filler_keys) {
+  size_t len = (size_t)snprintf(buf, size,
+                                "{\"object_device_id\":\"bench_device\","
+                                "\"service_id\":\"aquarium_threshold\","
+                                "\"command_name\":\"set_thresholds\","
+                                "\"paras\":{");
+  for (int i = 0; i < filler_keys && len < size; ++i) {
+    len += (size_t)snprintf(buf + len, size - len, "\"ext_%02d\":%d,", i, i);
+  }
+  len += (size_t)snprintf(
+      buf + len, size - len,
+      "\"temp_min\":24.0,\"temp_max\":28.0,\"ph_min\":6.5,\"ph_max\":7.5,"
+      "\"tds_warn\":500,\"tds_critical\":800,\"turbidity_warn\":30,"
+      "\"turbidity_critical\":50,\"level_min\":20,\"level_max\":95,"
+      "\"feed_interval\":12,\"feed_amount\":\"2\",\"target_temp\":26.5}}");
+  return len;
+}
+
+void test_bench_parse_command_scales_linearly(void) {
+  static const int filler_steps[] = {0, 12, 24, 36, 48};
+  static ParseBenchCtx ctx;
+  double ns_per_byte[sizeof(filler_steps) / sizeof(filler_steps[0])];
+  char msg[128];
+
+  for (size_t i = 0; i < sizeof(filler_steps) / sizeof(filler_steps[0]);
+       ++i) {
+    ctx.len = build_threshold_payload(ctx.json, sizeof(ctx.json),
+                                      filler_steps[i]);
+    TEST_ASSERT_TRUE(ctx.len < sizeof(ctx.json));
+    TEST_ASSERT_EQUAL(AQUA_OK,
+                      aqua_parse_command_json(ctx.json, ctx.len, &ctx.cmd));
+    TEST_ASSERT_TRUE(ctx.cmd.params.threshold.has_target_temp);
+
+    double ns = bench_ns_per_call(bench_parse_command, &ctx);
+    ns_per_byte[i] = ns / (double)ctx.len;
+
+    snprintf(msg, sizeof(msg), "parse_command %4u B: %8.1f ns/call %6.2f ns/B",
+             (unsigned)ctx.len, ns, ns_per_byte[i]);
+    TEST_MESSAGE(msg);
+  }
+
+  /* 线性：最长 payload 的单字节耗时不应显著高于最短 payload */
+  size_t last = sizeof(filler_steps) / sizeof(filler_steps[0]) - 1;
+  BENCH_TIMING_ASSERT(ns_per_byte[last] < ns_per_byte[0] * 2.0);
+}
+
+/* ============================================================================
+ * 命令解析：真实 IoTDA 命令语料
+ * ============================================================================
+ */
+
+/* 按 docs/Interface.MD 1.3 节及运维常用的单项设置整理 */
+static const struct {
+  const char *json;
+  CommandType type;
+} COMMAND_CORPUS[] = {
+    {"{\"object_device_id\":\"690237639798273cc4fd09cb_MyAquarium_01\","
+     "\"service_id\":\"aquarium_control\",\"command_name\":\"control\","
+     "\"paras\":{\"heater\":true,\"pump_in\":false,\"pump_out\":false,"
+     "\"mute\":false,\"auto_mode\":true,\"feed\":false,"
+     "\"feed_once_delay\":600,\"target_temp\":26.0}}",
+     COMMAND_TYPE_CONTROL},
+    {"{\"object_device_id\":\"690237639798273cc4fd09cb_MyAquarium_01\","
+     "\"service_id\":\"aquarium_control\",\"command_name\":\"control\","
+     "\"paras\":{\"heater\":false}}",
+     COMMAND_TYPE_CONTROL},
+    {"{\"object_device_id\":\"690237639798273cc4fd09cb_MyAquarium_01\","
+     "\"service_id\":\"aquarium_control\",\"command_name\":\"control\","
+     "\"paras\":{\"feed\":true}}",
+     COMMAND_TYPE_CONTROL},
+    {"{\"object_device_id\":\"690237639798273cc4fd09cb_MyAquarium_01\","
+     "\"service_id\":\"aquarium_control\",\"command_name\":\"control\","
+     "\"paras\":{\"target_temp\":25.5,\"auto_mode\":true}}",
+     COMMAND_TYPE_CONTROL},
+    {"{\"object_device_id\":\"690237639798273cc4fd09cb_MyAquarium_01\","
+     "\"service_id\":\"aquarium_threshold\",\"command_name\":"
+     "\"set_thresholds\",\"paras\":{\"temp_min\":24.0,\"temp_max\":28.0,"
+     "\"ph_min\":6.5,\"ph_max\":7.5,\"tds_warn\":500,\"tds_critical\":800,"
+     "\"turbidity_warn\":30,\"turbidity_critical\":50,\"level_min\":20,"
+     "\"level_max\":95,\"feed_interval\":12,\"feed_amount\":\"2\"}}",
+     COMMAND_TYPE_SET_THRESHOLDS},
+    {"{\"object_device_id\":\"690237639798273cc4fd09cb_MyAquarium_01\","
+     "\"service_id\":\"aquarium_threshold\",\"command_name\":"
+     "\"set_thresholds\",\"paras\":{\"temp_deadband\":0.2,"
+     "\"ph_deadband\":0.05,\"level_deadband\":2}}",
+     COMMAND_TYPE_SET_THRESHOLDS},
+    {"{\"object_device_id\":\"690237639798273cc4fd09cb_MyAquarium_01\","
+     "\"service_id\":\"aquariumConfig\",\"command_name\":\"set_config\","
+     "\"paras\":{\"wifi_ssid\":\"MyWiFi\",\"wifi_password\":\"password123\","
+     "\"ph_offset\":0.15,\"tds_factor\":1.02}}",
+     COMMAND_TYPE_SET_CONFIG},
+    {"{\"object_device_id\":\"690237639798273cc4fd09cb_MyAquarium_01\","
+     "\"service_id\":\"aquariumConfig\",\"command_name\":\"set_config\","
+     "\"paras\":{\"ph_offset\":-0.08}}",
+     COMMAND_TYPE_SET_CONFIG},
+};
+
+#define COMMAND_CORPUS_COUNT (sizeof(COMMAND_CORPUS) / sizeof(COMMAND_CORPUS[0]))
+
+typedef struct {
+  size_t lens[COMMAND_CORPUS_COUNT];
+  ParsedCommand cmd;
+} CorpusBenchCtx;
+
+static void bench_parse_corpus(void *ctx) {
+  CorpusBenchCtx *c = (CorpusBenchCtx *)ctx;
+  for (size_t i = 0; i < COMMAND_CORPUS_COUNT; ++i) {
+    (void)aqua_parse_command_json(COMMAND_CORPUS[i].json, c->lens[i], &c->cmd);
+  }
+}
+
+void test_bench_parse_command_corpus(void) {
+  static CorpusBenchCtx ctx;
+  size_t total = 0;
+  char msg[128];
+
+  for (size_t i = 0; i < COMMAND_CORPUS_COUNT; ++i) {
+    ctx.lens[i] = strlen(COMMAND_CORPUS[i].json);
+    total += ctx.lens[i];
+    TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_command_json(COMMAND_CORPUS[i].json,
+                                                       ctx.lens[i], &ctx.cmd));
+    TEST_ASSERT_EQUAL(COMMAND_CORPUS[i].type, ctx.cmd.type);
+  }
+
+  double ns = bench_ns_per_call(bench_parse_corpus, &ctx);
+  snprintf(msg, sizeof(msg),
+           "parse_command corpus: %u cmds %u B %8.1f ns/cmd %6.2f ns/B",
+           (unsigned)COMMAND_CORPUS_COUNT, (unsigned)total,
+           ns / (double)COMMAND_CORPUS_COUNT, ns / (double)total);
+  TEST_MESSAGE(msg);
+}
+
+/* ============================================================================
+ * 属性上报：整数格式化 vs snprintf("%.2f")
+ * ============================================================================
+ */
+
+typedef struct {
+  AquariumProperties props;
+  char buf[512];
+  size_t len;
+} PropsBenchCtx;
+
+/* 改造前 aqua_build_properties_json 的 snprintf 实现，仅作对照 */
+static void bench_props_snprintf(void *ctx) {
+  PropsBenchCtx *c = (PropsBenchCtx *)ctx;
+  const AquariumProperties *p = &c->props;
+  int len = snprintf(
+      c->buf, sizeof(c->buf),
+      "{\"services\":[{\"service_id\":\"" SERVICE_ID_AQUARIUM "\","
+      "\"properties\":{\"temperature\":%.2f,\"ph\":%.2f,\"tds\":%.2f,"
+      "\"turbidity\":%.2f,\"water_level\":%.2f,\"heater\":%s,"
+      "\"pump_in\":%s,\"pump_out\":%s,\"auto_mode\":%s,"
+      "\"feed_countdown\":%d,\"feeding_in_progress\":%s,"
+      "\"alarm_level\":%d,\"alarm_muted\":%s}}]}",
+      (double)p->temperature, (double)p->ph, (double)p->tds,
+      (double)p->turbidity, (double)p->water_level,
+      p->heater ? "true" : "false", p->pump_in ? "true" : "false",
+      p->pump_out ? "true" : "false", p->auto_mode ? "true" : "false",
+      (int)p->feed_countdown, p->feeding_in_progress ? "true" : "false",
+      (int)p->alarm_level, p->alarm_muted ? "true" : "false");
+  c->len = (len > 0) ? (size_t)len : 0;
+}
+
+static void bench_props_fmt(void *ctx) {
+  PropsBenchCtx *c = (PropsBenchCtx *)ctx;
+  (void)aqua_build_properties_json(&c->props, c->buf, sizeof(c->buf),
+                                   &c->len);
+}
+
+void test_bench_properties_format(void) {
+  static PropsBenchCtx ctx = {.props = {.temperature = 26.37f,
+                                        .ph = 7.18f,
+                                        .tds = 352.6f,
+                                        .turbidity = 14.92f,
+                                        .water_level = 85.4f,
+                                        .heater = true,
+                                        .auto_mode = true,
+                                        .feed_countdown = 3600,
+                                        .alarm_level = 1}};
+  char ref[sizeof(ctx.buf)];
+  char msg[128];
+
+  /* 两条路径的输出必须逐字节一致 */
+  bench_props_snprintf(&ctx);
+  memcpy(ref, ctx.buf, sizeof(ref));
+  bench_props_fmt(&ctx);
+  TEST_ASSERT_EQUAL_STRING(ref, ctx.buf);
+
+  double ns_printf = bench_ns_per_call(bench_props_snprintf, &ctx);
+  double ns_fmt = bench_ns_per_call(bench_props_fmt, &ctx);
+
+  snprintf(msg, sizeof(msg),
+           "properties_json snprintf: %8.1f ns/call  aqua_fmt: %8.1f ns/call",
+           ns_printf, ns_fmt);
+  TEST_MESSAGE(msg);
+
+  BENCH_TIMING_ASSERT(ns_fmt < ns_printf);
+}
+
+typedef struct {
+  AquariumProperties props;
+  AquaReportFrame frame;
+  size_t len;
+} FrameBenchCtx;
+
+static void bench_report_frame(void *ctx) {
+  FrameBenchCtx *c = (FrameBenchCtx *)ctx;
+  (void)aqua_report_frame_update(&c->frame, &c->props, &c->len);
+}
+
+void test_bench_report_frame(void) {
+  static FrameBenchCtx frame_ctx;
+  static PropsBenchCtx props_ctx;
+  char msg[128];
+
+  frame_ctx.props = (AquariumProperties){.temperature = 26.37f,
+                                         .ph = 7.18f,
+                                         .tds = 352.6f,
+                                         .turbidity = 14.92f,
+                                         .water_level = 85.4f,
+                                         .heater = true,
+                                         .feed_countdown = 3600,
+                                         .alarm_level = 1};
+  props_ctx.props = frame_ctx.props;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_report_frame_init(&frame_ctx.frame));
+  size_t init_len = frame_ctx.frame.len;
+
+  double ns_build = bench_ns_per_call(bench_props_fmt, &props_ctx);
+  double ns_frame = bench_ns_per_call(bench_report_frame, &frame_ctx);
+
+  /* 帧长度固定；去掉槽位空白后与逐字段生成的 JSON 一致 */
+  char stripped[AQUA_REPORT_FRAME_MAX_LEN];
+  size_t n = 0;
+  for (size_t i = 0; i < frame_ctx.len; ++i) {
+    if (frame_ctx.frame.buf[i] != ' ') {
+      stripped[n++] = frame_ctx.frame.buf[i];
+    }
+  }
+  stripped[n] = '\0';
+  TEST_ASSERT_EQUAL(init_len, frame_ctx.len);
+  TEST_ASSERT_EQUAL_STRING(props_ctx.buf, stripped);
+
+  snprintf(msg, sizeof(msg),
+           "properties_json build: %8.1f ns/call  frame patch: %8.1f ns/call "
+           "(%u B)",
+           ns_build, ns_frame, (unsigned)frame_ctx.len);
+  TEST_MESSAGE(msg);
+
+  BENCH_TIMING_ASSERT(ns_frame < ns_build);
+}
+
+/* ============================================================================
+ * 属性上报：CBOR vs JSON
+ * ============================================================================
+ */
+
+/* 115200 8N1：每字节 10 个比特时间 */
+#define BENCH_UART_US_PER_BYTE (10.0 * 1e6 / 115200.0)
+
+typedef struct {
+  AquaPropertySample sample;
+  uint8_t buf[AQUA_CBOR_SAMPLE_MAX_LEN + 2];
+  size_t len;
+} CborBenchCtx;
+
+static void bench_props_cbor(void *ctx) {
+  CborBenchCtx *c = (CborBenchCtx *)ctx;
+  (void)aqua_build_properties_cbor(&c->sample, 1, c->buf, sizeof(c->buf),
+                                   &c->len);
+}
+
+void test_bench_properties_cbor(void) {
+  static PropsBenchCtx json_ctx;
+  static CborBenchCtx cbor_ctx;
+  char msg[160];
+
+  json_ctx.props = (AquariumProperties){.temperature = 26.37f,
+                                        .ph = 7.18f,
+                                        .tds = 352.6f,
+                                        .turbidity = 14.92f,
+                                        .water_level = 85.4f,
+                                        .heater = true,
+                                        .auto_mode = true,
+                                        .feed_countdown = 3600,
+                                        .alarm_level = 1};
+  cbor_ctx.sample.props = json_ctx.props;
+  cbor_ctx.sample.field_mask = AQUA_PROP_ALL;
+
+  bench_props_fmt(&json_ctx);
+  bench_props_cbor(&cbor_ctx);
+  TEST_ASSERT_TRUE(cbor_ctx.len > 0);
+
+  double ns_json = bench_ns_per_call(bench_props_fmt, &json_ctx);
+  double ns_cbor = bench_ns_per_call(bench_props_cbor, &cbor_ctx);
+
+  snprintf(msg, sizeof(msg),
+           "properties json: %3u B %6.2f ms@115200 %8.1f ns/call  "
+           "cbor: %3u B %6.2f ms@115200 %8.1f ns/call",
+           (unsigned)json_ctx.len,
+           json_ctx.len * BENCH_UART_US_PER_BYTE / 1000.0, ns_json,
+           (unsigned)cbor_ctx.len,
+           cbor_ctx.len * BENCH_UART_US_PER_BYTE / 1000.0, ns_cbor);
+  TEST_MESSAGE(msg);
+
+  /* 报文大小与往返解码结果是确定的，耗时对比仅供参考 */
+  AquaPropertySample decoded;
+  size_t count = 0;
+  TEST_ASSERT_TRUE(cbor_ctx.len * 4 < json_ctx.len);
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_properties_cbor(
+                                 cbor_ctx.buf, cbor_ctx.len, &decoded, 1,
+                                 &count));
+  TEST_ASSERT_EQUAL(1, count);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 352.6f, decoded.props.tds);
+  TEST_ASSERT_EQUAL(3600, decoded.props.feed_countdown);
+  BENCH_TIMING_ASSERT(ns_cbor < ns_json);
+}
+
+/* ============================================================================
+ * 列式遥测存储：按列扫描
+ * ============================================================================
+ */
+
+#define TM_BENCH_PATH "bench_telemetry.aqtm"
+#define TM_BENCH_ROWS (AQUA_TM_BLOCK_ROWS * 128u)
+
+typedef struct {
+  AquaTelemetryStore tm;
+  uint32_t t_begin;
+  uint32_t t_end;
+  double mean;
+} TmScanBenchCtx;
+
+/* 典型分析查询：时间窗口内的平均水温 */
+static void bench_tm_scan(void *ctx) {
+  TmScanBenchCtx *c = (TmScanBenchCtx *)ctx;
+  double sum = 0.0;
+  uint64_t n = 0;
+
+  for (uint64_t b = 0; b < aqua_tm_block_count(&c->tm); ++b) {
+    size_t rows = 0;
+    const uint32_t *time = aqua_tm_column(&c->tm, AQUA_TM_COL_TIME, b, &rows);
+    const float *temp =
+        aqua_tm_column(&c->tm, AQUA_PROP_BIT_TEMPERATURE, b, &rows);
+    for (size_t i = 0; i < rows; ++i) {
+      if (time[i] >= c->t_begin && time[i] < c->t_end) {
+        sum += temp[i];
+        n++;
+      }
+    }
+  }
+  c->mean = n ? sum / (double)n : 0.0;
+}
+
+void test_bench_telemetry_scan(void) {
+  static TmScanBenchCtx ctx;
+  char msg[128];
+
+  remove(TM_BENCH_PATH);
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_open(&ctx.tm, TM_BENCH_PATH));
+
+  /* 每 10 秒一条采样，温度在 24.00~27.99 之间循环 */
+  AquaPropertySample s = {.field_mask = AQUA_PROP_ALL};
+  clock_t start = clock();
+  for (uint32_t i = 0; i < TM_BENCH_ROWS; ++i) {
+    s.props.temperature = 24.0f + (float)(i % 400u) * 0.01f;
+    s.props.water_level = 80.0f;
+    s.event_time = 1760515200u + i * 10u;
+    TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_append(&ctx.tm, &s, 0));
+  }
+  double append_ns = ((double)(clock() - start) * 1e9 / CLOCKS_PER_SEC) /
+                     (double)TM_BENCH_ROWS;
+
+  ctx.t_begin = 1760515200u;
+  ctx.t_end = 1760515200u + TM_BENCH_ROWS * 10u;
+  double ns = bench_ns_per_call(bench_tm_scan, &ctx);
+  double rows_per_sec = (double)TM_BENCH_ROWS * 1e9 / ns;
+  TEST_ASSERT_FLOAT_WITHIN(0.01, 25.995, ctx.mean);
+
+  snprintf(msg, sizeof(msg),
+           "telemetry %u rows: append %6.1f ns/row, scan %8.1f Mrows/s",
+           (unsigned)TM_BENCH_ROWS, append_ns, rows_per_sec / 1e6);
+  TEST_MESSAGE(msg);
+
+  aqua_tm_close(&ctx.tm);
+  remove(TM_BENCH_PATH);
+
+  /* 分析工具要求每秒扫描百万级上报 */
+  BENCH_TIMING_ASSERT(rows_per_sec > 1e6);
+}
+
+/* ============================================================================
+ * 对抗性输入：单字节耗时上界
+ * ============================================================================
+ */
+
+/*
+ * 最坏情况语料：每类输入由一段填充成员撑到目标长度，再套进各解析器的
+ * 报文骨架。目标长度最大取 AT_LINE_MAX_LEN - 1，即一行 URC 能带进来的上限。
+ */
+typedef enum {
+  ADV_REPEATED_KEYS,   /* 同一个已知键重复出现 */
+  ADV_KEYS_IN_STRINGS, /* 字符串值里嵌着转义的键和括号 */
+  ADV_ESCAPE_RUN,      /* 一整段 \\ 转义 */
+  ADV_UNICODE_RUN,     /* 一整段 \u00XX 转义 */
+  ADV_DEEP_NESTING,    /* 深层嵌套数组 */
+  ADV_TRUNCATED,       /* 重复键报文截掉尾部 */
+  ADV_KIND_COUNT
+} AdvKind;
+
+static const char *const ADV_KIND_NAMES[ADV_KIND_COUNT] = {
+    "repeated_keys", "keys_in_strings", "escape_run",
+    "unicode_run",   "deep_nesting",    "truncated",
+};
+
+/* 下行解析器及其报文骨架：填充成员插在 head 与 tail 之间 */
+typedef enum {
+  ADV_PARSER_COMMAND,
+  ADV_PARSER_PROPERTIES,
+  ADV_PARSER_PROPERTIES_SET,
+  ADV_PARSER_OBJECT_DEVICE_ID,
+  ADV_PARSER_COUNT
+} AdvParser;
+
+static const struct {
+  const char *name;
+  const char *head;
+  const char *tail;
+} ADV_PARSERS[ADV_PARSER_COUNT] = {
+    {"command", "{\"service_id\":\"aquarium_control\","
+                "\"command_name\":\"control\",\"paras\":{",
+     "\"feed\":false}}"},
+    {"properties", "{\"services\":[{\"service_id\":\"Aquarium\","
+                   "\"properties\":{",
+     "\"temperature\":25.5}}]}"},
+    {"properties_set", "{\"services\":[{\"service_id\":\"Aquarium\","
+                       "\"properties\":{",
+     "\"pump_in\":false}}]}"},
+    {"object_device_id", "{", "\"object_device_id\":\"gw01_tank2\"}"},
+};
+
+static void adv_append(char *buf, size_t size, size_t *len, const char *s) {
+  size_t n = strlen(s);
+  if (*len + n < size) {
+    memcpy(buf + *len, s, n);
+    *len += n;
+  }
+}
+
+/* 用 unit 重复填满 [*len, limit)，不足一个 unit 的部分留空 */
+static void adv_repeat(char *buf, size_t limit, size_t *len, const char *unit) {
+  size_t n = strlen(unit);
+  while (*len + n <= limit) {
+    memcpy(buf + *len, unit, n);
+    *len += n;
+  }
+}
+
+static size_t adv_build(AdvParser parser, AdvKind kind, char *buf,
+                        size_t target) {
+  const char *tail = ADV_PARSERS[parser].tail;
+  size_t len = 0;
+  adv_append(buf, target, &len, ADV_PARSERS[parser].head);
+  size_t limit = target - strlen(tail);
+
+  switch (kind) {
+  case ADV_REPEATED_KEYS:
+  case ADV_TRUNCATED:
+    adv_repeat(buf, limit, &len, "\"heater\":true,");
+    break;
+  case ADV_KEYS_IN_STRINGS:
+    adv_repeat(buf, limit, &len,
+               "\"note\":\"\\\"heater\\\":true,\\\"paras\\\":{[\",");
+    break;
+  case ADV_ESCAPE_RUN:
+    adv_append(buf, target, &len, "\"note\":\"");
+    adv_repeat(buf, limit - 2, &len, "\\\\");
+    adv_append(buf, target, &len, "\",");
+    break;
+  case ADV_UNICODE_RUN:
+    adv_append(buf, target, &len, "\"note\":\"");
+    adv_repeat(buf, limit - 2, &len, "\\u0041");
+    adv_append(buf, target, &len, "\",");
+    break;
+  case ADV_DEEP_NESTING: {
+    size_t depth = (limit - len - 8) / 2;
+    adv_append(buf, target, &len, "\"note\":");
+    for (size_t i = 0; i < depth; ++i) {
+      buf[len++] = '[';
+    }
+    for (size_t i = 0; i < depth; ++i) {
+      buf[len++] = ']';
+    }
+    adv_append(buf, target, &len, ",");
+    break;
+  }
+  default:
+    break;
+  }
+
+  adv_append(buf, target + 1, &len, tail);
+  buf[len] = '\0';
+  return (kind == ADV_TRUNCATED) ? len * 2 / 3 : len;
+}
+
+typedef struct {
+  AdvParser parser;
+  char json[AT_LINE_MAX_LEN];
+  size_t len;
+  ParsedCommand cmd;
+  AquaPropertySample samples[2];
+  char id[64];
+} AdvBenchCtx;
+
+static void bench_adv_parse(void *ctx) {
+  AdvBenchCtx *c = (AdvBenchCtx *)ctx;
+  size_t count;
+
+  switch (c->parser) {
+  case ADV_PARSER_COMMAND:
+    (void)aqua_parse_command_json(c->json, c->len, &c->cmd);
+    break;
+  case ADV_PARSER_PROPERTIES:
+    (void)aqua_parse_properties_json(c->json, c->len, c->samples, 2, &count);
+    break;
+  case ADV_PARSER_PROPERTIES_SET:
+    (void)aqua_parse_properties_set_json(c->json, c->len, &c->cmd);
+    break;
+  default:
+    (void)aqua_extract_object_device_id(c->json, c->len, c->id,
+                                        sizeof(c->id));
+    break;
+  }
+}
+
+/*
+ * 线性由扫描步数保证：解析库在 UNIT_TEST 下累计检查的字符数，
+ * 每个对抗输入在两种长度下都不得超过 ADV_MAX_STEPS_PER_BYTE 倍输入长度。
+ * 耗时期望（BENCH_ASSERT_TIMING 时断言）：长度翻倍时单字节耗时基本不变，
+ * 且不超过真实命令语料的 ADV_MAX_NS_PER_BYTE_RATIO 倍（无病态常数）。
+ */
+#define ADV_SHORT_LEN ((AT_LINE_MAX_LEN - 1) / 2)
+#define ADV_LONG_LEN (AT_LINE_MAX_LEN - 1)
+#define ADV_MAX_STEPS_PER_BYTE 4
+#define ADV_MAX_NS_PER_BYTE_RATIO 8.0
+
+static double bench_corpus_ns_per_byte(void) {
+  static ParseBenchCtx ctx;
+  ctx.len = build_threshold_payload(ctx.json, sizeof(ctx.json), 0);
+  return bench_ns_per_call(bench_parse_command, &ctx) / (double)ctx.len;
+}
+
+void test_bench_adversarial_parse_is_linear(void) {
+  static AdvBenchCtx ctx;
+  char msg[160];
+  double ref = bench_corpus_ns_per_byte();
+
+  snprintf(msg, sizeof(msg), "adversarial reference: %6.2f ns/B", ref);
+  TEST_MESSAGE(msg);
+
+  for (int p = 0; p < ADV_PARSER_COUNT; ++p) {
+    for (int k = 0; k < ADV_KIND_COUNT; ++k) {
+      double ns_per_byte[2];
+      size_t lens[2];
+      uint32_t steps[2];
+      ctx.parser = (AdvParser)p;
+
+      for (int t = 0; t < 2; ++t) {
+        size_t target = t ? ADV_LONG_LEN : ADV_SHORT_LEN;
+        ctx.len = adv_build((AdvParser)p, (AdvKind)k, ctx.json, target);
+        TEST_ASSERT_TRUE(ctx.len <= target);
+        lens[t] = ctx.len;
+        aqua_json_scan_steps = 0;
+        bench_adv_parse(&ctx);
+        steps[t] = aqua_json_scan_steps;
+        ns_per_byte[t] =
+            bench_ns_per_call(bench_adv_parse, &ctx) / (double)ctx.len;
+      }
+
+      snprintf(msg, sizeof(msg),
+               "%-16s %-15s %3u B: %4u steps %6.2f ns/B  "
+               "%3u B: %4u steps %6.2f ns/B",
+               ADV_PARSERS[p].name, ADV_KIND_NAMES[k], (unsigned)lens[0],
+               (unsigned)steps[0], ns_per_byte[0], (unsigned)lens[1],
+               (unsigned)steps[1], ns_per_byte[1]);
+      TEST_MESSAGE(msg);
+
+      for (int t = 0; t < 2; ++t) {
+        TEST_ASSERT_TRUE_MESSAGE(steps[t] <= ADV_MAX_STEPS_PER_BYTE * lens[t],
+                                 msg);
+      }
+
+      BENCH_TIMING_ASSERT(ns_per_byte[1] < ns_per_byte[0] * 1.5);
+      BENCH_TIMING_ASSERT(ns_per_byte[1] < ref * ADV_MAX_NS_PER_BYTE_RATIO);
+    }
+  }
+}
+
+/* 截断与超长的 +MQTTSUBRECV 行：行切分同样按字节线性 */
+typedef struct {
+  AtClient at;
+  char rx[AT_LINE_MAX_LEN * 2];
+  size_t len;
+} AtFeedBenchCtx;
+
+static size_t mock_bench_write(const uint8_t *data, size_t len) {
+  (void)data;
+  return len;
+}
+
+static uint32_t mock_bench_now_ms(void) { return 0; }
+
+static void bench_at_feed(void *ctx) {
+  AtFeedBenchCtx *c = (AtFeedBenchCtx *)ctx;
+  (void)aqua_at_feed_rx(&c->at, (const uint8_t *)c->rx, c->len);
+  while (aqua_at_has_urc(&c->at)) {
+    AtLine line;
+    (void)aqua_at_pop_line(&c->at, &line);
+  }
+}
+
+/* 声明的长度远大于实际数据，行本身超过 AT_LINE_MAX_LEN 后才换行 */
+static size_t build_truncated_urc(char *buf, size_t target) {
+  size_t len = 0;
+  adv_append(buf, target, &len,
+             "+MQTTSUBRECV:0,\"$oc/devices/gw01/sys/commands/request_id=1\","
+             "99999999999999999999,{\"paras\":{");
+  adv_repeat(buf, target - 2, &len, "\"heater\":true,");
+  adv_append(buf, target + 1, &len, "\r\n");
+  return len;
+}
+
+void test_bench_adversarial_at_feed_is_linear(void) {
+  static AtFeedBenchCtx ctx;
+  double ns_per_byte[2];
+  size_t lens[2];
+  uint32_t steps[2];
+  char msg[128];
+
+  aqua_at_init(&ctx.at, mock_bench_write, mock_bench_now_ms);
+  for (int t = 0; t < 2; ++t) {
+    ctx.len = build_truncated_urc(ctx.rx, t ? sizeof(ctx.rx) - 1
+                                            : sizeof(ctx.rx) / 2);
+    lens[t] = ctx.len;
+    aqua_at_scan_steps = 0;
+    bench_at_feed(&ctx);
+    steps[t] = aqua_at_scan_steps;
+    ns_per_byte[t] = bench_ns_per_call(bench_at_feed, &ctx) / (double)ctx.len;
+  }
+
+  snprintf(msg, sizeof(msg),
+           "at_feed truncated urc: %4u / %4u steps, %6.2f / %6.2f ns/B",
+           (unsigned)steps[0], (unsigned)steps[1], ns_per_byte[0],
+           ns_per_byte[1]);
+  TEST_MESSAGE(msg);
+  for (int t = 0; t < 2; ++t) {
+    TEST_ASSERT_TRUE_MESSAGE(steps[t] <= ADV_MAX_STEPS_PER_BYTE * lens[t],
+                             msg);
+  }
+  BENCH_TIMING_ASSERT(ns_per_byte[1] < ns_per_byte[0] * 1.5);
+
+  /* 反复喂入超长行后行切分回到正常状态，下一行完整可读 */
+  static const char next[] = "+MQTTDISCONNECTED:0\r\n";
+  AtLine line;
+  aqua_at_feed_rx(&ctx.at, (const uint8_t *)next, sizeof(next) - 1);
+  TEST_ASSERT_TRUE(aqua_at_has_urc(&ctx.at));
+  aqua_at_pop_line(&ctx.at, &line);
+  TEST_ASSERT_EQUAL_STRING("+MQTTDISCONNECTED:0", line.data);
+}
+
+/* ============================================================================
+ * AT 接收：分段批量喂入 vs 逐字节喂入
+ * ============================================================================
+ */
+
+/* 与 main.c 的 UART RX 环形缓冲同尺寸，数据在中间回绕成两段 */
+#define BENCH_RX_RING_SIZE 2048
+#define BENCH_RX_WRAP_AT 1500
+
+typedef struct {
+  AtClient at;
+  uint8_t ring[BENCH_RX_RING_SIZE];
+  size_t len;
+} AtSpanBenchCtx;
+
+static void bench_at_drain(AtClient *at) {
+  while (aqua_at_has_urc(at)) {
+    AtLine line;
+    (void)aqua_at_pop_line(at, &line);
+  }
+}
+
+/* 取出全部行，累积行数与内容的 FNV-1a 摘要 */
+static size_t bench_at_digest(AtClient *at, uint32_t *digest) {
+  size_t lines = 0;
+  *digest = 2166136261u;
+  while (aqua_at_has_urc(at)) {
+    AtLine line;
+    (void)aqua_at_pop_line(at, &line);
+    for (size_t i = 0; i <= line.len; ++i) {
+      *digest = (*digest ^ (uint8_t)line.data[i]) * 16777619u;
+    }
+    lines++;
+  }
+  return lines;
+}
+
+static void bench_at_push_bytewise(AtSpanBenchCtx *c) {
+  for (size_t i = 0; i < c->len; ++i) {
+    uint8_t b = c->ring[(BENCH_RX_WRAP_AT + i) % BENCH_RX_RING_SIZE];
+    (void)aqua_at_feed_rx(&c->at, &b, 1);
+  }
+}
+
+static void bench_at_push_spans(AtSpanBenchCtx *c) {
+  size_t first = BENCH_RX_RING_SIZE - BENCH_RX_WRAP_AT;
+  (void)aqua_at_feed_rx_spans(&c->at, c->ring + BENCH_RX_WRAP_AT, first,
+                              c->ring, c->len - first);
+}
+
+static void bench_at_feed_bytewise(void *ctx) {
+  AtSpanBenchCtx *c = (AtSpanBenchCtx *)ctx;
+  bench_at_push_bytewise(c);
+  bench_at_drain(&c->at);
+}
+
+static void bench_at_feed_spans(void *ctx) {
+  AtSpanBenchCtx *c = (AtSpanBenchCtx *)ctx;
+  bench_at_push_spans(c);
+  bench_at_drain(&c->at);
+}
+
+/* 一次主循环攒下的典型下行：几条 +MQTTSUBRECV 命令夹杂短 URC */
+static size_t build_rx_burst(uint8_t *ring) {
+  char burst[BENCH_RX_RING_SIZE];
+  size_t len = 0;
+
+  for (size_t i = 0; i < COMMAND_CORPUS_COUNT && len < 1600; ++i) {
+    const char *payload = COMMAND_CORPUS[i].json;
+    len += (size_t)snprintf(
+        burst + len, sizeof(burst) - len,
+        "+MQTTSUBRECV:0,\"$oc/devices/gw01/sys/commands/request_id=%u\","
+        "%u,%s\r\nbusy p...\r\nOK\r\n",
+        (unsigned)i, (unsigned)strlen(payload), payload);
+  }
+  for (size_t i = 0; i < len; ++i) {
+    ring[(BENCH_RX_WRAP_AT + i) % BENCH_RX_RING_SIZE] = (uint8_t)burst[i];
+  }
+  return len;
+}
+
+void test_bench_at_feed_spans_vs_bytewise(void) {
+  static AtSpanBenchCtx ctx;
+  char msg[192];
+
+  ctx.len = build_rx_burst(ctx.ring);
+  TEST_ASSERT_TRUE(ctx.len > BENCH_RX_RING_SIZE - BENCH_RX_WRAP_AT);
+
+  /* 两种喂入方式切出的行必须完全一致 */
+  uint32_t digest_byte = 0;
+  uint32_t digest_span = 0;
+  aqua_at_init(&ctx.at, mock_bench_write, mock_bench_now_ms);
+  bench_at_push_bytewise(&ctx);
+  size_t lines_byte = bench_at_digest(&ctx.at, &digest_byte);
+  aqua_at_init(&ctx.at, mock_bench_write, mock_bench_now_ms);
+  bench_at_push_spans(&ctx);
+  size_t lines_span = bench_at_digest(&ctx.at, &digest_span);
+  TEST_ASSERT_TRUE(lines_byte > 0);
+  TEST_ASSERT_EQUAL(lines_byte, lines_span);
+  TEST_ASSERT_EQUAL_HEX32(digest_byte, digest_span);
+
+  double ns_byte = bench_ns_per_call(bench_at_feed_bytewise, &ctx);
+  double ns_span = bench_ns_per_call(bench_at_feed_spans, &ctx);
+  double cycles_per_ns = bench_cycles_per_ns();
+
+  if (cycles_per_ns > 0.0) {
+    snprintf(msg, sizeof(msg),
+             "at_feed %u B burst: bytewise %5.3f B/cycle  "
+             "spans %5.3f B/cycle  (%.1fx)",
+             (unsigned)ctx.len, ctx.len / (ns_byte * cycles_per_ns),
+             ctx.len / (ns_span * cycles_per_ns), ns_byte / ns_span);
+  } else {
+    snprintf(msg, sizeof(msg),
+             "at_feed %u B burst: bytewise %5.3f B/ns  "
+             "spans %5.3f B/ns  (%.1fx)",
+             (unsigned)ctx.len, ctx.len / ns_byte, ctx.len / ns_span,
+             ns_byte / ns_span);
+  }
+  TEST_MESSAGE(msg);
+  BENCH_TIMING_ASSERT(ns_span < ns_byte);
+}
+
+/* ============================================================================
+ * 启动到上线：模拟 ESP32 应答延迟下的连接耗时
+ * ============================================================================
+ */
+
+/* 模拟 ESP32 收到命令行后应答的延迟与主循环周期（毫秒） */
+#define SIM_ESP_LATENCY_MS 2U
+#define SIM_LOOP_PERIOD_MS 10U
+#define SIM_TIMEOUT_MS 30000U
+
+typedef struct {
+  char line[320];
+  size_t line_len;
+  char resp[256];
+  size_t resp_len;
+  uint32_t resp_due_ms;
+  unsigned commands;
+} SimEsp;
+
+static SimEsp g_sim_esp;
+static uint32_t g_sim_now_ms = 0;
+
+static uint32_t sim_now_ms(void) { return g_sim_now_ms; }
+
+static void sim_esp_reply(const char *text) {
+  size_t len = strlen(text);
+  if (g_sim_esp.resp_len + len > sizeof(g_sim_esp.resp))
+    return;
+  memcpy(g_sim_esp.resp + g_sim_esp.resp_len, text, len);
+  g_sim_esp.resp_len += len;
+  g_sim_esp.resp_due_ms = g_sim_now_ms + SIM_ESP_LATENCY_MS;
+}
+
+/* 按整行解析主机发出的命令，每条命令在延迟之后应答 OK */
+static size_t sim_esp_write(const uint8_t *data, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (g_sim_esp.line_len < sizeof(g_sim_esp.line) - 1) {
+      g_sim_esp.line[g_sim_esp.line_len++] = (char)data[i];
+    }
+    if (data[i] != '\n')
+      continue;
+
+    g_sim_esp.line[g_sim_esp.line_len] = '\0';
+    g_sim_esp.line_len = 0;
+    g_sim_esp.commands++;
+    if (strncmp(g_sim_esp.line, "AT+CIPSNTPTIME?", 15) == 0) {
+      sim_esp_reply("+CIPSNTPTIME:Thu Oct 16 08:00:00 2025\r\n");
+    }
+    sim_esp_reply("OK\r\n");
+  }
+  return len;
+}
+
+/* 到期的应答整体送入 AT 引擎（回调中发出的新命令会追加新的应答） */
+static void sim_esp_deliver(AtClient *at) {
+  if (g_sim_esp.resp_len == 0 || g_sim_now_ms < g_sim_esp.resp_due_ms)
+    return;
+
+  char rx[sizeof(g_sim_esp.resp)];
+  size_t len = g_sim_esp.resp_len;
+  memcpy(rx, g_sim_esp.resp, len);
+  g_sim_esp.resp_len = 0;
+  (void)aqua_at_feed_rx(at, (const uint8_t *)rx, len);
+}
+
+/*
+ * 模拟主循环从启动到 ONLINE 的耗时（模拟毫秒，结果确定）。两种情形都运行
+ * 当前的命令队列代码，只比较主循环收取 UART 的策略：drain_while_waiting
+ * 为 false 时只在每轮开头收取，命令完成随主循环推进；为 true 时在周期
+ * 等待期间每毫秒收取一次（对应 main.c 的忙等收取），OK 一到即发出下一条。
+ * 引入命令队列之前的状态机不在此模拟之列，结果不代表新旧实现的对比。
+ */
+static uint32_t sim_boot_to_online(bool drain_while_waiting) {
+  static AtClient at;
+  static AquariumApp app;
+  static MqttClient mqtt;
+
+  memset(&g_sim_esp, 0, sizeof(g_sim_esp));
+  g_sim_now_ms = 0;
+  aqua_at_init(&at, sim_esp_write, sim_now_ms);
+  aqua_app_init(&app, "bench_device");
+  aqua_mqtt_init(&mqtt, &at, &app);
+
+  MqttConfig cfg = {0};
+  strcpy(cfg.wifi_ssid, "BenchWiFi");
+  strcpy(cfg.wifi_password, "12345678");
+  strcpy(cfg.broker_host, "bench.iot.cn");
+  cfg.broker_port = 1883;
+  strcpy(cfg.device_id, "bench_device");
+  strcpy(cfg.device_secret, "secret");
+  aqua_mqtt_set_config(&mqtt, &cfg);
+  aqua_mqtt_set_timestamp(&mqtt, "2025101600");
+  aqua_mqtt_start(&mqtt);
+
+  while (mqtt.state != MQTT_STATE_ONLINE && g_sim_now_ms < SIM_TIMEOUT_MS) {
+    sim_esp_deliver(&at);
+    aqua_mqtt_step(&mqtt);
+    for (uint32_t i = 0; i < SIM_LOOP_PERIOD_MS; ++i) {
+      g_sim_now_ms++;
+      if (drain_while_waiting) {
+        sim_esp_deliver(&at);
+      }
+    }
+  }
+  return g_sim_now_ms;
+}
+
+void test_bench_boot_to_online(void) {
+  char msg[160];
+
+  uint32_t per_loop_ms = sim_boot_to_online(false);
+  unsigned commands = g_sim_esp.commands;
+  uint32_t pipelined_ms = sim_boot_to_online(true);
+
+  snprintf(msg, sizeof(msg),
+           "boot_to_online %u cmds (sim): drain per loop %u ms  "
+           "drain while waiting %u ms (%.1fx)",
+           commands, (unsigned)per_loop_ms, (unsigned)pipelined_ms,
+           (double)per_loop_ms / (double)pipelined_ms);
+  TEST_MESSAGE(msg);
+
+  TEST_ASSERT_TRUE(per_loop_ms < SIM_TIMEOUT_MS);
+  TEST_ASSERT_EQUAL(commands, g_sim_esp.commands);
+  /* 模拟时钟下的确定结果：等待期间收取时每条命令约一个应答延迟，
+   * 而不是一个主循环周期 */
+  TEST_ASSERT_TRUE(pipelined_ms * 2 < per_loop_ms);
+  TEST_ASSERT_TRUE(pipelined_ms <
+                   commands * (SIM_ESP_LATENCY_MS + 1) + SIM_LOOP_PERIOD_MS);
+}
+
+/* ============================================================================
+ * 主函数
+ * ============================================================================
+ */
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_bench_parse_command_scales_linearly);
+  RUN_TEST(test_bench_parse_command_corpus);
+  RUN_TEST(test_bench_properties_format);
+  RUN_TEST(test_bench_report_frame);
+  RUN_TEST(test_bench_properties_cbor);
+  RUN_TEST(test_bench_telemetry_scan);
+  RUN_TEST(test_bench_adversarial_parse_is_linear);
+  RUN_TEST(test_bench_adversarial_at_feed_is_linear);
+  RUN_TEST(test_bench_at_feed_spans_vs_bytewise);
+  RUN_TEST(test_bench_boot_to_online);
+
+  return UNITY_END();
+}
@@ -4,6 +4,7 @@
  */
 
 #include "aquarium_esp32_mqtt.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <unity.h>
@@ -15,9 +16,14 @@
 
 static uint8_t g_tx_buffer[2048];
 static size_t g_tx_len = 0;
+static size_t g_tx_room = SIZE_MAX; /* 模拟发送队列剩余空间 */
 static uint32_t g_mock_time_ms = 0;
 
 static size_t mock_write(const uint8_t *data, size_t len) {
+  if (len > g_tx_room) {
+    len = g_tx_room;
+  }
+  g_tx_room -= len;
   if (g_tx_len + len <= sizeof(g_tx_buffer)) {
     memcpy(g_tx_buffer + g_tx_len, data, len);
     g_tx_len += len;
@@ -29,6 +35,7 @@ static uint32_t mock_now_ms(void) { return g_mock_time_ms; }
 
 static void reset_mocks(void) {
   g_tx_len = 0;
+  g_tx_room = SIZE_MAX;
   g_mock_time_ms = 0;
   memset(g_tx_buffer, 0, sizeof(g_tx_buffer));
 }
@@ -138,15 +145,69 @@ void test_mqtt_full_connect(void) {
   aqua_mqtt_step(&mqtt);
   TEST_ASSERT_EQUAL(MQTT_STATE_MQTTCONN, mqtt.state);
 
+  reset_mocks();
   feed_ok(&at);
   aqua_mqtt_step(&mqtt);
   TEST_ASSERT_EQUAL(MQTT_STATE_MQTTSUB, mqtt.state);
+  TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer,
+                              "$oc/devices/device123/sys/commands/#"));
+
+  /* 命令之后依次订阅属性设置/查询 */
+  reset_mocks();
+  feed_ok(&at);
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_MQTTSUB, mqtt.state);
+  TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer,
+                              "$oc/devices/device123/sys/properties/set/#"));
+
+  reset_mocks();
+  feed_ok(&at);
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_MQTTSUB, mqtt.state);
+  TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer,
+                              "$oc/devices/device123/sys/properties/get/#"));
 
   feed_ok(&at);
   aqua_mqtt_step(&mqtt);
   TEST_ASSERT_EQUAL(MQTT_STATE_ONLINE, mqtt.state);
 }
 
+void test_mqtt_connect_sequence_advances_without_step(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "device123");
+  aqua_mqtt_init(&mqtt, &at, &app);
+
+  MqttConfig cfg = {0};
+  strcpy(cfg.wifi_ssid, "TestWiFi");
+  strcpy(cfg.wifi_password, "12345678");
+  strcpy(cfg.broker_host, "test.iot.cn");
+  cfg.broker_port = 1883;
+  strcpy(cfg.device_id, "device123");
+  strcpy(cfg.device_secret, "secret");
+  aqua_mqtt_set_config(&mqtt, &cfg);
+  aqua_mqtt_set_timestamp(&mqtt, "2025121400");
+
+  aqua_mqtt_start(&mqtt);
+
+  /* 初始化命令已排队：每个 OK 到达时下一条立即发出，无需等待 step */
+  const char *rx = "OK\r\nOK\r\nOK\r\n";
+  aqua_at_feed_rx(&at, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_EQUAL(MQTT_STATE_CWJAP, mqtt.state);
+  TEST_ASSERT_EQUAL_STRING_LEN("AT\r\nATE0\r\nAT+CWMODE=1\r\nAT+CWJAP=",
+                               (char *)g_tx_buffer, 32);
+
+  rx = "OK\r\nOK\r\n+CIPSNTPTIME:Sat Dec 14 13:00:00 2024\r\nOK\r\n"
+       "OK\r\nOK\r\n";
+  aqua_at_feed_rx(&at, (const uint8_t *)rx, strlen(rx));
+  TEST_ASSERT_EQUAL(MQTT_STATE_MQTTSUB, mqtt.state);
+  TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer,
+                              "$oc/devices/device123/sys/commands/#"));
+}
+
 /* ============================================================================
  * iFi 
  * ============================================================================
@@ -375,6 +436,44 @@ void test_mqtt_publish_completes_with_plain_ok_only(void) {
   TEST_ASSERT_EQUAL(MQTT_STATE_ONLINE, mqtt.state);
 }
 
+void test_mqtt_publish_payload_backpressure(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+  const char *payload = "{\"services\":[]}";
+
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "test");
+  aqua_mqtt_init(&mqtt, &at, &app);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  aqua_mqtt_publish(&mqtt, "t", payload, strlen(payload));
+  feed_prompt(&at);
+
+  /* 发送队列只剩 4 字节：payload 余下部分由 AT 层续发，主循环不阻塞 */
+  g_tx_len = 0;
+  g_tx_room = 4;
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUB_DATA, mqtt.state);
+  TEST_ASSERT_EQUAL(strlen(payload) - 4, aqua_at_tx_pending(&at));
+
+  /* payload 未发完前不能开始新的发布 */
+  mqtt.state = MQTT_STATE_ONLINE;
+  TEST_ASSERT_FALSE(aqua_mqtt_publish(&mqtt, "t", "{}", 2));
+  mqtt.state = MQTT_STATE_PUB_DATA;
+
+  g_tx_room = SIZE_MAX;
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(0, aqua_at_tx_pending(&at));
+  TEST_ASSERT_EQUAL_STRING_LEN(payload, (char *)g_tx_buffer, strlen(payload));
+
+  const char *urc = "+MQTTPUB:OK\r\n";
+  aqua_at_feed_rx(&at, (const uint8_t *)urc, strlen(urc));
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_ONLINE, mqtt.state);
+  TEST_ASSERT_TRUE(aqua_mqtt_publish(&mqtt, "t", "{}", 2));
+}
+
 /* ============================================================================
  * UB_DATA ERROR
  * ============================================================================
@@ -403,6 +502,78 @@ void test_mqtt_publish_timeout(void) {
   TEST_ASSERT_EQUAL(MQTT_STATE_ONLINE, mqtt.state);
 }
 
+void test_mqtt_late_publish_fail_after_fast_publishes(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+  const char *ok_urc = "+MQTTPUB:OK\r\n";
+  const char *fail_urc = "+MQTTPUB:FAIL\r\n";
+
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "test");
+  aqua_mqtt_init(&mqtt, &at, &app);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  /* 先有几次 50ms 内完成的发布 */
+  for (int i = 0; i < 4; ++i) {
+    aqua_mqtt_publish(&mqtt, "t", "{}", 2);
+    feed_prompt(&at);
+    aqua_mqtt_step(&mqtt);
+    g_mock_time_ms += 50;
+    aqua_at_feed_rx(&at, (const uint8_t *)ok_urc, strlen(ok_urc));
+    aqua_mqtt_step(&mqtt);
+    TEST_ASSERT_EQUAL(MQTT_STATE_ONLINE, mqtt.state);
+  }
+
+  /* 1s 后才到的失败结果仍然生效，不会被提前超时当作成功 */
+  aqua_mqtt_publish(&mqtt, "t", "{}", 2);
+  feed_prompt(&at);
+  aqua_mqtt_step(&mqtt);
+  g_mock_time_ms += 1000;
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUB_DATA, mqtt.state);
+
+  aqua_at_feed_rx(&at, (const uint8_t *)fail_urc, strlen(fail_urc));
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_ERROR, mqtt.state);
+  TEST_ASSERT_EQUAL(1, at.stats.cmd[AT_CMD_CLASS_PUBLISH].error);
+}
+
+void test_mqtt_wedged_module_detected_at_prompt(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+  const char *ok_urc = "+MQTTPUB:OK\r\n";
+
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "test");
+  aqua_mqtt_init(&mqtt, &at, &app);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  /* 先有几次 20ms 内给出 > 的发布 */
+  for (int i = 0; i < 4; ++i) {
+    aqua_mqtt_publish(&mqtt, "t", "{}", 2);
+    g_mock_time_ms += 20;
+    feed_prompt(&at);
+    aqua_mqtt_step(&mqtt);
+    aqua_at_feed_rx(&at, (const uint8_t *)ok_urc, strlen(ok_urc));
+    aqua_mqtt_step(&mqtt);
+    TEST_ASSERT_EQUAL(MQTT_STATE_ONLINE, mqtt.state);
+  }
+
+  /* 模组卡死不再给出 >：在估计的下限处判定，而不是等满 AT_TIMEOUT_MQTT */
+  aqua_mqtt_publish(&mqtt, "t", "{}", 2);
+  TEST_ASSERT_EQUAL(AT_RTO_MIN_MS, at.cmd_timeout_ms);
+  g_mock_time_ms += AT_RTO_MIN_MS - 1;
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUBLISHING, mqtt.state);
+
+  g_mock_time_ms += 1;
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_ERROR, mqtt.state);
+  TEST_ASSERT_EQUAL(1, at.stats.cmd[AT_CMD_CLASS_PROMPT].timeout);
+}
+
 void test_mqtt_pub_data_preserves_subrecv_for_next_poll(void) {
   AtClient at;
   AquariumApp app;
@@ -445,6 +616,68 @@ void test_mqtt_pub_data_preserves_subrecv_for_next_poll(void) {
   TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer, "request_id=r_pub"));
 }
 
+void test_mqtt_pub_data_skips_other_urcs_in_place(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+
+  reset_mocks();
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "dev123");
+  aqua_mqtt_init(&mqtt, &at, &app);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  TEST_ASSERT_TRUE(aqua_mqtt_publish(&mqtt, "test/topic", "{\"v\":1}", 7));
+  feed_prompt(&at);
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUB_DATA, mqtt.state);
+
+  /* 结果行前后的 URC 都留在原位，顺序不变 */
+  const char *rx = "+CWJAP:\"ap\"\r\n+MQTTCONNECTED:0\r\n"
+                   "+MQTTPUB:OK\r\n+MQTTDISCONNECTED:0\r\n";
+  aqua_at_feed_rx(&at, (const uint8_t *)rx, strlen(rx));
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_ONLINE, mqtt.state);
+
+  const char *expected[] = {"+CWJAP:\"ap\"", "+MQTTCONNECTED:0",
+                            "+MQTTDISCONNECTED:0"};
+  TEST_ASSERT_EQUAL(3, at.urc_count);
+  for (size_t i = 0; i < 3; ++i) {
+    AtLineView view;
+    TEST_ASSERT_EQUAL(AT_OK, aqua_at_peek_line(&at, i, &view));
+    TEST_ASSERT_EQUAL_STRING(expected[i], view.data);
+  }
+}
+
+void test_mqtt_stale_pub_result_does_not_complete_next_publish(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+
+  reset_mocks();
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "dev123");
+  aqua_mqtt_init(&mqtt, &at, &app);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  /* 不在 PUB_DATA 时到达的结果行照常入队，不算作下一次发布的结果 */
+  const char *stale = "+MQTTPUB:OK\r\n";
+  aqua_at_feed_rx(&at, (const uint8_t *)stale, strlen(stale));
+  TEST_ASSERT_EQUAL(1, at.urc_count);
+
+  TEST_ASSERT_TRUE(aqua_mqtt_publish(&mqtt, "test/topic", "{\"v\":1}", 7));
+  feed_prompt(&at);
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUB_DATA, mqtt.state);
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUB_DATA, mqtt.state);
+
+  const char *fail = "+MQTTPUB:FAIL\r\n";
+  aqua_at_feed_rx(&at, (const uint8_t *)fail, strlen(fail));
+  aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_ERROR, mqtt.state);
+}
+
 /* ============================================================================
  * +MQTTSUBRECV 
  * ============================================================================
@@ -463,11 +696,37 @@ void test_mqtt_truncated_subrecv_still_handled(void) {
   const char *urc = "+MQTTSUBRECV:0,\"topic\",100,short\r\n";
   aqua_at_feed_rx(&at, (const uint8_t *)urc, strlen(urc));
 
+  /* 声明长度未收齐：断流超时后按已收部分交付 */
+  g_mock_time_ms += AT_RAW_CAPTURE_TIMEOUT_MS;
+  aqua_at_step(&at);
+
   bool handled = aqua_mqtt_poll_commands(&mqtt);
   TEST_ASSERT_TRUE(handled);
   TEST_ASSERT_EQUAL(MQTT_STATE_ONLINE, mqtt.state);
 }
 
+void test_mqtt_subrecv_oversized_length_is_clamped(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+
+  reset_mocks();
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "dev123");
+  aqua_mqtt_init(&mqtt, &at, &app);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  /* 声明长度超出任何整数类型：按实际收到的数据处理并回错误响应 */
+  const char *urc =
+      "+MQTTSUBRECV:0,\"$oc/devices/dev123/sys/commands/request_id=r_big\","
+      "99999999999999999999999999,{\"service_id\":\r\n";
+  aqua_at_feed_rx(&at, (const uint8_t *)urc, strlen(urc));
+
+  TEST_ASSERT_TRUE(aqua_mqtt_poll_commands(&mqtt));
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUBLISHING, mqtt.state);
+  TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer, "request_id=r_big"));
+}
+
 void test_mqtt_truncated_subrecv_with_request_id_generates_error_response(void) {
   AtClient at;
   AquariumApp app;
@@ -483,6 +742,8 @@ void test_mqtt_truncated_subrecv_with_request_id_generates_error_response(void)
       "+MQTTSUBRECV:0,\"$oc/devices/dev123/sys/commands/request_id=r_trunc\","
       "120,{\"service_id\":\"aquarium_control\"\r\n";
   aqua_at_feed_rx(&at, (const uint8_t *)urc, strlen(urc));
+  g_mock_time_ms += AT_RAW_CAPTURE_TIMEOUT_MS;
+  aqua_at_step(&at);
 
   bool handled = aqua_mqtt_poll_commands(&mqtt);
   TEST_ASSERT_TRUE(handled);
@@ -525,6 +786,69 @@ void test_mqtt_command_response_closed_loop(void) {
   TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer, "request_id=r1"));
 }
 
+void test_mqtt_large_multiline_command_arrives_intact(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+  static char payload[900];
+  static char urc[1024];
+
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "dev123");
+  aqua_mqtt_init(&mqtt, &at, &app);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  /* 带 CRLF 缩进、超过一行上限的命令：按长度原样捕获后正常执行 */
+  int n = snprintf(payload, sizeof(payload),
+                   "{\r\n  \"service_id\":\"aquarium_control\",\r\n"
+                   "  \"command_name\":\"control\",\r\n"
+                   "  \"paras\":{\r\n    \"heater\":true");
+  memset(payload + n, ' ', sizeof(payload) - (size_t)n - 8);
+  memcpy(payload + sizeof(payload) - 8, "\r\n  }}\r\n", 8);
+  size_t urc_len = (size_t)snprintf(
+      urc, sizeof(urc),
+      "+MQTTSUBRECV:0,\"$oc/devices/dev123/sys/commands/request_id=r_big\","
+      "%u,",
+      (unsigned)sizeof(payload));
+  memcpy(urc + urc_len, payload, sizeof(payload));
+  urc_len += sizeof(payload);
+  TEST_ASSERT_TRUE(urc_len > AT_LINE_MAX_LEN);
+
+  reset_mocks();
+  aqua_at_feed_rx(&at, (const uint8_t *)urc, urc_len);
+
+  TEST_ASSERT_TRUE(aqua_mqtt_poll_commands(&mqtt));
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUBLISHING, mqtt.state);
+  TEST_ASSERT_NOT_NULL(strstr(mqtt.pub_payload, "\"result_code\":0"));
+}
+
+void test_mqtt_properties_get_response_closed_loop(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "dev123");
+  aqua_mqtt_init(&mqtt, &at, &app);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  const char *payload = "{\"object_device_id\":\"dev123\"}";
+  char urc[512];
+  snprintf(urc, sizeof(urc),
+           "+MQTTSUBRECV:0,\"$oc/devices/dev123/sys/properties/get/"
+           "request_id=g1\",%zu,%s\r\n",
+           strlen(payload), payload);
+
+  reset_mocks();
+  aqua_at_feed_rx(&at, (const uint8_t *)urc, strlen(urc));
+
+  TEST_ASSERT_TRUE(aqua_mqtt_poll_commands(&mqtt));
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUBLISHING, mqtt.state);
+  TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer,
+                              "sys/properties/get/response/request_id=g1"));
+  TEST_ASSERT_NOT_NULL(strstr(mqtt.pub_payload, "\"service_id\":\"Aquarium\""));
+}
+
 /* ============================================================================
  * NTP 
  * ============================================================================
@@ -569,6 +893,28 @@ void test_mqtt_parse_sntp_time_invalid_null(void) {
   TEST_ASSERT_FALSE(aqua_mqtt_parse_sntp_time("+CIPSNTPTIME:Mon Oct 18", NULL));
 }
 
+void test_mqtt_parse_sntp_epoch(void) {
+  uint32_t epoch = 0;
+  TEST_ASSERT_TRUE(aqua_mqtt_parse_sntp_epoch(
+      "+CIPSNTPTIME:Mon Oct 18 20:12:27 2021", &epoch));
+  TEST_ASSERT_EQUAL_UINT32(1634587947u, epoch);
+
+  TEST_ASSERT_TRUE(aqua_mqtt_parse_sntp_epoch(
+      "+CIPSNTPTIME:Thu Feb 29 00:00:00 2024", &epoch));
+  TEST_ASSERT_EQUAL_UINT32(1709164800u, epoch);
+
+  TEST_ASSERT_TRUE(aqua_mqtt_parse_sntp_epoch(
+      "+CIPSNTPTIME:Mon Mar  2 16:51:42 2026", &epoch));
+  TEST_ASSERT_EQUAL_UINT32(1772470302u, epoch);
+
+  /* ESP32 未同步时返回 1970 年，视为无效 */
+  TEST_ASSERT_FALSE(aqua_mqtt_parse_sntp_epoch(
+      "+CIPSNTPTIME:Thu Jan 01 00:00:00 1970", &epoch));
+  TEST_ASSERT_FALSE(aqua_mqtt_parse_sntp_epoch("Mon Oct 18 20:12:27 2021",
+                                               &epoch));
+  TEST_ASSERT_FALSE(aqua_mqtt_parse_sntp_epoch(NULL, &epoch));
+}
+
 void test_mqtt_parse_sntp_time_invalid_format(void) {
   char ts[12];
  /* */
@@ -851,9 +1197,17 @@ void test_mqtt_mqttsub_timeout_treated_online(void) {
   mqtt.state = MQTT_STATE_MQTTSUB;
   at.state = AT_STATE_DONE_TIMEOUT;
 
+  /* 每个订阅超时都继续下一个，最后一个之后上线 */
   aqua_mqtt_step(&mqtt);
+  TEST_ASSERT_EQUAL(MQTT_STATE_MQTTSUB, mqtt.state);
+
+  while (mqtt.state == MQTT_STATE_MQTTSUB) {
+    g_mock_time_ms += 20000;
+    aqua_mqtt_step(&mqtt);
+  }
 
   TEST_ASSERT_EQUAL(MQTT_STATE_ONLINE, mqtt.state);
+  TEST_ASSERT_EQUAL(3, mqtt.sub_index);
 }
 
 void test_mqtt_sntptime_time_updated_retries_query(void) {
@@ -1176,6 +1530,7 @@ int main(void) {
 
   RUN_TEST(test_mqtt_init);
   RUN_TEST(test_mqtt_full_connect);
+  RUN_TEST(test_mqtt_connect_sequence_advances_without_step);
   RUN_TEST(test_mqtt_wifi_connect_fail);
   RUN_TEST(test_mqtt_placeholder_wifi_enters_ap_mode_directly);
   RUN_TEST(test_mqtt_cwjap_command_escapes_credentials);
@@ -1184,11 +1539,19 @@ int main(void) {
   RUN_TEST(test_mqtt_publish_not_online);
   RUN_TEST(test_mqtt_publish_completes);
   RUN_TEST(test_mqtt_publish_completes_with_plain_ok_only);
+  RUN_TEST(test_mqtt_publish_payload_backpressure);
   RUN_TEST(test_mqtt_publish_timeout);
+  RUN_TEST(test_mqtt_late_publish_fail_after_fast_publishes);
+  RUN_TEST(test_mqtt_wedged_module_detected_at_prompt);
   RUN_TEST(test_mqtt_pub_data_preserves_subrecv_for_next_poll);
+  RUN_TEST(test_mqtt_pub_data_skips_other_urcs_in_place);
+  RUN_TEST(test_mqtt_stale_pub_result_does_not_complete_next_publish);
   RUN_TEST(test_mqtt_truncated_subrecv_still_handled);
   RUN_TEST(test_mqtt_truncated_subrecv_with_request_id_generates_error_response);
+  RUN_TEST(test_mqtt_subrecv_oversized_length_is_clamped);
   RUN_TEST(test_mqtt_command_response_closed_loop);
+  RUN_TEST(test_mqtt_large_multiline_command_arrives_intact);
+  RUN_TEST(test_mqtt_properties_get_response_closed_loop);
 
  /* SNTP */
   RUN_TEST(test_mqtt_parse_sntp_time_valid);
@@ -1197,6 +1560,7 @@ int main(void) {
   RUN_TEST(test_mqtt_parse_sntp_time_single_digit_day_with_double_spaces);
   RUN_TEST(test_mqtt_parse_sntp_time_invalid_null);
   RUN_TEST(test_mqtt_parse_sntp_time_invalid_format);
+  RUN_TEST(test_mqtt_parse_sntp_epoch);
 
  /* AP */
   RUN_TEST(test_mqtt_cwjap_fail_enters_ap_mode);
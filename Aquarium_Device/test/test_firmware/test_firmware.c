@@ -328,6 +328,112 @@ void test_firmware_subsecond_ticks_accumulate(void) {
   TEST_ASSERT_EQUAL(1, g_actuator_cb_count);
 }
 
+/* ============================================================================
+ * 测试：CBOR 上报按实际字节数发布（payload 中含 0 字节）
+ * ============================================================================
+ */
+
+void test_firmware_cbor_report_uses_binary_length(void) {
+  AtClient at;
+  AquariumApp app;
+  MqttClient mqtt;
+  AquaFirmware fw;
+
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&app, "dev123");
+  aqua_app_set_report_codec(&app, AQUA_REPORT_CODEC_CBOR);
+  aqua_mqtt_init(&mqtt, &at, &app);
+  aqua_fw_init(&fw, &app, &mqtt);
+
+  MqttConfig cfg = {0};
+  strcpy(cfg.device_id, "dev123");
+  aqua_mqtt_set_config(&mqtt, &cfg);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  aqua_app_set_report_interval(&app, 30);
+  aqua_fw_update_sensors(&fw, 25.5f, 7.2f, 300.0f, 10.0f, 80.0f);
+
+  g_mock_time_ms = 1000;
+  aqua_fw_step(&fw, g_mock_time_ms);
+  g_mock_time_ms = 31000;
+  reset_tx_buffer();
+  aqua_fw_step(&fw, g_mock_time_ms);
+
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUBLISHING, mqtt.state);
+  size_t len = aqua_app_get_report_len(&app);
+  TEST_ASSERT_TRUE(len > 0 && len < 64);
+
+  char expected[96];
+  snprintf(expected, sizeof(expected),
+           "AT+MQTTPUBRAW=0,\"$oc/devices/dev123/sys/messages/up\",%zu,0,0",
+           len);
+  TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer, expected));
+
+  /* 收到 > 后按原始字节发送，0 字节不截断 */
+  reset_tx_buffer();
+  feed_prompt(&at);
+  aqua_fw_step(&fw, g_mock_time_ms);
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUB_DATA, mqtt.state);
+  TEST_ASSERT_EQUAL(len, g_tx_len);
+  TEST_ASSERT_EQUAL_HEX8(0x82, g_tx_buffer[0]);
+}
+
+static size_t g_sub_actuator_mask = 0;
+
+static void mock_sub_actuator_cb(size_t index, const ActuatorDesired *actuators,
+                                 void *user_data) {
+  (void)actuators;
+  (void)user_data;
+  g_sub_actuator_mask |= (size_t)1 << index;
+}
+
+void test_firmware_gateway_reports_sub_devices(void) {
+  AtClient at;
+  static AquariumApp tanks[2];
+  AquaGateway gw;
+  MqttClient mqtt;
+  AquaFirmware fw;
+
+  aqua_at_init(&at, mock_write, mock_now_ms);
+  aqua_app_init(&tanks[0], "gw01");
+  aqua_app_init(&tanks[1], "gw01_tank2");
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_init(&gw, "gw01", tanks, 2));
+  aqua_mqtt_init(&mqtt, &at, &tanks[0]);
+  aqua_fw_init(&fw, &tanks[0], &mqtt);
+  g_sub_actuator_mask = 0;
+  aqua_fw_set_gateway(&fw, &gw, mock_sub_actuator_cb, NULL);
+  TEST_ASSERT_EQUAL_PTR(&gw, mqtt.gateway);
+
+  MqttConfig cfg = {0};
+  strcpy(cfg.device_id, "gw01");
+  aqua_mqtt_set_config(&mqtt, &cfg);
+  mqtt.state = MQTT_STATE_ONLINE;
+
+  aqua_gateway_set_report_interval(&gw, 30);
+
+  g_mock_time_ms = 1000;
+  aqua_fw_step(&fw, g_mock_time_ms);
+  g_mock_time_ms = 31000;
+  reset_tx_buffer();
+  aqua_fw_step(&fw, g_mock_time_ms);
+
+  TEST_ASSERT_EQUAL(3, g_sub_actuator_mask);
+  TEST_ASSERT_EQUAL(MQTT_STATE_PUBLISHING, mqtt.state);
+  char expected[128];
+  snprintf(expected, sizeof(expected),
+           "AT+MQTTPUBRAW=0,\"$oc/devices/gw01/sys/gateway/sub_devices/"
+           "properties/report\",%zu,0,0",
+           aqua_gateway_get_report_len(&gw));
+  TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer, expected));
+
+  reset_tx_buffer();
+  feed_prompt(&at);
+  aqua_fw_step(&fw, g_mock_time_ms);
+  TEST_ASSERT_NOT_NULL(strstr((char *)g_tx_buffer, "\"device_id\":\"gw01\""));
+  TEST_ASSERT_NOT_NULL(
+      strstr((char *)g_tx_buffer, "\"device_id\":\"gw01_tank2\""));
+}
+
 /* ============================================================================
  * 主函数
  * ============================================================================
@@ -344,6 +450,8 @@ int main(void) {
   RUN_TEST(test_firmware_offline_logic_continues);
   RUN_TEST(test_firmware_time_overflow_safe);
   RUN_TEST(test_firmware_subsecond_ticks_accumulate);
+  RUN_TEST(test_firmware_cbor_report_uses_binary_length);
+  RUN_TEST(test_firmware_gateway_reports_sub_devices);
 
   return UNITY_END();
 }
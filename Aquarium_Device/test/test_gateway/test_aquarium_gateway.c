@@ -0,0 +1,210 @@
+/**
+ * @file test_aquarium_gateway.c
+ * @brief IoTDA 网关模式单元测试
+ */
+
+#include "aquarium_gateway.h"
+#include <string.h>
+#include <unity.h>
+
+#define TEST_GATEWAY_ID "gw01"
+#define TEST_TANK2_ID "gw01_tank2"
+
+static AquariumApp g_tanks[2];
+static AquaGateway g_gw;
+
+void setUp(void) {
+  aqua_app_init(&g_tanks[0], TEST_GATEWAY_ID);
+  aqua_app_init(&g_tanks[1], TEST_TANK2_ID);
+  aqua_app_update_sensors(&g_tanks[0], 26.0f, 7.0f, 300.0f, 10.0f, 60.0f);
+  aqua_app_update_sensors(&g_tanks[1], 24.5f, 6.8f, 280.0f, 12.0f, 70.0f);
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_gateway_init(&g_gw, TEST_GATEWAY_ID, g_tanks, 2));
+}
+
+void tearDown(void) {}
+
+/* ============================================================================
+ * 测试：初始化
+ * ============================================================================
+ */
+
+void test_gateway_init(void) {
+  AquaGateway gw;
+  TEST_ASSERT_EQUAL_STRING(TEST_GATEWAY_ID, g_gw.gateway_id);
+  TEST_ASSERT_EQUAL(2, g_gw.count);
+  TEST_ASSERT_EQUAL(DEFAULT_REPORT_INTERVAL_SECONDS, g_gw.report_timer);
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
+                    aqua_gateway_init(&gw, NULL, g_tanks, 2));
+  TEST_ASSERT_EQUAL(AQUA_ERR_MISSING_FIELD,
+                    aqua_gateway_init(&gw, TEST_GATEWAY_ID, g_tanks, 0));
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_gateway_init(&gw, TEST_GATEWAY_ID, g_tanks,
+                                      AQUA_GATEWAY_MAX_DEVICES + 1));
+}
+
+/* ============================================================================
+ * 测试：合并上报
+ * ============================================================================
+ */
+
+void test_gateway_reports_all_tanks_in_one_publish(void) {
+  ActuatorDesired actuators[2];
+  char topic[256], payload[1024];
+  bool has_publish = true;
+
+  aqua_gateway_set_report_interval(&g_gw, 10);
+  aqua_gateway_set_utc_time(&g_gw, 1760515200u);
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_step(&g_gw, 5, actuators,
+                                               &has_publish, topic,
+                                               sizeof(topic), payload,
+                                               sizeof(payload)));
+  TEST_ASSERT_FALSE(has_publish);
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_step(&g_gw, 5, actuators,
+                                               &has_publish, topic,
+                                               sizeof(topic), payload,
+                                               sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_EQUAL_STRING(
+      "$oc/devices/gw01/sys/gateway/sub_devices/properties/report", topic);
+  TEST_ASSERT_EQUAL(strlen(payload), aqua_gateway_get_report_len(&g_gw));
+  TEST_ASSERT_EQUAL_PTR(
+      payload, strstr(payload, "{\"devices\":[{\"device_id\":\"gw01\","));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"temperature\":26.00"));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "{\"device_id\":\"gw01_tank2\""));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"temperature\":24.50"));
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"event_time\":\"20251015T080010Z\""));
+  TEST_ASSERT_EQUAL(10, g_gw.report_timer);
+}
+
+void test_gateway_splits_report_when_buffer_is_small(void) {
+  ActuatorDesired actuators[2];
+  char topic[256], payload[512];
+  bool has_publish = false;
+
+  aqua_gateway_set_report_interval(&g_gw, 10);
+
+  /* 两个全量采样放不进 512 字节：先发第一个，下一步立即补发第二个 */
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_step(&g_gw, 10, actuators,
+                                               &has_publish, topic,
+                                               sizeof(topic), payload,
+                                               sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"device_id\":\"gw01\""));
+  TEST_ASSERT_NULL(strstr(payload, TEST_TANK2_ID));
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_step(&g_gw, 1, actuators,
+                                               &has_publish, topic,
+                                               sizeof(topic), payload,
+                                               sizeof(payload)));
+  TEST_ASSERT_TRUE(has_publish);
+  TEST_ASSERT_NOT_NULL(strstr(payload, "\"device_id\":\"gw01_tank2\""));
+  TEST_ASSERT_EQUAL(10, g_gw.report_timer);
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_step(&g_gw, 1, actuators,
+                                               &has_publish, topic,
+                                               sizeof(topic), payload,
+                                               sizeof(payload)));
+  TEST_ASSERT_FALSE(has_publish);
+
+  /* 连一个子设备都放不下时报错，下个周期重试 */
+  g_gw.report_timer = 0;
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_gateway_step(&g_gw, 1, actuators, &has_publish, topic,
+                                      sizeof(topic), payload, 64));
+  TEST_ASSERT_FALSE(has_publish);
+  TEST_ASSERT_EQUAL(10, g_gw.report_timer);
+}
+
+/* ============================================================================
+ * 测试：下行路由
+ * ============================================================================
+ */
+
+void test_gateway_routes_command_by_object_device_id(void) {
+  const char *cmd_topic =
+      "$oc/devices/" TEST_GATEWAY_ID "/sys/commands/request_id=cmd01";
+  const char *cmd_payload = "{\"object_device_id\":\"" TEST_TANK2_ID "\","
+                            "\"service_id\":\"aquarium_control\","
+                            "\"command_name\":\"control\","
+                            "\"paras\":{\"auto_mode\":false,\"heater\":true}}";
+  char resp_topic[256], resp_payload[1024];
+  bool has_response = false;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_on_mqtt_command(
+                                 &g_gw, cmd_topic, cmd_payload,
+                                 strlen(cmd_payload), &has_response,
+                                 resp_topic, sizeof(resp_topic), resp_payload,
+                                 sizeof(resp_payload)));
+  TEST_ASSERT_TRUE(has_response);
+  TEST_ASSERT_EQUAL_STRING("$oc/devices/" TEST_GATEWAY_ID
+                           "/sys/commands/response/request_id=cmd01",
+                           resp_topic);
+  TEST_ASSERT_TRUE(g_tanks[1].state.props.heater);
+  TEST_ASSERT_FALSE(g_tanks[0].state.props.heater);
+
+  /* 执行器输出按子设备独立 */
+  ActuatorDesired actuators[2];
+  char topic[256], payload[1024];
+  bool has_publish;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_step(&g_gw, 1, actuators,
+                                               &has_publish, topic,
+                                               sizeof(topic), payload,
+                                               sizeof(payload)));
+  TEST_ASSERT_TRUE(actuators[1].heater);
+  TEST_ASSERT_FALSE(actuators[0].heater);
+}
+
+void test_gateway_routes_default_and_unknown_targets(void) {
+  const char *get_topic =
+      "$oc/devices/" TEST_GATEWAY_ID "/sys/properties/get/request_id=get01";
+  char resp_topic[256], resp_payload[1024];
+  bool has_response = false;
+
+  /* 不带 object_device_id：发给网关自身的水族箱 */
+  TEST_ASSERT_EQUAL_PTR(&g_tanks[0], aqua_gateway_route(&g_gw, "{}", 2));
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_on_mqtt_command(
+                                 &g_gw, get_topic, "{}", 2, &has_response,
+                                 resp_topic, sizeof(resp_topic), resp_payload,
+                                 sizeof(resp_payload)));
+  TEST_ASSERT_TRUE(has_response);
+  TEST_ASSERT_NOT_NULL(strstr(resp_payload, "\"temperature\":26.00"));
+
+  const char *tank2 = "{\"object_device_id\":\"" TEST_TANK2_ID "\"}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_gateway_on_mqtt_command(
+                                 &g_gw, get_topic, tank2, strlen(tank2),
+                                 &has_response, resp_topic, sizeof(resp_topic),
+                                 resp_payload, sizeof(resp_payload)));
+  TEST_ASSERT_TRUE(has_response);
+  TEST_ASSERT_NOT_NULL(strstr(resp_payload, "\"temperature\":24.50"));
+
+  /* 未知子设备：不回包 */
+  const char *unknown = "{\"object_device_id\":\"gw01_tank9\"}";
+  TEST_ASSERT_NULL(aqua_gateway_route(&g_gw, unknown, strlen(unknown)));
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_gateway_on_mqtt_command(
+                        &g_gw, get_topic, unknown, strlen(unknown),
+                        &has_response, resp_topic, sizeof(resp_topic),
+                        resp_payload, sizeof(resp_payload)));
+  TEST_ASSERT_FALSE(has_response);
+}
+
+/* ============================================================================
+ * 主函数
+ * ============================================================================
+ */
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_gateway_init);
+  RUN_TEST(test_gateway_reports_all_tanks_in_one_publish);
+  RUN_TEST(test_gateway_splits_report_when_buffer_is_small);
+  RUN_TEST(test_gateway_routes_command_by_object_device_id);
+  RUN_TEST(test_gateway_routes_default_and_unknown_targets);
+
+  return UNITY_END();
+}
@@ -87,8 +87,8 @@ void test_handle_control_command_success(void) {
                         "}";
 
   IoTDACommandResult result;
-  AquaError err = aqua_iotda_handle_command(TEST_DEVICE_ID, topic, payload,
-                                            strlen(payload), &state, &result);
+  AquaError err = aqua_iotda_handle_command(
+      TEST_DEVICE_ID, topic, payload, strlen(payload), &state, 0, &result);
 
   TEST_ASSERT_EQUAL(AQUA_OK, err);
   TEST_ASSERT_TRUE(result.has_response);
@@ -127,8 +127,8 @@ void test_handle_threshold_command_success(void) {
                         "}";
 
   IoTDACommandResult result;
-  AquaError err = aqua_iotda_handle_command(TEST_DEVICE_ID, topic, payload,
-                                            strlen(payload), &state, &result);
+  AquaError err = aqua_iotda_handle_command(
+      TEST_DEVICE_ID, topic, payload, strlen(payload), &state, 0, &result);
 
   TEST_ASSERT_EQUAL(AQUA_OK, err);
   TEST_ASSERT_TRUE(result.has_response);
@@ -162,8 +162,8 @@ void test_handle_config_command_success(void) {
       "}";
 
   IoTDACommandResult result;
-  AquaError err = aqua_iotda_handle_command(TEST_DEVICE_ID, topic, payload,
-                                            strlen(payload), &state, &result);
+  AquaError err = aqua_iotda_handle_command(
+      TEST_DEVICE_ID, topic, payload, strlen(payload), &state, 0, &result);
 
   TEST_ASSERT_EQUAL(AQUA_OK, err);
   TEST_ASSERT_TRUE(result.has_response);
@@ -178,6 +178,125 @@ void test_handle_config_command_success(void) {
   TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.25f, state.config.ph_offset);
 }
 
+/* ============================================================================
+ * 测试：命令响应附带状态快照
+ * ============================================================================
+ */
+
+void test_handle_control_command_state_snapshot(void) {
+  AquariumState state;
+  aqua_logic_init(&state);
+  state.props.temperature = 20.0f; /* 低于目标温度，自动模式下应加热 */
+  state.props.water_level = 60.0f;
+
+  const char *topic =
+      "$oc/devices/" TEST_DEVICE_ID "/sys/commands/request_id=req1";
+  const char *payload = "{\"service_id\":\"aquarium_control\","
+                        "\"command_name\":\"control\","
+                        "\"paras\":{\"heater\":false,\"mute\":true,"
+                        "\"target_temp\":25.5}}";
+
+  IoTDACommandResult result;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_command(
+                                 TEST_DEVICE_ID, topic, payload,
+                                 strlen(payload), &state,
+                                 IOTDA_CMD_RESPONSE_STATE, &result));
+
+  /* 自动模式接管加热棒：回显的是实际将要输出的状态 */
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"result_code\":0,\"response_name\":\"control_response\","
+      "\"paras\":{\"result\":\"success\",\"state\":{\"heater\":true,"
+      "\"pump_in\":false,\"pump_out\":false,\"auto_mode\":true,"
+      "\"feed_countdown\":43200,\"feeding_in_progress\":false,"
+      "\"alarm_muted\":true,\"target_temp\":25.50}}}",
+      result.response_payload);
+  TEST_ASSERT_EQUAL(strlen(result.response_payload),
+                    result.response_payload_len);
+
+  /* 未涉及目标温度时不回显 */
+  const char *mute = "{\"service_id\":\"aquarium_control\","
+                     "\"command_name\":\"control\","
+                     "\"paras\":{\"mute\":false}}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_command(
+                                 TEST_DEVICE_ID, topic, mute, strlen(mute),
+                                 &state, IOTDA_CMD_RESPONSE_STATE, &result));
+  TEST_ASSERT_NOT_NULL(
+      strstr(result.response_payload, "\"alarm_muted\":false}}}"));
+  TEST_ASSERT_NULL(strstr(result.response_payload, "target_temp"));
+}
+
+void test_handle_threshold_and_config_state_snapshot(void) {
+  AquariumState state;
+  aqua_logic_init(&state);
+  IoTDACommandResult result;
+
+  const char *topic =
+      "$oc/devices/" TEST_DEVICE_ID "/sys/commands/request_id=req2";
+  const char *thresholds = "{\"service_id\":\"aquarium_threshold\","
+                           "\"command_name\":\"set_thresholds\","
+                           "\"paras\":{\"ph_min\":6.8,\"feed_interval\":8}}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_command(
+                                 TEST_DEVICE_ID, topic, thresholds,
+                                 strlen(thresholds), &state,
+                                 IOTDA_CMD_RESPONSE_STATE, &result));
+  /* 只回显请求中的阈值，以及随投喂间隔重置的倒计时 */
+  TEST_ASSERT_NOT_NULL(strstr(result.response_payload,
+                              "\"state\":{\"ph_min\":6.80,"
+                              "\"feed_interval\":8,"
+                              "\"feed_countdown\":28800}}}"));
+
+  const char *target = "{\"service_id\":\"aquarium_threshold\","
+                       "\"command_name\":\"set_thresholds\","
+                       "\"paras\":{\"target_temp\":26.5}}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_command(
+                                 TEST_DEVICE_ID, topic, target, strlen(target),
+                                 &state, IOTDA_CMD_RESPONSE_STATE, &result));
+  TEST_ASSERT_NOT_NULL(strstr(result.response_payload,
+                              "\"state\":{\"target_temp\":26.50}}}"));
+
+  const char *config = "{\"service_id\":\"aquariumConfig\","
+                       "\"command_name\":\"set_config\","
+                       "\"paras\":{\"wifi_ssid\":\"Tank\","
+                       "\"wifi_password\":\"secret99\",\"tds_factor\":1.5}}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_command(
+                                 TEST_DEVICE_ID, topic, config, strlen(config),
+                                 &state, IOTDA_CMD_RESPONSE_STATE, &result));
+  TEST_ASSERT_NOT_NULL(
+      strstr(result.response_payload,
+             "\"state\":{\"tds_factor\":1.50}}}"));
+  TEST_ASSERT_NULL(strstr(result.response_payload, "secret99"));
+}
+
+void test_handle_command_state_snapshot_on_failure(void) {
+  AquariumState state;
+  aqua_logic_init(&state);
+  IoTDACommandResult result;
+
+  const char *topic =
+      "$oc/devices/" TEST_DEVICE_ID "/sys/commands/request_id=req3";
+
+  /* 应用失败：状态未变，快照帮助云端对齐 */
+  const char *bad_range = "{\"service_id\":\"aquarium_threshold\","
+                          "\"command_name\":\"set_thresholds\","
+                          "\"paras\":{\"temp_min\":30.0,\"temp_max\":20.0}}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_command(
+                                 TEST_DEVICE_ID, topic, bad_range,
+                                 strlen(bad_range), &state,
+                                 IOTDA_CMD_RESPONSE_STATE, &result));
+  TEST_ASSERT_NOT_NULL(strstr(result.response_payload, "\"result_code\":2"));
+  TEST_ASSERT_NOT_NULL(
+      strstr(result.response_payload, "\"state\":{\"temp_min\":24.00,"));
+
+  /* 解析失败：命令类型未知，不带快照 */
+  const char *garbage = "{\"service_id\":";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_command(
+                                 TEST_DEVICE_ID, topic, garbage,
+                                 strlen(garbage), &state,
+                                 IOTDA_CMD_RESPONSE_STATE, &result));
+  TEST_ASSERT_TRUE(result.has_response);
+  TEST_ASSERT_NULL(strstr(result.response_payload, "\"state\""));
+}
+
 /* ============================================================================
  * 测试：命令处理 - JSON 解析错误
  * ============================================================================
@@ -192,8 +311,8 @@ void test_handle_command_json_parse_error(void) {
   const char *payload = "{invalid json}";
 
   IoTDACommandResult result;
-  AquaError err = aqua_iotda_handle_command(TEST_DEVICE_ID, topic, payload,
-                                            strlen(payload), &state, &result);
+  AquaError err = aqua_iotda_handle_command(
+      TEST_DEVICE_ID, topic, payload, strlen(payload), &state, 0, &result);
 
   TEST_ASSERT_EQUAL(AQUA_OK, err); /* 函数执行成功 */
   TEST_ASSERT_TRUE(result.has_response);
@@ -223,8 +342,8 @@ void test_handle_command_unknown_command(void) {
                         "}";
 
   IoTDACommandResult result;
-  AquaError err = aqua_iotda_handle_command(TEST_DEVICE_ID, topic, payload,
-                                            strlen(payload), &state, &result);
+  AquaError err = aqua_iotda_handle_command(
+      TEST_DEVICE_ID, topic, payload, strlen(payload), &state, 0, &result);
 
   TEST_ASSERT_EQUAL(AQUA_OK, err);
   TEST_ASSERT_TRUE(result.has_response);
@@ -236,6 +355,33 @@ void test_handle_command_unknown_command(void) {
   TEST_ASSERT_NOT_NULL(strstr(result.response_payload, "unknown command"));
 }
 
+/* 密码超出字段容量：回报失败且不改动配置，而不是忽略该字段后回报成功 */
+void test_handle_command_oversized_password_fails(void) {
+  AquariumState state;
+  aqua_logic_init(&state);
+  strcpy(state.config.wifi_password, "old_password");
+
+  const char *topic =
+      "$oc/devices/" TEST_DEVICE_ID "/sys/commands/request_id=reqLong";
+  const char *payload =
+      "{\"service_id\":\"aquariumConfig\","
+      "\"command_name\":\"set_config\","
+      "\"paras\":{\"wifi_ssid\":\"Lab\",\"wifi_password\":"
+      "\"0123456789012345678901234567890123456789"
+      "0123456789012345678901234567890123456789\"}}";
+
+  IoTDACommandResult result;
+  AquaError err = aqua_iotda_handle_command(
+      TEST_DEVICE_ID, topic, payload, strlen(payload), &state, 0, &result);
+
+  TEST_ASSERT_EQUAL(AQUA_OK, err);
+  TEST_ASSERT_TRUE(result.has_response);
+  TEST_ASSERT_NOT_NULL(strstr(result.response_payload, "\"result_code\":2"));
+  TEST_ASSERT_NOT_NULL(
+      strstr(result.response_payload, "parameter value too long"));
+  TEST_ASSERT_EQUAL_STRING("old_password", state.config.wifi_password);
+}
+
 /* ============================================================================
  * 测试：命令处理 - Topic 解析失败
  * ============================================================================
@@ -251,8 +397,8 @@ void test_handle_command_invalid_topic(void) {
                         "\"control\",\"paras\":{}}";
 
   IoTDACommandResult result;
-  AquaError err = aqua_iotda_handle_command(TEST_DEVICE_ID, topic, payload,
-                                            strlen(payload), &state, &result);
+  AquaError err = aqua_iotda_handle_command(
+      TEST_DEVICE_ID, topic, payload, strlen(payload), &state, 0, &result);
 
   TEST_ASSERT_EQUAL(AQUA_ERR_TOPIC_PARSE, err);
   TEST_ASSERT_FALSE(result.has_response); /* 无法生成响应 */
@@ -276,8 +422,8 @@ void test_handle_feed_command(void) {
                         "}";
 
   IoTDACommandResult result;
-  AquaError err = aqua_iotda_handle_command(TEST_DEVICE_ID, topic, payload,
-                                            strlen(payload), &state, &result);
+  AquaError err = aqua_iotda_handle_command(
+      TEST_DEVICE_ID, topic, payload, strlen(payload), &state, 0, &result);
 
   TEST_ASSERT_EQUAL(AQUA_OK, err);
   TEST_ASSERT_TRUE(result.has_response);
@@ -304,8 +450,8 @@ void test_handle_feed_once_delay_command(void) {
                         "}";
 
   IoTDACommandResult result;
-  AquaError err = aqua_iotda_handle_command(TEST_DEVICE_ID, topic, payload,
-                                            strlen(payload), &state, &result);
+  AquaError err = aqua_iotda_handle_command(
+      TEST_DEVICE_ID, topic, payload, strlen(payload), &state, 0, &result);
 
   TEST_ASSERT_EQUAL(AQUA_OK, err);
   TEST_ASSERT_TRUE(result.has_response);
@@ -315,6 +461,100 @@ void test_handle_feed_once_delay_command(void) {
   TEST_ASSERT_EQUAL(120, state.feed_once_timer);
 }
 
+/* ============================================================================
+ * 测试：属性设置/查询
+ * ============================================================================
+ */
+
+void test_handle_properties_set(void) {
+  AquariumState state;
+  aqua_logic_init(&state);
+  state.props.auto_mode = false;
+  IoTDACommandResult result;
+
+  const char *topic = "$oc/devices/" TEST_DEVICE_ID
+                      "/sys/properties/set/request_id=set1";
+  const char *payload =
+      "{\"object_device_id\":\"" TEST_DEVICE_ID "\",\"services\":["
+      "{\"service_id\":\"Aquarium\",\"properties\":{\"pump_out\":true}}]}";
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_downlink(
+                                 TEST_DEVICE_ID, topic, payload,
+                                 strlen(payload), &state, 0, &result));
+  TEST_ASSERT_TRUE(result.has_response);
+  TEST_ASSERT_EQUAL_STRING("$oc/devices/" TEST_DEVICE_ID
+                           "/sys/properties/set/response/request_id=set1",
+                           result.response_topic);
+  TEST_ASSERT_EQUAL_STRING("{\"result_code\":0,\"result_desc\":\"success\"}",
+                           result.response_payload);
+  TEST_ASSERT_EQUAL(strlen(result.response_payload),
+                    result.response_payload_len);
+  TEST_ASSERT_TRUE(state.props.pump_out);
+
+  /* 与 set_thresholds 命令相同的跨字段校验 */
+  const char *bad_range =
+      "{\"services\":[{\"service_id\":\"aquarium_threshold\","
+      "\"properties\":{\"temp_min\":30.0,\"temp_max\":20.0}}]}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_downlink(
+                                 TEST_DEVICE_ID, topic, bad_range,
+                                 strlen(bad_range), &state, 0, &result));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"result_code\":1,\"result_desc\":\"property apply failed\"}",
+      result.response_payload);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, DEFAULT_TEMP_MIN,
+                           state.thresholds.temp_min);
+
+  /* 只读属性 */
+  const char *read_only =
+      "{\"services\":[{\"service_id\":\"Aquarium\","
+      "\"properties\":{\"alarm_level\":0}}]}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_downlink(
+                                 TEST_DEVICE_ID, topic, read_only,
+                                 strlen(read_only), &state, 0, &result));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"result_code\":1,\"result_desc\":\"property not writable\"}",
+      result.response_payload);
+}
+
+void test_handle_properties_get(void) {
+  AquariumState state;
+  aqua_logic_init(&state);
+  state.props.temperature = 25.5f;
+  state.props.heater = true;
+  IoTDACommandResult result;
+
+  const char *topic = "$oc/devices/" TEST_DEVICE_ID
+                      "/sys/properties/get/request_id=get1";
+  const char *payload = "{\"object_device_id\":\"" TEST_DEVICE_ID
+                        "\",\"service_id\":\"Aquarium\"}";
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_iotda_handle_downlink(
+                                 TEST_DEVICE_ID, topic, payload,
+                                 strlen(payload), &state, 0, &result));
+  TEST_ASSERT_TRUE(result.has_response);
+  TEST_ASSERT_EQUAL_STRING("$oc/devices/" TEST_DEVICE_ID
+                           "/sys/properties/get/response/request_id=get1",
+                           result.response_topic);
+
+  /* 与属性上报格式一致 */
+  char expected[IOTDA_PAYLOAD_MAX_LEN];
+  size_t expected_len;
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_build_properties_json(&state.props, expected,
+                                               sizeof(expected),
+                                               &expected_len));
+  TEST_ASSERT_EQUAL_STRING(expected, result.response_payload);
+  TEST_ASSERT_EQUAL(expected_len, result.response_payload_len);
+  TEST_ASSERT_NOT_NULL(strstr(result.response_payload, "\"heater\":true"));
+
+  /* 缺少 request_id 时无法回包 */
+  TEST_ASSERT_EQUAL(AQUA_ERR_TOPIC_PARSE,
+                    aqua_iotda_handle_properties_get(
+                        TEST_DEVICE_ID, "$oc/devices/x/sys/properties/get/",
+                        &state.props, &result));
+  TEST_ASSERT_FALSE(result.has_response);
+}
+
 /* ============================================================================
  * 测试：空指针
  * ============================================================================
@@ -324,21 +564,21 @@ void test_handle_command_null_ptr(void) {
   AquariumState state;
   IoTDACommandResult result;
 
-  TEST_ASSERT_EQUAL(
-      AQUA_ERR_NULL_PTR,
-      aqua_iotda_handle_command(NULL, "topic", "payload", 7, &state, &result));
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
+                    aqua_iotda_handle_command(NULL, "topic", "payload", 7,
+                                              &state, 0, &result));
   TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
                     aqua_iotda_handle_command(TEST_DEVICE_ID, NULL, "payload",
-                                              7, &state, &result));
+                                              7, &state, 0, &result));
   TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
                     aqua_iotda_handle_command(TEST_DEVICE_ID, "topic", NULL, 0,
-                                              &state, &result));
+                                              &state, 0, &result));
   TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
                     aqua_iotda_handle_command(TEST_DEVICE_ID, "topic",
-                                              "payload", 7, NULL, &result));
+                                              "payload", 7, NULL, 0, &result));
   TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
                     aqua_iotda_handle_command(TEST_DEVICE_ID, "topic",
-                                              "payload", 7, &state, NULL));
+                                              "payload", 7, &state, 0, NULL));
 }
 
 /* ============================================================================
@@ -359,10 +599,18 @@ int main(void) {
   RUN_TEST(test_handle_config_command_success);
   RUN_TEST(test_handle_feed_command);
   RUN_TEST(test_handle_feed_once_delay_command);
+  RUN_TEST(test_handle_control_command_state_snapshot);
+  RUN_TEST(test_handle_threshold_and_config_state_snapshot);
+  RUN_TEST(test_handle_command_state_snapshot_on_failure);
+
+  /* 属性设置/查询测试 */
+  RUN_TEST(test_handle_properties_set);
+  RUN_TEST(test_handle_properties_get);
 
   /* 命令处理错误测试 */
   RUN_TEST(test_handle_command_json_parse_error);
   RUN_TEST(test_handle_command_unknown_command);
+  RUN_TEST(test_handle_command_oversized_password_fails);
   RUN_TEST(test_handle_command_invalid_topic);
   RUN_TEST(test_handle_command_null_ptr);
 
@@ -406,6 +406,34 @@ void test_apply_threshold_command(void) {
   TEST_ASSERT_EQUAL(6 * 3600, state.feed_timer); /* 重置投喂计时器 */
 }
 
+void test_apply_threshold_command_deadbands(void) {
+  AquariumState state;
+  aqua_logic_init(&state);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, DEFAULT_TEMP_DEADBAND,
+                           state.thresholds.temp_deadband);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, DEFAULT_TDS_DEADBAND,
+                           state.thresholds.tds_deadband);
+
+  ParsedCommand cmd = {0};
+  cmd.type = COMMAND_TYPE_SET_THRESHOLDS;
+  cmd.params.threshold.has_temp_deadband = true;
+  cmd.params.threshold.temp_deadband = 0.5f;
+  cmd.params.threshold.has_ph_deadband = true;
+  cmd.params.threshold.ph_deadband = 0.0f;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_logic_apply_command(&state, &cmd));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.5f, state.thresholds.temp_deadband);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.0f, state.thresholds.ph_deadband);
+
+  /* 负值被拒绝，原值保持 */
+  memset(&cmd.params.threshold, 0, sizeof(cmd.params.threshold));
+  cmd.params.threshold.has_tds_deadband = true;
+  cmd.params.threshold.tds_deadband = -1.0f;
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_logic_apply_command(&state, &cmd));
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, DEFAULT_TDS_DEADBAND,
+                           state.thresholds.tds_deadband);
+}
+
 /* ============================================================================
  * 测试：命令应用 - config
  * ============================================================================
@@ -515,6 +543,56 @@ void test_apply_config_command_rejects_out_of_range_calibration(void) {
   TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, state.config.tds_factor);
 }
 
+/* 单字段范围来自 aquarium_schema.def：边界值接受，越界一位拒绝 */
+void test_apply_command_schema_field_bounds(void) {
+  AquariumState state;
+  aqua_logic_init(&state);
+  ParsedCommand cmd;
+
+  memset(&cmd, 0, sizeof(cmd));
+  cmd.type = COMMAND_TYPE_CONTROL;
+  cmd.params.control.has_feed_once_delay = true;
+  cmd.params.control.feed_once_delay = FEED_ONCE_DELAY_MAX_SECONDS;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_logic_apply_command(&state, &cmd));
+  cmd.params.control.feed_once_delay = FEED_ONCE_DELAY_MAX_SECONDS + 1;
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_logic_apply_command(&state, &cmd));
+  cmd.params.control.feed_once_delay = 0;
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_logic_apply_command(&state, &cmd));
+
+  memset(&cmd, 0, sizeof(cmd));
+  cmd.type = COMMAND_TYPE_SET_THRESHOLDS;
+  cmd.params.threshold.has_feed_amount = true;
+  cmd.params.threshold.feed_amount = 10;
+  cmd.params.threshold.has_tds_deadband = true;
+  cmd.params.threshold.tds_deadband = 5000.0f;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_logic_apply_command(&state, &cmd));
+  TEST_ASSERT_EQUAL(10, state.thresholds.feed_amount);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 5000.0f, state.thresholds.tds_deadband);
+  cmd.params.threshold.feed_amount = 11;
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_logic_apply_command(&state, &cmd));
+  TEST_ASSERT_EQUAL(10, state.thresholds.feed_amount);
+
+  /* Wi-Fi 字符串按长度范围校验 */
+  memset(&cmd, 0, sizeof(cmd));
+  cmd.type = COMMAND_TYPE_SET_CONFIG;
+  cmd.params.config.has_wifi_ssid = true;
+  cmd.params.config.has_wifi_password = true;
+  memset(cmd.params.config.wifi_ssid, 'a', WIFI_SSID_MAX_LEN);
+  strcpy(cmd.params.config.wifi_password, "secret");
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_logic_apply_command(&state, &cmd));
+  TEST_ASSERT_EQUAL(WIFI_SSID_MAX_LEN, strlen(state.config.wifi_ssid));
+  TEST_ASSERT_EQUAL_STRING("secret", state.config.wifi_password);
+  TEST_ASSERT_TRUE(state.config_dirty);
+
+  cmd.params.config.wifi_password[0] = '\0';
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_logic_apply_command(&state, &cmd));
+  TEST_ASSERT_EQUAL_STRING("secret", state.config.wifi_password);
+}
+
 void test_immediate_feed_command(void) {
   AquariumState state;
   aqua_logic_init(&state);
@@ -572,12 +650,14 @@ int main(void) {
   RUN_TEST(test_apply_control_command);
   RUN_TEST(test_apply_control_command_rejects_target_temp_out_of_range);
   RUN_TEST(test_apply_threshold_command);
+  RUN_TEST(test_apply_threshold_command_deadbands);
   RUN_TEST(test_apply_config_command);
   RUN_TEST(test_apply_threshold_command_rejects_out_of_range);
   RUN_TEST(test_apply_threshold_command_rejects_target_temp_out_of_range);
   RUN_TEST(test_apply_threshold_command_rejects_invalid_pairs);
   RUN_TEST(test_apply_config_command_rejects_unpaired_wifi_fields);
   RUN_TEST(test_apply_config_command_rejects_out_of_range_calibration);
+  RUN_TEST(test_apply_command_schema_field_bounds);
   RUN_TEST(test_immediate_feed_command);
 
   /* 紧急策略测试 */
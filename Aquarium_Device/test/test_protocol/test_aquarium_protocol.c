@@ -5,8 +5,12 @@
  * 使用 Unity 测试框架验证 JSON 编解码与字段一致性
  */
 
+#include "aquarium_cbor.h"
+#include "aquarium_format.h"
+#include "aquarium_json.h"
 #include "aquarium_protocol.h"
 #include <math.h>
+#include <stdio.h>
 #include <string.h>
 #include <unity.h>
 
@@ -117,6 +121,527 @@ void test_build_properties_json_buffer_small(void) {
   TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL, err);
 }
 
+void test_build_properties_json_values(void) {
+  AquariumProperties props = {.temperature = 26.456f,
+                              .ph = 7.2f,
+                              .tds = 350.0f,
+                              .turbidity = -0.004f,
+                              .water_level = 99.999f,
+                              .heater = true,
+                              .pump_in = false,
+                              .pump_out = true,
+                              .auto_mode = false,
+                              .feed_countdown = -12,
+                              .feeding_in_progress = true,
+                              .alarm_level = 2,
+                              .alarm_muted = false};
+  char buffer[512];
+  size_t len = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_json(&props, buffer,
+                                                        sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"services\":[{\"service_id\":\"Aquarium\",\"properties\":{"
+      "\"temperature\":26.46,\"ph\":7.20,\"tds\":350.00,\"turbidity\":0.00,"
+      "\"water_level\":100.00,\"heater\":true,\"pump_in\":false,"
+      "\"pump_out\":true,\"auto_mode\":false,\"feed_countdown\":-12,"
+      "\"feeding_in_progress\":true,\"alarm_level\":2,\"alarm_muted\":false}}]}",
+      buffer);
+  TEST_ASSERT_EQUAL(strlen(buffer), len);
+}
+
+void test_build_properties_fields_json(void) {
+  AquariumProperties props = {.temperature = 25.0f, .ph = 7.0f, .heater = true,
+                              .alarm_level = 1};
+  char buffer[512];
+  size_t len = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_fields_json(
+                                 &props, AQUA_PROP_PH | AQUA_PROP_HEATER |
+                                             AQUA_PROP_ALARM_LEVEL,
+                                 buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"services\":[{\"service_id\":\"Aquarium\",\"properties\":{"
+      "\"ph\":7.00,\"heater\":true,\"alarm_level\":1}}]}",
+      buffer);
+  TEST_ASSERT_EQUAL(strlen(buffer), len);
+
+  char full[512];
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_fields_json(
+                                 &props, AQUA_PROP_ALL, buffer, sizeof(buffer),
+                                 &len));
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_build_properties_json(&props, full, sizeof(full), &len));
+  TEST_ASSERT_EQUAL_STRING(full, buffer);
+}
+
+void test_build_properties_batch_json(void) {
+  AquaPropertySample samples[2] = {
+      {.props = {.temperature = 25.5f, .ph = 7.1f},
+       .field_mask = AQUA_PROP_TEMPERATURE | AQUA_PROP_PH,
+       .event_time = 1760515200u},
+      {.props = {.temperature = 25.75f, .heater = true},
+       .field_mask = AQUA_PROP_TEMPERATURE | AQUA_PROP_HEATER,
+       .event_time = 0},
+  };
+  char buffer[512];
+  size_t len = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_batch_json(
+                                 samples, 2, buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"services\":["
+      "{\"service_id\":\"Aquarium\",\"properties\":{"
+      "\"temperature\":25.50,\"ph\":7.10},"
+      "\"event_time\":\"20251015T080000Z\"},"
+      "{\"service_id\":\"Aquarium\",\"properties\":{"
+      "\"temperature\":25.75,\"heater\":true}}]}",
+      buffer);
+  TEST_ASSERT_EQUAL(strlen(buffer), len);
+
+  /* 单个无时间戳的全量采样与普通上报一致 */
+  char full[512];
+  samples[0].field_mask = AQUA_PROP_ALL;
+  samples[0].event_time = 0;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_batch_json(
+                                 samples, 1, buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_json(&samples[0].props, full,
+                                                        sizeof(full), &len));
+  TEST_ASSERT_EQUAL_STRING(full, buffer);
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_build_properties_batch_json(samples, 2, buffer, 64,
+                                                     &len));
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
+                    aqua_build_properties_batch_json(NULL, 1, buffer,
+                                                     sizeof(buffer), &len));
+}
+
+void test_fmt_event_time(void) {
+  static const struct {
+    uint32_t seconds;
+    const char *text;
+  } cases[] = {
+      {0u, "19700101T000000Z"},
+      {951782400u, "20000229T000000Z"},
+      {1634587947u, "20211018T201227Z"},
+      {1760515200u, "20251015T080000Z"},
+      {4102444799u, "20991231T235959Z"},
+      {4294967295u, "21060207T062815Z"},
+  };
+  char buf[32];
+  size_t len;
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i) {
+    AquaFmt f;
+    aqua_fmt_init(&f, buf, sizeof(buf));
+    aqua_fmt_event_time(&f, cases[i].seconds);
+    TEST_ASSERT_TRUE(aqua_fmt_finish(&f, &len));
+    TEST_ASSERT_EQUAL_STRING(cases[i].text, buf);
+  }
+}
+
+/* ============================================================================
+ * 测试：预格式化上报帧
+ * ============================================================================
+ */
+
+/* 去掉槽位填充空格（上报 JSON 的字符串值中不含空格） */
+static void strip_spaces(const char *in, char *out) {
+  while (*in) {
+    if (*in != ' ') {
+      *out++ = *in;
+    }
+    in++;
+  }
+  *out = '\0';
+}
+
+void test_build_sub_devices_report_json(void) {
+  AquaSubDeviceSample devices[2] = {
+      {.device_id = "gw_tank1",
+       .sample = {.props = {.temperature = 25.5f},
+                  .field_mask = AQUA_PROP_TEMPERATURE,
+                  .event_time = 1760515200u}},
+      {.device_id = "gw_tank2",
+       .sample = {.props = {.ph = 6.9f, .heater = true},
+                  .field_mask = AQUA_PROP_PH | AQUA_PROP_HEATER}},
+  };
+  char buffer[512];
+  size_t len = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_sub_devices_report_json(
+                                 devices, 2, buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"devices\":["
+      "{\"device_id\":\"gw_tank1\",\"services\":["
+      "{\"service_id\":\"Aquarium\",\"properties\":{"
+      "\"temperature\":25.50},\"event_time\":\"20251015T080000Z\"}]},"
+      "{\"device_id\":\"gw_tank2\",\"services\":["
+      "{\"service_id\":\"Aquarium\",\"properties\":{"
+      "\"ph\":6.90,\"heater\":true}}]}]}",
+      buffer);
+  TEST_ASSERT_EQUAL(strlen(buffer), len);
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_build_sub_devices_report_json(devices, 2, buffer, 96,
+                                                       &len));
+  devices[1].device_id = NULL;
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
+                    aqua_build_sub_devices_report_json(
+                        devices, 2, buffer, sizeof(buffer), &len));
+}
+
+void test_report_frame_matches_compact_json(void) {
+  static AquaReportFrame frame;
+  AquariumProperties props = {.temperature = 26.456f,
+                              .ph = 7.2f,
+                              .tds = 1350.0f,
+                              .turbidity = -0.004f,
+                              .water_level = 85.0f,
+                              .heater = true,
+                              .pump_out = true,
+                              .feed_countdown = -12,
+                              .feeding_in_progress = true,
+                              .alarm_level = 2};
+  char compact[512];
+  char stripped[AQUA_REPORT_FRAME_MAX_LEN];
+  size_t compact_len = 0;
+  size_t frame_len = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_report_frame_init(&frame));
+  size_t init_len = frame.len;
+
+  for (int round = 0; round < 3; ++round) {
+    TEST_ASSERT_EQUAL(AQUA_OK,
+                      aqua_report_frame_update(&frame, &props, &frame_len));
+    TEST_ASSERT_EQUAL(init_len, frame_len);
+    TEST_ASSERT_EQUAL(frame_len, strlen(frame.buf));
+
+    TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_json(
+                                   &props, compact, sizeof(compact),
+                                   &compact_len));
+    strip_spaces(frame.buf, stripped);
+    TEST_ASSERT_EQUAL_STRING(compact, stripped);
+
+    /* 数值变短、布尔翻转后不得残留旧内容 */
+    props.tds /= 100.0f;
+    props.feed_countdown = 7;
+    props.heater = !props.heater;
+    props.pump_in = !props.pump_in;
+  }
+}
+
+void test_report_frame_saturates_and_sanitizes(void) {
+  static AquaReportFrame frame;
+  AquariumProperties props = {.temperature = NAN,
+                              .ph = INFINITY,
+                              .tds = 1e9f,
+                              .turbidity = -1e9f,
+                              .water_level = 100.0f,
+                              .feed_countdown = INT32_MIN,
+                              .alarm_level = INT32_MAX};
+  size_t len = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_report_frame_init(&frame));
+  size_t init_len = frame.len;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_report_frame_update(&frame, &props, &len));
+  TEST_ASSERT_EQUAL(init_len, len);
+
+  TEST_ASSERT_NOT_NULL(strstr(frame.buf, "\"temperature\":     0.00,"));
+  TEST_ASSERT_NOT_NULL(strstr(frame.buf, "\"tds\": 99999.99,"));
+  TEST_ASSERT_NOT_NULL(strstr(frame.buf, "\"turbidity\":-99999.99,"));
+  TEST_ASSERT_NOT_NULL(strstr(frame.buf, "\"feed_countdown\":-2147483648,"));
+  TEST_ASSERT_NOT_NULL(strstr(frame.buf, "\"alarm_level\": 2147483647,"));
+  TEST_ASSERT_NOT_NULL(strstr(frame.buf, "\"alarm_muted\":false}}]}"));
+  TEST_ASSERT_NULL(strstr(frame.buf, "nan"));
+  TEST_ASSERT_NULL(strstr(frame.buf, "inf"));
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR, aqua_report_frame_init(NULL));
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
+                    aqua_report_frame_update(&frame, NULL, &len));
+}
+
+/* ============================================================================
+ * 测试：属性上报 JSON 解析
+ * ============================================================================
+ */
+
+static const AquariumProperties DECODE_PROPS = {.temperature = 26.37f,
+                                                .ph = 7.18f,
+                                                .tds = 352.6f,
+                                                .turbidity = 14.92f,
+                                                .water_level = 85.4f,
+                                                .heater = true,
+                                                .pump_out = true,
+                                                .auto_mode = true,
+                                                .feed_countdown = -3600,
+                                                .alarm_level = 2,
+                                                .alarm_muted = true};
+
+static void assert_props_equal(const AquariumProperties *expected,
+                               const AquariumProperties *actual) {
+  /* 上报保留 2 位小数 */
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, expected->temperature, actual->temperature);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, expected->ph, actual->ph);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, expected->tds, actual->tds);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, expected->turbidity, actual->turbidity);
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, expected->water_level, actual->water_level);
+  TEST_ASSERT_EQUAL(expected->heater, actual->heater);
+  TEST_ASSERT_EQUAL(expected->pump_in, actual->pump_in);
+  TEST_ASSERT_EQUAL(expected->pump_out, actual->pump_out);
+  TEST_ASSERT_EQUAL(expected->auto_mode, actual->auto_mode);
+  TEST_ASSERT_EQUAL(expected->feed_countdown, actual->feed_countdown);
+  TEST_ASSERT_EQUAL(expected->feeding_in_progress,
+                    actual->feeding_in_progress);
+  TEST_ASSERT_EQUAL(expected->alarm_level, actual->alarm_level);
+  TEST_ASSERT_EQUAL(expected->alarm_muted, actual->alarm_muted);
+}
+
+void test_parse_properties_json_round_trip(void) {
+  char buffer[512];
+  size_t len = 0;
+  size_t count = 0;
+  AquaPropertySample out[2];
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_json(
+                                 &DECODE_PROPS, buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_properties_json(buffer, len, out, 2, &count));
+  TEST_ASSERT_EQUAL(1, count);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_ALL, out[0].field_mask);
+  TEST_ASSERT_EQUAL(0, out[0].event_time);
+  assert_props_equal(&DECODE_PROPS, &out[0].props);
+
+  /* 预格式化帧中数值带前导空格，同样可以解析 */
+  static AquaReportFrame frame;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_report_frame_init(&frame));
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_report_frame_update(&frame, &DECODE_PROPS, &len));
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_properties_json(frame.buf, len, out, 2, &count));
+  TEST_ASSERT_EQUAL(1, count);
+  assert_props_equal(&DECODE_PROPS, &out[0].props);
+}
+
+void test_parse_properties_json_batch(void) {
+  AquaPropertySample in[3] = {
+      {.props = DECODE_PROPS,
+       .field_mask = AQUA_PROP_TEMPERATURE | AQUA_PROP_PH,
+       .event_time = 951782400u},
+      {.props = DECODE_PROPS,
+       .field_mask = AQUA_PROP_HEATER | AQUA_PROP_FEED_COUNTDOWN,
+       .event_time = 4294967295u},
+      {.props = DECODE_PROPS, .field_mask = AQUA_PROP_ALARM_LEVEL},
+  };
+  AquaPropertySample out[3];
+  char buffer[512];
+  size_t len = 0;
+  size_t count = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_batch_json(
+                                 in, 3, buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_properties_json(buffer, len, out, 3, &count));
+  TEST_ASSERT_EQUAL(3, count);
+  for (size_t i = 0; i < 3; ++i) {
+    TEST_ASSERT_EQUAL_HEX32(in[i].field_mask, out[i].field_mask);
+    TEST_ASSERT_EQUAL_UINT32(in[i].event_time, out[i].event_time);
+  }
+  TEST_ASSERT_FLOAT_WITHIN(0.005f, 26.37f, out[0].props.temperature);
+  TEST_ASSERT_TRUE(out[1].props.heater);
+  TEST_ASSERT_EQUAL(-3600, out[1].props.feed_countdown);
+  TEST_ASSERT_EQUAL(0, out[1].props.temperature);
+  TEST_ASSERT_EQUAL(2, out[2].props.alarm_level);
+
+  /* 容量不足：写满前两个并报错 */
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_parse_properties_json(buffer, len, out, 2, &count));
+  TEST_ASSERT_EQUAL(2, count);
+}
+
+void test_parse_properties_json_skips_foreign_content(void) {
+  const char *json =
+      "{ \"services\" : [ {\"properties\":{\"temperature\":\"hot\"},"
+      "\"service_id\":\"Other\"},\n"
+      "{\"properties\":{\"unknown\":[1,{\"a\":\"}\"}],\"ph\":6.5},"
+      "\"service_id\":\"Aquarium\",\"extra\":{\"x\":[]}} ],"
+      "\"trailer\":null }\r\n";
+  AquaPropertySample out[2];
+  size_t count = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_properties_json(json, strlen(json),
+                                                        out, 2, &count));
+  TEST_ASSERT_EQUAL(1, count);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_PH, out[0].field_mask);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 6.5f, out[0].props.ph);
+}
+
+void test_parse_properties_json_errors(void) {
+  static const char *const bad[] = {
+      "",
+      "{",
+      "{\"services\":[",
+      "{\"services\":[{\"service_id\":\"Aquarium\",\"properties\":{",
+      "{\"services\":[]",
+      "{\"services\":[]}x",
+      "{\"services\":[],}",
+      "{\"services\":[{\"service_id\":\"Aquarium\","
+      "\"properties\":{\"heater\":1}}]}",
+      "{\"services\":[{\"service_id\":\"Aquarium\","
+      "\"properties\":{\"temperature\":\"26\"}}]}",
+      "{\"services\":[{\"service_id\":\"Aquarium\","
+      "\"event_time\":\"20251315T080000Z\"}]}",
+      "{\"services\":[{\"service_id\":\"Aquarium\","
+      "\"event_time\":\"2025-10-15T08:00:00Z\"}]}",
+  };
+  AquaPropertySample out[1];
+  size_t count = 0;
+
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+    TEST_ASSERT_EQUAL_MESSAGE(
+        AQUA_ERR_JSON_PARSE,
+        aqua_parse_properties_json(bad[i], strlen(bad[i]), out, 1, &count),
+        bad[i]);
+  }
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_MISSING_FIELD,
+                    aqua_parse_properties_json("{}", 2, out, 1, &count));
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
+                    aqua_parse_properties_json(NULL, 0, out, 1, &count));
+}
+
+/* ============================================================================
+ * 测试：CBOR 属性上报编解码
+ * ============================================================================
+ */
+
+void test_cbor_known_encoding(void) {
+  AquaPropertySample s = {.props = {.temperature = 25.5f,
+                                    .heater = true,
+                                    .feed_countdown = -2},
+                          .field_mask = AQUA_PROP_TEMPERATURE |
+                                        AQUA_PROP_HEATER |
+                                        AQUA_PROP_FEED_COUNTDOWN,
+                          .event_time = 1000};
+  /* [1, {0: 2550, 5: true, 9: -2, 23: 1000}] */
+  static const uint8_t expected[] = {0x82, 0x01, 0xA4, 0x00, 0x19, 0x09,
+                                     0xF6, 0x05, 0xF5, 0x09, 0x21, 0x17,
+                                     0x19, 0x03, 0xE8};
+  uint8_t buf[64];
+  size_t len = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_build_properties_cbor(&s, 1, buf, sizeof(buf), &len));
+  TEST_ASSERT_EQUAL(sizeof(expected), len);
+  TEST_ASSERT_EQUAL_MEMORY(expected, buf, len);
+}
+
+void test_cbor_round_trip_full_report(void) {
+  AquaPropertySample in = {.props = DECODE_PROPS, .field_mask = AQUA_PROP_ALL};
+  AquaPropertySample out[1];
+  uint8_t buf[AQUA_CBOR_SAMPLE_MAX_LEN + 2];
+  char json[512];
+  size_t len = 0;
+  size_t json_len = 0;
+  size_t count = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_build_properties_cbor(&in, 1, buf, sizeof(buf), &len));
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_json(&DECODE_PROPS, json,
+                                                        sizeof(json),
+                                                        &json_len));
+  /* 全量上报不到 JSON 的 1/5 */
+  TEST_ASSERT_TRUE(len * 5 < json_len);
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_properties_cbor(buf, len, out, 1, &count));
+  TEST_ASSERT_EQUAL(1, count);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_ALL, out[0].field_mask);
+  TEST_ASSERT_EQUAL(0, out[0].event_time);
+  assert_props_equal(&DECODE_PROPS, &out[0].props);
+}
+
+void test_cbor_round_trip_batch_and_extremes(void) {
+  AquaPropertySample in[3] = {
+      {.props = {.temperature = -0.125f, .ph = NAN, .tds = 1e12f},
+       .field_mask = AQUA_PROP_TEMPERATURE | AQUA_PROP_PH | AQUA_PROP_TDS,
+       .event_time = 4294967295u},
+      {.props = {.feed_countdown = INT32_MIN, .alarm_level = INT32_MAX},
+       .field_mask = AQUA_PROP_FEED_COUNTDOWN | AQUA_PROP_ALARM_LEVEL},
+      {.field_mask = 0, .event_time = 1},
+  };
+  AquaPropertySample out[3];
+  uint8_t buf[128];
+  size_t len = 0;
+  size_t count = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_build_properties_cbor(in, 3, buf, sizeof(buf), &len));
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_properties_cbor(buf, len, out, 3, &count));
+  TEST_ASSERT_EQUAL(3, count);
+
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, -0.13f, out[0].props.temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.0f, out[0].props.ph);
+  TEST_ASSERT_FLOAT_WITHIN(1.0f, 21474836.47f, out[0].props.tds);
+  TEST_ASSERT_EQUAL_UINT32(4294967295u, out[0].event_time);
+  TEST_ASSERT_EQUAL(INT32_MIN, out[1].props.feed_countdown);
+  TEST_ASSERT_EQUAL(INT32_MAX, out[1].props.alarm_level);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_FEED_COUNTDOWN | AQUA_PROP_ALARM_LEVEL,
+                          out[1].field_mask);
+  TEST_ASSERT_EQUAL(0, out[2].field_mask);
+  TEST_ASSERT_EQUAL_UINT32(1, out[2].event_time);
+
+  /* 容量不足：写入前面的采样并报告 */
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_parse_properties_cbor(buf, len, out, 2, &count));
+  TEST_ASSERT_EQUAL(2, count);
+
+  /* 输出缓冲区不足 */
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_build_properties_cbor(in, 3, buf, len - 1, &len));
+}
+
+void test_cbor_parse_errors(void) {
+  static const struct {
+    uint8_t data[8];
+    size_t len;
+  } bad[] = {
+      {{0}, 0},                                 /* 空 */
+      {{0xA0}, 1},                              /* 顶层不是数组 */
+      {{0x80}, 1},                              /* 缺少版本 */
+      {{0x81, 0x02}, 2},                        /* 版本不符 */
+      {{0x9F, 0x01, 0xFF}, 3},                  /* 不定长数组 */
+      {{0x82, 0x01, 0xA1, 0x00}, 4},            /* 截断 */
+      {{0x82, 0x01, 0xA1, 0x05, 0x01}, 5},      /* BOOL 字段给了整数 */
+      {{0x82, 0x01, 0xA1, 0x00, 0xF5}, 5},      /* FLOAT 字段给了布尔 */
+      {{0x82, 0x01, 0xA1, 0x17, 0x20}, 5},      /* 负的 event_time */
+      {{0x82, 0x01, 0xA1, 0x00, 0x40}, 5},      /* 字节串值 */
+      {{0x82, 0x01, 0xA1, 0x61, 0x61, 0x00}, 6}, /* 文本键 */
+      {{0x82, 0x01, 0xA0, 0x00}, 4},            /* 尾部多余数据 */
+  };
+  AquaPropertySample out[2];
+  size_t count = 0;
+
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+    TEST_ASSERT_EQUAL(AQUA_ERR_JSON_PARSE,
+                      aqua_parse_properties_cbor(bad[i].data, bad[i].len, out,
+                                                 2, &count));
+  }
+
+  /* 未知的整数键跳过 */
+  static const uint8_t unknown[] = {0x82, 0x01, 0xA2, 0x10, 0x05, 0x05, 0xF5};
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_properties_cbor(
+                                 unknown, sizeof(unknown), out, 2, &count));
+  TEST_ASSERT_EQUAL(1, count);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_HEATER, out[0].field_mask);
+  TEST_ASSERT_TRUE(out[0].props.heater);
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
+                    aqua_parse_properties_cbor(NULL, 0, out, 1, &count));
+}
+
 /* ============================================================================
  * 测试：命令响应 JSON 生成
  * ============================================================================
@@ -159,6 +684,31 @@ void test_build_response_json_failure(void) {
   TEST_ASSERT_NOT_NULL(strstr(buffer, "\"error\":\"heater malfunction\""));
 }
 
+void test_build_command_response_json(void) {
+  char buffer[256];
+  size_t len = 0;
+
+  /* 命令名较长时 response_name 仍完整输出，错误信息按 JSON 转义 */
+  AquaError err = aqua_build_command_response_json(
+      2, "set_thresholds", "bad \"temp_min\"", buffer, sizeof(buffer), &len);
+  TEST_ASSERT_EQUAL(AQUA_OK, err);
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"result_code\":2,\"response_name\":\"set_thresholds_response\","
+      "\"paras\":{\"result\":\"failed\",\"error\":\"bad \\\"temp_min\\\"\"}}",
+      buffer);
+  TEST_ASSERT_EQUAL(strlen(buffer), len);
+
+  err = aqua_build_command_response_json(0, "control", NULL, buffer,
+                                         sizeof(buffer), &len);
+  TEST_ASSERT_EQUAL(AQUA_OK, err);
+  TEST_ASSERT_NOT_NULL(strstr(buffer, "\"result\":\"success\""));
+  TEST_ASSERT_NULL(strstr(buffer, "\"error\":"));
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_build_command_response_json(0, "control", NULL,
+                                                     buffer, 20, &len));
+}
+
 /* ============================================================================
  * 测试：命令解析 - control
  * ============================================================================
@@ -224,7 +774,9 @@ void test_parse_threshold_command(void) {
                      "\"level_max\":95,"
                      "\"feed_interval\":12,"
                      "\"feed_amount\":\"2\","
-                     "\"target_temp\":26.5"
+                     "\"target_temp\":26.5,"
+                     "\"temp_deadband\":0.2,"
+                     "\"tds_deadband\":10"
                      "}"
                      "}";
 
@@ -246,6 +798,11 @@ void test_parse_threshold_command(void) {
   TEST_ASSERT_EQUAL(2, cmd.params.threshold.feed_amount);
   TEST_ASSERT_TRUE(cmd.params.threshold.has_target_temp);
   TEST_ASSERT_FLOAT_WITHIN(0.1f, 26.5f, cmd.params.threshold.target_temp);
+  TEST_ASSERT_TRUE(cmd.params.threshold.has_temp_deadband);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 0.2f, cmd.params.threshold.temp_deadband);
+  TEST_ASSERT_TRUE(cmd.params.threshold.has_tds_deadband);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 10.0f, cmd.params.threshold.tds_deadband);
+  TEST_ASSERT_FALSE(cmd.params.threshold.has_ph_deadband);
 }
 
 /* ============================================================================
@@ -302,6 +859,747 @@ void test_parse_config_command_with_escaped_strings(void) {
   TEST_ASSERT_EQUAL_STRING("Pa\\\\ss\\\"word", cmd.params.config.wifi_password);
 }
 
+/* 按转义后的原文计长度会超出值缓冲区，解码后的内容仍在字段容量内 */
+void test_parse_config_command_with_unicode_escaped_password(void) {
+  char json[512];
+  size_t len = (size_t)snprintf(json, sizeof(json),
+                                "{\"service_id\":\"aquariumConfig\","
+                                "\"command_name\":\"set_config\","
+                                "\"paras\":{\"wifi_ssid\":\"Lab\","
+                                "\"wifi_password\":\"");
+  for (int i = 0; i < 40; ++i) {
+    len += (size_t)snprintf(json + len, sizeof(json) - len, "\\u0041");
+  }
+  len += (size_t)snprintf(json + len, sizeof(json) - len, "\"}}");
+
+  ParsedCommand cmd;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_command_json(json, len, &cmd));
+  TEST_ASSERT_TRUE(cmd.params.config.has_wifi_password);
+  TEST_ASSERT_EQUAL(40, strlen(cmd.params.config.wifi_password));
+  TEST_ASSERT_EQUAL('A', cmd.params.config.wifi_password[39]);
+}
+
+/* 值超出字段容量时报错，不能当作缺失而回报成功 */
+void test_parse_config_command_rejects_oversized_value(void) {
+  char json[512];
+  size_t len = (size_t)snprintf(json, sizeof(json),
+                                "{\"service_id\":\"aquariumConfig\","
+                                "\"command_name\":\"set_config\","
+                                "\"paras\":{\"wifi_password\":\"");
+  for (int i = 0; i < WIFI_PASSWORD_MAX_LEN + 1; ++i) {
+    json[len++] = 'p';
+  }
+  len += (size_t)snprintf(json + len, sizeof(json) - len, "\"}}");
+
+  ParsedCommand cmd;
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_VALUE,
+                    aqua_parse_command_json(json, len, &cmd));
+
+  /* 同名键出现在别的命令里不影响该命令 */
+  const char *control = "{\"service_id\":\"aquarium_control\","
+                        "\"command_name\":\"control\","
+                        "\"paras\":{\"heater\":true,\"wifi_password\":"
+                        "\"0123456789012345678901234567890123456789"
+                        "0123456789012345678901234567890123456789\"}}";
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_command_json(control, strlen(control), &cmd));
+  TEST_ASSERT_TRUE(cmd.params.control.has_heater);
+}
+
+void test_parse_command_keys_scoped_to_paras(void) {
+  /* paras 之外的同名键不能被当作参数 */
+  const char *json = "{"
+                     "\"target_temp\":99.0,"
+                     "\"service_id\":\"aquarium_control\","
+                     "\"command_name\":\"control\","
+                     "\"meta\":{\"heater\":true,\"note\":\"\\\"feed\\\":true\"},"
+                     "\"paras\":{"
+                     "\"opts\":{\"pump_in\":true},"
+                     "\"pump_out\":true"
+                     "}"
+                     "}";
+
+  ParsedCommand cmd;
+  AquaError err = aqua_parse_command_json(json, strlen(json), &cmd);
+
+  TEST_ASSERT_EQUAL(AQUA_OK, err);
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_CONTROL, cmd.type);
+  TEST_ASSERT_FALSE(cmd.params.control.has_target_temp);
+  TEST_ASSERT_FALSE(cmd.params.control.has_heater);
+  TEST_ASSERT_FALSE(cmd.params.control.has_feed);
+  TEST_ASSERT_FALSE(cmd.params.control.has_pump_in);
+  TEST_ASSERT_TRUE(cmd.params.control.has_pump_out);
+  TEST_ASSERT_TRUE(cmd.params.control.pump_out);
+}
+
+void test_parse_command_paras_before_service_id(void) {
+  const char *json = "{ \"paras\" : { \"ph_offset\" : -0.25 } ,"
+                     " \"command_name\" : \"set_config\" ,"
+                     " \"service_id\" : \"aquariumConfig\" }";
+
+  ParsedCommand cmd;
+  AquaError err = aqua_parse_command_json(json, strlen(json), &cmd);
+
+  TEST_ASSERT_EQUAL(AQUA_OK, err);
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_SET_CONFIG, cmd.type);
+  TEST_ASSERT_TRUE(cmd.params.config.has_ph_offset);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -0.25f, cmd.params.config.ph_offset);
+  TEST_ASSERT_FALSE(cmd.params.config.has_wifi_ssid);
+}
+
+void test_parse_command_malformed(void) {
+  ParsedCommand cmd;
+  const char *truncated = "{\"service_id\":\"aquarium_control\","
+                          "\"command_name\":\"control\","
+                          "\"paras\":{\"heater\":tr";
+  TEST_ASSERT_EQUAL(AQUA_ERR_JSON_PARSE,
+                    aqua_parse_command_json(truncated, strlen(truncated), &cmd));
+  /* 截断前已解析的 command_name 仍可用于生成错误响应 */
+  TEST_ASSERT_EQUAL_STRING("control", cmd.command_name);
+
+  const char *not_object = "[1,2,3]";
+  TEST_ASSERT_EQUAL(AQUA_ERR_JSON_PARSE,
+                    aqua_parse_command_json(not_object, strlen(not_object), &cmd));
+
+  const char *no_paras = "{\"service_id\":\"aquarium_control\","
+                         "\"command_name\":\"control\"}";
+  TEST_ASSERT_EQUAL(AQUA_ERR_MISSING_FIELD,
+                    aqua_parse_command_json(no_paras, strlen(no_paras), &cmd));
+}
+
+void test_parse_command_not_nul_terminated(void) {
+  /* 解析只读取 [json, json + len)，之后的字节不得影响结果 */
+  const char *body = "{\"service_id\":\"aquarium_control\","
+                     "\"command_name\":\"control\","
+                     "\"paras\":{\"feed_once_delay\":42}}";
+  char buf[256];
+  size_t len = strlen(body);
+  memcpy(buf, body, len);
+  memset(buf + len, '7', sizeof(buf) - len);
+
+  ParsedCommand cmd;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_command_json(buf, len, &cmd));
+  TEST_ASSERT_TRUE(cmd.params.control.has_feed_once_delay);
+  TEST_ASSERT_EQUAL(42, cmd.params.control.feed_once_delay);
+
+  /* 长度截断在数字中间：只能看到 "4" */
+  const char *cut = "{\"service_id\":\"aquarium_control\","
+                    "\"command_name\":\"control\","
+                    "\"paras\":{\"feed_once_delay\":42}}";
+  size_t cut_len = (size_t)(strstr(cut, "42") - cut) + 1;
+  TEST_ASSERT_EQUAL(AQUA_ERR_JSON_PARSE,
+                    aqua_parse_command_json(cut, cut_len, &cmd));
+}
+
+/*
+ * 由 aquarium_schema.def 生成包含全部参数的命令，确认解析表覆盖每个字段。
+ * 各类型的示例值均落在合法范围内。
+ */
+#define SCHEMA_SAMPLE_BOOL "true"
+#define SCHEMA_SAMPLE_INT "1"
+#define SCHEMA_SAMPLE_INT_OR_STRING "\"1\""
+#define SCHEMA_SAMPLE_FLOAT "1.5"
+#define SCHEMA_SAMPLE_STRING "\"x\""
+
+static void parse_schema_command(const char *json, ParsedCommand *cmd) {
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_command_json(json, strlen(json), cmd));
+}
+
+void test_parse_command_schema_covers_all_fields(void) {
+  ParsedCommand cmd;
+
+  parse_schema_command(
+      "{\"service_id\":\"aquarium_control\",\"command_name\":\"control\","
+      "\"paras\":{"
+#define AQUA_CONTROL_PARAM(name, type, min, max)                               \
+  "\"" #name "\":" SCHEMA_SAMPLE_##type ","
+#include "aquarium_schema.def"
+      "\"_end\":0}}",
+      &cmd);
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_CONTROL, cmd.type);
+#define AQUA_CONTROL_PARAM(name, type, min, max)                               \
+  TEST_ASSERT_TRUE(cmd.params.control.has_##name);
+#include "aquarium_schema.def"
+
+  parse_schema_command(
+      "{\"service_id\":\"aquarium_threshold\","
+      "\"command_name\":\"set_thresholds\",\"paras\":{"
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  "\"" #name "\":" SCHEMA_SAMPLE_##type ","
+#define AQUA_THRESHOLD_RUNTIME(name, type, min, max)                           \
+  "\"" #name "\":" SCHEMA_SAMPLE_##type ","
+#include "aquarium_schema.def"
+      "\"_end\":0}}",
+      &cmd);
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_SET_THRESHOLDS, cmd.type);
+#define AQUA_THRESHOLD_PARAM(name, type, min, max, def)                        \
+  TEST_ASSERT_TRUE(cmd.params.threshold.has_##name);
+#define AQUA_THRESHOLD_RUNTIME(name, type, min, max)                           \
+  TEST_ASSERT_TRUE(cmd.params.threshold.has_##name);
+#include "aquarium_schema.def"
+  TEST_ASSERT_EQUAL(1, cmd.params.threshold.feed_amount);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.5f, cmd.params.threshold.temp_deadband);
+
+  parse_schema_command(
+      "{\"service_id\":\"aquariumConfig\",\"command_name\":\"set_config\","
+      "\"paras\":{"
+#define AQUA_CONFIG_PARAM(name, type, min, max, def)                           \
+  "\"" #name "\":" SCHEMA_SAMPLE_##type ","
+#include "aquarium_schema.def"
+      "\"_end\":0}}",
+      &cmd);
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_SET_CONFIG, cmd.type);
+#define AQUA_CONFIG_PARAM(name, type, min, max, def)                           \
+  TEST_ASSERT_TRUE(cmd.params.config.has_##name);
+#include "aquarium_schema.def"
+  TEST_ASSERT_EQUAL_STRING("x", cmd.params.config.wifi_password);
+}
+
+void test_parse_command_key_near_misses(void) {
+  ParsedCommand cmd;
+  const char *json;
+
+  /* 与已知键只差一个字符、大小写或长度的键一律忽略 */
+  json = "{\"service_id\":\"aquarium_control\",\"command_name\":\"control\","
+         "\"paras\":{\"heate\":true,\"heaterr\":true,\"Heater\":true,"
+         "\"pump_i\\n\":true,\"service_id\":true,\"mute\":true}}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_command_json(json, strlen(json), &cmd));
+  TEST_ASSERT_FALSE(cmd.params.control.has_heater);
+  TEST_ASSERT_FALSE(cmd.params.control.has_pump_in);
+  TEST_ASSERT_TRUE(cmd.params.control.has_mute);
+
+  /* 命令键表中的取值出现在错误位置不会被当作参数 */
+  json = "{\"service_id\":\"aquarium_control\",\"command_name\":\"control\","
+         "\"paras\":{\"set_config\":true,\"paras\":true}}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_command_json(json, strlen(json), &cmd));
+
+  /* service_id / command_name 必须精确匹配且属于同一类命令 */
+  json = "{\"service_id\":\"aquarium_contro\",\"command_name\":\"control\","
+         "\"paras\":{}}";
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_parse_command_json(json, strlen(json), &cmd));
+  json = "{\"service_id\":\"aquarium_control\",\"command_name\":\"set_config\","
+         "\"paras\":{}}";
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_parse_command_json(json, strlen(json), &cmd));
+  json = "{\"service_id\":\"paras\",\"command_name\":\"paras\",\"paras\":{}}";
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_parse_command_json(json, strlen(json), &cmd));
+}
+
+void test_property_bits_follow_schema(void) {
+  TEST_ASSERT_EQUAL(13, AQUA_REPORT_FIELD_COUNT);
+  TEST_ASSERT_EQUAL_HEX32(0x1FFFu, AQUA_PROP_ALL);
+  TEST_ASSERT_EQUAL_HEX32(1u << 0, AQUA_PROP_TEMPERATURE);
+  TEST_ASSERT_EQUAL_HEX32(1u << 12, AQUA_PROP_ALARM_MUTED);
+}
+
+void test_parse_command_number_formats(void) {
+  const char *json = "{\"service_id\":\"aquarium_threshold\","
+                     "\"command_name\":\"set_thresholds\","
+                     "\"paras\":{"
+                     "\"temp_min\":-1.5e1,"
+                     "\"temp_max\":2.85E+1,"
+                     "\"ph_min\":650e-2,"
+                     "\"ph_max\":7,"
+                     "\"tds_warn\":-12,"
+                     "\"tds_critical\":99999999999,"
+                     "\"level_min\":\"20x\","
+                     "\"feed_amount\":\"-3\""
+                     "}}";
+
+  ParsedCommand cmd;
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_parse_command_json(json, strlen(json), &cmd));
+
+  const ThresholdCommandParams *p = &cmd.params.threshold;
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -15.0f, p->temp_min);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 28.5f, p->temp_max);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 6.5f, p->ph_min);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 7.0f, p->ph_max);
+  TEST_ASSERT_TRUE(p->has_tds_warn);
+  TEST_ASSERT_EQUAL(-12, p->tds_warn);
+  /* 超出 int32 范围的整数不再静默截断 */
+  TEST_ASSERT_FALSE(p->has_tds_critical);
+  TEST_ASSERT_FALSE(p->has_level_min);
+  TEST_ASSERT_TRUE(p->has_feed_amount);
+  TEST_ASSERT_EQUAL(-3, p->feed_amount);
+}
+
+/* ============================================================================
+ * 测试：属性设置解析
+ * ============================================================================
+ */
+
+void test_parse_properties_set_aquarium(void) {
+  const char *json =
+      "{\"object_device_id\":\"dev01\",\"services\":[{\"properties\":"
+      "{\"heater\":true,\"alarm_muted\":true,\"unknown\":1},"
+      "\"service_id\":\"Aquarium\"}]}";
+  ParsedCommand cmd;
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_properties_set_json(json, strlen(json), &cmd));
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_CONTROL, cmd.type);
+  TEST_ASSERT_EQUAL_STRING("Aquarium", cmd.service_id);
+  TEST_ASSERT_TRUE(cmd.params.control.has_heater);
+  TEST_ASSERT_TRUE(cmd.params.control.heater);
+  TEST_ASSERT_TRUE(cmd.params.control.has_mute);
+  TEST_ASSERT_TRUE(cmd.params.control.mute);
+  TEST_ASSERT_FALSE(cmd.params.control.has_pump_in);
+  TEST_ASSERT_FALSE(cmd.params.control.has_auto_mode);
+}
+
+void test_parse_properties_set_command_services(void) {
+  const char *json =
+      "{\"services\":[{\"service_id\":\"aquarium_threshold\","
+      "\"properties\":{\"temp_min\":22.5,\"feed_amount\":\"3\"}},"
+      "{\"service_id\":\"aquarium_threshold\","
+      "\"properties\":{\"level_max\":90}}]}";
+  ParsedCommand cmd;
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_properties_set_json(json, strlen(json), &cmd));
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_SET_THRESHOLDS, cmd.type);
+  TEST_ASSERT_TRUE(cmd.params.threshold.has_temp_min);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 22.5f, cmd.params.threshold.temp_min);
+  TEST_ASSERT_TRUE(cmd.params.threshold.has_feed_amount);
+  TEST_ASSERT_EQUAL(3, cmd.params.threshold.feed_amount);
+  TEST_ASSERT_TRUE(cmd.params.threshold.has_level_max);
+  TEST_ASSERT_EQUAL(90, cmd.params.threshold.level_max);
+  TEST_ASSERT_FALSE(cmd.params.threshold.has_ph_min);
+
+  json = "{\"services\":[{\"service_id\":\"aquariumConfig\","
+         "\"properties\":{\"wifi_ssid\":\"Home\",\"tds_factor\":1.5}}]}";
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_properties_set_json(json, strlen(json), &cmd));
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_SET_CONFIG, cmd.type);
+  TEST_ASSERT_EQUAL_STRING("Home", cmd.params.config.wifi_ssid);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.5f, cmd.params.config.tds_factor);
+}
+
+void test_parse_properties_set_errors(void) {
+  static const struct {
+    const char *json;
+    AquaError expected;
+  } CASES[] = {
+      {"{\"services\":[{\"service_id\":\"Aquarium\","
+       "\"properties\":{\"temperature\":30}}]}",
+       AQUA_ERR_INVALID_COMMAND},
+      {"{\"services\":[{\"service_id\":\"Aquarium\","
+       "\"properties\":{\"heater\":true}},{\"service_id\":"
+       "\"aquariumConfig\",\"properties\":{\"ph_offset\":1}}]}",
+       AQUA_ERR_INVALID_COMMAND},
+      {"{\"services\":[{\"service_id\":\"Pond\","
+       "\"properties\":{\"heater\":true}}]}",
+       AQUA_ERR_INVALID_SERVICE},
+      {"{\"services\":[{\"service_id\":\"Aquarium\","
+       "\"properties\":{\"unknown\":1}}]}",
+       AQUA_ERR_MISSING_FIELD},
+      {"{\"services\":[{\"properties\":{\"heater\":true}}]}",
+       AQUA_ERR_MISSING_FIELD},
+      {"{\"object_device_id\":\"dev01\"}", AQUA_ERR_MISSING_FIELD},
+      {"{\"services\":[{\"service_id\":\"Aquarium\","
+       "\"properties\":{\"heater\":1}}]}",
+       AQUA_ERR_JSON_PARSE},
+      {"{\"services\":[{\"service_id\":\"Aquarium\","
+       "\"properties\":{\"heater\":true}}]",
+       AQUA_ERR_JSON_PARSE},
+  };
+  ParsedCommand cmd;
+
+  for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); ++i) {
+    TEST_ASSERT_EQUAL_MESSAGE(
+        CASES[i].expected,
+        aqua_parse_properties_set_json(CASES[i].json, strlen(CASES[i].json),
+                                       &cmd),
+        CASES[i].json);
+  }
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
+                    aqua_parse_properties_set_json(NULL, 0, &cmd));
+}
+
+void test_build_properties_set_response_json(void) {
+  char buffer[128];
+  size_t len;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_set_response_json(
+                                 0, NULL, buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL_STRING("{\"result_code\":0,\"result_desc\":\"success\"}",
+                           buffer);
+  TEST_ASSERT_EQUAL(strlen(buffer), len);
+
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_build_properties_set_response_json(
+                        1, "property not writable", buffer, sizeof(buffer),
+                        &len));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"result_code\":1,\"result_desc\":\"property not writable\"}",
+      buffer);
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_build_properties_set_response_json(0, NULL, buffer,
+                                                            10, &len));
+}
+
+/* ============================================================================
+ * 测试：命令增量解析（分片喂入）
+ * ============================================================================
+ */
+
+static const char *CHUNK_CONTROL_JSON =
+    "{\"object_device_id\":\"dev\",\"service_id\":\"aquarium_control\","
+    "\"command_name\":\"control\",\"paras\":{\"heater\":true,"
+    "\"meta\":{\"heater\":false,\"list\":[1,{\"a\":\"}\"}]},"
+    "\"target_temp\":-2.5e1,\"feed\":false}}";
+
+void test_cmd_parser_byte_by_byte(void) {
+  AquaCmdParser parser;
+  ParsedCommand cmd;
+  size_t len = strlen(CHUNK_CONTROL_JSON);
+
+  aqua_cmd_parser_init(&parser, &cmd);
+  for (size_t i = 0; i + 1 < len; ++i) {
+    size_t consumed = 0;
+    TEST_ASSERT_EQUAL(AQUA_ERR_INCOMPLETE,
+                      aqua_cmd_parser_feed(&parser, &CHUNK_CONTROL_JSON[i], 1,
+                                           &consumed));
+    TEST_ASSERT_EQUAL(1, consumed);
+  }
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_cmd_parser_feed(
+                                 &parser, &CHUNK_CONTROL_JSON[len - 1], 1, NULL));
+
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_CONTROL, cmd.type);
+  TEST_ASSERT_TRUE(cmd.params.control.has_heater);
+  TEST_ASSERT_TRUE(cmd.params.control.heater);
+  TEST_ASSERT_TRUE(cmd.params.control.has_target_temp);
+  TEST_ASSERT_FLOAT_WITHIN(0.001f, -25.0f, cmd.params.control.target_temp);
+  TEST_ASSERT_TRUE(cmd.params.control.has_feed);
+  TEST_ASSERT_FALSE(cmd.params.control.feed);
+}
+
+void test_cmd_parser_every_split_point(void) {
+  size_t len = strlen(CHUNK_CONTROL_JSON);
+  ParsedCommand whole;
+  TEST_ASSERT_EQUAL(AQUA_OK,
+                    aqua_parse_command_json(CHUNK_CONTROL_JSON, len, &whole));
+
+  for (size_t split = 1; split < len; ++split) {
+    AquaCmdParser parser;
+    ParsedCommand cmd;
+    aqua_cmd_parser_init(&parser, &cmd);
+    TEST_ASSERT_EQUAL(AQUA_ERR_INCOMPLETE,
+                      aqua_cmd_parser_feed(&parser, CHUNK_CONTROL_JSON, split,
+                                           NULL));
+    TEST_ASSERT_EQUAL(AQUA_OK,
+                      aqua_cmd_parser_feed(&parser, CHUNK_CONTROL_JSON + split,
+                                           len - split, NULL));
+    TEST_ASSERT_EQUAL(0, memcmp(&whole, &cmd, sizeof(ParsedCommand)));
+  }
+}
+
+void test_cmd_parser_stops_after_document(void) {
+  const char *json = "{\"service_id\":\"aquariumConfig\","
+                     "\"command_name\":\"set_config\","
+                     "\"paras\":{\"wifi_ssid\":\"x\"}}\r\n{garbage";
+  AquaCmdParser parser;
+  ParsedCommand cmd;
+  size_t consumed = 0;
+
+  aqua_cmd_parser_init(&parser, &cmd);
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_cmd_parser_feed(&parser, json, strlen(json),
+                                                  &consumed));
+  TEST_ASSERT_EQUAL(strlen(json) - strlen("\r\n{garbage"), consumed);
+  TEST_ASSERT_EQUAL_STRING("x", cmd.params.config.wifi_ssid);
+
+  /* 完成后继续喂入不再消费数据，结果保持不变 */
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_cmd_parser_feed(&parser, "}", 1, &consumed));
+  TEST_ASSERT_EQUAL(0, consumed);
+}
+
+void test_cmd_parser_payload_longer_than_at_line(void) {
+  static char json[2048];
+  size_t len = (size_t)snprintf(json, sizeof(json),
+                                "{\"service_id\":\"aquarium_threshold\","
+                                "\"command_name\":\"set_thresholds\","
+                                "\"paras\":{");
+  for (int i = 0; i < 60; ++i) {
+    len += (size_t)snprintf(json + len, sizeof(json) - len,
+                            "\"ext_%03d\":\"%08d\",", i, i);
+  }
+  len += (size_t)snprintf(json + len, sizeof(json) - len,
+                          "\"tds_warn\":450,\"feed_amount\":\"3\"}}");
+  TEST_ASSERT_TRUE(len > 1024 && len < sizeof(json));
+
+  /* 整段接口受 AQUA_JSON_MAX_LEN 限制，增量接口不受限 */
+  ParsedCommand cmd;
+  TEST_ASSERT_EQUAL(AQUA_ERR_BUFFER_TOO_SMALL,
+                    aqua_parse_command_json(json, len, &cmd));
+
+  AquaCmdParser parser;
+  AquaError err = AQUA_ERR_INCOMPLETE;
+  aqua_cmd_parser_init(&parser, &cmd);
+  for (size_t off = 0; off < len; off += 64) {
+    size_t chunk = (len - off < 64) ? (len - off) : 64;
+    err = aqua_cmd_parser_feed(&parser, json + off, chunk, NULL);
+  }
+  TEST_ASSERT_EQUAL(AQUA_OK, err);
+  TEST_ASSERT_EQUAL(COMMAND_TYPE_SET_THRESHOLDS, cmd.type);
+  TEST_ASSERT_EQUAL(450, cmd.params.threshold.tds_warn);
+  TEST_ASSERT_EQUAL(3, cmd.params.threshold.feed_amount);
+}
+
+void test_cmd_parser_errors(void) {
+  AquaCmdParser parser;
+  ParsedCommand cmd;
+
+  aqua_cmd_parser_init(&parser, &cmd);
+  TEST_ASSERT_EQUAL(AQUA_ERR_JSON_PARSE,
+                    aqua_cmd_parser_feed(&parser, "[{}]", 4, NULL));
+
+  aqua_cmd_parser_init(&parser, &cmd);
+  TEST_ASSERT_EQUAL(AQUA_ERR_INCOMPLETE,
+                    aqua_cmd_parser_feed(&parser, "{\"paras\":{\"a\":[", 15,
+                                         NULL));
+  TEST_ASSERT_EQUAL(AQUA_ERR_JSON_PARSE,
+                    aqua_cmd_parser_feed(&parser, "}", 1, NULL));
+
+  aqua_cmd_parser_init(&parser, &cmd);
+  TEST_ASSERT_EQUAL(AQUA_ERR_MISSING_FIELD,
+                    aqua_cmd_parser_feed(&parser, "{\"paras\":{}}", 12, NULL));
+
+  aqua_cmd_parser_init(&parser, &cmd);
+  const char *unknown = "{\"service_id\":\"x\",\"command_name\":\"y\","
+                        "\"paras\":{}}";
+  TEST_ASSERT_EQUAL(AQUA_ERR_INVALID_COMMAND,
+                    aqua_cmd_parser_feed(&parser, unknown, strlen(unknown),
+                                         NULL));
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_NULL_PTR,
+                    aqua_cmd_parser_feed(NULL, "{", 1, NULL));
+}
+
+/* ============================================================================
+ * 测试：数值格式化
+ * ============================================================================
+ */
+
+void test_fmt_fixed_matches_printf(void) {
+  char ours[32];
+  char ref[32];
+
+  for (int32_t k = -200000; k <= 200000; k += 7) {
+    float v = (float)k / 1000.0f;
+    AquaFmt f;
+    aqua_fmt_init(&f, ours, sizeof(ours));
+    aqua_fmt_fixed(&f, v, 2);
+    TEST_ASSERT_TRUE(aqua_fmt_finish(&f, NULL));
+    snprintf(ref, sizeof(ref), "%.2f", (double)v);
+
+    if (strcmp(ours, ref) != 0) {
+      /* 仅允许恰好落在舍入中点附近的值（printf 按二进制精确值取偶）与
+       * 舍入后为零的负数（printf 输出 "-0.00"）存在差异 */
+      double scaled = fabs((double)v) * 100.0;
+      double frac = scaled - floor(scaled);
+      bool near_tie = fabs(frac - 0.5) < 1e-3;
+      bool neg_zero = (strcmp(ref, "-0.00") == 0 && strcmp(ours, "0.00") == 0);
+      if (!near_tie && !neg_zero) {
+        TEST_FAIL_MESSAGE(ref);
+      }
+    }
+  }
+}
+
+void test_fmt_int_and_edges(void) {
+  char buf[48];
+  AquaFmt f;
+  size_t len = 0;
+
+  aqua_fmt_init(&f, buf, sizeof(buf));
+  aqua_fmt_i32(&f, INT32_MIN);
+  aqua_fmt_char(&f, ' ');
+  aqua_fmt_i32(&f, INT32_MAX);
+  aqua_fmt_char(&f, ' ');
+  aqua_fmt_i32(&f, 0);
+  aqua_fmt_char(&f, ' ');
+  aqua_fmt_fixed(&f, 1.5f, 0);
+  aqua_fmt_char(&f, ' ');
+  aqua_fmt_fixed(&f, -0.05f, 3);
+  aqua_fmt_char(&f, ' ');
+  aqua_fmt_fixed(&f, NAN, 1);
+  TEST_ASSERT_TRUE(aqua_fmt_finish(&f, &len));
+  TEST_ASSERT_EQUAL_STRING("-2147483648 2147483647 0 2 -0.050 0.0", buf);
+  TEST_ASSERT_EQUAL(strlen(buf), len);
+
+  aqua_fmt_init(&f, buf, sizeof(buf));
+  aqua_fmt_fixed(&f, 1e20f, 2);
+  TEST_ASSERT_TRUE(aqua_fmt_finish(&f, NULL));
+  TEST_ASSERT_EQUAL_STRING("4294967295.00", buf);
+}
+
+void test_fmt_overflow_keeps_terminator(void) {
+  char buf[8];
+  AquaFmt f;
+  size_t len = 0;
+
+  aqua_fmt_init(&f, buf, sizeof(buf));
+  aqua_fmt_str(&f, "abc");
+  aqua_fmt_i32(&f, 1234);
+  TEST_ASSERT_TRUE(aqua_fmt_finish(&f, &len));
+  TEST_ASSERT_EQUAL(7, len);
+
+  aqua_fmt_char(&f, 'x');
+  TEST_ASSERT_FALSE(aqua_fmt_finish(&f, &len));
+  TEST_ASSERT_EQUAL_STRING("abc1234", buf);
+}
+
+/* ============================================================================
+ * 测试：JSON 写入器
+ * ============================================================================
+ */
+
+void test_jw_nesting_and_commas(void) {
+  char buf[128];
+  AquaJsonWriter w;
+  size_t len = 0;
+
+  aqua_jw_init(&w, buf, sizeof(buf));
+  aqua_jw_begin_obj(&w);
+  aqua_jw_key_i32(&w, "a", -1);
+  aqua_jw_key_arr(&w, "b");
+  aqua_jw_u32(&w, 1);
+  aqua_jw_begin_obj(&w);
+  aqua_jw_end_obj(&w);
+  aqua_jw_bool(&w, false);
+  aqua_jw_end_arr(&w);
+  aqua_jw_key_f32(&w, "c", 1.5f, 1);
+  aqua_jw_key_obj(&w, "d");
+  aqua_jw_key_str(&w, "e", "x");
+  aqua_jw_end_obj(&w);
+  aqua_jw_end_obj(&w);
+
+  TEST_ASSERT_TRUE(aqua_jw_finish(&w, &len));
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"a\":-1,\"b\":[1,{},false],\"c\":1.5,\"d\":{\"e\":\"x\"}}", buf);
+  TEST_ASSERT_EQUAL(strlen(buf), len);
+}
+
+void test_jw_string_escaping(void) {
+  char buf[64];
+  AquaJsonWriter w;
+
+  aqua_jw_init(&w, buf, sizeof(buf));
+  aqua_jw_str(&w, "a\"b\\c\nd\x01");
+  TEST_ASSERT_TRUE(aqua_jw_finish(&w, NULL));
+  TEST_ASSERT_EQUAL_STRING("\"a\\\"b\\\\c\\nd\\u0001\"", buf);
+}
+
+void test_jw_errors(void) {
+  char buf[64];
+  AquaJsonWriter w;
+
+  /* 缓冲区不足 */
+  aqua_jw_init(&w, buf, 8);
+  aqua_jw_begin_obj(&w);
+  aqua_jw_key_str(&w, "key", "value");
+  aqua_jw_end_obj(&w);
+  TEST_ASSERT_FALSE(aqua_jw_finish(&w, NULL));
+
+  /* 未闭合 */
+  aqua_jw_init(&w, buf, sizeof(buf));
+  aqua_jw_begin_obj(&w);
+  TEST_ASSERT_FALSE(aqua_jw_finish(&w, NULL));
+
+  /* 多余的闭合 */
+  aqua_jw_init(&w, buf, sizeof(buf));
+  aqua_jw_begin_obj(&w);
+  aqua_jw_end_obj(&w);
+  aqua_jw_end_arr(&w);
+  TEST_ASSERT_FALSE(aqua_jw_finish(&w, NULL));
+
+  /* 键后缺少值 */
+  aqua_jw_init(&w, buf, sizeof(buf));
+  aqua_jw_begin_obj(&w);
+  aqua_jw_key(&w, "k");
+  aqua_jw_end_obj(&w);
+  TEST_ASSERT_FALSE(aqua_jw_finish(&w, NULL));
+
+  /* 嵌套过深 */
+  aqua_jw_init(&w, buf, sizeof(buf));
+  for (int i = 0; i <= AQUA_JW_MAX_DEPTH; ++i) {
+    aqua_jw_begin_arr(&w);
+  }
+  TEST_ASSERT_FALSE(aqua_jw_finish(&w, NULL));
+}
+
+typedef struct {
+  char data[512];
+  size_t len;
+  size_t calls;
+  size_t fail_after; /* 第 N 次调用起返回失败，0 表示不失败 */
+} SinkCapture;
+
+static bool capture_sink(void *ctx, const char *data, size_t len) {
+  SinkCapture *c = (SinkCapture *)ctx;
+  c->calls++;
+  if (c->fail_after != 0 && c->calls >= c->fail_after) {
+    return false;
+  }
+  if (c->len + len < sizeof(c->data)) {
+    memcpy(c->data + c->len, data, len);
+    c->len += len;
+    c->data[c->len] = '\0';
+  }
+  return true;
+}
+
+static void jw_write_sample(AquaJsonWriter *w) {
+  aqua_jw_begin_obj(w);
+  aqua_jw_key_str(w, "service_id", SERVICE_ID_AQUARIUM);
+  aqua_jw_key_obj(w, "properties");
+  aqua_jw_key_f32(w, "temperature", 26.37f, 2);
+  aqua_jw_key_i32(w, "feed_countdown", 3600);
+  aqua_jw_key_bool(w, "heater", true);
+  aqua_jw_end_obj(w);
+  aqua_jw_end_obj(w);
+}
+
+void test_jw_sink_matches_buffer(void) {
+  char ref[256];
+  size_t ref_len = 0;
+  AquaJsonWriter w;
+
+  aqua_jw_init(&w, ref, sizeof(ref));
+  jw_write_sample(&w);
+  TEST_ASSERT_TRUE(aqua_jw_finish(&w, &ref_len));
+
+  /* 暂存区远小于报文：分多次交给回调，拼接结果一致 */
+  static SinkCapture cap;
+  char stage[8];
+  size_t len = 0;
+  memset(&cap, 0, sizeof(cap));
+  aqua_jw_init_sink(&w, stage, sizeof(stage), capture_sink, &cap);
+  jw_write_sample(&w);
+  TEST_ASSERT_TRUE(aqua_jw_finish(&w, &len));
+  TEST_ASSERT_EQUAL(ref_len, len);
+  TEST_ASSERT_EQUAL_STRING(ref, cap.data);
+  TEST_ASSERT_TRUE(cap.calls > 1);
+
+  /* 无暂存区：每次写入直接交给回调 */
+  memset(&cap, 0, sizeof(cap));
+  aqua_jw_init_sink(&w, NULL, 0, capture_sink, &cap);
+  jw_write_sample(&w);
+  TEST_ASSERT_TRUE(aqua_jw_finish(&w, &len));
+  TEST_ASSERT_EQUAL(ref_len, len);
+  TEST_ASSERT_EQUAL_STRING(ref, cap.data);
+
+  /* 回调失败后 finish 报错 */
+  memset(&cap, 0, sizeof(cap));
+  cap.fail_after = 2;
+  aqua_jw_init_sink(&w, stage, sizeof(stage), capture_sink, &cap);
+  jw_write_sample(&w);
+  TEST_ASSERT_FALSE(aqua_jw_finish(&w, NULL));
+}
+
 /* ============================================================================
  * 测试：Topic 解析
  * ============================================================================
@@ -328,6 +1626,51 @@ void test_extract_request_id_invalid(void) {
   TEST_ASSERT_EQUAL(AQUA_ERR_TOPIC_PARSE, err);
 }
 
+void test_parse_downlink_topic(void) {
+  TEST_ASSERT_EQUAL(AQUA_DOWNLINK_COMMAND,
+                    aqua_parse_downlink_topic(
+                        "$oc/devices/dev01/sys/commands/request_id=r1"));
+  TEST_ASSERT_EQUAL(AQUA_DOWNLINK_PROPERTIES_SET,
+                    aqua_parse_downlink_topic(
+                        "$oc/devices/dev01/sys/properties/set/request_id=r2"));
+  TEST_ASSERT_EQUAL(AQUA_DOWNLINK_PROPERTIES_GET,
+                    aqua_parse_downlink_topic(
+                        "$oc/devices/dev01/sys/properties/get/request_id=r3"));
+  TEST_ASSERT_EQUAL(AQUA_DOWNLINK_UNKNOWN,
+                    aqua_parse_downlink_topic(
+                        "$oc/devices/dev01/sys/properties/report"));
+  TEST_ASSERT_EQUAL(AQUA_DOWNLINK_UNKNOWN,
+                    aqua_parse_downlink_topic(
+                        "$oc/devices/dev01/sys/properties/getx/request_id=r"));
+  TEST_ASSERT_EQUAL(AQUA_DOWNLINK_UNKNOWN, aqua_parse_downlink_topic("topic"));
+  TEST_ASSERT_EQUAL(AQUA_DOWNLINK_UNKNOWN, aqua_parse_downlink_topic(NULL));
+}
+
+void test_extract_object_device_id(void) {
+  char id[32];
+  const char *cmd = "{\"object_device_id\":\"gw_tank2\","
+                    "\"service_id\":\"Control\",\"command_name\":\"feed\","
+                    "\"paras\":{}}";
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_extract_object_device_id(
+                                 cmd, strlen(cmd), id, sizeof(id)));
+  TEST_ASSERT_EQUAL_STRING("gw_tank2", id);
+
+  /* 嵌套对象里的同名键不算 */
+  const char *nested = "{\"services\":[{\"object_device_id\":\"x\"}]}";
+  TEST_ASSERT_EQUAL(AQUA_ERR_MISSING_FIELD,
+                    aqua_extract_object_device_id(nested, strlen(nested), id,
+                                                  sizeof(id)));
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_JSON_PARSE,
+                    aqua_extract_object_device_id(cmd, strlen(cmd), id, 4));
+  const char *num = "{\"object_device_id\":12}";
+  TEST_ASSERT_EQUAL(AQUA_ERR_JSON_PARSE,
+                    aqua_extract_object_device_id(num, strlen(num), id,
+                                                  sizeof(id)));
+  TEST_ASSERT_EQUAL(AQUA_ERR_JSON_PARSE,
+                    aqua_extract_object_device_id(cmd, 20, id, sizeof(id)));
+}
+
 /* ============================================================================
  * 测试：Topic 构建
  * ============================================================================
@@ -358,6 +1701,39 @@ void test_build_report_topic(void) {
   TEST_ASSERT_EQUAL_STRING("$oc/devices/690237639798273cc4fd09cb_MyAquarium_01/"
                            "sys/properties/report",
                            buffer);
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_message_up_topic(
+                                 "dev01", buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL_STRING("$oc/devices/dev01/sys/messages/up", buffer);
+  TEST_ASSERT_EQUAL(strlen(buffer), len);
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_gateway_report_topic(
+                                 "gw01", buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL_STRING(
+      "$oc/devices/gw01/sys/gateway/sub_devices/properties/report", buffer);
+  TEST_ASSERT_EQUAL(strlen(buffer), len);
+}
+
+void test_build_downlink_response_topic(void) {
+  char buffer[256];
+  size_t len;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_downlink_response_topic(
+                                 "dev01", AQUA_DOWNLINK_PROPERTIES_SET, "r2",
+                                 buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL_STRING(
+      "$oc/devices/dev01/sys/properties/set/response/request_id=r2", buffer);
+  TEST_ASSERT_EQUAL(strlen(buffer), len);
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_downlink_response_topic(
+                                 "dev01", AQUA_DOWNLINK_PROPERTIES_GET, "r3",
+                                 buffer, sizeof(buffer), &len));
+  TEST_ASSERT_EQUAL_STRING(
+      "$oc/devices/dev01/sys/properties/get/response/request_id=r3", buffer);
+
+  TEST_ASSERT_EQUAL(AQUA_ERR_TOPIC_PARSE,
+                    aqua_build_downlink_response_topic(
+                        "dev01", AQUA_DOWNLINK_UNKNOWN, "r", buffer,
+                        sizeof(buffer), &len));
 }
 
 /* ============================================================================
@@ -373,21 +1749,70 @@ int main(void) {
   RUN_TEST(test_build_properties_json_no_nan_inf);
   RUN_TEST(test_build_properties_json_null_ptr);
   RUN_TEST(test_build_properties_json_buffer_small);
+  RUN_TEST(test_build_properties_json_values);
+  RUN_TEST(test_build_properties_fields_json);
+  RUN_TEST(test_build_properties_batch_json);
+  RUN_TEST(test_build_sub_devices_report_json);
+  RUN_TEST(test_report_frame_matches_compact_json);
+  RUN_TEST(test_report_frame_saturates_and_sanitizes);
+  RUN_TEST(test_parse_properties_json_round_trip);
+  RUN_TEST(test_parse_properties_json_batch);
+  RUN_TEST(test_parse_properties_json_skips_foreign_content);
+  RUN_TEST(test_parse_properties_json_errors);
+  RUN_TEST(test_cbor_known_encoding);
+  RUN_TEST(test_cbor_round_trip_full_report);
+  RUN_TEST(test_cbor_round_trip_batch_and_extremes);
+  RUN_TEST(test_cbor_parse_errors);
 
   /* 命令响应测试 */
   RUN_TEST(test_build_response_json_success);
   RUN_TEST(test_build_response_json_failure);
+  RUN_TEST(test_build_command_response_json);
 
   /* 命令解析测试 */
   RUN_TEST(test_parse_control_command);
   RUN_TEST(test_parse_threshold_command);
   RUN_TEST(test_parse_config_command);
   RUN_TEST(test_parse_config_command_with_escaped_strings);
+  RUN_TEST(test_parse_config_command_with_unicode_escaped_password);
+  RUN_TEST(test_parse_config_command_rejects_oversized_value);
+  RUN_TEST(test_parse_command_keys_scoped_to_paras);
+  RUN_TEST(test_parse_command_paras_before_service_id);
+  RUN_TEST(test_parse_command_malformed);
+  RUN_TEST(test_parse_command_not_nul_terminated);
+  RUN_TEST(test_parse_command_number_formats);
+  RUN_TEST(test_parse_command_schema_covers_all_fields);
+  RUN_TEST(test_parse_command_key_near_misses);
+  RUN_TEST(test_property_bits_follow_schema);
+  RUN_TEST(test_parse_properties_set_aquarium);
+  RUN_TEST(test_parse_properties_set_command_services);
+  RUN_TEST(test_parse_properties_set_errors);
+  RUN_TEST(test_build_properties_set_response_json);
+  RUN_TEST(test_cmd_parser_byte_by_byte);
+  RUN_TEST(test_cmd_parser_every_split_point);
+  RUN_TEST(test_cmd_parser_stops_after_document);
+  RUN_TEST(test_cmd_parser_payload_longer_than_at_line);
+  RUN_TEST(test_cmd_parser_errors);
+
+  /* 数值格式化测试 */
+  RUN_TEST(test_fmt_fixed_matches_printf);
+  RUN_TEST(test_fmt_int_and_edges);
+  RUN_TEST(test_fmt_overflow_keeps_terminator);
+  RUN_TEST(test_fmt_event_time);
+
+  /* JSON 写入器测试 */
+  RUN_TEST(test_jw_nesting_and_commas);
+  RUN_TEST(test_jw_string_escaping);
+  RUN_TEST(test_jw_errors);
+  RUN_TEST(test_jw_sink_matches_buffer);
 
   /* Topic 测试 */
   RUN_TEST(test_extract_request_id);
   RUN_TEST(test_extract_request_id_invalid);
+  RUN_TEST(test_parse_downlink_topic);
+  RUN_TEST(test_extract_object_device_id);
   RUN_TEST(test_build_response_topic);
+  RUN_TEST(test_build_downlink_response_topic);
   RUN_TEST(test_build_report_topic);
 
   return UNITY_END();
@@ -0,0 +1,216 @@
+/**
+ * @file test_telemetry.c
+ * @brief 列式遥测存储单元测试（native 环境）
+ */
+
+#include "aquarium_telemetry.h"
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+
+#define TM_TEST_PATH "test_telemetry.aqtm"
+
+static AquaTelemetryStore g_tm;
+
+void setUp(void) {
+  remove(TM_TEST_PATH);
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_open(&g_tm, TM_TEST_PATH));
+}
+
+void tearDown(void) {
+  aqua_tm_close(&g_tm);
+  remove(TM_TEST_PATH);
+}
+
+/* ============================================================================
+ * 测试：追加与按列读取
+ * ============================================================================
+ */
+
+void test_tm_new_store_is_empty(void) {
+  size_t rows = 123;
+  TEST_ASSERT_EQUAL(0, aqua_tm_rows(&g_tm));
+  TEST_ASSERT_EQUAL(0, aqua_tm_block_count(&g_tm));
+  TEST_ASSERT_NULL(aqua_tm_column(&g_tm, AQUA_TM_COL_TIME, 0, &rows));
+  TEST_ASSERT_EQUAL(0, rows);
+}
+
+void test_tm_append_carries_forward_missing_fields(void) {
+  AquaPropertySample s1 = {.props = {.temperature = 25.5f,
+                                     .ph = 7.1f,
+                                     .heater = true,
+                                     .feed_countdown = 600},
+                           .field_mask = AQUA_PROP_ALL,
+                           .event_time = 1000};
+  AquaPropertySample s2 = {.props = {.temperature = 26.0f},
+                           .field_mask = AQUA_PROP_TEMPERATURE};
+
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_append(&g_tm, &s1, 1));
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_append(&g_tm, &s2, 2000));
+  TEST_ASSERT_EQUAL(2, aqua_tm_rows(&g_tm));
+
+  size_t rows = 0;
+  const float *temp =
+      aqua_tm_column(&g_tm, AQUA_PROP_BIT_TEMPERATURE, 0, &rows);
+  const float *ph = aqua_tm_column(&g_tm, AQUA_PROP_BIT_PH, 0, &rows);
+  const uint8_t *heater = aqua_tm_column(&g_tm, AQUA_PROP_BIT_HEATER, 0, &rows);
+  const int32_t *feed =
+      aqua_tm_column(&g_tm, AQUA_PROP_BIT_FEED_COUNTDOWN, 0, &rows);
+  const uint32_t *time = aqua_tm_column(&g_tm, AQUA_TM_COL_TIME, 0, &rows);
+  const uint16_t *mask = aqua_tm_column(&g_tm, AQUA_TM_COL_MASK, 0, &rows);
+  TEST_ASSERT_EQUAL(2, rows);
+
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 25.5f, temp[0]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 26.0f, temp[1]);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 7.1f, ph[1]);
+  TEST_ASSERT_EQUAL(1, heater[1]);
+  TEST_ASSERT_EQUAL(600, feed[1]);
+  TEST_ASSERT_EQUAL_UINT32(1000, time[0]);
+  TEST_ASSERT_EQUAL_UINT32(2000, time[1]);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_ALL, mask[0]);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_TEMPERATURE, mask[1]);
+
+  AquaPropertySample row;
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_read_row(&g_tm, 1, &row));
+  TEST_ASSERT_TRUE(row.props.heater);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 26.0f, row.props.temperature);
+  TEST_ASSERT_EQUAL_HEX32(AQUA_PROP_TEMPERATURE, row.field_mask);
+  TEST_ASSERT_EQUAL(TELEMETRY_ERR_FORMAT, aqua_tm_read_row(&g_tm, 2, &row));
+}
+
+void test_tm_grows_across_blocks_and_reopens(void) {
+  const uint64_t total = AQUA_TM_BLOCK_ROWS * 2 + 17;
+  AquaPropertySample s = {.field_mask = AQUA_PROP_WATER_LEVEL |
+                                        AQUA_PROP_ALARM_LEVEL};
+
+  for (uint64_t i = 0; i < total; ++i) {
+    s.props.water_level = (float)(i % 100);
+    s.props.alarm_level = (int32_t)(i % 3);
+    TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_append(&g_tm, &s, (uint32_t)i));
+  }
+  TEST_ASSERT_EQUAL(total, aqua_tm_rows(&g_tm));
+  TEST_ASSERT_EQUAL(3, aqua_tm_block_count(&g_tm));
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_sync(&g_tm));
+
+  /* 重新打开后数据与行数保持，可以继续追加 */
+  aqua_tm_close(&g_tm);
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_open(&g_tm, TM_TEST_PATH));
+  TEST_ASSERT_EQUAL(total, aqua_tm_rows(&g_tm));
+
+  size_t rows = 0;
+  const uint32_t *time = aqua_tm_column(&g_tm, AQUA_TM_COL_TIME, 2, &rows);
+  TEST_ASSERT_EQUAL(17, rows);
+  TEST_ASSERT_EQUAL_UINT32(AQUA_TM_BLOCK_ROWS * 2 + 16, time[16]);
+
+  uint64_t checked = 0;
+  for (uint64_t b = 0; b < aqua_tm_block_count(&g_tm); ++b) {
+    const float *level =
+        aqua_tm_column(&g_tm, AQUA_PROP_BIT_WATER_LEVEL, b, &rows);
+    const int32_t *alarm =
+        aqua_tm_column(&g_tm, AQUA_PROP_BIT_ALARM_LEVEL, b, &rows);
+    for (size_t i = 0; i < rows; ++i, ++checked) {
+      TEST_ASSERT_EQUAL((int)(checked % 100), (int)level[i]);
+      TEST_ASSERT_EQUAL((int)(checked % 3), alarm[i]);
+    }
+  }
+  TEST_ASSERT_EQUAL(total, checked);
+
+  s.props.water_level = 42.0f;
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_append(&g_tm, &s, 0));
+  TEST_ASSERT_EQUAL(total + 1, aqua_tm_rows(&g_tm));
+}
+
+void test_tm_append_json(void) {
+  AquaPropertySample samples[2] = {
+      {.props = {.temperature = 24.25f, .tds = 310.0f},
+       .field_mask = AQUA_PROP_TEMPERATURE | AQUA_PROP_TDS,
+       .event_time = 1760515200u},
+      {.props = {.tds = 315.5f}, .field_mask = AQUA_PROP_TDS},
+  };
+  char json[512];
+  size_t len = 0;
+  size_t appended = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_batch_json(
+                                 samples, 2, json, sizeof(json), &len));
+  TEST_ASSERT_EQUAL(TELEMETRY_OK,
+                    aqua_tm_append_json(&g_tm, json, len, 1760515260u,
+                                        &appended));
+  TEST_ASSERT_EQUAL(2, appended);
+
+  AquaPropertySample row;
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_read_row(&g_tm, 1, &row));
+  TEST_ASSERT_EQUAL_UINT32(1760515260u, row.event_time);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 24.25f, row.props.temperature);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 315.5f, row.props.tds);
+
+  TEST_ASSERT_EQUAL(TELEMETRY_ERR_PARSE,
+                    aqua_tm_append_json(&g_tm, "{\"services\":[", 13, 0,
+                                        &appended));
+  TEST_ASSERT_EQUAL(0, appended);
+  TEST_ASSERT_EQUAL(2, aqua_tm_rows(&g_tm));
+}
+
+void test_tm_append_cbor(void) {
+  AquaPropertySample samples[2] = {
+      {.props = {.ph = 6.85f}, .field_mask = AQUA_PROP_PH,
+       .event_time = 1760515200u},
+      {.props = {.alarm_muted = true}, .field_mask = AQUA_PROP_ALARM_MUTED},
+  };
+  uint8_t data[64];
+  size_t len = 0;
+  size_t appended = 0;
+
+  TEST_ASSERT_EQUAL(AQUA_OK, aqua_build_properties_cbor(samples, 2, data,
+                                                        sizeof(data), &len));
+  TEST_ASSERT_EQUAL(TELEMETRY_OK,
+                    aqua_tm_append_cbor(&g_tm, data, len, 1760515260u,
+                                        &appended));
+  TEST_ASSERT_EQUAL(2, appended);
+
+  AquaPropertySample row;
+  TEST_ASSERT_EQUAL(TELEMETRY_OK, aqua_tm_read_row(&g_tm, 1, &row));
+  TEST_ASSERT_EQUAL_UINT32(1760515260u, row.event_time);
+  TEST_ASSERT_FLOAT_WITHIN(1e-6f, 6.85f, row.props.ph);
+  TEST_ASSERT_TRUE(row.props.alarm_muted);
+
+  TEST_ASSERT_EQUAL(TELEMETRY_ERR_PARSE,
+                    aqua_tm_append_cbor(&g_tm, data, len - 1, 0, &appended));
+  TEST_ASSERT_EQUAL(0, appended);
+}
+
+/* ============================================================================
+ * 测试：文件格式校验
+ * ============================================================================
+ */
+
+void test_tm_rejects_foreign_file(void) {
+  aqua_tm_close(&g_tm);
+
+  FILE *fp = fopen(TM_TEST_PATH, "wb");
+  TEST_ASSERT_NOT_NULL(fp);
+  static const uint8_t junk[AQUA_TM_HEADER_SIZE] = {'n', 'o', 't', 'a'};
+  fwrite(junk, 1, sizeof(junk), fp);
+  fclose(fp);
+
+  TEST_ASSERT_EQUAL(TELEMETRY_ERR_FORMAT, aqua_tm_open(&g_tm, TM_TEST_PATH));
+  TEST_ASSERT_EQUAL(TELEMETRY_ERR_NULL_PTR, aqua_tm_open(NULL, TM_TEST_PATH));
+}
+
+/* ============================================================================
+ * 主函数
+ * ============================================================================
+ */
+
+int main(void) {
+  UNITY_BEGIN();
+
+  RUN_TEST(test_tm_new_store_is_empty);
+  RUN_TEST(test_tm_append_carries_forward_missing_fields);
+  RUN_TEST(test_tm_grows_across_blocks_and_reopens);
+  RUN_TEST(test_tm_append_json);
+  RUN_TEST(test_tm_append_cbor);
+  RUN_TEST(test_tm_rejects_foreign_file);
+
+  return UNITY_END();
+}